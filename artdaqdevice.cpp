@@ -0,0 +1,228 @@
+#include "artdaqdevice.h"
+#include <QDebug>
+#include <QStringList>
+
+// 定义必要的常量，确保这些常量在Art_DAQ.h中未定义的情况下可用
+#ifndef ArtDAQ_Val_Cfg_Default
+#define ArtDAQ_Val_Cfg_Default  -1
+#endif
+
+#ifndef ArtDAQ_Val_Volts
+#define ArtDAQ_Val_Volts     10348
+#endif
+
+#ifndef ArtDAQ_Val_Rising
+#define ArtDAQ_Val_Rising    10280
+#endif
+
+#ifndef ArtDAQ_Val_ContSamps
+#define ArtDAQ_Val_ContSamps 10123
+#endif
+
+#ifndef ArtDAQ_Val_Acquired_Into_Buffer
+#define ArtDAQ_Val_Acquired_Into_Buffer 1
+#endif
+
+#ifndef ArtDAQ_Val_StartTrigger
+#define ArtDAQ_Val_StartTrigger 12491
+#endif
+
+#ifndef ArtDAQ_Val_SampleClock
+#define ArtDAQ_Val_SampleClock 12487
+#endif
+
+#ifndef ArtDAQ_Val_GroupByScanNumber
+#define ArtDAQ_Val_GroupByScanNumber 1
+#endif
+
+ArtDAQDevice::ArtDAQDevice()
+    : m_taskHandle(0)
+    , m_samplesCallback(nullptr)
+    , m_doneCallback(nullptr)
+    , m_context(nullptr)
+{
+}
+
+ArtDAQDevice::~ArtDAQDevice()
+{
+    stop();
+}
+
+void ArtDAQDevice::fail(const QString &what)
+{
+    char errBuff[2048] = {'\0'};
+    ArtDAQ_GetExtendedErrorInfo(errBuff, 2048);
+    m_lastError = QString("%1: %2").arg(what, errBuff);
+    if (m_taskHandle != 0) {
+        ArtDAQ_ClearTask(m_taskHandle);
+        m_taskHandle = 0;
+    }
+}
+
+bool ArtDAQDevice::configure(const DAQDeviceConfig &config)
+{
+    stop();
+    m_config = config;
+
+    QStringList channelList;
+    for (int ch : config.channels) {
+        channelList.append(QString("%1/ai%2").arg(config.deviceName).arg(ch));
+    }
+    const QByteArray deviceChannelStr = channelList.join(",").toLocal8Bit();
+    qDebug() << "[ArtDAQDevice] 使用设备通道字符串:" << deviceChannelStr;
+
+    // 创建任务
+    if (ArtDAQ_CreateTask("", &m_taskHandle) < 0) {
+        fail("创建任务失败");
+        return false;
+    }
+
+    // 创建模拟输入通道
+    if (ArtDAQ_CreateAIVoltageChan(m_taskHandle, deviceChannelStr.constData(), "", ArtDAQ_Val_Cfg_Default,
+                                   config.rangeMin, config.rangeMax, ArtDAQ_Val_Volts, NULL) < 0) {
+        fail("创建通道失败");
+        return false;
+    }
+
+    // 设置采样时钟：从设备可使用主设备导出的采样时钟
+    QByteArray clockSource;
+    if (config.syncRole == DAQSyncRole::Slave) {
+        clockSource = config.sampleClockTerminal.toLocal8Bit();
+    }
+    if (ArtDAQ_CfgSampClkTiming(m_taskHandle, clockSource.constData(), config.sampleRate, ArtDAQ_Val_Rising,
+                                ArtDAQ_Val_ContSamps, config.samplesPerChannel) < 0) {
+        fail("设置采样时钟失败");
+        return false;
+    }
+
+    // 多设备同步：主设备导出开始触发和采样时钟，从设备等待开始触发
+    if (config.syncRole == DAQSyncRole::Master) {
+        if (!config.startTriggerTerminal.isEmpty()
+            && ArtDAQ_ExportSignal(m_taskHandle, ArtDAQ_Val_StartTrigger,
+                                   config.startTriggerTerminal.toLocal8Bit().constData()) < 0) {
+            fail("导出开始触发失败");
+            return false;
+        }
+        if (!config.sampleClockTerminal.isEmpty()
+            && ArtDAQ_ExportSignal(m_taskHandle, ArtDAQ_Val_SampleClock,
+                                   config.sampleClockTerminal.toLocal8Bit().constData()) < 0) {
+            fail("导出采样时钟失败");
+            return false;
+        }
+    } else if (config.syncRole == DAQSyncRole::Slave && !config.startTriggerTerminal.isEmpty()) {
+        if (ArtDAQ_CfgDigEdgeStartTrig(m_taskHandle, config.startTriggerTerminal.toLocal8Bit().constData(),
+                                       ArtDAQ_Val_Rising) < 0) {
+            fail("设置开始触发失败");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ArtDAQDevice::start(SamplesCallback samplesCallback, DoneCallback doneCallback, void *context)
+{
+    if (m_taskHandle == 0) {
+        m_lastError = "任务未配置";
+        return false;
+    }
+
+    m_samplesCallback = samplesCallback;
+    m_doneCallback = doneCallback;
+    m_context = context;
+
+    // 注册回调函数
+    if (ArtDAQ_RegisterEveryNSamplesEvent(m_taskHandle, ArtDAQ_Val_Acquired_Into_Buffer,
+                                          uInt32(m_config.samplesPerChannel), 0, everyNCallback, this) < 0) {
+        fail("注册回调函数失败");
+        return false;
+    }
+
+    if (ArtDAQ_RegisterDoneEvent(m_taskHandle, 0, doneCallback, this) < 0) {
+        fail("注册完成事件失败");
+        return false;
+    }
+
+    // 开始任务
+    if (ArtDAQ_StartTask(m_taskHandle) < 0) {
+        fail("启动任务失败");
+        return false;
+    }
+
+    return true;
+}
+
+void ArtDAQDevice::stop()
+{
+    // ClearTask返回后驱动不会再调用回调
+    if (m_taskHandle != 0) {
+        ArtDAQ_StopTask(m_taskHandle);
+        ArtDAQ_ClearTask(m_taskHandle);
+        m_taskHandle = 0;
+    }
+}
+
+int ArtDAQDevice::readAnalog(int scans, double *buffer, std::uint32_t bufferSize, int *scansRead)
+{
+    int32 read = 0;
+    const int32 errorCode = ArtDAQ_ReadAnalogF64(m_taskHandle, scans, 10.0, ArtDAQ_Val_GroupByScanNumber,
+                                                 buffer, bufferSize, &read, NULL);
+    *scansRead = read;
+    return errorCode;
+}
+
+int ArtDAQDevice::readBinary(int scans, std::int16_t *buffer, std::uint32_t bufferSize, int *scansRead)
+{
+    int32 read = 0;
+    const int32 errorCode = ArtDAQ_ReadBinaryI16(m_taskHandle, scans, 10.0, ArtDAQ_Val_GroupByScanNumber,
+                                                 buffer, bufferSize, &read, NULL);
+    *scansRead = read;
+    return errorCode;
+}
+
+bool ArtDAQDevice::channelRange(int index, double *minValue, double *maxValue)
+{
+    if (m_taskHandle == 0 || index < 0 || index >= m_config.channels.size()) {
+        return false;
+    }
+    const QByteArray name = QString("%1/ai%2").arg(m_config.deviceName).arg(m_config.channels[index]).toLocal8Bit();
+    float64 maxRange = 0.0;
+    float64 minRange = 0.0;
+    if (ArtDAQ_GetAIMax(m_taskHandle, name.constData(), &maxRange) < 0
+        || ArtDAQ_GetAIMin(m_taskHandle, name.constData(), &minRange) < 0) {
+        return false;
+    }
+    *minValue = minRange;
+    *maxValue = maxRange;
+    return true;
+}
+
+// 驱动回调：转发给设备使用者
+int32 ART_CALLBACK ArtDAQDevice::everyNCallback(TaskHandle taskHandle, int32 everyNsamplesEventType,
+                                                uInt32 nSamples, void *callbackData)
+{
+    Q_UNUSED(taskHandle);
+    Q_UNUSED(everyNsamplesEventType);
+    ArtDAQDevice *device = static_cast<ArtDAQDevice *>(callbackData);
+    if (!device || !device->m_samplesCallback) {
+        return -1;
+    }
+    device->m_samplesCallback(device->m_context, int(nSamples));
+    return 0;
+}
+
+int32 ART_CALLBACK ArtDAQDevice::doneCallback(TaskHandle taskHandle, int32 status, void *callbackData)
+{
+    Q_UNUSED(taskHandle);
+    ArtDAQDevice *device = static_cast<ArtDAQDevice *>(callbackData);
+    if (!device || !device->m_doneCallback) {
+        return 0;
+    }
+
+    char errBuff[2048] = {'\0'};
+    if (status < 0) {
+        ArtDAQ_GetExtendedErrorInfo(errBuff, 2048);
+    }
+    device->m_doneCallback(device->m_context, status, errBuff);
+    return 0;
+}
@@ -0,0 +1,40 @@
+#ifndef ARTDAQDEVICE_H
+#define ARTDAQDEVICE_H
+
+#include "daqdevice.h"
+#include "Art_DAQ.h"
+
+// ArtDAQ硬件后端：封装Art_DAQ驱动的任务创建、采样时钟与EveryNSamples回调
+class ArtDAQDevice : public DAQDevice
+{
+public:
+    ArtDAQDevice();
+    ~ArtDAQDevice() override;
+
+    QString backendName() const override { return "ArtDAQ"; }
+
+    bool configure(const DAQDeviceConfig &config) override;
+    bool start(SamplesCallback samplesCallback, DoneCallback doneCallback, void *context) override;
+    void stop() override;
+
+    int readAnalog(int scans, double *buffer, std::uint32_t bufferSize, int *scansRead) override;
+    int readBinary(int scans, std::int16_t *buffer, std::uint32_t bufferSize, int *scansRead) override;
+
+    bool channelRange(int index, double *minValue, double *maxValue) override;
+
+private:
+    // 记录驱动错误信息并清理任务
+    void fail(const QString &what);
+
+    static int32 ART_CALLBACK everyNCallback(TaskHandle taskHandle, int32 everyNsamplesEventType,
+                                            uInt32 nSamples, void *callbackData);
+    static int32 ART_CALLBACK doneCallback(TaskHandle taskHandle, int32 status, void *callbackData);
+
+    TaskHandle m_taskHandle;
+    DAQDeviceConfig m_config;
+    SamplesCallback m_samplesCallback;
+    DoneCallback m_doneCallback;
+    void *m_context;
+};
+
+#endif // ARTDAQDEVICE_H
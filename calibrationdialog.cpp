@@ -6,6 +6,7 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <limits>
 
 // Constructor
 CalibrationDialog::CalibrationDialog(SnapshotThread *thread, QWidget *parent)
@@ -47,7 +48,7 @@ CalibrationDialog::CalibrationDialog(SnapshotThread *thread, QWidget *parent)
 
     // Initialize calibration data storage
     calibrationPoints.clear();
-    tempMeasurements.clear();
+    rawHistory = snapshotThread ? snapshotThread->rawSnapshotHistory() : nullptr;
     channelCalibrationPoints.clear();
     channelCalibrationResults.clear();
 
@@ -415,8 +416,8 @@ void CalibrationDialog::useDefaultChannelDetection()
     int defaultChannelCount = 16; // 默认支持16个Modbus通道
 
     // 如果有有效的快照数据，使用实际的数据大小
-    if (latestRawSnapshot.modbusValid && !latestRawSnapshot.modbusData.isEmpty()) {
-        defaultChannelCount = latestRawSnapshot.modbusData.size();
+    if (latestRawSnapshot->modbusValid && !latestRawSnapshot->modbusData.isEmpty()) {
+        defaultChannelCount = latestRawSnapshot->modbusData.size();
     }
 
     // 添加所有通道
@@ -462,9 +463,9 @@ void CalibrationDialog::updateChannelComboBox()
         if (internalDeviceType == "DAQ") {
             // For DAQ, always show all configured channels
             qDebug() << "[CalibrationDialog] DAQ channel count:" << count;
-            qDebug() << "[CalibrationDialog] DAQ data valid:" << latestRawSnapshot.daqValid;
-            if (latestRawSnapshot.daqValid) {
-                qDebug() << "[CalibrationDialog] DAQ data size:" << latestRawSnapshot.daqData.size();
+            qDebug() << "[CalibrationDialog] DAQ data valid:" << latestRawSnapshot->daqValid;
+            if (latestRawSnapshot->daqValid) {
+                qDebug() << "[CalibrationDialog] DAQ data size:" << latestRawSnapshot->daqData.size();
             }
 
             // Get DAQ channels from MainWindow
@@ -487,9 +488,9 @@ void CalibrationDialog::updateChannelComboBox()
         else if (internalDeviceType == "ECU") {
             // For ECU, always show all 9 standard channels
             qDebug() << "[CalibrationDialog] ECU channel count:" << count;
-            qDebug() << "[CalibrationDialog] ECU data valid:" << latestRawSnapshot.ecuValid;
-            if (latestRawSnapshot.ecuValid) {
-                qDebug() << "[CalibrationDialog] ECU data size:" << latestRawSnapshot.ecuData.size();
+            qDebug() << "[CalibrationDialog] ECU data valid:" << latestRawSnapshot->ecuValid;
+            if (latestRawSnapshot->ecuValid) {
+                qDebug() << "[CalibrationDialog] ECU data size:" << latestRawSnapshot->ecuData.size();
             }
 
             // Always add all ECU channels
@@ -498,7 +499,7 @@ void CalibrationDialog::updateChannelComboBox()
             }
         }
         else if (internalDeviceType == "Custom") {
-            for (int i = 0; i < qMin(count, latestRawSnapshot.customData.size()); ++i) {
+            for (int i = 0; i < qMin(count, latestRawSnapshot->customData.size()); ++i) {
                 deviceValidChannels.append(i); // Custom数据通常是计算出来的，都视为有效
             }
         }
@@ -638,10 +639,10 @@ void CalibrationDialog::onDeviceChanged(int index)
         plot->replot();
 
         // Check if DAQ data is valid
-        if (!latestRawSnapshot.daqValid) {
+        if (!latestRawSnapshot->daqValid) {
             qDebug() << "[CalibrationDialog] Warning: DAQ data is not valid in the latest snapshot";
         } else {
-            qDebug() << "[CalibrationDialog] DAQ data is valid, channels:" << latestRawSnapshot.daqData.size();
+            qDebug() << "[CalibrationDialog] DAQ data is valid, channels:" << latestRawSnapshot->daqData.size();
         }
 
         // Initialize empty calibration points for the current channel
@@ -662,10 +663,10 @@ void CalibrationDialog::onDeviceChanged(int index)
         plot->replot();
 
         // Check if ECU data is valid
-        if (!latestRawSnapshot.ecuValid) {
+        if (!latestRawSnapshot->ecuValid) {
             qDebug() << "[CalibrationDialog] Warning: ECU data is not valid in the latest snapshot";
         } else {
-            qDebug() << "[CalibrationDialog] ECU data is valid, channels:" << latestRawSnapshot.ecuData.size();
+            qDebug() << "[CalibrationDialog] ECU data is valid, channels:" << latestRawSnapshot->ecuData.size();
         }
 
         // Initialize empty calibration points for the current channel
@@ -745,7 +746,7 @@ void CalibrationDialog::onChannelChanged(int index)
         plot->replot();
 
         // 重置当前值显示
-        QVector<double> latestValues = getMultiChannelRawValues(latestRawSnapshot);
+        QVector<double> latestValues = getMultiChannelRawValues(*latestRawSnapshot);
         updateMultiChannelValueLabel(latestValues);
         } else {
         currentChannelIndex = selectedChannel;
@@ -853,31 +854,50 @@ void CalibrationDialog::updateMultiChannelPlot(double time, const QVector<double
 }
 
 // Slot to receive raw snapshot data from SnapshotThread
-void CalibrationDialog::onRawSnapshotReceived(const DataSnapshot &rawSnapshot)
+void CalibrationDialog::onRawSnapshotReceived(const SnapshotHandle &rawSnapshot)
 {
-    // Store the latest snapshot
+    // Store the latest snapshot (shared handle, no copy)
     latestRawSnapshot = rawSnapshot;
-    latestSnapshotIndex = rawSnapshot.snapshotIndex;
+    latestSnapshotIndex = rawSnapshot->snapshotIndex;
 
     // Get the raw value for the currently selected channel
-    double currentRawValue = getRawValueFromSnapshot(rawSnapshot);
+    double currentRawValue = getRawValueFromSnapshot(*rawSnapshot);
     latestRawValue = currentRawValue; // Update the latest known raw value
 
-    // If collecting points for calibration, add to temporary list
-    if (isCollectingPoints) {
-        // For single channel mode, just store the current raw value
-        tempMeasurements.append(currentRawValue);
-
-        // For batch calibration mode, store the entire snapshot for later processing
-        if (isBatchCalibration && getDeviceInternalName(currentDeviceType) == "Modbus") {
-            tempSnapshots.append(rawSnapshot);
-        }
-    }
+    // 采集期间的原始值由SnapshotThread写入原始快照历史，采集结束时按时间区间查询
 
     // Note: UI updates (plot, label) are handled by onDataUpdateTimerTimeout
     // to control the update frequency.
 }
 
+// 本次采集区间内各通道原始值的平均值
+QVector<double> CalibrationDialog::averageCollectedValues(const QVector<SnapshotHistory::Channel> &channels,
+                                                          QVector<int> *counts) const
+{
+    QVector<double> averages(channels.size(), 0.0);
+    counts->fill(0, channels.size());
+    if (!rawHistory) {
+        return averages;
+    }
+
+    // 不抽取，取区间内全部行
+    const SnapshotHistory::QueryResult collected =
+        rawHistory->query(collectionStartTime, std::numeric_limits<double>::infinity(), channels, 0);
+    for (int i = 0; i < channels.size(); ++i) {
+        double sum = 0.0;
+        for (double value : collected.values[i]) {
+            if (!std::isnan(value)) {
+                sum += value;
+                ++(*counts)[i];
+            }
+        }
+        if ((*counts)[i] > 0) {
+            averages[i] = sum / (*counts)[i];
+        }
+    }
+    return averages;
+}
+
 // Get the raw value for the current device/channel from a snapshot
 double CalibrationDialog::getRawValueFromSnapshot(const DataSnapshot& snapshot)
 {
@@ -917,7 +937,7 @@ void CalibrationDialog::onDataUpdateTimerTimeout()
 
     if (isBatchCalibration) {
         // 批量校准模式 - 更新多通道数据
-        QVector<double> values = getMultiChannelRawValues(latestRawSnapshot);
+        QVector<double> values = getMultiChannelRawValues(*latestRawSnapshot);
         updateMultiChannelValueLabel(values);
         updateMultiChannelPlot(elapsedSeconds, values);
     } else {
@@ -1163,9 +1183,12 @@ void CalibrationDialog::onAddPointClicked()
     // Update the input field with the potentially modified standard value
     calibrationInput->setValue(standardValue);
 
-    // Clear temporary measurements and snapshots
-    tempMeasurements.clear();
-    tempSnapshots.clear();
+    // 记录采集区间的起点：此后到达的原始快照计入平均值
+    double firstTime = 0.0;
+    double lastTime = 0.0;
+    collectionStartTime = rawHistory && rawHistory->timeRange(&firstTime, &lastTime)
+                              ? std::nextafter(lastTime, std::numeric_limits<double>::infinity())
+                              : -std::numeric_limits<double>::infinity();
 
     // Start the 5-second collection period
     isCollectingPoints = true;
@@ -1196,50 +1219,33 @@ void CalibrationDialog::onPointCollectionTimerTimeout()
         // For temperature sensors, we collect data for all valid channels simultaneously
 
         // Get the raw values for all valid channels
-        if (latestRawSnapshot.modbusValid) {
+        if (latestRawSnapshot->modbusValid) {
             // We need to analyze the collected data from all snapshots
             // Each snapshot contains data for all channels
 
-            // Create a map to store measurements for each channel
-            QMap<int, QVector<double>> channelMeasurements;
-
-            // Initialize the map for all valid channels
+            // 从原始快照历史查询采集区间内全部有效通道
+            QVector<SnapshotHistory::Channel> channels;
             for (int ch : validChannels) {
-                channelMeasurements[ch] = QVector<double>();
-            }
-
-            // Process all collected snapshots
-            for (int i = 0; i < tempSnapshots.size(); i++) {
-                const DataSnapshot& snapshot = tempSnapshots[i];
-                if (snapshot.modbusValid) {
-                    // Extract values for each valid channel from this snapshot
-                    for (int ch : validChannels) {
-                        if (ch < snapshot.modbusData.size()) {
-                            double val = snapshot.modbusData[ch];
-                            channelMeasurements[ch].append(val);
-                        }
-                    }
-                }
+                channels.append({SessionLog::ModbusValue, ch});
             }
+            QVector<int> counts;
+            const QVector<double> averages = averageCollectedValues(channels, &counts);
 
             // Now calculate the average for each channel
-            for (int ch : validChannels) {
-                if (!channelMeasurements[ch].isEmpty()) {
-                    double sum = 0.0;
-                    for (double val : channelMeasurements[ch]) {
-                        sum += val;
-                    }
-                    double average = sum / channelMeasurements[ch].size();
+            for (int i = 0; i < validChannels.size(); ++i) {
+                const int ch = validChannels[i];
+                if (counts[i] > 0) {
+                    double average = averages[i];
 
                     // Add calibration point for this channel
                     channelCalibrationPoints[ch].append(qMakePair(average, standardValue));
                     qDebug() << "[CalibrationDialog] Added calibration point for channel" << ch
                             << "average:" << average << "standard:" << standardValue
-                            << "(from" << channelMeasurements[ch].size() << "samples)";
+                            << "(from" << counts[i] << "samples)";
                 } else {
                     // If no measurements for this channel, use the latest raw value
-                    if (ch < latestRawSnapshot.modbusData.size()) {
-                        double latestVal = latestRawSnapshot.modbusData[ch];
+                    if (ch < latestRawSnapshot->modbusData.size()) {
+                        double latestVal = latestRawSnapshot->modbusData[ch];
                         channelCalibrationPoints[ch].append(qMakePair(latestVal, standardValue));
                         qDebug() << "[CalibrationDialog] Added calibration point for channel" << ch
                                 << "using latest value:" << latestVal << "standard:" << standardValue
@@ -1261,13 +1267,18 @@ void CalibrationDialog::onPointCollectionTimerTimeout()
     } else {
         // 单通道校准模式
         double averageRawValue = 0.0;
-    if (!tempMeasurements.isEmpty()) {
-        double sum = 0.0;
-            for (double val : tempMeasurements) {
-                sum += val;
-        }
-            averageRawValue = sum / tempMeasurements.size();
-            qDebug() << "[CalibrationDialog] Collected" << tempMeasurements.size() << "points, Average raw value:" << averageRawValue;
+        const QString deviceName = getDeviceInternalName(currentDeviceType);
+        SnapshotHistory::Channel channel;
+        channel.kind = deviceName == "DAQ" ? SessionLog::DAQValue
+                     : deviceName == "ECU" ? SessionLog::ECUValue
+                     : deviceName == "Custom" ? SessionLog::CustomValue
+                     : SessionLog::ModbusValue;
+        channel.channel = currentChannelIndex;
+        QVector<int> counts;
+        const QVector<double> averages = averageCollectedValues({channel}, &counts);
+    if (counts[0] > 0) {
+            averageRawValue = averages[0];
+            qDebug() << "[CalibrationDialog] Collected" << counts[0] << "points, Average raw value:" << averageRawValue;
     } else {
             averageRawValue = latestRawValue;
             qDebug() << "[CalibrationDialog] No points collected in 5s, using last raw value:" << averageRawValue;
@@ -70,8 +70,8 @@ private:
 
     // 数据存储和处理
     QVector<QPair<double, double>> calibrationPoints; // 保存校准点 <平均原始值, 标准值>
-    QVector<double> tempMeasurements;   // 临时存储原始数据点以计算平均值
-    QVector<DataSnapshot> tempSnapshots; // 临时存储收集期间的快照数据，用于批量校准
+    std::shared_ptr<const SnapshotHistory> rawHistory; // 原始快照历史，采集结束时按采集区间查询求平均
+    double collectionStartTime = 0.0;   // 本次采集开始时最新原始快照的时间戳（不含）
     QVector<QColor> channelColors;      // 存储不同通道的颜色
     QTimer dataUpdateTimer;             // 定时器，用于定期更新UI（图表和标签）
     QTimer pointCollectionTimer;        // 5秒校准点采集定时器
@@ -89,7 +89,7 @@ private:
     double coef_a, coef_b, coef_c, coef_d; // y = ax³ + bx² + cx + d
 
     // 缓存最新的原始快照数据
-    DataSnapshot latestRawSnapshot;
+    SnapshotHandle latestRawSnapshot;
     int latestSnapshotIndex = -1;
 
     // 温度传感器批量校准相关
@@ -137,7 +137,9 @@ private slots:
     void onConfirmClicked();
 
     // 数据处理和定时器槽
-    void onRawSnapshotReceived(const DataSnapshot &rawSnapshot); // 接收原始快照数据
+    void onRawSnapshotReceived(const SnapshotHandle &rawSnapshot); // 接收原始快照数据
+    // 本次采集区间内各通道原始值的平均值（取自原始快照历史，忽略无效值）；counts为各通道的有效点数
+    QVector<double> averageCollectedValues(const QVector<SnapshotHistory::Channel> &channels, QVector<int> *counts) const;
     void onDataUpdateTimerTimeout();  // 定时更新UI（图表，标签）
     void onPointCollectionTimerTimeout(); // 5秒点采集结束
 };
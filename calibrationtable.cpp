@@ -0,0 +1,268 @@
+#include "calibrationtable.h"
+#include "cpufeatures.h"
+#include <QDebug>
+#include <QFile>
+#include <QStringList>
+#include <QTextCodec>
+#include <algorithm>
+
+namespace {
+
+void hornerScalar(const double *a, const double *b, const double *c, const double *d,
+                  double *values, int begin, int count)
+{
+    for (int i = begin; i < count; ++i) {
+        const double x = values[i];
+        values[i] = ((a[i] * x + b[i]) * x + c[i]) * x + d[i];
+    }
+}
+
+#ifdef SIMD_HAVE_SSE2
+// SSE2：每次校准2个通道
+int hornerSse2(const double *a, const double *b, const double *c, const double *d, double *values, int count)
+{
+    int i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const __m128d x = _mm_loadu_pd(values + i);
+        __m128d y = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(a + i), x), _mm_loadu_pd(b + i));
+        y = _mm_add_pd(_mm_mul_pd(y, x), _mm_loadu_pd(c + i));
+        y = _mm_add_pd(_mm_mul_pd(y, x), _mm_loadu_pd(d + i));
+        _mm_storeu_pd(values + i, y);
+    }
+    return i;
+}
+#endif
+
+#ifdef SIMD_HAVE_X86
+// AVX2/FMA：每次校准4个通道，三次乘加
+SIMD_TARGET_AVX2 int hornerAvx2(const double *a, const double *b, const double *c, const double *d,
+                                double *values, int count)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m256d x = _mm256_loadu_pd(values + i);
+        __m256d y = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), x, _mm256_loadu_pd(b + i));
+        y = _mm256_fmadd_pd(y, x, _mm256_loadu_pd(c + i));
+        y = _mm256_fmadd_pd(y, x, _mm256_loadu_pd(d + i));
+        _mm256_storeu_pd(values + i, y);
+    }
+    return i;
+}
+#endif
+
+} // namespace
+
+CalibrationTable CalibrationTable::compile(const QMap<QString, QMap<int, CalibrationParams>> &params)
+{
+    CalibrationTable table;
+    for (auto it = params.constBegin(); it != params.constEnd(); ++it) {
+        const int source = sourceFromName(it.key());
+        if (source < 0 || it.value().isEmpty()) {
+            continue;
+        }
+
+        // 按最大通道号展开，未配置的通道为y=x
+        const int channels = qMax(0, it.value().lastKey() + 1);
+        Coefficients &coefficients = table.m_coefficients[source];
+        coefficients.a.assign(size_t(channels), 0.0);
+        coefficients.b.assign(size_t(channels), 0.0);
+        coefficients.c.assign(size_t(channels), 1.0);
+        coefficients.d.assign(size_t(channels), 0.0);
+        for (auto channel = it.value().constBegin(); channel != it.value().constEnd(); ++channel) {
+            if (channel.key() < 0) {
+                continue;
+            }
+            const size_t index = size_t(channel.key());
+            coefficients.a[index] = channel.value().a;
+            coefficients.b[index] = channel.value().b;
+            coefficients.c[index] = channel.value().c;
+            coefficients.d[index] = channel.value().d;
+        }
+    }
+    return table;
+}
+
+int CalibrationTable::sourceFromName(const QString &name)
+{
+    if (name == "Modbus") {
+        return Modbus;
+    }
+    if (name == "DAQ") {
+        return DAQ;
+    }
+    if (name == "ECU") {
+        return ECU;
+    }
+    if (name == "Custom") {
+        return Custom;
+    }
+    return -1;
+}
+
+CalibrationParams CalibrationTable::params(Source source, int channel) const
+{
+    CalibrationParams result;
+    const Coefficients &coefficients = m_coefficients[source];
+    if (channel >= 0 && channel < int(coefficients.a.size())) {
+        result.a = coefficients.a[size_t(channel)];
+        result.b = coefficients.b[size_t(channel)];
+        result.c = coefficients.c[size_t(channel)];
+        result.d = coefficients.d[size_t(channel)];
+    }
+    return result;
+}
+
+bool CalibrationTable::isLinear(Source source, int channel) const
+{
+    const Coefficients &coefficients = m_coefficients[source];
+    if (channel < 0 || channel >= int(coefficients.a.size())) {
+        return true;
+    }
+    return coefficients.a[size_t(channel)] == 0.0 && coefficients.b[size_t(channel)] == 0.0;
+}
+
+void CalibrationTable::apply(Source source, double *values, int count) const
+{
+    const Coefficients &coefficients = m_coefficients[source];
+    const int n = qMin(count, int(coefficients.a.size()));
+    if (n <= 0) {
+        return;
+    }
+
+    const double *a = coefficients.a.data();
+    const double *b = coefficients.b.data();
+    const double *c = coefficients.c.data();
+    const double *d = coefficients.d.data();
+    int done = 0;
+#ifdef SIMD_HAVE_X86
+    if (cpuHasAvx2Fma()) {
+        done = hornerAvx2(a, b, c, d, values, n);
+    } else
+#endif
+    {
+#ifdef SIMD_HAVE_SSE2
+        done = hornerSse2(a, b, c, d, values, n);
+#endif
+    }
+    hornerScalar(a, b, c, d, values, done, n);
+}
+
+QMap<QString, QMap<int, CalibrationParams>> CalibrationTable::parseFile(const QString &filePath)
+{
+    QMap<QString, QMap<int, CalibrationParams>> allCalibrationParams;
+    qDebug() << "[CalibrationTable] Attempting to load calibration settings from:" << filePath;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) { // Read as raw bytes
+        qDebug() << "[CalibrationTable] Warning: Cannot open calibration file:" << filePath << file.errorString() << ". Using default calibration (y=x).";
+        return allCalibrationParams;
+    }
+
+    QByteArray fileContent = file.readAll();
+    file.close(); // Close file after reading
+
+    // Get UTF-8 codec
+    QTextCodec *codec = QTextCodec::codecForName("UTF-8");
+    QString contentString;
+    if(codec) {
+        contentString = codec->toUnicode(fileContent);
+        qDebug() << "[CalibrationTable] Read calibration file and converted to Unicode using UTF-8 codec.";
+    } else {
+        qDebug() << "[CalibrationTable] Warning: Could not find UTF-8 codec! Trying Latin1.";
+        // Fallback to Latin1 if UTF-8 is somehow unavailable
+         contentString = QString::fromLatin1(fileContent);
+    }
+
+    QStringList lines = contentString.split('\n', Qt::SkipEmptyParts); // Split content into lines
+
+    QString currentSourceType = "";
+    int lineNum = 0;
+
+    // Process lines
+    for (const QString &rawLine : lines) {
+        lineNum++;
+        QString line = rawLine.trimmed(); // Trim whitespace from each line
+
+        // Skip empty lines and comments (lines starting with ';' or '#')
+        if (line.isEmpty() || line.startsWith(';') || line.startsWith('#')) {
+            continue;
+        }
+
+        // Check for section header
+        if (line.startsWith('[') && line.endsWith(']')) {
+            currentSourceType = line.mid(1, line.length() - 2).trimmed();
+            qDebug() << "[CalibrationTable] Parsing section:" << currentSourceType;
+            continue;
+        }
+
+        // Parse key-value pairs within a section
+        if (!currentSourceType.isEmpty()) {
+            int equalsPos = line.indexOf('=');
+            if (equalsPos != -1) {
+                QString key = line.left(equalsPos).trimmed();
+                QString valueString = line.mid(equalsPos + 1).trimmed();
+
+                // 移除引号（如果存在）
+                if (valueString.startsWith('"') && valueString.endsWith('"')) {
+                    valueString = valueString.mid(1, valueString.length() - 2);
+                }
+
+                // 移除时间戳（如果存在）
+                // 时间戳格式如：; Timestamp: 2023-05-20 14:30:45
+                int timeStampStart = valueString.indexOf(QString("; Timestamp:"));
+                if (timeStampStart != -1) {
+                    valueString = valueString.left(timeStampStart).trimmed();
+                }
+
+                // Remove potential inline comments
+                int commentPos = valueString.indexOf(';');
+                if (commentPos != -1) {
+                    valueString = valueString.left(commentPos).trimmed();
+                }
+                int commentPosHash = valueString.indexOf('#');
+                 if (commentPosHash != -1) {
+                    valueString = valueString.left(commentPosHash).trimmed();
+                }
+
+                 qDebug() << "[CalibrationTable Debug] Reading Key:" << currentSourceType << "/" << key << "Raw Value String:'" << valueString << "'";
+
+                if (key.startsWith("Channel_")) {
+                    bool okIndex;
+                    int channelIndex = key.mid(8).toInt(&okIndex);
+
+                    if (okIndex) {
+                        QStringList coeffStrings = valueString.split(',', Qt::SkipEmptyParts);
+
+                        if (coeffStrings.size() >= 4) { // 至少需要4个系数
+                            bool okA, okB, okC, okD;
+                            CalibrationParams params;
+                            params.a = coeffStrings[0].trimmed().toDouble(&okA);
+                            params.b = coeffStrings[1].trimmed().toDouble(&okB);
+                            params.c = coeffStrings[2].trimmed().toDouble(&okC);
+                            params.d = coeffStrings[3].trimmed().toDouble(&okD);
+
+                            if (okA && okB && okC && okD) {
+                                // Ensure the map for the sourceType exists
+                                if (!allCalibrationParams.contains(currentSourceType)) {
+                                    allCalibrationParams[currentSourceType] = QMap<int, CalibrationParams>();
+                                }
+                                allCalibrationParams[currentSourceType][channelIndex] = params;
+                                qDebug() << "[CalibrationTable] Loaded calibration for" << currentSourceType << "Channel" << channelIndex
+                                         << ": a=" << params.a << ", b=" << params.b << ", c=" << params.c << ", d=" << params.d;
+                            } else {
+                                qDebug() << "[CalibrationTable] Warning: Invalid number format in calibration for" << currentSourceType << key << "at line" << lineNum << ". Using default.";
+                            }
+                        } else {
+                            qDebug() << "[CalibrationTable] Warning: Incorrect number of coefficients for" << currentSourceType << key << "at line" << lineNum << "(found" << coeffStrings.size() << ", expected 4). Using default.";
+                        }
+                    } else {
+                         qDebug() << "[CalibrationTable] Warning: Invalid channel index format for" << currentSourceType << key << "at line" << lineNum << ". Skipping.";
+                    }
+                }
+            }
+        }
+    }
+
+    qDebug() << "[CalibrationTable] Finished loading calibration settings manually.";
+    return allCalibrationParams;
+}
@@ -0,0 +1,61 @@
+#ifndef CALIBRATIONTABLE_H
+#define CALIBRATIONTABLE_H
+
+#include <QMap>
+#include <QString>
+#include <vector>
+
+// 校准参数：y = a*x^3 + b*x^2 + c*x + d
+struct CalibrationParams {
+    double a = 0.0;
+    double b = 0.0;
+    double c = 1.0; // 默认 y=x
+    double d = 0.0;
+};
+
+// 编译后的校准表
+//
+// 把按数据源名称和通道号保存的校准参数展开为每个数据源一组连续的系数数组，
+// 快照线程按数组批量求值（Horner形式，运行时选择AVX2/FMA或SSE2内核），不再逐通道按字符串查找。
+// 构建完成后只读，可在多个线程间共享；重新加载时在后台构建新表后整体替换。
+class CalibrationTable
+{
+public:
+    enum Source {
+        Modbus,
+        DAQ,
+        ECU,
+        Custom,
+        SourceCount
+    };
+
+    // 由按数据源名称（"Modbus"、"DAQ"、"ECU"、"Custom"）分组的参数构建，未知数据源忽略
+    static CalibrationTable compile(const QMap<QString, QMap<int, CalibrationParams>> &params);
+    // 解析校准文件（calibration.ini），文件不存在时返回空表（全部为y=x）。不依赖对象状态，可在任意线程调用
+    static QMap<QString, QMap<int, CalibrationParams>> parseFile(const QString &filePath);
+    // 数据源名称对应的枚举值，未知名称返回-1
+    static int sourceFromName(const QString &name);
+
+    // 指定通道的校准参数，未配置时为y=x
+    CalibrationParams params(Source source, int channel) const;
+    // 指定通道是否为线性校准（a=b=0）
+    bool isLinear(Source source, int channel) const;
+    // 已配置的通道数（最大通道号+1）
+    int channelCount(Source source) const { return int(m_coefficients[source].a.size()); }
+
+    // 原位校准count个通道的值：values[i] = ((a[i]*x + b[i])*x + c[i])*x + d[i]，超出表长的通道保持不变
+    void apply(Source source, double *values, int count) const;
+
+private:
+    // 每个数据源的系数按通道连续存放
+    struct Coefficients {
+        std::vector<double> a;
+        std::vector<double> b;
+        std::vector<double> c;
+        std::vector<double> d;
+    };
+
+    Coefficients m_coefficients[SourceCount];
+};
+
+#endif // CALIBRATIONTABLE_H
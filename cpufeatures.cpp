@@ -0,0 +1,41 @@
+#include "cpufeatures.h"
+
+#if defined(SIMD_HAVE_X86) && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace {
+
+bool detectAvx2Fma()
+{
+#if defined(SIMD_HAVE_X86) && defined(_MSC_VER) && !defined(__clang__)
+    int info[4] = {0, 0, 0, 0};
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    // 操作系统必须保存YMM寄存器状态
+    if (!osxsave || !avx || !fma || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(SIMD_HAVE_X86)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
+bool cpuHasAvx2Fma()
+{
+    static const bool supported = detectAvx2Fma();
+    return supported;
+}
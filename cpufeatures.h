@@ -0,0 +1,27 @@
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+// SIMD编译宏与运行时CPU特性检测
+//
+// 各数值内核在同一个可执行文件中同时编译SSE2基线版本和AVX2/FMA版本，
+// 运行时通过cpuHasAvx2Fma()选择，无需为整个工程打开/arch:AVX2。
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_HAVE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+// MSVC无需/arch即可使用AVX2内建函数
+#define SIMD_TARGET_AVX2
+#else
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_HAVE_SSE2 1
+#endif
+
+// 当前CPU与操作系统是否支持AVX2和FMA（结果在首次调用时缓存）
+bool cpuHasAvx2Fma();
+
+#endif // CPUFEATURES_H
@@ -0,0 +1,142 @@
+// DAQ采集管线基准测试
+//
+// 使用模拟设备驱动完整的采集管线（设备回调线程 -> 环形缓冲区 -> DAQ线程 -> 数据块信号），
+// 无需硬件即可在Linux上测量吞吐量、丢块/溢出和端到端延迟。
+// 延迟定义为：收到数据块的时刻 - 块内最后一个样本的理论采集时刻（仅实时模式有意义）。
+//
+// 示例：daqbench --channels 16 --rate 50000 --block 1000 --seconds 10 --filter
+//       daqbench --devices 4 --channels 16 --rate 100000   （4个同步设备合并为64通道）
+#include "daqthread.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <vector>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("daqbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("使用模拟设备测试DAQ采集管线的吞吐量和延迟");
+    parser.addHelpOption();
+    QCommandLineOption channelsOption("channels", "每个设备的通道数", "n", "8");
+    QCommandLineOption devicesOption("devices", "模拟设备数（多设备时共享开始触发并合并通道）", "n", "1");
+    QCommandLineOption rateOption("rate", "每通道采样率（Hz）", "hz", "10000");
+    QCommandLineOption blockOption("block", "每次回调的扫描数", "n", "1000");
+    QCommandLineOption secondsOption("seconds", "运行时间（秒）", "s", "5");
+    QCommandLineOption ringOption("ring", "环形缓冲区容量（数据块个数）", "n", "64");
+    QCommandLineOption rawOption("raw", "使用原始int16模式");
+    QCommandLineOption filterOption("filter", "启用FIR低通滤波");
+    QCommandLineOption freeRunOption("free-run", "不按采样率节拍，尽快产生数据（测量最大吞吐量）");
+    parser.addOptions({channelsOption, devicesOption, rateOption, blockOption, secondsOption, ringOption,
+                       rawOption, filterOption, freeRunOption});
+    parser.process(app);
+
+    const int channelsPerDevice = qMax(1, parser.value(channelsOption).toInt());
+    const int deviceCount = qMax(1, parser.value(devicesOption).toInt());
+    const int channels = channelsPerDevice * deviceCount;
+    const double rate = qMax(1.0, parser.value(rateOption).toDouble());
+    const int block = qMax(1, parser.value(blockOption).toInt());
+    const double seconds = qMax(0.1, parser.value(secondsOption).toDouble());
+    const bool freeRun = parser.isSet(freeRunOption);
+
+    QStringList channelList;
+    for (int ch = 0; ch < channelsPerDevice; ++ch) {
+        channelList.append(QString::number(ch));
+    }
+    QStringList deviceList;
+    for (int i = 1; i <= deviceCount; ++i) {
+        deviceList.append(QString("Sim%1").arg(i));
+    }
+
+    QThread daqThread;
+    DAQThread *daq = new DAQThread;
+    daq->moveToThread(&daqThread);
+    QObject::connect(&daqThread, &QThread::finished, daq, &QObject::deleteLater);
+    daqThread.start();
+
+    // 统计（在主线程中更新）
+    QElapsedTimer clock;
+    quint64 blocks = 0;
+    quint64 lostBlocks = 0;
+    quint64 nextSequence = 0;
+    qint64 samples = 0;
+    quint64 overruns = 0;
+    std::vector<double> latencies;
+    latencies.reserve(size_t(seconds * rate / block) + 16);
+
+    QObject::connect(daq, &DAQThread::dataBlockReady, &app, [&](const DAQDataBlock &data) {
+        if (data.sequence != nextSequence) {
+            lostBlocks += data.sequence - nextSequence;
+        }
+        nextSequence = data.sequence + 1;
+        ++blocks;
+        samples += data.samplesPerChannel;
+        const double acquiredMs = (data.firstSampleIndex + data.samplesPerChannel) * 1000.0 / data.sampleRate;
+        latencies.push_back(clock.nsecsElapsed() / 1e6 - acquiredMs);
+    });
+    QObject::connect(daq, &DAQThread::ringStatistics, &app,
+                     [&](quint64 ringOverruns, quint64, int, int) { overruns = ringOverruns; });
+    QObject::connect(daq, &DAQThread::error, &app, [&](const QString &message) {
+        qCritical().noquote() << "错误:" << message;
+        app.exit(1);
+    });
+    QObject::connect(daq, &DAQThread::acquisitionStatus, &app, [&](bool running, const QString &) {
+        if (running) {
+            clock.start();
+            QTimer::singleShot(int(seconds * 1000), &app, [&]() { daq->stopAcquisition(); });
+        } else if (clock.isValid()) {
+            app.quit();
+        }
+    });
+
+    // 在DAQ线程中完成配置后开始采集
+    const int ringCapacity = parser.value(ringOption).toInt();
+    const bool rawMode = parser.isSet(rawOption);
+    const bool filter = parser.isSet(filterOption);
+    QMetaObject::invokeMethod(daq, [=]() {
+        daq->setRingCapacity(ringCapacity);
+        daq->setRawModeEnabled(rawMode);
+        daq->setSimulationRealTime(!freeRun);
+        daq->initDAQ(deviceList.join(","), channelList.join("/"), rate, block);
+        daq->setFilterEnabled(filter);
+        daq->startAcquisition();
+    }, Qt::QueuedConnection);
+
+    const int result = app.exec();
+    const double elapsed = clock.isValid() ? clock.nsecsElapsed() / 1e9 : 0.0;
+
+    daqThread.quit();
+    daqThread.wait();
+
+    if (result != 0) {
+        return result;
+    }
+
+    qInfo().noquote() << QString("设备 %1，通道 %2，采样率 %3 Hz，块大小 %4，%5%6%7")
+                             .arg(deviceCount).arg(channels).arg(rate).arg(block)
+                             .arg(rawMode ? "原始int16" : "float64")
+                             .arg(filter ? "，FIR滤波" : "")
+                             .arg(freeRun ? "，不限速" : "");
+    qInfo().noquote() << QString("运行 %1 s：%2 个数据块，%3 样本/通道，%4 M样本/s（全部通道）")
+                             .arg(elapsed, 0, 'f', 2).arg(blocks).arg(samples)
+                             .arg(elapsed > 0.0 ? samples * double(channels) / elapsed / 1e6 : 0.0, 0, 'f', 2);
+    qInfo().noquote() << QString("丢失数据块 %1，环形缓冲区溢出 %2").arg(lostBlocks).arg(overruns);
+
+    if (!freeRun && !latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&](double p) {
+            return latencies[std::min(latencies.size() - 1, size_t(p * (latencies.size() - 1) + 0.5))];
+        };
+        qInfo().noquote() << QString("延迟（ms）：p50 %1，p99 %2，最大 %3")
+                                 .arg(percentile(0.5), 0, 'f', 3)
+                                 .arg(percentile(0.99), 0, 'f', 3)
+                                 .arg(latencies.back(), 0, 'f', 3);
+    }
+    return 0;
+}
@@ -0,0 +1,26 @@
+#include "daqdevice.h"
+#include "simulateddaqdevice.h"
+#ifdef HAVE_ARTDAQ
+#include "artdaqdevice.h"
+#endif
+
+bool hasArtDAQBackend()
+{
+#ifdef HAVE_ARTDAQ
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::unique_ptr<DAQDevice> createDAQDevice(const QString &deviceName)
+{
+    if (deviceName.startsWith("Sim", Qt::CaseInsensitive)) {
+        return std::make_unique<SimulatedDAQDevice>();
+    }
+#ifdef HAVE_ARTDAQ
+    return std::make_unique<ArtDAQDevice>();
+#else
+    return nullptr;
+#endif
+}
@@ -0,0 +1,76 @@
+#ifndef DAQDEVICE_H
+#define DAQDEVICE_H
+
+#include <QString>
+#include <QVector>
+#include <cstdint>
+#include <memory>
+
+// 多设备同步中的角色
+enum class DAQSyncRole {
+    Standalone,     // 独立运行，使用板载采样时钟、软件启动
+    Master,         // 主设备：导出开始触发（和采样时钟），最后启动
+    Slave           // 从设备：等待主设备的开始触发（并使用其采样时钟），先于主设备启动
+};
+
+// 采集设备配置
+struct DAQDeviceConfig {
+    QString deviceName;             // 设备名称，如"Dev1"；以"Sim"开头时使用模拟设备
+    QVector<int> channels;          // 物理通道号
+    double sampleRate = 10000.0;    // 每通道采样率（Hz）
+    int samplesPerChannel = 1000;   // 每次回调的扫描数
+    double rangeMin = -10.0;        // 输入量程（V）
+    double rangeMax = 10.0;
+
+    // 多设备同步（终端名称带设备前缀，如"/Dev1/PFI0"）
+    DAQSyncRole syncRole = DAQSyncRole::Standalone;
+    QString startTriggerTerminal;   // 主设备：开始触发的导出终端；从设备：开始触发源
+    QString sampleClockTerminal;    // 主设备：采样时钟的导出终端；从设备：外部采样时钟源。为空时各自使用板载时钟
+};
+
+// 采集设备后端接口
+//
+// 与ArtDAQ驱动的回调模型一致：设备在自己的线程中每采满samplesPerChannel次扫描调用一次
+// SamplesCallback，回调内部再调用readAnalog/readBinary把数据读入调用方提供的缓冲区（按扫描分组交错存储）。
+// 回调运行在设备线程上，不应使用Qt事件循环。stop()返回后不会再有回调。
+class DAQDevice
+{
+public:
+    // nSamples为本次可读取的扫描数
+    using SamplesCallback = void (*)(void *context, int nSamples);
+    // status < 0 表示任务异常终止，message为错误说明
+    using DoneCallback = void (*)(void *context, int status, const char *message);
+
+    virtual ~DAQDevice() = default;
+
+    // 后端名称，用于日志
+    virtual QString backendName() const = 0;
+
+    // 创建任务并配置通道与采样时钟，失败时返回false并设置lastError()
+    virtual bool configure(const DAQDeviceConfig &config) = 0;
+    // 注册回调并开始采集
+    virtual bool start(SamplesCallback samplesCallback, DoneCallback doneCallback, void *context) = 0;
+    // 停止并清理任务
+    virtual void stop() = 0;
+
+    // 在SamplesCallback中调用：读取至多scans次扫描，返回值<0表示失败
+    virtual int readAnalog(int scans, double *buffer, std::uint32_t bufferSize, int *scansRead) = 0;
+    virtual int readBinary(int scans, std::int16_t *buffer, std::uint32_t bufferSize, int *scansRead) = 0;
+
+    // 配置后查询指定通道（按config.channels中的序号）的实际量程
+    virtual bool channelRange(int index, double *minValue, double *maxValue) = 0;
+
+    QString lastError() const { return m_lastError; }
+
+protected:
+    QString m_lastError;
+};
+
+// 按设备名称创建后端：以"Sim"开头（不区分大小写）使用模拟设备，否则使用ArtDAQ硬件；
+// 当前平台不支持硬件时返回nullptr
+std::unique_ptr<DAQDevice> createDAQDevice(const QString &deviceName);
+
+// 当前构建是否包含ArtDAQ硬件后端
+bool hasArtDAQBackend();
+
+#endif // DAQDEVICE_H
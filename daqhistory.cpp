@@ -0,0 +1,240 @@
+#include "daqhistory.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <new>
+
+void HistorySpan::copyTo(double *out) const
+{
+    if (firstCount > 0) {
+        std::memcpy(out, first, firstCount * sizeof(double));
+    }
+    if (secondCount > 0) {
+        std::memcpy(out + firstCount, second, secondCount * sizeof(double));
+    }
+}
+
+DAQHistoryStore::DAQHistoryStore()
+    : m_channels(0)
+    , m_capacity(0)
+    , m_mask(0)
+    , m_slack(0)
+    , m_sampleRate(0.0)
+    , m_start(0)
+    , m_end(0)
+    , m_started(false)
+    , m_writeIndex(0)
+    , m_writeCount(0)
+{
+}
+
+bool DAQHistoryStore::allocate(int channels, std::size_t historySamples, std::size_t maxBlockSize, double sampleRate)
+{
+    release();
+    if (channels <= 0 || historySamples == 0 || maxBlockSize == 0) {
+        return false;
+    }
+
+    std::size_t capacity = 1;
+    while (capacity < historySamples + maxBlockSize) {
+        capacity <<= 1;
+    }
+
+    try {
+        m_storage.assign(capacity * std::size_t(channels), 0.0);
+    } catch (const std::bad_alloc &) {
+        m_storage.clear();
+        return false;
+    }
+
+    m_channels = channels;
+    m_capacity = capacity;
+    m_mask = capacity - 1;
+    m_slack = maxBlockSize;
+    m_sampleRate = sampleRate;
+    reset();
+    return true;
+}
+
+void DAQHistoryStore::release()
+{
+    std::vector<double>().swap(m_storage);
+    m_channels = 0;
+    m_capacity = 0;
+    m_mask = 0;
+    m_slack = 0;
+    reset();
+}
+
+void DAQHistoryStore::reset()
+{
+    m_start.store(0, std::memory_order_relaxed);
+    m_end.store(0, std::memory_order_release);
+    m_started = false;
+    m_writeIndex = 0;
+    m_writeCount = 0;
+}
+
+bool DAQHistoryStore::beginWrite(std::int64_t firstSampleIndex, int count)
+{
+    m_writeCount = 0;
+    if (m_capacity == 0 || count <= 0 || std::size_t(count) > m_slack) {
+        return false;
+    }
+
+    if (!m_started) {
+        m_started = true;
+        m_start.store(firstSampleIndex, std::memory_order_relaxed);
+        m_end.store(firstSampleIndex, std::memory_order_release);
+    }
+
+    std::int64_t end = m_end.load(std::memory_order_relaxed);
+    if (firstSampleIndex < end) {
+        return false;
+    }
+
+    std::int64_t gap = firstSampleIndex - end;
+    if (gap >= std::int64_t(historyLength())) {
+        // 空缺超过整个历史长度：直接从新位置重新开始
+        m_start.store(firstSampleIndex, std::memory_order_relaxed);
+        m_end.store(firstSampleIndex, std::memory_order_release);
+    } else {
+        // 丢块造成的空缺填NaN（绘图时显示为断开），每次最多填一个写入余量后发布，保证读者视图有效
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        while (gap > 0) {
+            const std::int64_t chunk = std::min<std::int64_t>(gap, std::int64_t(m_slack));
+            for (std::int64_t i = end; i < end + chunk; ++i) {
+                const std::size_t pos = std::size_t(i) & m_mask;
+                for (int ch = 0; ch < m_channels; ++ch) {
+                    row(ch)[pos] = nan;
+                }
+            }
+            end += chunk;
+            gap -= chunk;
+            m_end.store(end, std::memory_order_release);
+        }
+    }
+
+    m_writeIndex = firstSampleIndex;
+    m_writeCount = count;
+    return true;
+}
+
+void DAQHistoryStore::writeChannel(int channel, const double *samples)
+{
+    if (m_writeCount <= 0 || channel < 0 || channel >= m_channels) {
+        return;
+    }
+    const std::size_t pos = std::size_t(m_writeIndex) & m_mask;
+    const std::size_t firstCount = std::min(std::size_t(m_writeCount), m_capacity - pos);
+    double *dst = row(channel);
+    std::memcpy(dst + pos, samples, firstCount * sizeof(double));
+    if (firstCount < std::size_t(m_writeCount)) {
+        std::memcpy(dst, samples + firstCount, (std::size_t(m_writeCount) - firstCount) * sizeof(double));
+    }
+}
+
+void DAQHistoryStore::commitWrite()
+{
+    if (m_writeCount <= 0) {
+        return;
+    }
+    m_end.store(m_writeIndex + m_writeCount, std::memory_order_release);
+    m_writeCount = 0;
+}
+
+std::int64_t DAQHistoryStore::beginIndex() const
+{
+    const std::int64_t end = m_end.load(std::memory_order_acquire);
+    const std::int64_t start = m_start.load(std::memory_order_relaxed);
+    return std::max(start, end - std::int64_t(historyLength()));
+}
+
+HistorySpan DAQHistoryStore::span(int channel, std::int64_t from, std::int64_t to) const
+{
+    HistorySpan result;
+    if (channel < 0 || channel >= m_channels) {
+        return result;
+    }
+
+    const std::int64_t end = m_end.load(std::memory_order_acquire);
+    const std::int64_t begin = std::max(m_start.load(std::memory_order_relaxed), end - std::int64_t(historyLength()));
+    from = std::max(from, begin);
+    to = std::min(to, end);
+    if (to <= from) {
+        return result;
+    }
+
+    const std::size_t count = std::size_t(to - from);
+    const std::size_t pos = std::size_t(from) & m_mask;
+    const double *base = row(channel);
+    result.firstSampleIndex = from;
+    result.first = base + pos;
+    result.firstCount = std::min(count, m_capacity - pos);
+    if (result.firstCount < count) {
+        result.second = base;
+        result.secondCount = count - result.firstCount;
+    }
+    return result;
+}
+
+HistorySpan DAQHistoryStore::latest(int channel, std::size_t count) const
+{
+    const std::int64_t end = endIndex();
+    return span(channel, end - std::int64_t(count), end);
+}
+
+std::size_t DAQHistoryStore::envelope(int channel, std::int64_t from, std::int64_t to, std::size_t maxPoints,
+                                      std::int64_t *indices, double *values) const
+{
+    const HistorySpan view = span(channel, from, to);
+    const std::size_t count = view.size();
+    if (count == 0 || maxPoints == 0) {
+        return 0;
+    }
+
+    std::size_t points = 0;
+    if (count <= maxPoints) {
+        for (std::size_t i = 0; i < count; ++i) {
+            indices[i] = view.firstSampleIndex + std::int64_t(i);
+            values[i] = view[i];
+        }
+        points = count;
+    } else {
+        // 最小/最大值抽取：每个区间输出两个点，丢块填充的NaN不参与比较
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        const std::size_t buckets = std::max<std::size_t>(1, maxPoints / 2);
+        for (std::size_t b = 0; b < buckets; ++b) {
+            const std::size_t i0 = count * b / buckets;
+            const std::size_t i1 = count * (b + 1) / buckets;
+            double minValue = nan;
+            double maxValue = nan;
+            std::size_t minPos = 0;
+            std::size_t maxPos = 0;
+            bool found = false;
+            for (std::size_t i = i0; i < i1; ++i) {
+                const double v = view[i];
+                if (v != v) {
+                    continue;
+                }
+                if (!found || v < minValue) {
+                    minValue = v;
+                    minPos = i;
+                }
+                if (!found || v > maxValue) {
+                    maxValue = v;
+                    maxPos = i;
+                }
+                found = true;
+            }
+            indices[points] = view.firstSampleIndex + std::int64_t(i0);
+            indices[points + 1] = view.firstSampleIndex + std::int64_t(i1 - 1);
+            values[points] = minPos <= maxPos ? minValue : maxValue;
+            values[points + 1] = minPos <= maxPos ? maxValue : minValue;
+            points += 2;
+        }
+    }
+    // 读取期间写者可能已覆盖视图起点（seqlock方式确认）
+    return isReadable(view.firstSampleIndex) ? points : 0;
+}
@@ -0,0 +1,101 @@
+#ifndef DAQHISTORY_H
+#define DAQHISTORY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 历史样本的零拷贝视图：环形回绕时由两段连续内存组成
+struct HistorySpan {
+    const double *first = nullptr;
+    std::size_t firstCount = 0;
+    const double *second = nullptr;
+    std::size_t secondCount = 0;
+    std::int64_t firstSampleIndex = 0;   // 视图中第一个样本的全局样本序号
+
+    std::size_t size() const { return firstCount + secondCount; }
+    bool isEmpty() const { return size() == 0; }
+    double operator[](std::size_t i) const { return i < firstCount ? first[i] : second[i - firstCount]; }
+    double last() const { return secondCount > 0 ? second[secondCount - 1] : first[firstCount - 1]; }
+    // 复制到连续缓冲区，out至少容纳size()个值
+    void copyTo(double *out) const;
+};
+
+// 通道优先的DAQ历史样本存储
+//
+// 每个通道一段容量为2的幂的环形区域（所有通道位于同一块连续内存），按全局样本序号寻址，
+// 追加一个数据块的开销只与块大小有关，与历史长度无关，可以保存数分钟的全速率数据。
+// 单写者（DAQ线程或快照线程）、多读者：写者先写入样本再发布结束序号（release），
+// 读者只能访问距写入位置至少一个最大块的样本，因此在下一块写入期间视图仍然有效；
+// 读取耗时较长时可在读完后调用isReadable()确认数据未被覆盖（seqlock方式）。
+class DAQHistoryStore
+{
+public:
+    DAQHistoryStore();
+
+    DAQHistoryStore(const DAQHistoryStore &) = delete;
+    DAQHistoryStore &operator=(const DAQHistoryStore &) = delete;
+
+    // 分配存储（非实时路径调用）。容量向上取整为2的幂，并额外预留maxBlockSize作为写入余量
+    bool allocate(int channels, std::size_t historySamples, std::size_t maxBlockSize, double sampleRate);
+    // 释放存储
+    void release();
+    // 清空历史（仅在没有读者时调用）
+    void reset();
+
+    int channelCount() const { return m_channels; }
+    std::size_t capacity() const { return m_capacity; }
+    // 可读取的历史长度（每通道样本数）
+    std::size_t historyLength() const { return m_capacity - m_slack; }
+    std::size_t maxBlockSize() const { return m_slack; }
+    double sampleRate() const { return m_sampleRate; }
+
+    // ---- 写端（单写者）----
+    // 开始写入一个数据块。样本序号不连续（丢块）时空缺部分填NaN；块超过maxBlockSize时返回false
+    bool beginWrite(std::int64_t firstSampleIndex, int count);
+    // 写入一个通道的count个样本（count由beginWrite指定）
+    void writeChannel(int channel, const double *samples);
+    // 发布已写入的数据块
+    void commitWrite();
+
+    // ---- 读端 ----
+    // 已发布样本的结束序号（不含）
+    std::int64_t endIndex() const { return m_end.load(std::memory_order_acquire); }
+    // 当前可读取的最早样本序号
+    std::int64_t beginIndex() const;
+    // 可读取的样本数
+    std::size_t size() const { return std::size_t(endIndex() - beginIndex()); }
+    // 样本序号[from, to)与可读范围的交集
+    HistorySpan span(int channel, std::int64_t from, std::int64_t to) const;
+    // 最近count个样本
+    HistorySpan latest(int channel, std::size_t count) const;
+    // 序号from之后的样本是否仍未被覆盖
+    bool isReadable(std::int64_t from) const { return from >= beginIndex(); }
+    // 一个通道样本序号[from, to)的绘图点。样本数超过maxPoints时按样本数等分为maxPoints/2个区间，
+    // 每个区间输出两个点（区间首尾样本的序号），取区间内的最小值和最大值并按出现的先后顺序排列，峰值不会丢失；
+    // 否则原样输出。indices和values至少容纳maxPoints个值，返回输出的点数；读取期间数据被覆盖时返回0
+    std::size_t envelope(int channel, std::int64_t from, std::int64_t to, std::size_t maxPoints,
+                         std::int64_t *indices, double *values) const;
+    // 样本序号对应的时间（秒，从开始采集算起）
+    double timeOf(std::int64_t sampleIndex) const { return m_sampleRate > 0.0 ? sampleIndex / m_sampleRate : 0.0; }
+
+private:
+    double *row(int channel) { return m_storage.data() + std::size_t(channel) * m_capacity; }
+    const double *row(int channel) const { return m_storage.data() + std::size_t(channel) * m_capacity; }
+
+    std::vector<double> m_storage;   // [通道][容量]
+    int m_channels;
+    std::size_t m_capacity;
+    std::size_t m_mask;
+    std::size_t m_slack;
+    double m_sampleRate;
+
+    std::atomic<std::int64_t> m_start;   // 本轮第一个样本的序号
+    std::atomic<std::int64_t> m_end;     // 已发布样本的结束序号
+    bool m_started;
+    std::int64_t m_writeIndex;           // 正在写入的数据块的第一个样本序号
+    int m_writeCount;                    // 正在写入的数据块的样本数
+};
+
+#endif // DAQHISTORY_H
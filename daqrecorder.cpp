@@ -0,0 +1,444 @@
+#include "daqrecorder.h"
+#include "samplescaling.h"
+#include <QDateTime>
+#include <QDir>
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const char FileMagic[8] = {'D', 'A', 'Q', 'R', 'E', 'C', '1', '\0'};
+const char IndexMagic[8] = {'D', 'A', 'Q', 'I', 'D', 'X', '1', '\0'};
+const quint32 ChunkMagic = 0x4B4E4843;   // "CHNK"
+const quint32 FileVersion = 1;
+const quint32 FormatInt16 = 1;
+const quint32 FormatFloat64 = 2;
+const qint64 HeaderPatchOffset = 48;     // 块索引偏移、块数、样本总数在文件头中的位置
+
+template <typename T>
+void appendLE(QByteArray &out, T value)
+{
+    const T le = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&le), sizeof(T));
+}
+
+void appendF64(QByteArray &out, double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    appendLE<quint64>(out, bits);
+}
+
+} // namespace
+
+DAQRecorder::DAQRecorder(QObject *parent)
+    : QThread(parent)
+    , m_queuedBytes(0)
+    , m_queueLimit(256ll << 20)
+    , m_stopRequested(false)
+    , m_recording(false)
+    , m_blocksDropped(0)
+    , m_fileOpen(false)
+    , m_channels(0)
+    , m_sampleRate(0.0)
+    , m_rawFormat(false)
+    , m_startSampleIndex(0)
+    , m_samplesWritten(0)
+    , m_bytesWritten(0)
+    , m_chunkBytes(4ll << 20)
+    , m_chunkSamples(0)
+    , m_chunkFilled(0)
+    , m_chunkFirstSample(0)
+    , m_statsBytes(0)
+{
+}
+
+DAQRecorder::~DAQRecorder()
+{
+    stopThread();
+}
+
+void DAQRecorder::setQueueLimit(qint64 bytes)
+{
+    QMutexLocker locker(&m_queueMutex);
+    m_queueLimit = qMax<qint64>(1 << 20, bytes);
+}
+
+void DAQRecorder::setChunkBytes(qint64 bytes)
+{
+    // 下一个文件生效
+    QMutexLocker locker(&m_queueMutex);
+    m_chunkBytes = qMax<qint64>(64 << 10, bytes);
+}
+
+void DAQRecorder::stopThread()
+{
+    {
+        QMutexLocker locker(&m_queueMutex);
+        m_stopRequested = true;
+        m_queueCondition.wakeAll();
+    }
+    if (isRunning()) {
+        wait();
+    }
+}
+
+void DAQRecorder::startRecording(const QString &directory, const QString &description)
+{
+    QueueItem item;
+    item.kind = QueueItem::Start;
+    item.directory = directory;
+    item.description = description;
+
+    QMutexLocker locker(&m_queueMutex);
+    m_recording.store(true, std::memory_order_release);
+    m_blocksDropped.store(0, std::memory_order_relaxed);
+    m_queue.append(item);
+    m_queueCondition.wakeAll();
+}
+
+void DAQRecorder::stopRecording()
+{
+    QueueItem item;
+    item.kind = QueueItem::Stop;
+
+    QMutexLocker locker(&m_queueMutex);
+    m_recording.store(false, std::memory_order_release);
+    m_queue.append(item);
+    m_queueCondition.wakeAll();
+}
+
+qint64 DAQRecorder::blockBytes(const DAQDataBlock &block)
+{
+    return block.isRaw() ? qint64(block.rawSamples.size()) * qint64(sizeof(qint16))
+                         : qint64(block.samples.size()) * qint64(sizeof(double));
+}
+
+// 运行在DAQ线程：只入队，不复制样本，队列满时丢弃
+void DAQRecorder::enqueueBlock(const DAQDataBlock &block)
+{
+    if (!m_recording.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    QueueItem item;
+    item.kind = QueueItem::Block;
+    item.block = block;
+    item.bytes = blockBytes(block);
+
+    QMutexLocker locker(&m_queueMutex);
+    if (m_queuedBytes + item.bytes > m_queueLimit) {
+        m_blocksDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    m_queuedBytes += item.bytes;
+    m_queue.append(item);
+    m_queueCondition.wakeAll();
+}
+
+void DAQRecorder::run()
+{
+    qDebug() << "[DAQRecorder] 记录线程已启动";
+    bool armed = false;   // 收到Start后、Stop前写入数据块
+    m_statsTimer.start();
+    m_statsBytes = 0;
+
+    forever {
+        QList<QueueItem> items;
+        {
+            QMutexLocker locker(&m_queueMutex);
+            if (m_queue.isEmpty() && !m_stopRequested) {
+                m_queueCondition.wait(&m_queueMutex, 500);
+            }
+            if (m_stopRequested && m_queue.isEmpty()) {
+                break;
+            }
+            items.swap(m_queue);
+        }
+
+        qint64 processedBytes = 0;
+        for (const QueueItem &item : items) {
+            try {
+                switch (item.kind) {
+                case QueueItem::Start:
+                    closeFile();
+                    m_directory = item.directory;
+                    m_description = item.description;
+                    armed = true;
+                    break;
+                case QueueItem::Stop:
+                    closeFile();
+                    armed = false;
+                    break;
+                case QueueItem::Block:
+                    processedBytes += item.bytes;
+                    if (armed) {
+                        processBlock(item.block);
+                    }
+                    break;
+                }
+            } catch (const std::exception &e) {
+                qDebug() << "[DAQRecorder] 处理数据块时出错:" << e.what();
+            }
+        }
+
+        qint64 queuedBytes = 0;
+        {
+            QMutexLocker locker(&m_queueMutex);
+            m_queuedBytes -= processedBytes;
+            queuedBytes = m_queuedBytes;
+        }
+
+        // 约每秒报告一次状态
+        if (m_statsTimer.elapsed() >= 1000) {
+            const double seconds = m_statsTimer.restart() / 1000.0;
+            emit recorderStatistics(m_blocksDropped.load(std::memory_order_relaxed), queuedBytes,
+                                    m_statsBytes / seconds / 1e6);
+            m_statsBytes = 0;
+        }
+    }
+
+    closeFile();
+    qDebug() << "[DAQRecorder] 记录线程已停止";
+}
+
+void DAQRecorder::processBlock(const DAQDataBlock &block)
+{
+    const int n = block.samplesPerChannel;
+    if (block.numChannels <= 0 || n <= 0) {
+        return;
+    }
+
+    // 新一轮采集或数据格式变化时开始新文件
+    if (m_fileOpen && ((block.sequence == 0 && m_samplesWritten + m_chunkFilled > 0)
+                       || block.numChannels != m_channels || block.sampleRate != m_sampleRate)) {
+        closeFile();
+    }
+    if (!m_fileOpen && !openFile(block)) {
+        return;
+    }
+
+    // 样本序号不连续（丢块）时结束当前数据块
+    if (m_chunkFilled > 0 && block.firstSampleIndex != m_chunkFirstSample + m_chunkFilled) {
+        flushChunk();
+    }
+
+    const int bytesPerSample = m_rawFormat ? int(sizeof(qint16)) : int(sizeof(double));
+    int offset = 0;
+    while (offset < n && m_fileOpen) {
+        if (m_chunkFilled == 0) {
+            m_chunkFirstSample = block.firstSampleIndex + offset;
+        }
+        const int count = qMin(n - offset, m_chunkSamples - m_chunkFilled);
+
+        for (int ch = 0; ch < m_channels; ++ch) {
+            char *row = m_chunkBuffer.data() + (qint64(ch) * m_chunkSamples + m_chunkFilled) * bytesPerSample;
+            if (m_rawFormat) {
+                qint16 *dst = reinterpret_cast<qint16 *>(row);
+                if (block.isRaw()) {
+                    std::memcpy(dst, block.rawChannel(ch) + offset, size_t(count) * sizeof(qint16));
+                } else {
+                    // 文件为码值格式但数据块已换算为电压（如中途启用了滤波器）：按文件头系数重新量化
+                    const double *src = block.channel(ch) + offset;
+                    const double inverse = 1.0 / m_scale[ch];
+                    for (int i = 0; i < count; ++i) {
+                        const double code = std::round((src[i] - m_offset[ch]) * inverse);
+                        dst[i] = qint16(qBound(-32768.0, code, 32767.0));
+                    }
+                }
+            } else {
+                double *dst = reinterpret_cast<double *>(row);
+                if (block.isRaw()) {
+                    convertInt16ToVolts(block.rawChannel(ch) + offset, count, block.rawScale.value(ch, 1.0),
+                                        block.rawOffset.value(ch, 0.0), dst);
+                } else {
+                    std::memcpy(dst, block.channel(ch) + offset, size_t(count) * sizeof(double));
+                }
+            }
+        }
+
+        m_chunkFilled += count;
+        offset += count;
+        if (m_chunkFilled == m_chunkSamples) {
+            flushChunk();
+        }
+    }
+}
+
+bool DAQRecorder::openFile(const DAQDataBlock &block)
+{
+    QDir dir(m_directory.isEmpty() ? QDir::currentPath() : m_directory);
+    if (!dir.exists() && !dir.mkpath(".")) {
+        emit recordingError(QString("无法创建记录目录: %1").arg(dir.path()));
+        return false;
+    }
+
+    const QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
+    m_file.setFileName(dir.filePath(timestamp + ".daqrec"));
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        emit recordingError(QString("无法打开记录文件: %1 (%2)").arg(m_file.fileName(), m_file.errorString()));
+        return false;
+    }
+
+    m_channels = block.numChannels;
+    m_sampleRate = block.sampleRate;
+    m_rawFormat = block.isRaw();
+    m_scale.fill(1.0, m_channels);
+    m_offset.fill(0.0, m_channels);
+    if (m_rawFormat) {
+        for (int ch = 0; ch < m_channels; ++ch) {
+            m_scale[ch] = block.rawScale.value(ch, 1.0);
+            m_offset[ch] = block.rawOffset.value(ch, 0.0);
+        }
+    }
+    m_startSampleIndex = block.firstSampleIndex;
+    m_samplesWritten = 0;
+    m_bytesWritten = 0;
+    m_index.clear();
+
+    qint64 chunkBytes = 0;
+    {
+        QMutexLocker locker(&m_queueMutex);
+        chunkBytes = m_chunkBytes;
+    }
+    const int bytesPerSample = m_rawFormat ? int(sizeof(qint16)) : int(sizeof(double));
+    m_chunkSamples = int(qMax<qint64>(1, chunkBytes / (qint64(m_channels) * bytesPerSample)));
+    m_chunkBuffer.resize(qint64(m_channels) * m_chunkSamples * bytesPerSample);
+    m_chunkFilled = 0;
+    m_chunkFirstSample = m_startSampleIndex;
+
+    // 文件头
+    const QByteArray description = m_description.toUtf8();
+    QByteArray header;
+    header.append(FileMagic, sizeof(FileMagic));
+    appendLE<quint32>(header, FileVersion);
+    appendLE<quint32>(header, 0);                        // 文件头长度，稍后填写
+    appendLE<quint32>(header, quint32(m_channels));
+    appendLE<quint32>(header, m_rawFormat ? FormatInt16 : FormatFloat64);
+    appendF64(header, m_sampleRate);
+    appendLE<qint64>(header, m_startSampleIndex);
+    appendLE<qint64>(header, QDateTime::currentMSecsSinceEpoch());
+    appendLE<quint64>(header, 0);                        // 块索引偏移（关闭时回填）
+    appendLE<quint64>(header, 0);                        // 块数（关闭时回填）
+    appendLE<qint64>(header, 0);                         // 每通道样本总数（关闭时回填）
+    appendLE<quint32>(header, quint32(description.size()));
+    header.append(description);
+    for (int ch = 0; ch < m_channels; ++ch) {
+        appendF64(header, m_scale[ch]);
+        appendF64(header, m_offset[ch]);
+    }
+    while (header.size() % 8 != 0) {
+        header.append('\0');
+    }
+    const quint32 headerSize = qToLittleEndian(quint32(header.size()));
+    std::memcpy(header.data() + 12, &headerSize, sizeof(headerSize));
+
+    m_fileOpen = true;
+    if (!writeAll(header.constData(), header.size())) {
+        return false;
+    }
+
+    qDebug() << "[DAQRecorder] 开始记录:" << m_file.fileName() << "通道" << m_channels << "采样率" << m_sampleRate
+             << (m_rawFormat ? "int16码值" : "float64电压");
+    emit recordingStarted(m_file.fileName());
+    return true;
+}
+
+void DAQRecorder::flushChunk()
+{
+    if (!m_fileOpen || m_chunkFilled <= 0) {
+        return;
+    }
+
+    // 未填满时把各通道紧凑排列，整块一次写入
+    const int bytesPerSample = m_rawFormat ? int(sizeof(qint16)) : int(sizeof(double));
+    const qint64 rowBytes = qint64(m_chunkFilled) * bytesPerSample;
+    if (m_chunkFilled < m_chunkSamples) {
+        char *base = m_chunkBuffer.data();
+        for (int ch = 1; ch < m_channels; ++ch) {
+            std::memmove(base + ch * rowBytes, base + qint64(ch) * m_chunkSamples * bytesPerSample, size_t(rowBytes));
+        }
+    }
+
+    QByteArray chunkHeader;
+    appendLE<quint32>(chunkHeader, ChunkMagic);
+    appendLE<quint32>(chunkHeader, quint32(m_channels));
+    appendLE<quint32>(chunkHeader, quint32(m_chunkFilled));
+    appendLE<quint32>(chunkHeader, m_rawFormat ? FormatInt16 : FormatFloat64);
+    appendLE<qint64>(chunkHeader, m_chunkFirstSample);
+    appendLE<quint64>(chunkHeader, quint64(rowBytes * m_channels));
+
+    const quint64 offset = quint64(m_file.pos());
+    if (!writeAll(chunkHeader.constData(), chunkHeader.size())
+        || !writeAll(m_chunkBuffer.constData(), rowBytes * m_channels)) {
+        return;
+    }
+
+    m_index.push_back({offset, m_chunkFirstSample, quint32(m_chunkFilled)});
+    m_samplesWritten += m_chunkFilled;
+    m_chunkFirstSample += m_chunkFilled;
+    m_chunkFilled = 0;
+}
+
+void DAQRecorder::closeFile()
+{
+    if (!m_fileOpen) {
+        return;
+    }
+    flushChunk();
+    if (!m_fileOpen) {
+        return;   // 写入失败时已关闭
+    }
+
+    // 块索引
+    QByteArray index;
+    index.append(IndexMagic, sizeof(IndexMagic));
+    appendLE<quint64>(index, quint64(m_index.size()));
+    for (const ChunkIndexEntry &entry : m_index) {
+        appendLE<quint64>(index, entry.fileOffset);
+        appendLE<qint64>(index, entry.firstSampleIndex);
+        appendLE<quint32>(index, entry.samplesPerChannel);
+        appendLE<quint32>(index, 0);
+    }
+    const quint64 indexOffset = quint64(m_file.pos());
+    if (!writeAll(index.constData(), index.size())) {
+        return;
+    }
+
+    // 回填文件头
+    QByteArray patch;
+    appendLE<quint64>(patch, indexOffset);
+    appendLE<quint64>(patch, quint64(m_index.size()));
+    appendLE<qint64>(patch, m_samplesWritten);
+    if (!m_file.seek(HeaderPatchOffset) || !writeAll(patch.constData(), patch.size())) {
+        return;
+    }
+
+    m_file.close();
+    m_fileOpen = false;
+    qDebug() << "[DAQRecorder] 记录结束:" << m_file.fileName() << "每通道样本" << m_samplesWritten
+             << "写入" << m_bytesWritten / 1e6 << "MB";
+    emit recordingStopped(m_file.fileName(), m_samplesWritten, m_bytesWritten);
+}
+
+bool DAQRecorder::writeAll(const char *data, qint64 size)
+{
+    qint64 written = 0;
+    while (written < size) {
+        const qint64 result = m_file.write(data + written, size - written);
+        if (result <= 0) {
+            const QString message = QString("写入记录文件失败: %1 (%2)").arg(m_file.fileName(), m_file.errorString());
+            qDebug() << "[DAQRecorder]" << message;
+            m_file.close();
+            m_fileOpen = false;
+            m_chunkFilled = 0;
+            emit recordingError(message);
+            return false;
+        }
+        written += result;
+    }
+    m_bytesWritten += size;
+    m_statsBytes += size;
+    return true;
+}
@@ -0,0 +1,127 @@
+#ifndef DAQRECORDER_H
+#define DAQRECORDER_H
+
+#include <QThread>
+#include <QString>
+#include <QVector>
+#include <QList>
+#include <QFile>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <atomic>
+#include <vector>
+#include "daqthread.h"
+
+// 全速率DAQ数据记录器
+//
+// 在独立的I/O线程中把每个DAQ数据块写入分块二进制文件（*.daqrec），文件格式（小端）：
+//   文件头：magic "DAQREC1\0"、版本、文件头长度、通道数、样本格式（1=int16码值，2=float64电压）、
+//          采样率、起始样本序号、开始时间（ms）、块索引偏移、块数、每通道样本总数、
+//          说明文字（UTF-8）、每通道换算系数与偏移（电压 = 码值 * scale + offset）
+//   数据块：magic "CHNK"、通道数、每通道样本数、样本格式、第一个样本的序号、数据长度，
+//          随后为通道优先的样本数据；样本序号不连续（丢块）时开始新的数据块
+//   块索引：magic "DAQIDX1\0"、块数，每块（文件偏移、第一个样本序号、每通道样本数）
+// 块索引偏移和块数在停止记录时回填；异常退出时为0，读取端可按块头顺序扫描恢复。
+//
+// DAQ线程只把数据块（隐式共享，不复制样本）放入有界队列，队列满时丢弃并计数，
+// 不会阻塞采集管线；记录线程把样本拼接成几MB的大块后顺序写入。
+class DAQRecorder : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit DAQRecorder(QObject *parent = nullptr);
+    ~DAQRecorder();
+
+    // 队列上限（字节），默认256MB
+    void setQueueLimit(qint64 bytes);
+    // 每个数据块的目标大小（字节），默认4MB
+    void setChunkBytes(qint64 bytes);
+
+    bool isRecording() const { return m_recording.load(std::memory_order_acquire); }
+
+    // 线程停止执行（会先关闭当前文件）
+    void stopThread();
+
+public slots:
+    // 开始记录：后续数据块写入directory下以时间命名的文件，description写入文件头
+    void startRecording(const QString &directory, const QString &description);
+    // 停止记录：写完队列中已有的数据块后关闭文件
+    void stopRecording();
+    // 入队一个数据块；应以Qt::DirectConnection连接到DAQThread::dataBlockReady，在DAQ线程中执行
+    void enqueueBlock(const DAQDataBlock &block);
+
+signals:
+    void recordingStarted(QString filePath);
+    void recordingStopped(QString filePath, qint64 samplesPerChannel, qint64 bytesWritten);
+    void recordingError(QString errorMessage);
+    // 约每秒一次：丢弃的数据块数、队列占用（字节）、写入速率（MB/s）
+    void recorderStatistics(quint64 blocksDropped, qint64 queuedBytes, double writeMBps);
+
+protected:
+    // 重写run方法，实现记录线程主循环
+    void run() override;
+
+private:
+    struct QueueItem {
+        enum Kind { Block, Start, Stop } kind = Block;
+        DAQDataBlock block;
+        QString directory;
+        QString description;
+        qint64 bytes = 0;
+    };
+
+    struct ChunkIndexEntry {
+        quint64 fileOffset;
+        qint64 firstSampleIndex;
+        quint32 samplesPerChannel;
+    };
+
+    static qint64 blockBytes(const DAQDataBlock &block);
+
+    // 以下方法只在记录线程中调用
+    void processBlock(const DAQDataBlock &block);
+    bool openFile(const DAQDataBlock &block);
+    void closeFile();
+    void flushChunk();
+    bool writeAll(const char *data, qint64 size);
+
+    // 队列（m_queueMutex保护）
+    QMutex m_queueMutex;
+    QWaitCondition m_queueCondition;
+    QList<QueueItem> m_queue;
+    qint64 m_queuedBytes;
+    qint64 m_queueLimit;
+    bool m_stopRequested;
+    std::atomic<bool> m_recording;
+    std::atomic<quint64> m_blocksDropped;
+
+    // 当前文件（仅记录线程使用）
+    QString m_directory;
+    QString m_description;
+    QFile m_file;
+    bool m_fileOpen;
+    int m_channels;
+    double m_sampleRate;
+    bool m_rawFormat;                        // 文件样本格式为int16码值
+    QVector<double> m_scale;
+    QVector<double> m_offset;
+    qint64 m_startSampleIndex;
+    qint64 m_samplesWritten;
+    qint64 m_bytesWritten;
+    std::vector<ChunkIndexEntry> m_index;
+
+    // 正在拼接的数据块（通道优先，每通道容量m_chunkSamples）
+    qint64 m_chunkBytes;
+    int m_chunkSamples;
+    int m_chunkFilled;
+    qint64 m_chunkFirstSample;
+    QByteArray m_chunkBuffer;
+
+    QElapsedTimer m_statsTimer;
+    qint64 m_statsBytes;
+};
+
+#endif // DAQRECORDER_H
@@ -0,0 +1,203 @@
+#ifndef DAQRINGBUFFER_H
+#define DAQRINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+// 单生产者/单消费者（SPSC）无锁数据块环形缓冲区
+//
+// 生产者为驱动回调线程，消费者为DAQ线程。所有内存在采集开始前一次性分配，
+// 回调路径上不分配内存、不加锁、不使用Qt类型。每个槽位存放一次回调读取的
+// 交错样本（按扫描分组），槽位按缓存行对齐，读写索引位于不同缓存行以避免伪共享。
+template <typename T>
+class DAQBlockRing
+{
+public:
+    static constexpr std::size_t CacheLineSize = 64;
+
+    DAQBlockRing() = default;
+    ~DAQBlockRing() { release(); }
+
+    DAQBlockRing(const DAQBlockRing &) = delete;
+    DAQBlockRing &operator=(const DAQBlockRing &) = delete;
+
+    // 分配缓冲区（非实时路径调用）。slotCount向上取整为2的幂，
+    // 另外多分配一个丢弃槽位，供缓冲区满时回调仍能把数据从驱动中读出。
+    bool allocate(std::size_t slotCount, std::size_t samplesPerSlot)
+    {
+        release();
+        if (slotCount < 2 || samplesPerSlot == 0) {
+            return false;
+        }
+
+        std::size_t count = 1;
+        while (count < slotCount) {
+            count <<= 1;
+        }
+
+        const std::size_t bytes = samplesPerSlot * sizeof(T);
+        const std::size_t stride = (bytes + CacheLineSize - 1) / CacheLineSize * CacheLineSize;
+
+        m_storage = static_cast<unsigned char *>(
+            ::operator new((count + 1) * stride, std::align_val_t(CacheLineSize), std::nothrow));
+        m_meta = new (std::nothrow) SlotMeta[count + 1];
+        if (!m_storage || !m_meta) {
+            release();
+            return false;
+        }
+
+        m_slotCount = count;
+        m_mask = count - 1;
+        m_slotStride = stride;
+        m_samplesPerSlot = samplesPerSlot;
+        reset();
+        return true;
+    }
+
+    void release()
+    {
+        if (m_storage) {
+            ::operator delete(m_storage, std::align_val_t(CacheLineSize));
+            m_storage = nullptr;
+        }
+        delete[] m_meta;
+        m_meta = nullptr;
+        m_slotCount = 0;
+        m_mask = 0;
+        m_slotStride = 0;
+        m_samplesPerSlot = 0;
+    }
+
+    // 清空读写位置与统计（仅在生产者和消费者都停止时调用）
+    void reset()
+    {
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
+        m_cachedTail = 0;
+        m_overruns.store(0, std::memory_order_relaxed);
+        m_blocksWritten.store(0, std::memory_order_relaxed);
+        m_highWater.store(0, std::memory_order_relaxed);
+    }
+
+    bool isAllocated() const { return m_storage != nullptr; }
+    std::size_t slotCount() const { return m_slotCount; }
+    std::size_t samplesPerSlot() const { return m_samplesPerSlot; }
+
+    // ---- 生产者接口（回调线程） ----
+
+    // 获取下一个可写槽位；缓冲区已满时返回nullptr（调用者应改用discardSlot()并记录溢出）
+    T *beginWrite()
+    {
+        const std::uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_cachedTail >= m_slotCount) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head - m_cachedTail >= m_slotCount) {
+                return nullptr;
+            }
+        }
+        return slotData(head & m_mask);
+    }
+
+    // 提交beginWrite()返回的槽位；timestampNs为读出数据时的PipelineClock时间
+    void commitWrite(std::uint64_t sequence, std::int32_t samplesPerChannel, std::int64_t firstSampleIndex,
+                     std::int64_t timestampNs = 0)
+    {
+        const std::uint64_t head = m_head.load(std::memory_order_relaxed);
+        SlotMeta &meta = m_meta[head & m_mask];
+        meta.sequence = sequence;
+        meta.samplesPerChannel = samplesPerChannel;
+        meta.firstSampleIndex = firstSampleIndex;
+        meta.timestampNs = timestampNs;
+        m_head.store(head + 1, std::memory_order_release);
+        m_blocksWritten.fetch_add(1, std::memory_order_relaxed);
+
+        const std::uint64_t fill = head + 1 - m_cachedTail;
+        if (fill > m_highWater.load(std::memory_order_relaxed)) {
+            m_highWater.store(fill, std::memory_order_relaxed);
+        }
+    }
+
+    // 缓冲区满时用于接收并丢弃驱动数据的槽位
+    T *discardSlot() { return slotData(m_slotCount); }
+
+    // 记录一次溢出（数据块被丢弃）
+    void markOverrun() { m_overruns.fetch_add(1, std::memory_order_relaxed); }
+
+    // ---- 消费者接口（DAQ线程） ----
+
+    // 获取最早的未读槽位；为空时返回nullptr
+    const T *beginRead(std::uint64_t *sequence, std::int32_t *samplesPerChannel, std::int64_t *firstSampleIndex,
+                       std::int64_t *timestampNs = nullptr) const
+    {
+        const std::uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        const SlotMeta &meta = m_meta[tail & m_mask];
+        if (sequence) {
+            *sequence = meta.sequence;
+        }
+        if (samplesPerChannel) {
+            *samplesPerChannel = meta.samplesPerChannel;
+        }
+        if (firstSampleIndex) {
+            *firstSampleIndex = meta.firstSampleIndex;
+        }
+        if (timestampNs) {
+            *timestampNs = meta.timestampNs;
+        }
+        return slotData(tail & m_mask);
+    }
+
+    // 释放beginRead()返回的槽位
+    void endRead()
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // ---- 统计（任意线程） ----
+
+    std::size_t fillLevel() const
+    {
+        return std::size_t(m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire));
+    }
+    std::uint64_t overruns() const { return m_overruns.load(std::memory_order_relaxed); }
+    std::uint64_t blocksWritten() const { return m_blocksWritten.load(std::memory_order_relaxed); }
+    std::uint64_t highWater() const { return m_highWater.load(std::memory_order_relaxed); }
+
+private:
+    struct SlotMeta {
+        std::uint64_t sequence = 0;
+        std::int32_t samplesPerChannel = 0;
+        std::int64_t firstSampleIndex = 0;
+        std::int64_t timestampNs = 0;
+    };
+
+    T *slotData(std::size_t index) const
+    {
+        return reinterpret_cast<T *>(m_storage + index * m_slotStride);
+    }
+
+    unsigned char *m_storage = nullptr;
+    SlotMeta *m_meta = nullptr;
+    std::size_t m_slotCount = 0;
+    std::size_t m_mask = 0;
+    std::size_t m_slotStride = 0;
+    std::size_t m_samplesPerSlot = 0;
+
+    // 生产者独占的缓存行
+    alignas(CacheLineSize) std::atomic<std::uint64_t> m_head{0};
+    std::uint64_t m_cachedTail = 0;
+
+    // 消费者独占的缓存行
+    alignas(CacheLineSize) std::atomic<std::uint64_t> m_tail{0};
+
+    // 统计计数
+    alignas(CacheLineSize) std::atomic<std::uint64_t> m_overruns{0};
+    std::atomic<std::uint64_t> m_blocksWritten{0};
+    std::atomic<std::uint64_t> m_highWater{0};
+};
+
+#endif // DAQRINGBUFFER_H
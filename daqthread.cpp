@@ -1,29 +1,59 @@
 #include "daqthread.h"
+#include "pipelinelatency.h"
+#include "samplescaling.h"
+#include "simulateddaqdevice.h"
+#include "threadaffinity.h"
+#include <QThread>
+#include <QVarLengthArray>
 #include <cmath>
+#include <limits>
+#include <type_traits>
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
-// 全局变量，供回调函数使用
-DAQThread* g_daqThread = nullptr;
+void DAQDataBlock::channelToVolts(int ch, double *out) const
+{
+    if (ch < 0 || ch >= numChannels || samplesPerChannel <= 0) {
+        return;
+    }
+    if (isRaw()) {
+        convertInt16ToVolts(rawChannel(ch), samplesPerChannel, rawScale.value(ch, 1.0), rawOffset.value(ch, 0.0), out);
+    } else {
+        std::copy(channel(ch), channel(ch) + samplesPerChannel, out);
+    }
+}
 
 DAQThread::DAQThread(QObject *parent)
     : QObject(parent)
-    , taskHandle(0)
+    , simulationRealTime(true)
+    , syncStartTriggerTerminal("PFI0")
+    , syncSampleClockTerminal("PFI1")
+    , coreAffinityBase(1)
+    , mergeDrops(0)
+    , acquisitionSerial(0)
     , sampleRate(10000)
     , samplesPerChannel(1000)
     , numChannels(0)
     , isAcquiring(false)
+    , fullWindowEnabled(false)
+    , totalSamplesAcquired(0)
+    , ringCapacity(64)
+    , drainTimer(new QTimer(this))
+    , lastReportedOverruns(0)
+    , rawModeEnabled(false)
+    , rawModeActive(false)
     , filterEnabled(false)
     , cutoffFrequency(50.0)   // 默认截止频率设置为50Hz，适合低频滤波
     , filterOrder(128)        // 默认滤波器阶数增加到128，提高低频滤波效果
 {
-    // 设置全局指针
-    g_daqThread = this;
-
     // 初始化滤波器系数
     calculateFilterCoefficients();
 
+    // 取数定时器作为子对象随DAQThread一起移动到DAQ线程
+    drainTimer->setTimerType(Qt::PreciseTimer);
+    connect(drainTimer, &QTimer::timeout, this, &DAQThread::drainRing);
+
     qDebug() << "[DAQThread] 初始化完成，默认滤波器设置: 截止频率=" << cutoffFrequency << "Hz, 阶数=" << filterOrder;
 }
 
@@ -31,7 +61,7 @@ DAQThread::~DAQThread()
 {
     // 确保任务已停止
     if (isAcquiring) {
-        stopAcquisition();
+        stopTask();
     }
 }
 
@@ -43,19 +73,22 @@ void DAQThread::initDAQ(const QString &deviceName, const QString &channelStr, do
     this->m_deviceName = deviceName;
     this->m_channelStr = channelStr;
 
-    // 解析通道
-    QVector<int> channels = parseChannels(channelStr);
-    if (channels.isEmpty()) {
-        emit error("通道格式无效，请使用数字和'/'符号分隔，例如：0/1/2");
+    // 解析设备和通道
+    const QStringList deviceNames = parseDeviceNames(deviceName);
+    const QVector<QVector<int>> deviceChannels = parseDeviceChannels(channelStr, qMax(1, int(deviceNames.size())));
+    if (deviceChannels.isEmpty()) {
+        emit error("通道格式无效，请使用数字和'/'符号分隔，例如：0/1/2；多个设备的通道用';'分隔，例如：0/1;0/1/2");
         return;
     }
 
-    numChannels = channels.size();
+    numChannels = 0;
+    for (const QVector<int> &channels : deviceChannels) {
+        numChannels += channels.size();
+    }
 
     // 初始化数据缓冲区
-    timeData.clear();
-    channelData.clear();
-    channelData.resize(numChannels);
+    windowHistory.reset();
+    totalSamplesAcquired = 0;
 
     qDebug() << "初始化DAQ任务: 设备=" << deviceName << ", 通道=" << channelStr
              << ", 采样率=" << sampleRate << ", 通道数=" << numChannels;
@@ -65,164 +98,457 @@ void DAQThread::initDAQ(const QString &deviceName, const QString &channelStr, do
 
 void DAQThread::startAcquisition()
 {
+    // 环形缓冲区和取数定时器归DAQ线程所有，跨线程调用时转到DAQ线程执行
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, &DAQThread::startAcquisition, Qt::QueuedConnection);
+        return;
+    }
+
     if (isAcquiring) {
         emit error("数据采集已在进行中");
         return;
     }
 
+    // 获取设备名称 - 从initDAQ中保存的变量获取
+    QStringList deviceNames = parseDeviceNames(m_deviceName);
+    if (deviceNames.isEmpty()) {
+        deviceNames.append("Dev1"); // 默认设备名
+    }
+
     // 使用存储的通道字符串重新解析通道
-    QVector<int> channels = parseChannels(m_channelStr);
-    if (channels.isEmpty() || numChannels == 0) {
+    const QVector<QVector<int>> deviceChannels = parseDeviceChannels(m_channelStr, int(deviceNames.size()));
+    if (deviceChannels.isEmpty() || numChannels == 0) {
         emit error("未指定通道");
         return;
     }
 
-    // 获取设备名称 - 从initDAQ中保存的变量获取
-    QString deviceName = m_deviceName;
-    if (deviceName.isEmpty()) {
-        deviceName = "Dev1"; // 默认设备名
+    // 按设备名称创建后端并配置任务（通道、采样时钟和同步方式）
+    // 多设备时第一个设备为主设备，导出开始触发和采样时钟；其余为从设备
+    const bool synchronized = deviceNames.size() > 1;
+    const bool pinThreads = coreAffinityBase >= 0 && coreAffinityBase + int(deviceNames.size()) <= logicalCoreCount();
+    devices.clear();
+    ++acquisitionSerial;
+    int channelOffset = 0;
+    for (int i = 0; i < deviceNames.size(); ++i) {
+        auto context = std::make_unique<DeviceContext>();
+        context->owner = this;
+        context->acquisition = acquisitionSerial;
+        context->deviceName = deviceNames[i];
+        context->channels = deviceChannels[i];
+        context->channelOffset = channelOffset;
+        context->cpuCore = pinThreads ? coreAffinityBase + i : -1;
+        channelOffset += context->channels.size();
+
+        context->device = createDAQDevice(context->deviceName);
+        if (!context->device) {
+            devices.clear();
+            emit error(QString("当前平台不支持设备 %1，可使用模拟设备（设备名以Sim开头）").arg(context->deviceName));
+            return;
+        }
+        if (auto *simulated = dynamic_cast<SimulatedDAQDevice *>(context->device.get())) {
+            simulated->setRealTime(simulationRealTime);
+        }
+
+        DAQDeviceConfig config;
+        config.deviceName = context->deviceName;
+        config.channels = context->channels;
+        config.sampleRate = sampleRate;
+        config.samplesPerChannel = samplesPerChannel;
+        if (synchronized) {
+            // 主设备导出到自己的终端，从设备从自己的同名终端接收（设备之间按终端接线）
+            const auto terminal = [&](const QString &name) {
+                return name.isEmpty() ? QString() : QString("/%1/%2").arg(context->deviceName, name);
+            };
+            config.syncRole = (i == 0) ? DAQSyncRole::Master : DAQSyncRole::Slave;
+            config.startTriggerTerminal = terminal(syncStartTriggerTerminal);
+            config.sampleClockTerminal = terminal(syncSampleClockTerminal);
+        }
+        if (!context->device->configure(config)) {
+            const QString message = QString("%1: %2").arg(context->deviceName, context->device->lastError());
+            devices.clear();
+            emit error(message);
+            return;
+        }
+        qDebug() << "[DAQThread] 设备" << context->deviceName << "使用" << context->device->backendName() << "后端，通道"
+                 << context->channels << (synchronized ? (i == 0 ? "（主设备）" : "（从设备）") : "");
+        devices.push_back(std::move(context));
+    }
+    numChannels = channelOffset;
+
+    // 按当前采样率重新计算滤波器系数，并清空各通道的滤波历史
+    calculateFilterCoefficients();
+    firFilter.setChannelCount(numChannels);
+
+    // 原始模式需要各通道的码值换算系数
+    rawModeActive = rawModeEnabled;
+    if (rawModeActive) {
+        rawScale.resize(numChannels);
+        rawOffset.resize(numChannels);
+        for (const auto &context : devices) {
+            queryRawScaling(*context);
+        }
+        qDebug() << "[DAQThread] 原始模式换算系数:" << rawScale << "偏移:" << rawOffset;
     }
 
-    QString deviceChannelStr = getDeviceChannelString(deviceName, channels);
-    qDebug() << "使用设备通道字符串: " << deviceChannelStr;
+    // 预先为每个设备分配回调使用的环形缓冲区，回调中不再分配内存
+    for (const auto &context : devices) {
+        const size_t slotSamples = size_t(samplesPerChannel) * size_t(context->channels.size());
+        const bool allocated = rawModeActive ? context->rawRing.allocate(size_t(ringCapacity), slotSamples)
+                                             : context->ring.allocate(size_t(ringCapacity), slotSamples);
+        if (!allocated) {
+            devices.clear();
+            emit error("分配采集环形缓冲区失败");
+            return;
+        }
+    }
 
-    // 设置ArtDAQ任务
-    int32 errorCode = 0;
-    char errBuff[2048] = {'\0'};
+    // 每次开始采集时数据块序号和样本序号从0开始
+    totalSamplesAcquired = 0;
+    lastReportedOverruns = 0;
+    mergeDrops = 0;
+    windowHistory.reset();
 
-    // 创建任务
-    errorCode = ArtDAQ_CreateTask("", &taskHandle);
-    if (errorCode < 0) {
-        ArtDAQ_GetExtendedErrorInfo(errBuff, 2048);
-        emit error(QString("创建任务失败: %1").arg(errBuff));
-        return;
+    // 先置位isAcquiring，再注册回调并开始任务，使开始后立即到达的回调能写入环形缓冲区。
+    // 从设备先启动并等待开始触发，主设备最后启动
+    isAcquiring = true;
+    for (int i = int(devices.size()) - 1; i >= 0; --i) {
+        DeviceContext &context = *devices[size_t(i)];
+        if (!context.device->start(&DAQThread::deviceSamplesCallback, &DAQThread::deviceDoneCallback, &context)) {
+            const QString message = QString("%1: %2").arg(context.deviceName, context.device->lastError());
+            stopTask();
+            emit error(message);
+            return;
+        }
     }
 
-    // 创建模拟输入通道
-    errorCode = ArtDAQ_CreateAIVoltageChan(taskHandle, deviceChannelStr.toStdString().c_str(), "",
-                                      ArtDAQ_Val_Cfg_Default, -10.0, 10.0, ArtDAQ_Val_Volts, NULL);
-    if (errorCode < 0) {
-        ArtDAQ_GetExtendedErrorInfo(errBuff, 2048);
-        ArtDAQ_ClearTask(taskHandle);
-        taskHandle = 0;
-        emit error(QString("创建通道失败: %1").arg(errBuff));
+    // 取数周期取数据块周期的1/4，限制在1~20ms
+    const double blockPeriodMs = samplesPerChannel * 1000.0 / sampleRate;
+    drainTimer->start(qBound(1, int(blockPeriodMs / 4.0), 20));
+    ringStatsTimer.start();
+
+    emit acquisitionStatus(true, "数据采集已开始");
+}
+
+void DAQThread::stopAcquisition()
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, &DAQThread::stopAcquisition, Qt::QueuedConnection);
         return;
     }
 
-    // 设置采样时钟
-    errorCode = ArtDAQ_CfgSampClkTiming(taskHandle, "", sampleRate, ArtDAQ_Val_Rising,
-                                   ArtDAQ_Val_ContSamps, samplesPerChannel);
-    if (errorCode < 0) {
-        ArtDAQ_GetExtendedErrorInfo(errBuff, 2048);
-        ArtDAQ_ClearTask(taskHandle);
-        taskHandle = 0;
-        emit error(QString("设置采样时钟失败: %1").arg(errBuff));
+    if (!isAcquiring) {
         return;
     }
 
-    // 注册回调函数
-    errorCode = ArtDAQ_RegisterEveryNSamplesEvent(taskHandle, ArtDAQ_Val_Acquired_Into_Buffer,
-                                            samplesPerChannel, 0, EveryNCallbackDAQ, NULL);
-    if (errorCode < 0) {
-        ArtDAQ_GetExtendedErrorInfo(errBuff, 2048);
-        ArtDAQ_ClearTask(taskHandle);
-        taskHandle = 0;
-        emit error(QString("注册回调函数失败: %1").arg(errBuff));
-        return;
+    stopTask();
+    emit acquisitionStatus(false, "数据采集已停止");
+}
+
+void DAQThread::stopTask()
+{
+    // 停止和清理任务，stop()返回后不会再有回调写入环形缓冲区；先停主设备（触发和时钟源）
+    isAcquiring = false;
+    for (const auto &context : devices) {
+        if (context->device) {
+            context->device->stop();
+        }
     }
+    devices.clear();
 
-    errorCode = ArtDAQ_RegisterDoneEvent(taskHandle, 0, DoneCallbackDAQ, NULL);
-    if (errorCode < 0) {
-        ArtDAQ_GetExtendedErrorInfo(errBuff, 2048);
-        ArtDAQ_ClearTask(taskHandle);
-        taskHandle = 0;
-        emit error(QString("注册完成事件失败: %1").arg(errBuff));
-        return;
+    drainTimer->stop();
+    if (mergeDrops > 0) {
+        qDebug() << "[DAQThread] 本次采集因设备间丢块未能合并的数据块:" << mergeDrops;
     }
+}
 
-    // 开始任务
-    errorCode = ArtDAQ_StartTask(taskHandle);
-    if (errorCode < 0) {
-        ArtDAQ_GetExtendedErrorInfo(errBuff, 2048);
-        ArtDAQ_ClearTask(taskHandle);
-        taskHandle = 0;
-        emit error(QString("启动任务失败: %1").arg(errBuff));
+// 取出各设备环形缓冲区中所有已提交的数据块，合并后处理
+void DAQThread::drainRing()
+{
+    if (devices.empty()) {
         return;
     }
+    if (rawModeActive) {
+        drainBlocks<std::int16_t>();
+    } else {
+        drainBlocks<double>();
+    }
+    reportRingStatistics();
+}
 
-    isAcquiring = true;
-    emit acquisitionStatus(true, "数据采集已开始");
+template <typename T>
+DAQBlockRing<T> &DAQThread::ringOf(DeviceContext &context)
+{
+    if constexpr (std::is_same_v<T, std::int16_t>) {
+        return context.rawRing;
+    } else {
+        return context.ring;
+    }
 }
 
-void DAQThread::stopAcquisition()
+// 合并阶段：各设备共享开始触发和采样时钟，同一序号的数据块覆盖相同的样本序号。
+// 只有所有设备都已提交最早的数据块时才合并；某个设备丢失了该序号（环形缓冲区溢出）时，
+// 其余设备的同序号数据块无法组成完整通道集，一并丢弃，下游通过序号间断发现丢块
+template <typename T>
+void DAQThread::drainBlocks()
 {
-    if (!isAcquiring) {
+    const size_t deviceCount = devices.size();
+    QVarLengthArray<const T *, 8> data(qsizetype(deviceCount));
+    QVarLengthArray<std::uint64_t, 8> sequences(qsizetype(deviceCount));
+    QVarLengthArray<std::int32_t, 8> reads(qsizetype(deviceCount));
+    QVarLengthArray<std::int64_t, 8> firstIndices(qsizetype(deviceCount));
+    QVarLengthArray<std::int64_t, 8> timestamps(qsizetype(deviceCount));
+
+    forever {
+        std::uint64_t minSequence = std::numeric_limits<std::uint64_t>::max();
+        for (size_t i = 0; i < deviceCount; ++i) {
+            data[i] = ringOf<T>(*devices[i]).beginRead(&sequences[i], &reads[i], &firstIndices[i], &timestamps[i]);
+            if (!data[i]) {
+                return;   // 等待其余设备
+            }
+            minSequence = qMin(minSequence, sequences[i]);
+        }
+
+        bool complete = true;
+        int read = reads[0];
+        std::int64_t timestampNs = timestamps[0];
+        for (size_t i = 0; i < deviceCount; ++i) {
+            complete = complete && sequences[i] == minSequence;
+            read = qMin(read, int(reads[i]));
+            timestampNs = qMin(timestampNs, timestamps[i]);
+        }
+
+        if (complete) {
+            if constexpr (std::is_same_v<T, std::int16_t>) {
+                processRawData(data.constData(), read, minSequence, firstIndices[0], timestampNs);
+            } else {
+                processData(data.constData(), read, minSequence, firstIndices[0], timestampNs);
+            }
+        } else {
+            ++mergeDrops;
+        }
+
+        for (size_t i = 0; i < deviceCount; ++i) {
+            if (sequences[i] == minSequence) {
+                ringOf<T>(*devices[i]).endRead();
+            }
+        }
+    }
+}
+
+// 约每秒报告一次缓冲区状态（各设备合计），出现新的溢出时立即报告
+void DAQThread::reportRingStatistics()
+{
+    quint64 overruns = 0;
+    quint64 blocksWritten = 0;
+    int fillLevel = 0;
+    int capacity = 0;
+    for (const auto &context : devices) {
+        const auto collect = [&](const auto &source) {
+            overruns += source.overruns();
+            blocksWritten += source.blocksWritten();
+            fillLevel = qMax(fillLevel, int(source.fillLevel()));
+            capacity = int(source.slotCount());
+        };
+        if (rawModeActive) {
+            collect(context->rawRing);
+        } else {
+            collect(context->ring);
+        }
+    }
+
+    if (overruns != lastReportedOverruns || ringStatsTimer.elapsed() >= 1000) {
+        if (overruns != lastReportedOverruns) {
+            qDebug() << "[DAQThread] 环形缓冲区溢出，累计丢弃" << overruns << "个数据块";
+        }
+        lastReportedOverruns = overruns;
+        ringStatsTimer.restart();
+        emit ringStatistics(overruns, blocksWritten, fillLevel, capacity);
+    }
+}
+
+void DAQThread::processData(const double *const *data, int read, quint64 sequence, qint64 firstSampleIndex,
+                            qint64 timestampNs)
+{
+    if (read <= 0 || !isAcquiring) {
         return;
     }
 
-    // 停止和清理任务
-    if (taskHandle != 0) {
-        ArtDAQ_StopTask(taskHandle);
-        ArtDAQ_ClearTask(taskHandle);
-        taskHandle = 0;
+    // 构造本次回调的增量数据块
+    DAQDataBlock block;
+    block.sequence = sequence;
+    block.firstSampleIndex = firstSampleIndex;
+    block.numChannels = numChannels;
+    block.samplesPerChannel = read;
+    block.sampleRate = sampleRate;
+    block.timestampNs = timestampNs;
+    block.samples.resize(qsizetype(numChannels) * read);
+
+    // 每个设备的数据是交错存储的，分块转置到合并通道集中该设备所在的位置
+    for (size_t i = 0; i < devices.size(); ++i) {
+        const DeviceContext &context = *devices[i];
+        transposeScans(data[i], read, int(context.channels.size()),
+                       block.samples.data() + qsizetype(context.channelOffset) * read, size_t(read));
     }
 
-    isAcquiring = false;
-    emit acquisitionStatus(false, "数据采集已停止");
+    // 如果滤波器启用，按通道整块滤波（原位）
+    if (filterEnabled) {
+        filterBlock(block);
+    }
+    publishBlock(block);
 }
 
-void DAQThread::processData(float64 *data, int32 read)
+void DAQThread::processRawData(const std::int16_t *const *data, int read, quint64 sequence, qint64 firstSampleIndex,
+                               qint64 timestampNs)
 {
     if (read <= 0 || !isAcquiring) {
         return;
     }
 
-    // 计算当前的时间点
-    double startTime = 0.0;
-    if (!timeData.isEmpty()) {
-        startTime = timeData.last() + 1.0 / sampleRate;
+    DAQDataBlock block;
+    block.sequence = sequence;
+    block.firstSampleIndex = firstSampleIndex;
+    block.numChannels = numChannels;
+    block.samplesPerChannel = read;
+    block.sampleRate = sampleRate;
+    block.timestampNs = timestampNs;
+
+    // 解交错码值（每样本2字节，保持原始格式）
+    block.rawSamples.resize(qsizetype(numChannels) * read);
+    for (size_t i = 0; i < devices.size(); ++i) {
+        const DeviceContext &context = *devices[i];
+        const int channels = int(context.channels.size());
+        for (int ch = 0; ch < channels; ++ch) {
+            deinterleaveInt16(data[i] + ch, channels, read,
+                              block.rawSamples.data() + qsizetype(context.channelOffset + ch) * read);
+        }
     }
+    block.rawScale = rawScale;
+    block.rawOffset = rawOffset;
 
-    // 确保滤波缓冲区大小正确
-    if (filterBuffers.size() != numChannels) {
-        filterBuffers.resize(numChannels);
+    // 滤波需要浮点数：批量换算为电压后滤波，数据块改为电压模式
+    if (filterEnabled) {
+        block.samples.resize(qsizetype(numChannels) * read);
         for (int ch = 0; ch < numChannels; ++ch) {
-            filterBuffers[ch].resize(filterOrder + 1); // 确保缓冲区大小与滤波器阶数匹配
-            filterBuffers[ch].fill(0.0); // 初始化为0
+            block.channelToVolts(ch, block.samples.data() + qsizetype(ch) * read);
         }
-        qDebug() << "[DAQThread] 初始化滤波缓冲区: " << numChannels << "个通道, 每通道" << (filterOrder + 1) << "个样本";
+        block.rawSamples.clear();
+        block.rawScale.clear();
+        block.rawOffset.clear();
+        filterBlock(block);
     }
+    publishBlock(block);
+}
 
-    // 每个通道的数据是交错存储的，需要解交错
-    for (int i = 0; i < read; ++i) {
-        double time = startTime + i / sampleRate;
-        timeData.append(time);
-
-        for (int ch = 0; ch < numChannels; ++ch) {
-            double rawValue = data[i * numChannels + ch];
+void DAQThread::filterBlock(DAQDataBlock &block)
+{
+    if (firFilter.channelCount() != block.numChannels) {
+        firFilter.setChannelCount(block.numChannels);
+    }
+    double *out = block.samples.data();
+    for (int ch = 0; ch < block.numChannels; ++ch) {
+        double *samples = out + qsizetype(ch) * block.samplesPerChannel;
+        firFilter.process(ch, samples, samples, block.samplesPerChannel);
+    }
+}
 
-            // 如果滤波器启用，应用滤波
-            if (filterEnabled) {
-                double filteredValue = applyFilter(rawValue, ch);
-                channelData[ch].append(filteredValue);
+void DAQThread::publishBlock(const DAQDataBlock &block)
+{
+    const int read = block.samplesPerChannel;
+    totalSamplesAcquired = block.firstSampleIndex + read;
+
+    // 仅在开启时维护并发送完整滑动窗口（最近10000点）
+    if (fullWindowEnabled) {
+        const int maxDataPoints = 10000;
+        if (windowHistory.channelCount() != numChannels || windowHistory.sampleRate() != sampleRate
+            || windowHistory.maxBlockSize() < size_t(read)) {
+            windowHistory.allocate(numChannels, maxDataPoints, size_t(qMax(read, samplesPerChannel)), sampleRate);
+        }
+        if (windowHistory.beginWrite(block.firstSampleIndex, read)) {
+            if (block.isRaw()) {
+                if (windowScratch.size() < read) {
+                    windowScratch.resize(read);
+                }
+                for (int ch = 0; ch < numChannels; ++ch) {
+                    block.channelToVolts(ch, windowScratch.data());
+                    windowHistory.writeChannel(ch, windowScratch.constData());
+                }
             } else {
-                channelData[ch].append(rawValue);
+                for (int ch = 0; ch < numChannels; ++ch) {
+                    windowHistory.writeChannel(ch, block.channel(ch));
+                }
             }
+            windowHistory.commitWrite();
         }
-    }
 
-    // 限制数据点数量，避免内存占用过多
-    int maxDataPoints = 10000;
-    if (timeData.size() > maxDataPoints) {
-        int removeCount = timeData.size() - maxDataPoints;
-        timeData.remove(0, removeCount);
+        // 从历史存储复制出窗口，追加样本的开销与窗口长度无关
+        const std::int64_t end = windowHistory.endIndex();
+        const std::int64_t begin = qMax(windowHistory.beginIndex(), end - maxDataPoints);
+        QVector<double> timeData(end - begin);
+        for (std::int64_t i = begin; i < end; ++i) {
+            timeData[i - begin] = windowHistory.timeOf(i);
+        }
+        QVector<QVector<double>> channelData(numChannels);
         for (int ch = 0; ch < numChannels; ++ch) {
-            channelData[ch].remove(0, removeCount);
+            const HistorySpan span = windowHistory.span(ch, begin, end);
+            channelData[ch].resize(qsizetype(span.size()));
+            span.copyTo(channelData[ch].data());
         }
+
+        emit dataReady(timeData, channelData, numChannels);
+    }
+
+    // 发送增量数据块
+    PipelineLatency::recordSince(PipelineLatency::DAQAcquire, block.timestampNs);
+    emit dataBlockReady(block);
+}
+
+// 查询设备各通道量程，计算原始码值的换算系数（写入合并通道集中该设备所在的位置）
+void DAQThread::queryRawScaling(DeviceContext &context)
+{
+    // 驱动未提供换算多项式，按16位码值均匀覆盖量程计算：
+    // 电压 = 码值 * (max - min) / 65536 + (max + min) / 2
+    for (int i = 0; i < context.channels.size(); ++i) {
+        double maxValue = 10.0;
+        double minValue = -10.0;
+        if (!context.device->channelRange(i, &minValue, &maxValue) || maxValue <= minValue) {
+            qDebug() << "[DAQThread] 无法读取" << context.deviceName << "第" << i << "个通道的量程，按±10V换算";
+            maxValue = 10.0;
+            minValue = -10.0;
+        }
+        rawScale[context.channelOffset + i] = (maxValue - minValue) / 65536.0;
+        rawOffset[context.channelOffset + i] = (maxValue + minValue) / 2.0;
+    }
+}
+
+QStringList DAQThread::parseDeviceNames(const QString &deviceName) const
+{
+    QStringList names;
+    for (const QString &part : deviceName.split(",", Qt::SkipEmptyParts)) {
+        const QString name = part.trimmed();
+        if (!name.isEmpty()) {
+            names.append(name);
+        }
+    }
+    return names;
+}
+
+QVector<QVector<int>> DAQThread::parseDeviceChannels(const QString &channelStr, int deviceCount)
+{
+    const QStringList groups = channelStr.split(";", Qt::SkipEmptyParts);
+    QVector<QVector<int>> result;
+    if (groups.size() > 1 && groups.size() != deviceCount) {
+        qDebug() << "[DAQThread] 通道分组数" << groups.size() << "与设备数" << deviceCount << "不一致";
+        return result;
     }
 
-    // 将数据发送到主线程
-    emit dataReady(timeData, channelData, numChannels);
+    for (int i = 0; i < deviceCount; ++i) {
+        const QVector<int> channels = parseChannels(groups.size() > 1 ? groups[i] : channelStr);
+        if (channels.isEmpty()) {
+            return {};
+        }
+        result.append(channels);
+    }
+    return result;
 }
 
 QVector<int> DAQThread::parseChannels(const QString &channelStr)
@@ -255,77 +581,124 @@ QVector<int> DAQThread::parseChannels(const QString &channelStr)
     return channels;
 }
 
-QString DAQThread::getDeviceChannelString(const QString &deviceName, const QVector<int> &channels)
-{
-    QStringList channelList;
+// 设备回调实现
+// 运行在设备回调线程：直接读入预分配的环形缓冲区槽位，不分配内存、不加锁
+namespace {
 
-    for (int ch : channels) {
-        channelList.append(QString("%1/ai%2").arg(deviceName).arg(ch));
+// 将设备中的一次回调数据读入环形缓冲区槽位
+template <typename T, typename ReadFn>
+void readIntoRing(DAQBlockRing<T> &ring, int numChannels, int nSamples, ReadFn readFn,
+                  quint64 &blockSequence, qint64 &sampleIndex)
+{
+    // 每个槽位最多容纳samplesPerChannel次扫描
+    const std::uint32_t slotSamples = std::uint32_t(ring.samplesPerSlot());
+    const int maxScans = int(slotSamples / std::uint32_t(numChannels));
+    const int scansToRead = nSamples < maxScans ? nSamples : maxScans;
+
+    // 缓冲区满时仍需把数据从设备中读出，读入丢弃槽位并计为溢出
+    T *slot = ring.beginWrite();
+    const bool overrun = (slot == nullptr);
+    if (overrun) {
+        slot = ring.discardSlot();
     }
 
-    QString result = channelList.join(",");
-    qDebug() << "生成设备通道字符串:" << result;
-    return result;
+    int read = 0;
+    const int errorCode = readFn(scansToRead, slot, slotSamples, &read);
+    if (errorCode < 0) {
+        qDebug() << "读取数据失败，错误码:" << errorCode;
+    } else if (read > 0) {
+        const quint64 sequence = blockSequence++;
+        if (overrun) {
+            ring.markOverrun();
+        } else {
+            ring.commitWrite(sequence, read, sampleIndex, PipelineClock::nowNs());
+        }
+        sampleIndex += read;
+    }
 }
 
-// 全局回调函数实现
-int32 ART_CALLBACK EveryNCallbackDAQ(TaskHandle taskHandle, int32 everyNsamplesEventType, uInt32 nSamples, void *callbackData)
+} // namespace
+
+void DAQThread::deviceSamplesCallback(void *context, int nSamples)
 {
-    int32 errorCode = 0;
-    char errBuff[2048] = {'\0'};
-    int32 read = 0;
+    DeviceContext *device = static_cast<DeviceContext *>(context);
 
-    // 检查全局指针是否有效
-    if (!g_daqThread || !g_daqThread->isAcquiring) {
-        qDebug() << "回调函数: g_daqThread无效或非采集状态";
-        return -1;
+    // 检查对象是否有效
+    if (!device || !device->owner || !device->owner->isAcquiring || !device->device) {
+        return;
     }
 
-    // 创建足够大的缓冲区来存储所有通道的数据
-    int numChannels = g_daqThread->numChannels;
-    int bufferSize = nSamples * numChannels;
-    float64 *data = new float64[bufferSize];
-
-    // 读取数据
-    errorCode = ArtDAQ_ReadAnalogF64(taskHandle, nSamples, 10.0, ArtDAQ_Val_GroupByScanNumber,
-                               data, bufferSize, &read, NULL);
+    // 首次回调时把该设备的回调线程固定到自己的核心上
+    if (!device->pinned) {
+        device->pinned = true;
+        if (device->cpuCore >= 0 && !pinCurrentThreadToCore(device->cpuCore)) {
+            qDebug() << "[DAQThread]" << device->deviceName << "回调线程绑定核心" << device->cpuCore << "失败";
+        }
+    }
 
-    if (errorCode < 0) {
-        ArtDAQ_GetExtendedErrorInfo(errBuff, 2048);
-        qDebug() << "读取数据失败: " << errBuff;
-    } else if (read > 0) {
-        qDebug() << "成功读取" << read << "个样本，" << numChannels << "个通道";
-        // 处理数据
-        g_daqThread->processData(data, read);
+    DAQDevice *backend = device->device.get();
+    const int channels = int(device->channels.size());
+    if (device->owner->rawModeActive) {
+        // 原始模式：直接读取16位ADC码值，不在回调中换算
+        if (!device->rawRing.isAllocated()) {
+            return;
+        }
+        readIntoRing(device->rawRing, channels, nSamples,
+                     [backend](int scans, std::int16_t *slot, std::uint32_t size, int *read) {
+                         return backend->readBinary(scans, slot, size, read);
+                     },
+                     device->producerBlockSequence, device->producerSampleIndex);
     } else {
-        qDebug() << "未读取到数据";
+        if (!device->ring.isAllocated()) {
+            return;
+        }
+        readIntoRing(device->ring, channels, nSamples,
+                     [backend](int scans, double *slot, std::uint32_t size, int *read) {
+                         return backend->readAnalog(scans, slot, size, read);
+                     },
+                     device->producerBlockSequence, device->producerSampleIndex);
     }
-
-    delete[] data;
-    return 0;
 }
 
-int32 ART_CALLBACK DoneCallbackDAQ(TaskHandle taskHandle, int32 status, void *callbackData)
+void DAQThread::deviceDoneCallback(void *context, int status, const char *message)
 {
-    int32 errorCode = 0;
-    char errBuff[2048] = {'\0'};
+    DeviceContext *device = static_cast<DeviceContext *>(context);
 
     // 检查是否由于错误停止
     if (status < 0) {
-        ArtDAQ_GetExtendedErrorInfo(errBuff, 2048);
-        qDebug() << "任务异常终止: " << errBuff;
-        if (g_daqThread) {
-            g_daqThread->isAcquiring = false;
-            emit g_daqThread->acquisitionStatus(false, QString("任务异常终止: %1").arg(errBuff));
+        qDebug() << "任务异常终止: " << message;
+        if (device && device->owner) {
+            // 回调中只停止写入环形缓冲区；其余设备的任务和取数定时器在DAQ线程中一起停止。
+            // 设备上下文在停止时释放，转到DAQ线程时只带走序号和文本
+            DAQThread *owner = device->owner;
+            const quint64 acquisition = device->acquisition;
+            const QString text = QString("%1 任务异常终止: %2").arg(device->deviceName, QString::fromUtf8(message));
+            owner->isAcquiring = false;
+            QMetaObject::invokeMethod(owner, [owner, acquisition, text]() {
+                if (acquisition != owner->acquisitionSerial || owner->devices.empty()) {
+                    // 已停止或已开始新的采集
+                    return;
+                }
+                owner->stopTask();
+                emit owner->acquisitionStatus(false, text);
+            }, Qt::QueuedConnection);
         }
     }
-
-    return 0;
 }
 
 // 设置滤波器启用状态
 void DAQThread::setFilterEnabled(bool enabled)
 {
+    // 滤波引擎归DAQ线程所有，跨线程调用时转到DAQ线程执行
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, enabled]() { setFilterEnabled(enabled); }, Qt::QueuedConnection);
+        return;
+    }
+
+    if (enabled && !filterEnabled) {
+        // 重新启用时清空历史，避免使用关闭前的旧样本
+        firFilter.reset();
+    }
     filterEnabled = enabled;
     qDebug() << "[DAQThread] 滤波器状态已设置为:" << (enabled ? "启用" : "禁用");
 }
@@ -333,6 +706,11 @@ void DAQThread::setFilterEnabled(bool enabled)
 // 设置截止频率
 void DAQThread::setCutoffFrequency(double frequency)
 {
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, frequency]() { setCutoffFrequency(frequency); }, Qt::QueuedConnection);
+        return;
+    }
+
     // 防止设置无效的截止频率
     if (frequency <= 0 || frequency >= sampleRate / 2.0) {
         qDebug() << "[DAQThread] 无效的截止频率:" << frequency << "必须在(0," << sampleRate/2.0 << ")范围内";
@@ -358,6 +736,98 @@ double DAQThread::getCutoffFrequency() const
     return cutoffFrequency;
 }
 
+// 设置是否发送完整滑动窗口
+void DAQThread::setFullWindowEnabled(bool enabled)
+{
+    // 窗口存储归DAQ线程所有，跨线程调用时转到DAQ线程执行
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, enabled]() { setFullWindowEnabled(enabled); }, Qt::QueuedConnection);
+        return;
+    }
+
+    fullWindowEnabled = enabled;
+    if (!enabled) {
+        // 关闭时释放窗口数据
+        windowHistory.release();
+        windowScratch.clear();
+    }
+    qDebug() << "[DAQThread] 完整窗口发送已设置为:" << (enabled ? "启用" : "禁用");
+}
+
+bool DAQThread::isFullWindowEnabled() const
+{
+    return fullWindowEnabled;
+}
+
+// 设置原始int16模式
+void DAQThread::setRawModeEnabled(bool enabled)
+{
+    // 采集配置由DAQ线程在开始采集时读取，跨线程调用时转到DAQ线程执行
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, enabled]() { setRawModeEnabled(enabled); }, Qt::QueuedConnection);
+        return;
+    }
+    rawModeEnabled = enabled;
+    qDebug() << "[DAQThread] 原始int16模式设置为:" << (enabled ? "启用" : "禁用") << "（下次开始采集时生效）";
+}
+
+bool DAQThread::isRawModeEnabled() const
+{
+    return rawModeEnabled;
+}
+
+// 设置模拟设备是否按采样率节拍运行
+void DAQThread::setSimulationRealTime(bool realTime)
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, realTime]() { setSimulationRealTime(realTime); }, Qt::QueuedConnection);
+        return;
+    }
+    simulationRealTime = realTime;
+    qDebug() << "[DAQThread] 模拟设备" << (realTime ? "按采样率节拍运行" : "尽快产生数据") << "（下次开始采集时生效）";
+}
+
+// 设置多设备同步终端
+void DAQThread::setSyncTerminals(const QString &startTrigger, const QString &sampleClock)
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, startTrigger, sampleClock]() { setSyncTerminals(startTrigger, sampleClock); },
+                                  Qt::QueuedConnection);
+        return;
+    }
+    syncStartTriggerTerminal = startTrigger.trimmed();
+    syncSampleClockTerminal = sampleClock.trimmed();
+    qDebug() << "[DAQThread] 多设备同步终端: 开始触发=" << syncStartTriggerTerminal
+             << "采样时钟=" << syncSampleClockTerminal << "（下次开始采集时生效）";
+}
+
+// 设置回调线程绑定的起始核心
+void DAQThread::setCoreAffinity(int firstCore)
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, firstCore]() { setCoreAffinity(firstCore); }, Qt::QueuedConnection);
+        return;
+    }
+    coreAffinityBase = firstCore < 0 ? -1 : firstCore;
+    qDebug() << "[DAQThread] 回调线程绑定起始核心:" << coreAffinityBase << "（下次开始采集时生效）";
+}
+
+// 设置环形缓冲区容量
+void DAQThread::setRingCapacity(int blocks)
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, blocks]() { setRingCapacity(blocks); }, Qt::QueuedConnection);
+        return;
+    }
+    // 采集期间回调线程正在写入环形缓冲区，不能改变容量
+    if (isAcquiring) {
+        qDebug() << "[DAQThread] 采集进行中，无法修改环形缓冲区容量";
+        return;
+    }
+    ringCapacity = qMax(2, blocks);
+    qDebug() << "[DAQThread] 环形缓冲区容量设置为:" << ringCapacity << "个数据块（下次开始采集时生效）";
+}
+
 // 计算FIR滤波器系数 - 使用Hamming窗函数
 void DAQThread::calculateFilterCoefficients()
 {
@@ -366,7 +836,7 @@ void DAQThread::calculateFilterCoefficients()
     filterOrder = 128; // 增加滤波器阶数以提高低频滤波效果
 
     // 重置滤波器系数
-    filterCoefficients.resize(filterOrder + 1);
+    std::vector<double> filterCoefficients(filterOrder + 1);
 
     // 归一化截止频率
     double normalizedCutoff = cutoffFrequency / sampleRate;
@@ -404,46 +874,9 @@ void DAQThread::calculateFilterCoefficients()
         filterCoefficients[i] /= sum;
     }
 
+    // 抽头数不变时滤波引擎保留各通道历史，切换截止频率不会产生瞬态
+    firFilter.setCoefficients(filterCoefficients);
+
     qDebug() << "[DAQThread] 已计算" << (filterOrder + 1) << "阶FIR滤波器系数，使用Hamming窗函数";
     qDebug() << "[DAQThread] 截止频率:" << cutoffFrequency << "Hz，采样率:" << sampleRate << "Hz";
 }
-
-// 应用滤波器到单个样本 - 优化版本
-double DAQThread::applyFilter(double sample, int channelIndex)
-{
-    // 检查通道索引是否有效
-    if (channelIndex < 0 || channelIndex >= filterBuffers.size()) {
-        return sample; // 如果无效，返回原始样本
-    }
-
-    // 确保缓冲区大小正确
-    if (filterBuffers[channelIndex].size() != filterOrder + 1) {
-        filterBuffers[channelIndex].resize(filterOrder + 1);
-        filterBuffers[channelIndex].fill(sample); // 初始化为当前样本值，减少初始瞬态
-    }
-
-    // 移动缓冲区数据 - 使用更高效的方式
-    memmove(&filterBuffers[channelIndex][1], &filterBuffers[channelIndex][0], filterOrder * sizeof(double));
-
-    // 将新样本添加到缓冲区开头
-    filterBuffers[channelIndex][0] = sample;
-
-    // 应用FIR滤波器 - 使用向量化计算提高效率
-    double result = 0.0;
-
-    // 将卷积计算分成多个块以提高缓存命中率
-    const int blockSize = 16; // 适合现代CPU缓存线的块大小
-
-    for (int i = 0; i <= filterOrder; i += blockSize) {
-        double blockSum = 0.0;
-        int blockEnd = qMin(i + blockSize, filterOrder + 1);
-
-        for (int j = i; j < blockEnd; j++) {
-            blockSum += filterBuffers[channelIndex][j] * filterCoefficients[j];
-        }
-
-        result += blockSum;
-    }
-
-    return result;
-}
\ No newline at end of file
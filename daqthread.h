@@ -3,42 +3,46 @@
 
 #include <QObject>
 #include <QVector>
+#include <QStringList>
+#include <QTimer>
+#include <QElapsedTimer>
 #include <QDebug>
-#include "Art_DAQ.h"
-
-// 定义必要的常量，确保这些常量在Art_DAQ.h中未定义的情况下可用
-#ifndef ArtDAQ_Val_Cfg_Default
-#define ArtDAQ_Val_Cfg_Default  -1
-#endif
-
-#ifndef ArtDAQ_Val_Volts
-#define ArtDAQ_Val_Volts     10348
-#endif
-
-#ifndef ArtDAQ_Val_Rising
-#define ArtDAQ_Val_Rising    10280
-#endif
-
-#ifndef ArtDAQ_Val_ContSamps
-#define ArtDAQ_Val_ContSamps 10123
-#endif
-
-#ifndef ArtDAQ_Val_Acquired_Into_Buffer
-#define ArtDAQ_Val_Acquired_Into_Buffer 1
-#endif
-
-#ifndef ArtDAQ_Val_GroupByScanNumber
-#define ArtDAQ_Val_GroupByScanNumber 1
-#endif
-
-// 定义回调函数类型
-#ifndef ART_CALLBACK
-#ifdef _WIN32
-#define ART_CALLBACK __cdecl
-#else
-#define ART_CALLBACK
-#endif
-#endif
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "daqdevice.h"
+#include "daqhistory.h"
+#include "daqringbuffer.h"
+#include "firfilter.h"
+#include "pipelineclock.h"
+
+// DAQ数据块：一次回调新增的样本，按通道优先（channel-major）连续存储
+struct DAQDataBlock {
+    quint64 sequence = 0;           // 块序号，每次开始采集后从0递增，用于检测丢块
+    qint64 firstSampleIndex = 0;    // 块内第一个样本的全局样本序号
+    int numChannels = 0;            // 通道数量
+    int samplesPerChannel = 0;      // 每通道样本数
+    double sampleRate = 0.0;        // 采样率（Hz）
+    qint64 timestampNs = 0;         // 设备回调读出本块数据的时刻（PipelineClock纳秒，多设备取最早），约为最后一个样本的采集时刻
+    QVector<double> samples;        // 样本数据（电压），大小为 numChannels * samplesPerChannel
+
+    // 原始模式下样本以ADC码值保存，samples为空
+    QVector<qint16> rawSamples;     // 原始码值，大小为 numChannels * samplesPerChannel
+    QVector<double> rawScale;       // 每通道换算系数：电压 = 码值 * rawScale + rawOffset
+    QVector<double> rawOffset;
+
+    // 指定通道样本的起始地址（仅电压模式）
+    const double *channel(int ch) const { return samples.constData() + qsizetype(ch) * samplesPerChannel; }
+    // 是否为原始码值数据块
+    bool isRaw() const { return !rawSamples.isEmpty(); }
+    // 指定通道原始码值的起始地址（仅原始模式）
+    const qint16 *rawChannel(int ch) const { return rawSamples.constData() + qsizetype(ch) * samplesPerChannel; }
+    // 取出指定通道的电压值，原始模式下批量换算；out至少容纳samplesPerChannel个值
+    void channelToVolts(int ch, double *out) const;
+    // 块内第一个样本的采集时间（秒，从开始采集算起）
+    double startTime() const { return sampleRate > 0.0 ? firstSampleIndex / sampleRate : 0.0; }
+};
 
 class DAQThread : public QObject
 {
@@ -50,6 +54,8 @@ public:
 
 public slots:
     // 用于从主线程接收命令的槽函数
+    // 多设备：deviceName用逗号分隔（如"Dev1,Dev2"，第一个为主设备），channelStr用分号按设备分组
+    // （如"0/1/2;0/1"），只有一组时所有设备使用相同通道。各设备通道按顺序合并为一个通道集
     void initDAQ(const QString &deviceName, const QString &channelStr, double sampleRate, int samplesPerChannel);
     void startAcquisition();
     void stopAcquisition();
@@ -60,62 +66,134 @@ public slots:
     bool isFilterEnabled() const;
     double getCutoffFrequency() const;
 
+    // 是否额外发送完整滑动窗口（dataReady），默认关闭，仅发送增量数据块
+    void setFullWindowEnabled(bool enabled);
+    bool isFullWindowEnabled() const;
+
+    // 设置回调环形缓冲区的容量（数据块个数），下次开始采集时生效；采集进行中时忽略
+    void setRingCapacity(int blocks);
+
+    // 原始int16模式：回调直接读取16位ADC码值（ArtDAQ_ReadBinaryI16），环形缓冲区与数据块均保存码值，
+    // 由需要浮点数的消费者批量换算；启用滤波器时数据块仍换算为电压。下次开始采集时生效
+    void setRawModeEnabled(bool enabled);
+    bool isRawModeEnabled() const;
+
+    // 模拟设备（设备名以"Sim"开头）是否按采样率节拍产生数据；关闭后尽快产生，用于吞吐量测试
+    void setSimulationRealTime(bool realTime);
+
+    // 多设备同步使用的终端（不含设备前缀，如"PFI0"）：主设备把开始触发和采样时钟导出到这两个终端，
+    // 从设备从同名终端接收；sampleClock为空时只共享开始触发。下次开始采集时生效
+    void setSyncTerminals(const QString &startTrigger, const QString &sampleClock);
+
+    // 设备回调线程绑定的起始核心：第i个设备的回调线程固定在firstCore+i核心上，-1表示不绑定。下次开始采集时生效
+    void setCoreAffinity(int firstCore);
+
 signals:
-    // 将数据发送到主线程的信号
+    // 每次回调新增的数据块（增量发送，消费者自行保存历史数据）
+    void dataBlockReady(const DAQDataBlock &block);
+    // 完整滑动窗口（最近10000点），需通过setFullWindowEnabled(true)开启
     void dataReady(QVector<double> timeData, QVector<QVector<double>> channelData, int numChannels);
     void acquisitionStatus(bool isRunning, QString message);
     void error(QString errorMessage);
+    // 回调环形缓冲区状态：溢出（丢弃）块数、已写入块数、当前占用、容量
+    void ringStatistics(quint64 overruns, quint64 blocksWritten, int fillLevel, int capacity);
+
+private slots:
+    // 由DAQ线程定时调用，批量取出环形缓冲区中的数据块
+    void drainRing();
 
 private:
-    // 数据采集任务句柄
-    TaskHandle taskHandle;
+    // 单个采集设备：独立的任务、回调和环形缓冲区
+    struct DeviceContext {
+        DAQThread *owner = nullptr;
+        QString deviceName;
+        QVector<int> channels;                   // 物理通道号
+        int channelOffset = 0;                   // 在合并通道集中的起始序号
+        std::unique_ptr<DAQDevice> device;       // 采集设备后端（ArtDAQ硬件或模拟设备）
+        DAQBlockRing<double> ring;               // 电压模式，由回调写入、drainRing读取
+        DAQBlockRing<std::int16_t> rawRing;      // 原始int16模式
+        quint64 producerBlockSequence = 0;       // 回调线程维护的数据块序号（含被丢弃的块）
+        qint64 producerSampleIndex = 0;          // 回调线程维护的样本序号
+        int cpuCore = -1;                        // 回调线程绑定的核心，-1表示不绑定
+        bool pinned = false;                     // 回调线程是否已绑定（仅回调线程使用）
+        quint64 acquisition = 0;                 // 所属采集的序号（acquisitionSerial）
+    };
+
+    // 本次采集的设备，第一个为主设备；每次开始采集时按设备名称创建
+    std::vector<std::unique_ptr<DeviceContext>> devices;
+    bool simulationRealTime;
+    QString syncStartTriggerTerminal;        // 多设备同步：开始触发终端
+    QString syncSampleClockTerminal;         // 多设备同步：采样时钟终端
+    int coreAffinityBase;                    // 回调线程绑定的起始核心
+    quint64 mergeDrops;                      // 因某个设备丢块而无法合并、被丢弃的数据块数
+    quint64 acquisitionSerial;               // 每次开始采集加1，丢弃上一次采集迟到的异常终止通知
     // 采样率
     double sampleRate;
     // 每次读取的样本数
     int samplesPerChannel;
     // 通道数量
     int numChannels;
-    // 是否正在采集
-    bool isAcquiring;
+    // 是否正在采集（驱动回调线程也会读取）
+    std::atomic<bool> isAcquiring;
     // 设备名称
     QString m_deviceName;
     // 通道字符串
     QString m_channelStr;
     // 解析通道字符串
     QVector<int> parseChannels(const QString &channelStr);
-    // 获取设备/通道字符串
-    QString getDeviceChannelString(const QString &deviceName, const QVector<int> &channels);
-
-    // 回调函数所需的数据
-    QVector<QVector<double>> channelData;
-    QVector<double> timeData;
+    // 解析设备名称列表和按设备分组的通道，失败时返回空列表
+    QStringList parseDeviceNames(const QString &deviceName) const;
+    QVector<QVector<int>> parseDeviceChannels(const QString &channelStr, int deviceCount);
+
+    // 完整滑动窗口数据
+    DAQHistoryStore windowHistory;           // 完整滑动窗口（通道优先环形存储，仅在开启时分配）
+    QVector<double> windowScratch;           // 原始码值换算为电压的临时缓冲区
+
+    // 增量数据块相关
+    bool fullWindowEnabled;                  // 是否发送完整滑动窗口
+    qint64 totalSamplesAcquired;             // 已采集的每通道样本总数
+
+    // 回调与DAQ线程之间的无锁环形缓冲区位于各DeviceContext中（按模式只分配其中一个）
+    std::atomic<bool> rawModeEnabled;        // 配置：下次采集是否使用原始模式（可在其他线程查询）
+    bool rawModeActive;                      // 本次采集是否使用原始模式（回调线程读取）
+    QVector<double> rawScale;                // 每通道码值换算系数（合并通道集）
+    QVector<double> rawOffset;               // 每通道码值换算偏移
+    int ringCapacity;                        // 每个设备的环形缓冲区容量（数据块个数）
+    QTimer *drainTimer;                      // 批量取数定时器（属于DAQ线程）
+    QElapsedTimer ringStatsTimer;            // 控制状态信号的发送频率
+    quint64 lastReportedOverruns;            // 上次报告的溢出数
 
     // 低通滤波器相关变量
     bool filterEnabled;                      // 滤波器启用状态
     double cutoffFrequency;                  // 截止频率（Hz）
-    QVector<QVector<double>> filterBuffers;  // 每个通道的滤波缓冲区
-    QVector<double> filterCoefficients;      // FIR滤波器系数
+    BlockFirFilter firFilter;                // 分块FIR滤波引擎（仅在DAQ线程中使用）
     int filterOrder;                         // 滤波器阶数
 
-    // 友元声明以便回调函数可以访问私有成员
-    friend int32 ART_CALLBACK EveryNCallbackDAQ(TaskHandle taskHandle, int32 everyNsamplesEventType,
-                                       uInt32 nSamples, void *callbackData);
-    friend int32 ART_CALLBACK DoneCallbackDAQ(TaskHandle taskHandle, int32 status, void *callbackData);
-
-    // 数据处理方法
-    void processData(float64 *data, int32 read);
+    // 设备回调（运行在设备回调线程）：直接读入预分配的环形缓冲区槽位，不分配内存、不加锁
+    static void deviceSamplesCallback(void *context, int nSamples);
+    static void deviceDoneCallback(void *context, int status, const char *message);
+
+    // 停止并清理任务（在DAQ线程或析构时调用）
+    void stopTask();
+
+    // 数据处理方法（在DAQ线程中执行），data[i]为第i个设备的交错样本
+    void processData(const double *const *data, int read, quint64 sequence, qint64 firstSampleIndex, qint64 timestampNs);
+    void processRawData(const std::int16_t *const *data, int read, quint64 sequence, qint64 firstSampleIndex,
+                        qint64 timestampNs);
+    void filterBlock(DAQDataBlock &block);
+    void publishBlock(const DAQDataBlock &block);
+    // 合并阶段：各设备环形缓冲区中序号相同的数据块合并为一个数据块
+    template <typename T>
+    void drainBlocks();
+    template <typename T>
+    static DAQBlockRing<T> &ringOf(DeviceContext &context);
+    void reportRingStatistics();
+
+    // 查询各通道量程，计算原始码值的换算系数
+    void queryRawScaling(DeviceContext &context);
 
     // 滤波器相关方法
-    void calculateFilterCoefficients();      // 计算滤波器系数
-    double applyFilter(double sample, int channelIndex); // 应用滤波器到单个样本
+    void calculateFilterCoefficients();      // 计算滤波器系数并更新滤波引擎
 };
 
-// 声明回调函数
-int32 ART_CALLBACK EveryNCallbackDAQ(TaskHandle taskHandle, int32 everyNsamplesEventType,
-                           uInt32 nSamples, void *callbackData);
-int32 ART_CALLBACK DoneCallbackDAQ(TaskHandle taskHandle, int32 status, void *callbackData);
-
-// 全局变量，供回调函数使用
-extern DAQThread* g_daqThread;
-
 #endif // DAQTHREAD_H
\ No newline at end of file
@@ -90,11 +90,13 @@ void DashboardCalculator::run()
             }
             
             // 预处理公式，替换变量为数值
-            QString processedFormula = request.formula;
+            QString processedFormula;
             
-            // 使用正则表达式查找变量模式（如A_0, B_1等）
-            static QRegularExpression varPattern("([A-Z]_[0-9]+)");
+            // 使用正则表达式查找变量模式（如A_0, B_1, 以及DAQ窗口统计B_0.max/min/mean/rms）
+            // 按匹配位置重建公式，避免 A_1 误替换 A_10 中的前缀
+            static QRegularExpression varPattern("([A-Z]_[0-9]+(?:\\.(?:min|max|mean|rms))?)");
             QRegularExpressionMatchIterator matches = varPattern.globalMatch(request.formula);
+            int lastEnd = 0;
             
             // 记录变量替换前后的情况，帮助诊断问题
             bool hasUnknownVars = false;
@@ -109,18 +111,21 @@ void DashboardCalculator::run()
             while (matches.hasNext()) {
                 QRegularExpressionMatch match = matches.next();
                 QString varName = match.captured(1);
+                processedFormula += request.formula.mid(lastEnd, match.capturedStart(1) - lastEnd);
+                lastEnd = match.capturedEnd(1);
                 
                 if (allVariablesCopy.contains(varName)) {
                     // 使用变量表中的值替换变量名
                     double value = allVariablesCopy[varName];
-                    processedFormula.replace(varName, QString::number(value));
+                    processedFormula += QString::number(value);
                 } else {
                     // 如果变量未提供，使用0
                     qDebug() << "变量" << varName << "未提供值，使用默认值0";
-                    processedFormula.replace(varName, "0");
+                    processedFormula += "0";
                     hasUnknownVars = true;
                 }
             }
+            processedFormula += request.formula.mid(lastEnd);
             
             // 输出处理后的公式，帮助调试
             qDebug() << "处理后的公式:" << processedFormula;
@@ -0,0 +1,202 @@
+#include "datasnapshot.h"
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+struct SnapshotPoolState {
+    std::mutex mutex;
+    std::vector<SnapshotSlot *> freeSlots;
+    int allocated = 0;
+    bool closed = false;
+};
+
+struct SnapshotSlot {
+    DataSnapshot snapshot;
+    std::atomic<int> refs{0};
+    std::shared_ptr<SnapshotPoolState> pool;
+};
+
+namespace {
+
+// 槽位的最后一个引用释放：放回池中，池已销毁时删除
+void recycleSlot(SnapshotSlot *slot)
+{
+    // 先持有池状态，删除槽位时不会在持锁期间析构互斥量
+    const std::shared_ptr<SnapshotPoolState> state = slot->pool;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (!state->closed) {
+            state->freeSlots.push_back(slot);
+            return;
+        }
+        --state->allocated;
+    }
+    delete slot;
+}
+
+const DataSnapshot &emptySnapshot()
+{
+    static const DataSnapshot snapshot;
+    return snapshot;
+}
+
+} // namespace
+
+void DataSnapshot::assignValues(QVector<double> &dst, const QVector<double> &src)
+{
+    dst.resize(src.size());
+    std::copy(src.cbegin(), src.cend(), dst.begin());
+}
+
+void DataSnapshot::copyFrom(const DataSnapshot &other)
+{
+    if (this == &other) {
+        return;
+    }
+    timestamp = other.timestamp;
+    assignValues(modbusData, other.modbusData);
+    assignValues(daqData, other.daqData);
+    assignValues(daqMin, other.daqMin);
+    assignValues(daqMax, other.daqMax);
+    assignValues(daqMean, other.daqMean);
+    assignValues(daqRms, other.daqRms);
+    assignValues(ecuData, other.ecuData);
+    assignValues(customData, other.customData);
+    customValid.resize(other.customValid.size());
+    std::copy(other.customValid.cbegin(), other.customValid.cend(), customValid.begin());
+    modbusValid = other.modbusValid;
+    daqValid = other.daqValid;
+    ecuValid = other.ecuValid;
+    daqRunning = other.daqRunning;
+    snapshotIndex = other.snapshotIndex;
+    modbusAge = other.modbusAge;
+    daqAge = other.daqAge;
+    ecuAge = other.ecuAge;
+    acquiredNs = other.acquiredNs;
+    tickNs = other.tickNs;
+    builtNs = other.builtNs;
+    publishedNs = other.publishedNs;
+}
+
+SnapshotHandle::SnapshotHandle(SnapshotSlot *slot)
+    : m_slot(slot)
+{
+    if (m_slot) {
+        m_slot->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+SnapshotHandle::SnapshotHandle(const SnapshotHandle &other)
+    : m_slot(other.m_slot)
+{
+    if (m_slot) {
+        m_slot->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+SnapshotHandle::SnapshotHandle(SnapshotHandle &&other) noexcept
+    : m_slot(other.m_slot)
+{
+    other.m_slot = nullptr;
+}
+
+SnapshotHandle &SnapshotHandle::operator=(const SnapshotHandle &other)
+{
+    if (m_slot != other.m_slot) {
+        if (other.m_slot) {
+            other.m_slot->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        release();
+        m_slot = other.m_slot;
+    }
+    return *this;
+}
+
+SnapshotHandle &SnapshotHandle::operator=(SnapshotHandle &&other) noexcept
+{
+    if (this != &other) {
+        release();
+        m_slot = other.m_slot;
+        other.m_slot = nullptr;
+    }
+    return *this;
+}
+
+SnapshotHandle::~SnapshotHandle()
+{
+    release();
+}
+
+void SnapshotHandle::release()
+{
+    // acq_rel：其他线程对快照的读取先于回收后的改写
+    if (m_slot && m_slot->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        recycleSlot(m_slot);
+    }
+    m_slot = nullptr;
+}
+
+const DataSnapshot *SnapshotHandle::get() const
+{
+    return m_slot ? &m_slot->snapshot : &emptySnapshot();
+}
+
+int SnapshotHandle::useCount() const
+{
+    return m_slot ? m_slot->refs.load(std::memory_order_acquire) : 0;
+}
+
+DataSnapshot *SnapshotHandle::uniqueData()
+{
+    return useCount() == 1 ? &m_slot->snapshot : nullptr;
+}
+
+SnapshotPool::SnapshotPool()
+    : m_state(std::make_shared<SnapshotPoolState>())
+{
+}
+
+SnapshotPool::~SnapshotPool()
+{
+    std::vector<SnapshotSlot *> released;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->closed = true;
+        released.swap(m_state->freeSlots);
+        m_state->allocated -= int(released.size());
+    }
+    for (SnapshotSlot *slot : released) {
+        delete slot;
+    }
+}
+
+SnapshotHandle SnapshotPool::acquire()
+{
+    SnapshotSlot *slot = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        if (!m_state->freeSlots.empty()) {
+            slot = m_state->freeSlots.back();
+            m_state->freeSlots.pop_back();
+        } else {
+            ++m_state->allocated;
+        }
+    }
+    if (!slot) {
+        slot = new SnapshotSlot;
+        slot->pool = m_state;
+    }
+    return SnapshotHandle(slot);
+}
+
+int SnapshotPool::freeCount() const
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return int(m_state->freeSlots.size());
+}
+
+int SnapshotPool::allocatedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->allocated;
+}
@@ -0,0 +1,126 @@
+#ifndef DATASNAPSHOT_H
+#define DATASNAPSHOT_H
+
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+// 使用与MainWindow相同的数据快照类
+class DataSnapshot {
+public: // 公开访问成员
+    double timestamp;                   // 时间戳（秒）
+    QVector<double> modbusData;         // Modbus数据(一维) - 每个寄存器的值
+    QVector<double> daqData;            // DAQ数据(一维) - 修改为一维，每个通道只保留最新值
+    QVector<double> daqMin;             // DAQ窗口统计：两次快照之间全部样本的最小值
+    QVector<double> daqMax;             // DAQ窗口统计：最大值
+    QVector<double> daqMean;            // DAQ窗口统计：平均值
+    QVector<double> daqRms;             // DAQ窗口统计：均方根
+    QVector<double> ecuData;            // ECU数据(9通道)
+    QVector<double> customData;         // 新增：自定义计算数据
+    QVector<bool> customValid;          // 各派生通道是否有效（所用数据源有效且引用的通道存在），与customData等长；无效时customData为0
+    bool modbusValid;                   // Modbus数据有效标志
+    bool daqValid;                      // DAQ数据有效标志
+    bool ecuValid;                      // ECU数据有效标志
+    bool daqRunning;                    // DAQ运行状态标志
+    int snapshotIndex;                  // 快照索引（序号）
+    // 各数据源的时效（秒）：快照时刻与所用数据中最近一次采集的时间差，无数据时为-1
+    double modbusAge;
+    double daqAge;
+    double ecuAge;
+    // 管线各阶段时刻（PipelineClock纳秒，0表示未知），用于延迟统计
+    qint64 acquiredNs;                  // 所用各数据源最近一次采集时刻中最早的一个
+    qint64 tickNs;                      // 快照调度触发、开始生成
+    qint64 builtNs;                     // 原始快照（含派生通道）生成完成
+    qint64 publishedNs;                 // 校准完成、发布给各接收者
+
+    // 构造函数，初始化所有数据
+    DataSnapshot() {
+        timestamp = 0.0;                // 初始化为0秒
+        modbusData.resize(16, 0.0);     // 16个Modbus寄存器
+        daqData.resize(16, 0.0);        // 16个DAQ通道，每个通道只保存最新值
+        daqMin.resize(16, 0.0);
+        daqMax.resize(16, 0.0);
+        daqMean.resize(16, 0.0);
+        daqRms.resize(16, 0.0);
+        ecuData.resize(9, 0.0);         // 9个ECU通道
+        customData.resize(5, 0.0);      // 初始化自定义数据，预留5个位置
+        customValid.resize(5, false);
+        modbusValid = false;
+        daqValid = false;
+        ecuValid = false;
+        daqRunning = false;             // 初始化DAQ运行状态为false
+        snapshotIndex = 0;              // 初始化索引为0
+        modbusAge = -1.0;
+        daqAge = -1.0;
+        ecuAge = -1.0;
+        acquiredNs = 0;
+        tickNs = 0;
+        builtNs = 0;
+        publishedNs = 0;
+    }
+
+    // 原地复制全部字段：目标已有足够容量时不分配内存（池中复用的快照使用）
+    void copyFrom(const DataSnapshot &other);
+    // 原地复制数组内容，不与源共享缓冲区
+    static void assignValues(QVector<double> &dst, const QVector<double> &src);
+};
+
+struct SnapshotSlot;
+struct SnapshotPoolState;
+
+// 不可变快照句柄
+//
+// 引用计数的只读快照，跨线程传递（队列连接、队列缓存、日志）时只复制指针；
+// 最后一个句柄释放后快照回到所在的SnapshotPool中复用，稳态下不再分配内存。
+// 空句柄解引用得到一个全部为默认值的快照。
+class SnapshotHandle
+{
+public:
+    SnapshotHandle() = default;
+    SnapshotHandle(const SnapshotHandle &other);
+    SnapshotHandle(SnapshotHandle &&other) noexcept;
+    SnapshotHandle &operator=(const SnapshotHandle &other);
+    SnapshotHandle &operator=(SnapshotHandle &&other) noexcept;
+    ~SnapshotHandle();
+
+    bool isNull() const { return m_slot == nullptr; }
+    const DataSnapshot &operator*() const { return *get(); }
+    const DataSnapshot *operator->() const { return get(); }
+    const DataSnapshot *get() const;
+
+    // 当前引用数（空句柄为0）
+    int useCount() const;
+    // 唯一持有者在发布前填充快照；句柄已被共享时返回nullptr
+    DataSnapshot *uniqueData();
+
+private:
+    friend class SnapshotPool;
+    explicit SnapshotHandle(SnapshotSlot *slot);
+    void release();
+
+    SnapshotSlot *m_slot = nullptr;
+};
+
+// 快照对象池：槽位在释放后按原容量复用（各QVector保持已分配的缓冲区）。
+// 池对象销毁后仍在使用的句柄照常有效，释放时直接删除。
+class SnapshotPool
+{
+public:
+    SnapshotPool();
+    ~SnapshotPool();
+
+    SnapshotPool(const SnapshotPool &) = delete;
+    SnapshotPool &operator=(const SnapshotPool &) = delete;
+
+    // 取出一个快照（池为空时新建），返回时为唯一持有，内容为上次使用后的值，调用者负责填充全部字段
+    SnapshotHandle acquire();
+
+    // 空闲槽位数和已分配槽位总数
+    int freeCount() const;
+    int allocatedCount() const;
+
+private:
+    std::shared_ptr<SnapshotPoolState> m_state;
+};
+
+#endif // DATASNAPSHOT_H
@@ -0,0 +1,374 @@
+#include "decimator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+
+const int DefaultCicOrder = 4;
+
+// 低速输出（<100Hz）时每个抽头的延迟都很可观，使用较短的滤波器
+const double LowRateThreshold = 100.0;
+
+double hamming(int n, int length)
+{
+    if (length <= 1) {
+        return 1.0;
+    }
+    return 0.54 - 0.46 * std::cos(2.0 * M_PI * n / (length - 1));
+}
+
+// 判断rate是否为整数比（容许浮点误差）
+bool integerRatio(double from, double to, int *ratio)
+{
+    if (from <= 0.0 || to <= 0.0 || to > from) {
+        return false;
+    }
+    const double r = from / to;
+    const double rounded = std::round(r);
+    if (rounded < 1.0 || std::fabs(r - rounded) > 1e-6 * rounded) {
+        return false;
+    }
+    *ratio = int(rounded);
+    return true;
+}
+
+} // namespace
+
+MultiStageDecimator::MultiStageDecimator()
+    : m_inputRate(0.0)
+{
+}
+
+bool MultiStageDecimator::configure(double inputRate, const std::vector<double> &outputRates, int channels)
+{
+    std::vector<StageSpec> stages;
+    double rate = inputRate;
+    for (double target : outputRates) {
+        int ratio = 1;
+        if (!integerRatio(rate, target, &ratio)) {
+            m_stages.clear();
+            m_channels.clear();
+            return false;
+        }
+        planRatio(ratio, target, &stages);
+        rate = target;
+    }
+    return build(inputRate, stages, channels);
+}
+
+bool MultiStageDecimator::configure(double inputRate, const std::vector<StageSpec> &stages, int channels)
+{
+    return build(inputRate, stages, channels);
+}
+
+void MultiStageDecimator::planRatio(int ratio, double outputRate, std::vector<StageSpec> *stages)
+{
+    if (ratio <= 1) {
+        return;
+    }
+
+    // ratio = R * 2^k
+    int k = 0;
+    int r = ratio;
+    while ((r & 1) == 0) {
+        r >>= 1;
+        ++k;
+    }
+
+    const bool lowRate = outputRate < LowRateThreshold;
+
+    if (r > 1) {
+        StageSpec cic;
+        cic.type = StageType::CIC;
+        cic.factor = r;
+        cic.taps = DefaultCicOrder;
+        stages->push_back(cic);
+    }
+    for (int i = 1; i < k; ++i) {
+        StageSpec hb;
+        hb.type = StageType::HalfBand;
+        hb.factor = 2;
+        hb.taps = lowRate ? 7 : 11;
+        stages->push_back(hb);
+    }
+
+    // 最后一级补偿FIR；奇数抽取比时以↓1运行，仅做下垂补偿
+    StageSpec comp;
+    comp.type = StageType::CompensatedFIR;
+    comp.factor = k > 0 ? 2 : 1;
+    comp.taps = lowRate ? 15 : 31;
+    stages->push_back(comp);
+}
+
+bool MultiStageDecimator::build(double inputRate, const std::vector<StageSpec> &specs, int channels)
+{
+    m_stages.clear();
+    m_channels.clear();
+    if (inputRate <= 0.0 || channels <= 0 || specs.empty()) {
+        return false;
+    }
+
+    m_inputRate = inputRate;
+    double rate = inputRate;
+
+    // 记录最近一个CIC，供其后的补偿FIR计算下垂
+    int cicFactor = 1;
+    int cicOrder = 0;
+    double cicRateRatio = 1.0;   // CIC输入速率 / 当前级输入速率
+
+    for (const StageSpec &spec : specs) {
+        if (spec.factor < 1) {
+            m_stages.clear();
+            return false;
+        }
+
+        Stage stage;
+        stage.spec = spec;
+        std::vector<double> h;
+        switch (spec.type) {
+        case StageType::CIC:
+            h = designCic(spec.factor, std::max(1, spec.taps));
+            break;
+        case StageType::HalfBand:
+            stage.spec.factor = 2;
+            h = designHalfBand(spec.taps);
+            break;
+        case StageType::CompensatedFIR:
+            h = designCompensator(std::max(3, spec.taps), spec.factor, cicFactor, cicOrder, cicRateRatio);
+            break;
+        }
+        setCoefficients(&stage, h);
+
+        if (spec.type == StageType::CIC) {
+            cicFactor = spec.factor;
+            cicOrder = std::max(1, spec.taps);
+            cicRateRatio = 1.0;
+        }
+        cicRateRatio *= stage.spec.factor;
+
+        rate /= stage.spec.factor;
+        stage.outputRate = rate;
+        m_stages.push_back(stage);
+    }
+
+    m_channels.assign(size_t(channels), std::vector<StageState>(m_stages.size()));
+    reset();
+    return true;
+}
+
+void MultiStageDecimator::reset()
+{
+    for (std::vector<StageState> &states : m_channels) {
+        for (size_t s = 0; s < states.size(); ++s) {
+            StageState &state = states[s];
+            state.work.assign(size_t(m_stages[s].length - 1), 0.0);
+            state.phase = 0;
+            state.out.clear();
+            state.produced = 0;
+        }
+    }
+}
+
+int MultiStageDecimator::stageForRate(double rate) const
+{
+    for (size_t s = 0; s < m_stages.size(); ++s) {
+        if (std::fabs(m_stages[s].outputRate - rate) <= 1e-6 * rate) {
+            return int(s);
+        }
+    }
+    return -1;
+}
+
+double MultiStageDecimator::groupDelay(int stageIndex) const
+{
+    double delay = 0.0;
+    double rate = m_inputRate;
+    for (int s = 0; s <= stageIndex && s < int(m_stages.size()); ++s) {
+        delay += (m_stages[size_t(s)].length - 1) / 2.0 / rate;
+        rate = m_stages[size_t(s)].outputRate;
+    }
+    return delay;
+}
+
+double MultiStageDecimator::macsPerSecond() const
+{
+    double macs = 0.0;
+    for (const Stage &stage : m_stages) {
+        macs += double(stage.coefs.size()) * stage.outputRate;
+    }
+    return macs;
+}
+
+void MultiStageDecimator::process(int channel, const double *input, int count)
+{
+    if (channel < 0 || channel >= int(m_channels.size())) {
+        return;
+    }
+
+    std::vector<StageState> &states = m_channels[size_t(channel)];
+    const double *in = input;
+    int n = count;
+
+    for (size_t s = 0; s < m_stages.size(); ++s) {
+        const Stage &stage = m_stages[s];
+        StageState &state = states[s];
+
+        state.produced += std::int64_t(state.out.size());
+        state.out.clear();
+        if (n <= 0) {
+            in = nullptr;
+            n = 0;
+            continue;
+        }
+
+        const size_t history = size_t(stage.length - 1);
+        if (state.work.size() < history + size_t(n)) {
+            state.work.resize(history + size_t(n));
+        }
+        double *w = state.work.data();
+        std::memcpy(w + history, in, size_t(n) * sizeof(double));
+
+        // 只在输出点上计算，跳过零系数
+        const int factor = stage.spec.factor;
+        const int *offsets = stage.offsets.data();
+        const double *coefs = stage.coefs.data();
+        const size_t nonZero = stage.coefs.size();
+        int j = state.phase;
+        for (; j < n; j += factor) {
+            const double *x = w + j;
+            double acc = 0.0;
+            for (size_t i = 0; i < nonZero; ++i) {
+                acc += coefs[i] * x[offsets[i]];
+            }
+            state.out.push_back(acc);
+        }
+        state.phase = j - n;
+
+        if (history > 0) {
+            std::memmove(w, w + n, history * sizeof(double));
+        }
+
+        in = state.out.data();
+        n = int(state.out.size());
+    }
+}
+
+const std::vector<double> &MultiStageDecimator::output(int channel, int stageIndex) const
+{
+    return m_channels[size_t(channel)][size_t(stageIndex)].out;
+}
+
+std::int64_t MultiStageDecimator::outputOffset(int channel, int stageIndex) const
+{
+    return m_channels[size_t(channel)][size_t(stageIndex)].produced;
+}
+
+void MultiStageDecimator::setCoefficients(Stage *stage, const std::vector<double> &h)
+{
+    const int length = int(h.size());
+    stage->length = length;
+    stage->offsets.clear();
+    stage->coefs.clear();
+    for (int k = 0; k < length; ++k) {
+        if (h[size_t(k)] != 0.0) {
+            // y[j] = sum(h[k] * x[j-k])，x[j]位于窗口的length-1+j处
+            stage->offsets.push_back(length - 1 - k);
+            stage->coefs.push_back(h[size_t(k)]);
+        }
+    }
+}
+
+// CIC：N个长度为R的滑动平均级联，直流增益归一化为1
+std::vector<double> MultiStageDecimator::designCic(int factor, int order)
+{
+    std::vector<double> h(1, 1.0);
+    for (int n = 0; n < order; ++n) {
+        std::vector<double> next(h.size() + size_t(factor) - 1, 0.0);
+        for (size_t i = 0; i < h.size(); ++i) {
+            for (int r = 0; r < factor; ++r) {
+                next[i + size_t(r)] += h[i] / factor;
+            }
+        }
+        h.swap(next);
+    }
+    return h;
+}
+
+// 半带滤波器：截止0.25fs的加窗sinc，偶数偏移处系数为零
+std::vector<double> MultiStageDecimator::designHalfBand(int taps)
+{
+    // 长度取4m+3，保证两端系数非零
+    int length = std::max(3, taps);
+    while ((length - 3) % 4 != 0) {
+        ++length;
+    }
+
+    const int center = (length - 1) / 2;
+    std::vector<double> h(size_t(length), 0.0);
+    double oddSum = 0.0;
+    for (int n = 0; n < length; ++n) {
+        const int m = n - center;
+        if (m % 2 != 0) {
+            h[size_t(n)] = std::sin(M_PI * m / 2.0) / (M_PI * m) * hamming(n, length);
+            oddSum += h[size_t(n)];
+        }
+    }
+    // 中心系数固定为0.5，其余非零系数之和归一化为0.5，使直流增益为1且保持半带特性
+    for (double &value : h) {
+        value *= 0.5 / oddSum;
+    }
+    h[size_t(center)] = 0.5;
+    return h;
+}
+
+// 补偿FIR：频率采样法，通带内幅度为1/|H_cic(f)|，截止在输出奈奎斯特频率的90%
+std::vector<double> MultiStageDecimator::designCompensator(int taps, int factor, int cicFactor, int cicOrder,
+                                                           double cicRateRatio)
+{
+    const int length = taps | 1;   // 奇数长度，保证整数群延迟
+    const double cutoff = 0.45 / factor;
+    const int gridPoints = 2048;
+
+    auto desired = [&](double f) {
+        if (cicFactor <= 1 || cicOrder <= 0) {
+            return 1.0;
+        }
+        // f相对于本级输入速率，换算到CIC输入速率
+        const double fc = f / cicRateRatio;
+        const double denominator = cicFactor * std::sin(M_PI * fc);
+        const double response = std::fabs(denominator) < 1e-12 ? 1.0
+                              : std::pow(std::fabs(std::sin(M_PI * fc * cicFactor) / denominator), cicOrder);
+        return std::min(1.0 / std::max(response, 1e-6), 4.0);
+    };
+
+    const double center = (length - 1) / 2.0;
+    std::vector<double> h(size_t(length), 0.0);
+    const double df = cutoff / gridPoints;
+    for (int n = 0; n < length; ++n) {
+        const double m = n - center;
+        double value = 0.0;
+        for (int g = 0; g < gridPoints; ++g) {
+            const double f = (g + 0.5) * df;
+            value += desired(f) * std::cos(2.0 * M_PI * f * m);
+        }
+        h[size_t(n)] = 2.0 * value * df * hamming(n, length);
+    }
+
+    // 直流增益归一化为1
+    double sum = 0.0;
+    for (double value : h) {
+        sum += value;
+    }
+    if (std::fabs(sum) > 1e-12) {
+        for (double &value : h) {
+            value /= sum;
+        }
+    }
+    return h;
+}
@@ -0,0 +1,93 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 多级抗混叠抽取器
+//
+// 将全速率DAQ数据逐级降采样到绘图速率（如1kHz）和快照速率（如10Hz）。
+// 每一级的总抽取比按 R * 2^k 分解为：
+//   CIC(R) -> 半带滤波器(↓2) x (k-1) -> 补偿FIR(↓2)
+// CIC承担大部分抽取（仅需少量乘加），补偿FIR同时抵消CIC通带下垂并决定最终过渡带。
+// 所有级均只在输出点上计算（多相方式），半带滤波器跳过零系数。
+// 由于样本为浮点数，CIC以非递归形式（N个长度为R的滑动平均级联后的系数）实现，
+// 避免积分器累积误差。
+class MultiStageDecimator
+{
+public:
+    enum class StageType {
+        CIC,            // 级联积分梳状滤波器
+        HalfBand,       // 半带滤波器，固定↓2
+        CompensatedFIR  // 补偿FIR，抵消前面CIC的通带下垂
+    };
+
+    struct StageSpec {
+        StageType type = StageType::CIC;
+        int factor = 1;     // 抽取比
+        int taps = 0;       // FIR抽头数（CIC为阶数N）
+    };
+
+    MultiStageDecimator();
+
+    // 按输出速率链自动规划，例如 inputRate=10000, outputRates={1000, 10}；
+    // 相邻速率之比必须为整数，否则返回false
+    bool configure(double inputRate, const std::vector<double> &outputRates, int channels);
+    // 使用显式给定的级配置
+    bool configure(double inputRate, const std::vector<StageSpec> &stages, int channels);
+
+    // 清空所有通道的滤波历史与输出计数
+    void reset();
+
+    bool isConfigured() const { return !m_stages.empty(); }
+    int channelCount() const { return int(m_channels.size()); }
+    int stageCount() const { return int(m_stages.size()); }
+    const StageSpec &stage(int index) const { return m_stages[size_t(index)].spec; }
+    double inputRate() const { return m_inputRate; }
+    double stageOutputRate(int index) const { return m_stages[size_t(index)].outputRate; }
+
+    // 输出速率等于rate的级索引，不存在时返回-1
+    int stageForRate(double rate) const;
+    // 从输入到指定级输出的累计群延迟（秒）
+    double groupDelay(int stageIndex) const;
+    // 每通道每秒的乘加次数估计
+    double macsPerSecond() const;
+
+    // 处理一个通道的数据块，各级输出可通过output()读取（每次调用前清空）
+    void process(int channel, const double *input, int count);
+
+    // 最近一次process()中指定级产生的输出
+    const std::vector<double> &output(int channel, int stageIndex) const;
+    // 最近一次process()之前，指定级已输出的样本总数（用于计算输出样本的时间）
+    std::int64_t outputOffset(int channel, int stageIndex) const;
+
+private:
+    struct Stage {
+        StageSpec spec;
+        double outputRate = 0.0;
+        int length = 0;                 // 完整系数长度
+        std::vector<int> offsets;       // 非零系数在[历史 | 当前块]窗口中的偏移
+        std::vector<double> coefs;      // 非零系数
+    };
+
+    struct StageState {
+        std::vector<double> work;       // [历史(length-1) | 当前块]
+        int phase = 0;                  // 当前块中下一个输出点的位置
+        std::vector<double> out;        // 本次输出
+        std::int64_t produced = 0;      // 已输出样本总数（不含本次）
+    };
+
+    bool build(double inputRate, const std::vector<StageSpec> &stages, int channels);
+    static void planRatio(int ratio, double outputRate, std::vector<StageSpec> *stages);
+    static void setCoefficients(Stage *stage, const std::vector<double> &h);
+    static std::vector<double> designCic(int factor, int order);
+    static std::vector<double> designHalfBand(int taps);
+    static std::vector<double> designCompensator(int taps, int factor, int cicFactor, int cicOrder, double cicRateRatio);
+
+    double m_inputRate;
+    std::vector<Stage> m_stages;
+    std::vector<std::vector<StageState>> m_channels;
+};
+
+#endif // DECIMATOR_H
@@ -0,0 +1,483 @@
+#include "derivedchannels.h"
+#include <QHash>
+#include <QPair>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// 变量读取的数组编号
+enum LoadArray : quint8 {
+    ModbusArray,
+    DAQArray,
+    DAQMinArray,
+    DAQMaxArray,
+    DAQMeanArray,
+    DAQRmsArray,
+    ECUArray
+};
+
+double divide(double a, double b)
+{
+    return b != 0.0 ? a / b : 0.0; // 防止除以零
+}
+
+} // namespace
+
+// 递归下降解析公式，边解析边生成指令（每个运算结果占用一个新寄存器，常量子表达式在编译时求值）
+class DerivedChannelCompiler
+{
+public:
+    explicit DerivedChannelCompiler(DerivedChannelProgram &program) : m_program(program) {}
+
+    bool compileChannel(int channel, const QString &formula, QString *error)
+    {
+        m_text = formula;
+        m_pos = 0;
+        m_channel = channel;
+        m_sources = 0;
+        m_loadsUsed.clear();
+        m_error.clear();
+        m_errorPos = 0;
+
+        const int result = parseExpression();
+        skipSpaces();
+        if (m_error.isEmpty() && m_pos < m_text.size()) {
+            fail(QString("无法识别的字符 '%1'").arg(m_text[m_pos]));
+        }
+        if (!m_error.isEmpty()) {
+            *error = QString("派生通道D_%1公式 \"%2\" 第%3个字符: %4").arg(channel).arg(formula).arg(m_errorPos + 1).arg(m_error);
+            return false;
+        }
+        m_program.m_outputs.push_back(result);
+        m_program.m_channelSources.push_back(m_sources);
+
+        std::sort(m_loadsUsed.begin(), m_loadsUsed.end());
+        m_loadsUsed.erase(std::unique(m_loadsUsed.begin(), m_loadsUsed.end()), m_loadsUsed.end());
+        if (m_program.m_channelLoadBegin.empty()) {
+            m_program.m_channelLoadBegin.push_back(0);
+        }
+        m_program.m_channelLoads.insert(m_program.m_channelLoads.end(), m_loadsUsed.begin(), m_loadsUsed.end());
+        m_program.m_channelLoadBegin.push_back(int(m_program.m_channelLoads.size()));
+        return true;
+    }
+
+private:
+    using OpCode = DerivedChannelProgram::OpCode;
+
+    void fail(const QString &message)
+    {
+        if (m_error.isEmpty()) {
+            m_error = message;
+            m_errorPos = m_pos;
+        }
+    }
+
+    void skipSpaces()
+    {
+        while (m_pos < m_text.size() && m_text[m_pos].isSpace()) {
+            ++m_pos;
+        }
+    }
+
+    bool accept(QChar c)
+    {
+        skipSpaces();
+        if (m_pos < m_text.size() && m_text[m_pos] == c) {
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+
+    int newRegister(double initial = 0.0)
+    {
+        m_program.m_initial.push_back(initial);
+        m_isConstant.push_back(false);
+        return int(m_program.m_initial.size()) - 1;
+    }
+
+    int constant(double value)
+    {
+        quint64 key = 0;
+        std::memcpy(&key, &value, sizeof(key)); // 按位比较，区分0与-0
+        auto it = m_constants.constFind(key);
+        if (it != m_constants.constEnd()) {
+            return it.value();
+        }
+        const int reg = newRegister(value);
+        m_isConstant[size_t(reg)] = true;
+        m_constants.insert(key, reg);
+        return reg;
+    }
+
+    int load(quint8 array, int index, quint8 source)
+    {
+        m_sources |= source;
+        const QPair<int, int> key(array, index);
+        auto it = m_loadRegisters.constFind(key);
+        if (it != m_loadRegisters.constEnd()) {
+            m_loadsUsed.push_back(it.value().second);
+            return it.value().first;
+        }
+        const int reg = newRegister();
+        const int loadIndex = int(m_program.m_loads.size());
+        m_program.m_loads.push_back({array, index, reg});
+        m_loadRegisters.insert(key, qMakePair(reg, loadIndex));
+        m_loadsUsed.push_back(loadIndex);
+        return reg;
+    }
+
+    static double apply(OpCode op, double a, double b)
+    {
+        switch (op) {
+        case DerivedChannelProgram::Add: return a + b;
+        case DerivedChannelProgram::Sub: return a - b;
+        case DerivedChannelProgram::Mul: return a * b;
+        case DerivedChannelProgram::Div: return divide(a, b);
+        case DerivedChannelProgram::Pow: return std::pow(a, b);
+        case DerivedChannelProgram::Neg: return -a;
+        case DerivedChannelProgram::Abs: return std::fabs(a);
+        case DerivedChannelProgram::Sqrt: return std::sqrt(a);
+        case DerivedChannelProgram::Min: return std::fmin(a, b);
+        case DerivedChannelProgram::Max: return std::fmax(a, b);
+        }
+        return 0.0;
+    }
+
+    int emitOp(OpCode op, int a, int b = -1)
+    {
+        if (a < 0 || (b < 0 && op < DerivedChannelProgram::Neg)) {
+            return -1; // 操作数已出错
+        }
+        const bool constA = m_isConstant[size_t(a)];
+        const bool constB = b < 0 || m_isConstant[size_t(b)];
+        if (constA && constB) {
+            return constant(apply(op, m_program.m_initial[size_t(a)], b < 0 ? 0.0 : m_program.m_initial[size_t(b)]));
+        }
+        const int dst = newRegister();
+        m_program.m_code.push_back({op, dst, a, b < 0 ? a : b});
+        return dst;
+    }
+
+    // expression := term (('+' | '-') term)*
+    int parseExpression()
+    {
+        int left = parseTerm();
+        while (m_error.isEmpty()) {
+            if (accept('+')) {
+                left = emitOp(DerivedChannelProgram::Add, left, parseTerm());
+            } else if (accept('-')) {
+                left = emitOp(DerivedChannelProgram::Sub, left, parseTerm());
+            } else {
+                break;
+            }
+        }
+        return left;
+    }
+
+    // term := unary (('*' | '/') unary)*
+    int parseTerm()
+    {
+        int left = parseUnary();
+        while (m_error.isEmpty()) {
+            if (accept('*')) {
+                left = emitOp(DerivedChannelProgram::Mul, left, parseUnary());
+            } else if (accept('/')) {
+                left = emitOp(DerivedChannelProgram::Div, left, parseUnary());
+            } else {
+                break;
+            }
+        }
+        return left;
+    }
+
+    // unary := ('-' | '+') unary | power
+    int parseUnary()
+    {
+        if (accept('-')) {
+            return emitOp(DerivedChannelProgram::Neg, parseUnary());
+        }
+        if (accept('+')) {
+            return parseUnary();
+        }
+        return parsePower();
+    }
+
+    // power := primary ('^' unary)?（右结合）
+    int parsePower()
+    {
+        const int base = parsePrimary();
+        if (m_error.isEmpty() && accept('^')) {
+            return emitOp(DerivedChannelProgram::Pow, base, parseUnary());
+        }
+        return base;
+    }
+
+    int parsePrimary()
+    {
+        skipSpaces();
+        if (m_pos >= m_text.size()) {
+            fail("公式不完整");
+            return -1;
+        }
+        if (accept('(')) {
+            const int value = parseExpression();
+            if (m_error.isEmpty() && !accept(')')) {
+                fail("缺少 ')'");
+            }
+            return value;
+        }
+
+        const QChar c = m_text[m_pos];
+        if (c.isDigit() || c == '.') {
+            return parseNumber();
+        }
+        if (c.isLetter()) {
+            int end = m_pos;
+            while (end < m_text.size() && (m_text[end].isLetterOrNumber() || m_text[end] == '_')) {
+                ++end;
+            }
+            const QString word = m_text.mid(m_pos, end - m_pos);
+            if (word.size() >= 3 && word[1] == '_' && QString("ABCD").contains(word[0])) {
+                return parseVariable(word, end);
+            }
+            m_pos = end;
+            return parseFunction(word);
+        }
+        fail(QString("无法识别的字符 '%1'").arg(c));
+        return -1;
+    }
+
+    int parseNumber()
+    {
+        int end = m_pos;
+        while (end < m_text.size() && (m_text[end].isDigit() || m_text[end] == '.')) {
+            ++end;
+        }
+        // 指数部分（如1e-3）
+        if (end < m_text.size() && (m_text[end] == 'e' || m_text[end] == 'E')) {
+            int exp = end + 1;
+            if (exp < m_text.size() && (m_text[exp] == '+' || m_text[exp] == '-')) {
+                ++exp;
+            }
+            if (exp < m_text.size() && m_text[exp].isDigit()) {
+                end = exp;
+                while (end < m_text.size() && m_text[end].isDigit()) {
+                    ++end;
+                }
+            }
+        }
+        bool ok = false;
+        const double value = m_text.mid(m_pos, end - m_pos).toDouble(&ok);
+        if (!ok) {
+            fail(QString("无效的数值 \"%1\"").arg(m_text.mid(m_pos, end - m_pos)));
+            return -1;
+        }
+        m_pos = end;
+        return constant(value);
+    }
+
+    // A_n、B_n、B_n.min/max/mean/rms、C_n、D_n
+    int parseVariable(const QString &word, int end)
+    {
+        bool ok = false;
+        const int index = word.mid(2).toInt(&ok);
+        if (!ok || index < 0) {
+            fail(QString("无效的变量 \"%1\"").arg(word));
+            return -1;
+        }
+        m_pos = end;
+
+        switch (word[0].toLatin1()) {
+        case 'A':
+            return load(ModbusArray, index, DerivedChannelProgram::ModbusBit);
+        case 'B':
+            if (m_pos < m_text.size() && m_text[m_pos] == '.') {
+                int statEnd = m_pos + 1;
+                while (statEnd < m_text.size() && m_text[statEnd].isLetter()) {
+                    ++statEnd;
+                }
+                const QString stat = m_text.mid(m_pos + 1, statEnd - m_pos - 1);
+                const QStringList stats = {"min", "max", "mean", "rms"};
+                const int k = stats.indexOf(stat);
+                if (k < 0) {
+                    fail(QString("无效的DAQ窗口统计 \"%1\"（应为min/max/mean/rms）").arg(stat));
+                    return -1;
+                }
+                m_pos = statEnd;
+                return load(quint8(DAQMinArray + k), index, DerivedChannelProgram::DAQBit);
+            }
+            return load(DAQArray, index, DerivedChannelProgram::DAQBit);
+        case 'C':
+            return load(ECUArray, index, DerivedChannelProgram::ECUBit);
+        default:
+            // 只能引用已经计算的派生通道
+            if (index >= m_channel) {
+                fail(QString("D_%1 尚未计算（只能引用编号更小的派生通道）").arg(index));
+                return -1;
+            }
+            m_sources |= m_program.m_channelSources[size_t(index)];
+            m_loadsUsed.insert(m_loadsUsed.end(),
+                               m_program.m_channelLoads.begin() + m_program.m_channelLoadBegin[size_t(index)],
+                               m_program.m_channelLoads.begin() + m_program.m_channelLoadBegin[size_t(index) + 1]);
+            return m_program.m_outputs[size_t(index)];
+        }
+    }
+
+    int parseFunction(const QString &name)
+    {
+        struct Function {
+            const char *name;
+            OpCode op;
+            int arguments;
+        };
+        static const Function functions[] = {
+            {"abs", DerivedChannelProgram::Abs, 1},
+            {"sqrt", DerivedChannelProgram::Sqrt, 1},
+            {"min", DerivedChannelProgram::Min, 2},
+            {"max", DerivedChannelProgram::Max, 2},
+            {"pow", DerivedChannelProgram::Pow, 2}
+        };
+        const Function *function = nullptr;
+        for (const Function &f : functions) {
+            if (name.compare(f.name, Qt::CaseInsensitive) == 0) {
+                function = &f;
+            }
+        }
+        if (!function) {
+            fail(QString("未知的函数或变量 \"%1\"").arg(name));
+            return -1;
+        }
+        if (!accept('(')) {
+            fail(QString("函数 %1 缺少 '('").arg(name));
+            return -1;
+        }
+        const int a = parseExpression();
+        int b = -1;
+        if (function->arguments == 2 && m_error.isEmpty() && !accept(',')) {
+            fail(QString("函数 %1 需要2个参数").arg(name));
+        }
+        if (function->arguments == 2 && m_error.isEmpty()) {
+            b = parseExpression();
+        }
+        if (m_error.isEmpty() && !accept(')')) {
+            fail(QString("函数 %1 缺少 ')'").arg(name));
+        }
+        return m_error.isEmpty() ? emitOp(function->op, a, b) : -1;
+    }
+
+    DerivedChannelProgram &m_program;
+    QString m_text;
+    int m_pos = 0;
+    int m_channel = 0;
+    quint8 m_sources = 0;
+    QString m_error;
+    int m_errorPos = 0;
+    std::vector<bool> m_isConstant;
+    QHash<quint64, int> m_constants;
+    QHash<QPair<int, int>, QPair<int, int>> m_loadRegisters;   // (数组, 通道) -> (寄存器, 读取编号)
+    std::vector<int> m_loadsUsed;   // 当前公式（含引用的派生通道）读取的变量
+};
+
+DerivedChannelProgram DerivedChannelProgram::compile(const QVector<DerivedChannel> &channels, QString *error)
+{
+    DerivedChannelProgram program;
+    DerivedChannelCompiler compiler(program);
+    for (int i = 0; i < channels.size(); ++i) {
+        if (!compiler.compileChannel(i, channels[i].formula, error)) {
+            return DerivedChannelProgram();
+        }
+    }
+    program.m_channels = channels;
+    return program;
+}
+
+QVector<DerivedChannel> DerivedChannelProgram::defaultChannels()
+{
+    return {
+        {"Custom_0", QString(), "B_0 * C_0 * 10"},
+        {"Custom_1", QString(), "B_1 * C_1"},
+        {"Custom_2", QString(), "B_2 * C_2"},
+        {"Custom_3", QString(), "0"},
+        {"Custom_4", QString(), "0"}
+    };
+}
+
+QStringList DerivedChannelProgram::channelNames() const
+{
+    QStringList names;
+    for (const DerivedChannel &channel : m_channels) {
+        names << channel.name;
+    }
+    return names;
+}
+
+QStringList DerivedChannelProgram::channelUnits() const
+{
+    QStringList units;
+    for (const DerivedChannel &channel : m_channels) {
+        units << channel.unit;
+    }
+    return units;
+}
+
+void DerivedChannelProgram::evaluate(DataSnapshot &snapshot, std::vector<double> &registers) const
+{
+    registers.assign(m_initial.begin(), m_initial.end());
+    double *r = registers.data();
+
+    // 无效的数据源；读取不存在的通道只使引用了该变量的派生通道无效
+    quint8 invalid = 0;
+    if (!snapshot.modbusValid) invalid |= ModbusBit;
+    if (!snapshot.daqValid) invalid |= DAQBit;
+    if (!snapshot.ecuValid) invalid |= ECUBit;
+
+    const QVector<double> *arrays[] = {&snapshot.modbusData, &snapshot.daqData, &snapshot.daqMin, &snapshot.daqMax,
+                                       &snapshot.daqMean, &snapshot.daqRms, &snapshot.ecuData};
+    bool missing = false;
+    for (const Load &load : m_loads) {
+        const QVector<double> &source = *arrays[load.array];
+        if (load.index < source.size()) {
+            r[load.dst] = source[load.index];
+        } else {
+            missing = true;
+        }
+    }
+
+    for (const Instruction &ins : m_code) {
+        const double a = r[ins.a];
+        const double b = r[ins.b];
+        switch (ins.op) {
+        case Add: r[ins.dst] = a + b; break;
+        case Sub: r[ins.dst] = a - b; break;
+        case Mul: r[ins.dst] = a * b; break;
+        case Div: r[ins.dst] = divide(a, b); break;
+        case Pow: r[ins.dst] = std::pow(a, b); break;
+        case Neg: r[ins.dst] = -a; break;
+        case Abs: r[ins.dst] = std::fabs(a); break;
+        case Sqrt: r[ins.dst] = std::sqrt(a); break;
+        case Min: r[ins.dst] = std::fmin(a, b); break;
+        case Max: r[ins.dst] = std::fmax(a, b); break;
+        }
+    }
+
+    const int count = channelCount();
+    snapshot.customData.resize(count);
+    snapshot.customValid.resize(count);
+    for (int i = 0; i < count; ++i) {
+        bool ok = (m_channelSources[size_t(i)] & invalid) == 0;
+        if (ok && missing) {
+            for (int k = m_channelLoadBegin[size_t(i)]; k < m_channelLoadBegin[size_t(i) + 1]; ++k) {
+                const Load &load = m_loads[size_t(m_channelLoads[size_t(k)])];
+                if (load.index >= arrays[load.array]->size()) {
+                    ok = false;
+                    break;
+                }
+            }
+        }
+        snapshot.customData[i] = ok ? r[m_outputs[size_t(i)]] : 0.0;
+        snapshot.customValid[i] = ok;
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef DERIVEDCHANNELS_H
+#define DERIVEDCHANNELS_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <vector>
+#include "datasnapshot.h"
+
+// 派生通道定义（DataSnapshot::customData的一个通道，变量名D_n）
+struct DerivedChannel {
+    QString name;
+    QString unit;
+    QString formula;
+};
+
+// 编译后的派生通道程序
+//
+// 公式语法：数值常量、变量 A_n（Modbus）、B_n（DAQ）、B_n.min/max/mean/rms（DAQ窗口统计）、
+// C_n（ECU）、D_n（编号更小的派生通道），运算符 + - * / ^、括号，函数 abs、sqrt、min、max、pow。
+// 全部公式一次编译为寄存器指令：常量和变量各占一个寄存器，同一变量在所有公式中只读取一次；
+// 每个快照先按顺序读取变量，再执行各公式的指令，不做字符串替换或解析。
+// 除数为0时结果为0（与仪表盘公式一致）。公式引用的数据源无效或通道不存在时，该派生通道输出0。
+// 编译完成后只读，可在多个线程间共享；求值使用调用者提供的寄存器缓冲区。
+class DerivedChannelProgram
+{
+public:
+    DerivedChannelProgram() = default;
+
+    // 编译全部派生通道；任一公式有误时返回空程序，error给出通道和出错位置
+    static DerivedChannelProgram compile(const QVector<DerivedChannel> &channels, QString *error);
+    // 默认定义：与原先固定写在快照线程中的5个自定义通道相同
+    static QVector<DerivedChannel> defaultChannels();
+
+    int channelCount() const { return int(m_channels.size()); }
+    const QVector<DerivedChannel> &channels() const { return m_channels; }
+    QStringList channelNames() const;
+    QStringList channelUnits() const;
+
+    // 对快照求值，结果写入snapshot.customData，各通道是否有效写入snapshot.customValid（大小均为channelCount()）。
+    // registers为调用者持有的寄存器缓冲区（保留容量，稳态下不分配内存）
+    void evaluate(DataSnapshot &snapshot, std::vector<double> &registers) const;
+
+private:
+    enum OpCode : quint8 {
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Pow,
+        Neg,
+        Abs,
+        Sqrt,
+        Min,
+        Max
+    };
+
+    // 数据源位（用于有效性判断）
+    enum SourceBit : quint8 {
+        ModbusBit = 0x01,
+        DAQBit = 0x02,
+        ECUBit = 0x04
+    };
+
+    // 变量读取：从快照的某个数组读取一个通道到寄存器
+    struct Load {
+        quint8 array;      // 见derivedchannels.cpp中的数组编号
+        int index;
+        int dst;
+    };
+
+    struct Instruction {
+        OpCode op;
+        int dst;
+        int a;
+        int b;
+    };
+
+    friend class DerivedChannelCompiler;
+
+    QVector<DerivedChannel> m_channels;
+    std::vector<double> m_initial;          // 寄存器初值（常量寄存器的值，其余为0）
+    std::vector<Load> m_loads;
+    std::vector<Instruction> m_code;
+    std::vector<int> m_outputs;             // 每个派生通道结果所在的寄存器
+    std::vector<quint8> m_channelSources;   // 每个派生通道（含间接引用）依赖的数据源位
+    std::vector<int> m_channelLoads;        // 每个派生通道（含间接引用）读取的变量（m_loads下标），按通道依次排列
+    std::vector<int> m_channelLoadBegin;    // 通道i的变量为m_channelLoads[m_channelLoadBegin[i], m_channelLoadBegin[i+1])
+};
+
+#endif // DERIVEDCHANNELS_H
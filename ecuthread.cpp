@@ -1,4 +1,5 @@
 #include "ecuthread.h"
+#include "pipelinelatency.h"
 
 ECUThread::ECUThread(QObject *parent)
     : QObject{parent}
@@ -106,6 +107,7 @@ void ECUThread::processSerialData()
     }
     
     // 读取可用数据
+    const qint64 readNs = PipelineClock::nowNs();
     dataBuffer.append(serialPort->readAll());
     
     // 处理缓冲区中的数据
@@ -141,6 +143,8 @@ void ECUThread::processSerialData()
         if (parseECUData(frame, ecuData)) {
             // 设置时间戳
             ecuData.timestamp = QDateTime::currentDateTime();
+            ecuData.acquiredNs = PipelineClock::nowNs();
+            PipelineLatency::record(PipelineLatency::ECUAcquire, ecuData.acquiredNs - readNs);
             
             // 发送解析成功的数据
             qDebug() << "[ECUThread] Emitting ecuDataReady. Data isValid:" << ecuData.isValid;
@@ -9,6 +9,7 @@
 #include <QDebug>
 #include <QDateTime>
 #include <QVector>
+#include "pipelineclock.h"
 
 // ECU数据结构体
 struct ECUData {
@@ -50,6 +51,7 @@ struct ECUData {
     bool flightTimeError;     // 飞行时间故障
     
     bool isValid;             // 数据是否有效
+    qint64 acquiredNs = 0;    // 数据帧解析完成的时刻（PipelineClock纳秒）
 
     // 默认构造函数
     ECUData() : 
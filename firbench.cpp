@@ -0,0 +1,193 @@
+// FIR滤波引擎基准测试
+//
+// 对比原先DAQThread逐样本的FIR滤波（每个样本移动一次历史缓冲区再做一次点积）和分块滤波引擎BlockFirFilter：
+// 先用随机数据和随机块长校验两者输出一致（误差不超过--tolerance），再分别测量每个数据块的处理时间。
+// 抽头数达到FFT阈值且块足够长时，分块引擎使用FFT重叠保留法。
+//
+// 示例：firbench --channels 16 --block 1000 --taps 129,513 --blocks 200
+//       firbench --channels 4 --block 10000 --taps 1025,2049
+#include "firfilter.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QtMath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+// 与DAQThread::calculateFilterCoefficients相同的Hamming窗sinc低通设计
+std::vector<double> designLowPass(int taps, double normalizedCutoff)
+{
+    const int order = taps - 1;
+    std::vector<double> h(size_t(taps), 0.0);
+    double sum = 0.0;
+    for (int i = 0; i <= order; ++i) {
+        double coef;
+        if (2 * i == order) {
+            coef = 2.0 * normalizedCutoff;
+        } else {
+            const double x = 2.0 * M_PI * normalizedCutoff * (i - order / 2.0);
+            coef = qSin(x) / x;
+        }
+        h[size_t(i)] = coef * (0.54 - 0.46 * qCos(2.0 * M_PI * i / qMax(1, order)));
+        sum += h[size_t(i)];
+    }
+    for (double &c : h) {
+        c /= sum;
+    }
+    return h;
+}
+
+// 原先的逐样本滤波：每个样本把历史缓冲区整体后移一位，新样本放在开头，再与系数做点积
+class PerSampleFirFilter
+{
+public:
+    PerSampleFirFilter(const std::vector<double> &coefficients, int channels)
+        : m_coefficients(coefficients), m_buffers(size_t(channels), std::vector<double>(coefficients.size(), 0.0))
+    {
+    }
+
+    double apply(double sample, int channel)
+    {
+        std::vector<double> &buffer = m_buffers[size_t(channel)];
+        const int order = int(m_coefficients.size()) - 1;
+        std::memmove(&buffer[1], &buffer[0], size_t(order) * sizeof(double));
+        buffer[0] = sample;
+
+        double result = 0.0;
+        const int blockSize = 16;
+        for (int i = 0; i <= order; i += blockSize) {
+            double blockSum = 0.0;
+            const int blockEnd = qMin(i + blockSize, order + 1);
+            for (int j = i; j < blockEnd; ++j) {
+                blockSum += buffer[size_t(j)] * m_coefficients[size_t(j)];
+            }
+            result += blockSum;
+        }
+        return result;
+    }
+
+private:
+    std::vector<double> m_coefficients;
+    std::vector<std::vector<double>> m_buffers;
+};
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("firbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("对比逐样本FIR滤波与分块FIR滤波引擎的输出和耗时");
+    parser.addHelpOption();
+    QCommandLineOption channelsOption("channels", "通道数", "n", "16");
+    QCommandLineOption blockOption("block", "每个数据块每通道的样本数", "n", "1000");
+    QCommandLineOption tapsOption("taps", "抽头数，逗号分隔时依次测试", "list", "129,513");
+    QCommandLineOption blocksOption("blocks", "计时的数据块个数", "n", "200");
+    QCommandLineOption cutoffOption("cutoff", "归一化截止频率（截止频率/采样率）", "f", "0.05");
+    QCommandLineOption toleranceOption("tolerance", "允许的最大输出误差", "e", "1e-9");
+    parser.addOptions({channelsOption, blockOption, tapsOption, blocksOption, cutoffOption, toleranceOption});
+    parser.process(app);
+
+    const int channels = qMax(1, parser.value(channelsOption).toInt());
+    const int blockSize = qMax(1, parser.value(blockOption).toInt());
+    const int blocks = qMax(1, parser.value(blocksOption).toInt());
+    const double cutoff = qBound(0.001, parser.value(cutoffOption).toDouble(), 0.45);
+    const double tolerance = parser.value(toleranceOption).toDouble();
+    QVector<int> tapsList;
+    for (const QString &value : parser.value(tapsOption).split(',', Qt::SkipEmptyParts)) {
+        tapsList.append(qMax(1, value.trimmed().toInt()));
+    }
+    if (tapsList.isEmpty()) {
+        tapsList.append(129);
+    }
+
+    std::mt19937 random(12345);
+    std::uniform_real_distribution<double> sample(-10.0, 10.0);
+    std::uniform_int_distribution<int> randomBlock(1, blockSize * 2);
+
+    qInfo().noquote() << QString("通道 %1，数据块 %2 样本/通道，%3 个数据块，AVX2 %4")
+                             .arg(channels).arg(blockSize).arg(blocks).arg(BlockFirFilter::usesAvx2() ? "是" : "否");
+
+    bool allOk = true;
+    for (int taps : tapsList) {
+        const std::vector<double> h = designLowPass(taps, cutoff);
+
+        // 一致性：随机块长（覆盖短于抽头数的块和直接/FFT两种方式的切换），逐通道比较
+        double maxError = 0.0;
+        {
+            PerSampleFirFilter reference(h, channels);
+            BlockFirFilter filter;
+            filter.setChannelCount(channels);
+            filter.setCoefficients(h);
+            std::vector<double> input;
+            std::vector<double> output;
+            for (int b = 0; b < 50; ++b) {
+                const int count = randomBlock(random);
+                input.resize(size_t(count));
+                output.resize(size_t(count));
+                for (int ch = 0; ch < channels; ++ch) {
+                    for (double &x : input) {
+                        x = sample(random);
+                    }
+                    filter.process(ch, input.data(), output.data(), count);
+                    for (int i = 0; i < count; ++i) {
+                        maxError = qMax(maxError, qAbs(output[size_t(i)] - reference.apply(input[size_t(i)], ch)));
+                    }
+                }
+            }
+        }
+        const bool ok = maxError <= tolerance;
+        allOk = allOk && ok;
+
+        // 计时：两者处理相同的数据块序列
+        std::vector<double> data(size_t(channels) * size_t(blockSize));
+        for (double &x : data) {
+            x = sample(random);
+        }
+        std::vector<double> output(size_t(blockSize));
+        volatile double sink = 0.0;
+
+        PerSampleFirFilter reference(h, channels);
+        QElapsedTimer timer;
+        timer.start();
+        for (int b = 0; b < blocks; ++b) {
+            for (int ch = 0; ch < channels; ++ch) {
+                const double *in = data.data() + size_t(ch) * size_t(blockSize);
+                for (int i = 0; i < blockSize; ++i) {
+                    output[size_t(i)] = reference.apply(in[i], ch);
+                }
+                sink = sink + output[0];
+            }
+        }
+        const double oldMs = timer.nsecsElapsed() / 1e6 / blocks;
+
+        BlockFirFilter filter;
+        filter.setChannelCount(channels);
+        filter.setCoefficients(h);
+        timer.restart();
+        for (int b = 0; b < blocks; ++b) {
+            for (int ch = 0; ch < channels; ++ch) {
+                filter.process(ch, data.data() + size_t(ch) * size_t(blockSize), output.data(), blockSize);
+                sink = sink + output[0];
+            }
+        }
+        const double newMs = timer.nsecsElapsed() / 1e6 / blocks;
+
+        qInfo().noquote() << QString("抽头 %1（%2）：逐样本 %3 ms/块，分块 %4 ms/块（%5倍），最大误差 %6%7")
+                                 .arg(taps, 4)
+                                 .arg(filter.method() == BlockFirFilter::Method::FFT ? "FFT" : "直接卷积")
+                                 .arg(oldMs, 0, 'f', 3).arg(newMs, 0, 'f', 3)
+                                 .arg(newMs > 0.0 ? oldMs / newMs : 0.0, 0, 'f', 1)
+                                 .arg(maxError, 0, 'g', 3)
+                                 .arg(ok ? QString() : QString("，超过允许误差 %1").arg(tolerance));
+    }
+    return allOk ? 0 : 1;
+}
@@ -0,0 +1,342 @@
+#include "firfilter.h"
+#include "cpufeatures.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+
+// ---- 直接卷积内核：w为[历史 | 当前块]，hr为反序系数，out[i] = sum(hr[k] * w[i+k]) ----
+
+void firDirectScalar(const double *w, const double *hr, int taps, double *out, int begin, int count)
+{
+    for (int i = begin; i < count; ++i) {
+        const double *x = w + i;
+        double acc = 0.0;
+        for (int k = 0; k < taps; ++k) {
+            acc += hr[k] * x[k];
+        }
+        out[i] = acc;
+    }
+}
+
+#ifdef SIMD_HAVE_SSE2
+// SSE2：每次计算4个输出点
+void firDirectSse2(const double *w, const double *hr, int taps, double *out, int count)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const double *x = w + i;
+        __m128d acc0 = _mm_setzero_pd();
+        __m128d acc1 = _mm_setzero_pd();
+        for (int k = 0; k < taps; ++k) {
+            const __m128d h = _mm_set1_pd(hr[k]);
+            acc0 = _mm_add_pd(acc0, _mm_mul_pd(h, _mm_loadu_pd(x + k)));
+            acc1 = _mm_add_pd(acc1, _mm_mul_pd(h, _mm_loadu_pd(x + k + 2)));
+        }
+        _mm_storeu_pd(out + i, acc0);
+        _mm_storeu_pd(out + i + 2, acc1);
+    }
+    firDirectScalar(w, hr, taps, out, i, count);
+}
+#endif
+
+#ifdef SIMD_HAVE_X86
+// AVX2/FMA：每次计算16个输出点，4个累加器隐藏FMA延迟
+SIMD_TARGET_AVX2 void firDirectAvx2(const double *w, const double *hr, int taps, double *out, int count)
+{
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const double *x = w + i;
+        __m256d acc0 = _mm256_setzero_pd();
+        __m256d acc1 = _mm256_setzero_pd();
+        __m256d acc2 = _mm256_setzero_pd();
+        __m256d acc3 = _mm256_setzero_pd();
+        for (int k = 0; k < taps; ++k) {
+            const __m256d h = _mm256_broadcast_sd(hr + k);
+            acc0 = _mm256_fmadd_pd(h, _mm256_loadu_pd(x + k), acc0);
+            acc1 = _mm256_fmadd_pd(h, _mm256_loadu_pd(x + k + 4), acc1);
+            acc2 = _mm256_fmadd_pd(h, _mm256_loadu_pd(x + k + 8), acc2);
+            acc3 = _mm256_fmadd_pd(h, _mm256_loadu_pd(x + k + 12), acc3);
+        }
+        _mm256_storeu_pd(out + i, acc0);
+        _mm256_storeu_pd(out + i + 4, acc1);
+        _mm256_storeu_pd(out + i + 8, acc2);
+        _mm256_storeu_pd(out + i + 12, acc3);
+    }
+    for (; i + 4 <= count; i += 4) {
+        const double *x = w + i;
+        __m256d acc = _mm256_setzero_pd();
+        for (int k = 0; k < taps; ++k) {
+            acc = _mm256_fmadd_pd(_mm256_broadcast_sd(hr + k), _mm256_loadu_pd(x + k), acc);
+        }
+        _mm256_storeu_pd(out + i, acc);
+    }
+    firDirectScalar(w, hr, taps, out, i, count);
+}
+#endif
+
+// 复数乘法（显式展开，避免std::complex乘法的NaN/Inf慢路径）
+inline std::complex<double> cmul(const std::complex<double> &a, const std::complex<double> &b)
+{
+    return std::complex<double>(a.real() * b.real() - a.imag() * b.imag(),
+                                a.real() * b.imag() + a.imag() * b.real());
+}
+
+// 迭代基2 FFT（原位）。tw按级连续存放：第len级的half个旋转因子位于tw[half-1 ...]，
+// 内层循环顺序访问；逆变换由调用方用共轭实现
+void fftInPlace(std::complex<double> *a, int n, const std::vector<int> &rev,
+                const std::vector<std::complex<double>> &tw)
+{
+    for (int i = 0; i < n; ++i) {
+        if (i < rev[i]) {
+            std::swap(a[i], a[rev[i]]);
+        }
+    }
+    // 第一级旋转因子为1，单独展开
+    for (int i = 0; i + 1 < n; i += 2) {
+        const std::complex<double> u = a[i];
+        const std::complex<double> v = a[i + 1];
+        a[i] = u + v;
+        a[i + 1] = u - v;
+    }
+    for (int half = 2; half < n; half <<= 1) {
+        const std::complex<double> *w = tw.data() + (half - 1);
+        for (int i = 0; i < n; i += 2 * half) {
+            std::complex<double> *lo = a + i;
+            std::complex<double> *hi = a + i + half;
+            for (int j = 0; j < half; ++j) {
+                const std::complex<double> v = cmul(hi[j], w[j]);
+                const std::complex<double> u = lo[j];
+                lo[j] = u + v;
+                hi[j] = u - v;
+            }
+        }
+    }
+}
+
+} // namespace
+
+BlockFirFilter::BlockFirFilter()
+    : m_method(Method::Direct)
+    , m_fftThreshold(256)
+    , m_fftSize(0)
+    , m_fftStep(0)
+{
+}
+
+bool BlockFirFilter::usesAvx2()
+{
+    return cpuHasAvx2Fma();
+}
+
+void BlockFirFilter::setCoefficients(const std::vector<double> &coefficients)
+{
+    const bool sizeChanged = coefficients.size() != m_taps.size();
+    m_taps = coefficients;
+    m_reversed.assign(m_taps.rbegin(), m_taps.rend());
+    chooseMethod();
+    if (sizeChanged) {
+        reset();
+    }
+}
+
+void BlockFirFilter::setChannelCount(int channels)
+{
+    m_channels.assign(size_t(std::max(0, channels)), ChannelState());
+    reset();
+}
+
+void BlockFirFilter::reset()
+{
+    const size_t history = m_taps.empty() ? 0 : m_taps.size() - 1;
+    for (ChannelState &state : m_channels) {
+        state.work.assign(history, 0.0);
+    }
+}
+
+void BlockFirFilter::setFftThreshold(int taps)
+{
+    m_fftThreshold = std::max(2, taps);
+    chooseMethod();
+}
+
+void BlockFirFilter::chooseMethod()
+{
+    m_method = int(m_taps.size()) >= m_fftThreshold ? Method::FFT : Method::Direct;
+    if (m_method == Method::FFT) {
+        m_fftSize = 0;
+        prepareFft(0);
+    } else {
+        m_fftKernel.clear();
+        m_twiddles.clear();
+        m_bitReverse.clear();
+        m_fftSize = 0;
+        m_fftStep = 0;
+    }
+}
+
+void BlockFirFilter::prepareFft(int blockSize)
+{
+    const int taps = int(m_taps.size());
+
+    // FFT长度：至少为抽头数的2倍；数据块较长时放大到一次FFT可处理半个数据块
+    // （两段打包成一次复数FFT），但不超过抽头数的8倍，避免补零浪费
+    const int history = taps - 1;
+    const int wanted = std::min(std::max(2 * taps, history + (blockSize + 1) / 2), 8 * taps);
+    int n = 1;
+    int bits = 0;
+    while (n < wanted) {
+        n <<= 1;
+        ++bits;
+    }
+    if (n == m_fftSize && !m_fftKernel.empty()) {
+        return;
+    }
+    m_fftSize = n;
+    m_fftStep = n - (taps - 1);
+
+    m_bitReverse.resize(size_t(n));
+    for (int i = 0; i < n; ++i) {
+        int r = 0;
+        for (int b = 0; b < bits; ++b) {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        m_bitReverse[size_t(i)] = r;
+    }
+
+    m_twiddles.resize(size_t(std::max(1, n - 1)));
+    for (int half = 1; half < n; half <<= 1) {
+        for (int j = 0; j < half; ++j) {
+            const double angle = -M_PI * j / half;
+            m_twiddles[size_t(half - 1 + j)] = std::complex<double>(std::cos(angle), std::sin(angle));
+        }
+    }
+
+    // 系数频谱，预先乘以1/N省去逆变换的缩放
+    m_fftKernel.assign(size_t(n), std::complex<double>(0.0, 0.0));
+    for (int k = 0; k < taps; ++k) {
+        m_fftKernel[size_t(k)] = m_taps[size_t(k)];
+    }
+    fftInPlace(m_fftKernel.data(), n, m_bitReverse, m_twiddles);
+    const double scale = 1.0 / double(n);
+    for (std::complex<double> &value : m_fftKernel) {
+        value *= scale;
+    }
+}
+
+void BlockFirFilter::process(int channel, const double *input, double *output, int count)
+{
+    if (channel < 0 || channel >= int(m_channels.size()) || count <= 0) {
+        return;
+    }
+    if (m_taps.empty()) {
+        if (output != input) {
+            std::memcpy(output, input, size_t(count) * sizeof(double));
+        }
+        return;
+    }
+
+    // 两种方式共用[历史 | 当前块]布局，可逐块切换；数据块短于4倍抽头数时
+    // FFT补零浪费过大，仍使用直接卷积
+    ChannelState &state = m_channels[size_t(channel)];
+    if (m_method == Method::FFT && count >= 4 * int(m_taps.size())) {
+        processFft(state, input, output, count);
+    } else {
+        processDirect(state, input, output, count);
+    }
+}
+
+void BlockFirFilter::processDirect(ChannelState &state, const double *input, double *output, int count)
+{
+    const int taps = int(m_taps.size());
+    const size_t history = size_t(taps - 1);
+
+    // 拼接[历史 | 当前块]，仅在块变大时重新分配
+    if (state.work.size() < history + size_t(count)) {
+        state.work.resize(history + size_t(count));
+    }
+    double *w = state.work.data();
+    std::memcpy(w + history, input, size_t(count) * sizeof(double));
+
+#ifdef SIMD_HAVE_X86
+    if (usesAvx2()) {
+        firDirectAvx2(w, m_reversed.data(), taps, output, count);
+    } else
+#endif
+    {
+#ifdef SIMD_HAVE_SSE2
+        firDirectSse2(w, m_reversed.data(), taps, output, count);
+#else
+        firDirectScalar(w, m_reversed.data(), taps, output, 0, count);
+#endif
+    }
+
+    // 保留最后taps-1个样本作为下一块的历史（每块只移动一次）
+    if (history > 0) {
+        std::memmove(w, w + count, history * sizeof(double));
+    }
+}
+
+void BlockFirFilter::processFft(ChannelState &state, const double *input, double *output, int count)
+{
+    const int history = int(m_taps.size()) - 1;
+    prepareFft(count);   // 数据块长度不变时直接返回
+    const int n = m_fftSize;
+
+    // 与直接卷积相同的[历史 | 当前块]拼接，各段从中按偏移取数，input可与output相同
+    if (state.work.size() < size_t(history) + size_t(count)) {
+        state.work.resize(size_t(history) + size_t(count));
+    }
+    double *w = state.work.data();
+    std::memcpy(w + history, input, size_t(count) * sizeof(double));
+
+    if (int(state.fftBuf.size()) != n) {
+        state.fftBuf.resize(size_t(n));
+    }
+    std::complex<double> *buf = state.fftBuf.data();
+
+    // 系数为实数，两段实信号分别放入实部和虚部，一次复数FFT同时完成两段卷积
+    int done = 0;
+    while (done < count) {
+        const int remaining = count - done;
+        int m1 = std::min(m_fftStep, remaining);
+        if (remaining <= 2 * m_fftStep && remaining > 1) {
+            m1 = (remaining + 1) / 2;   // 剩余不足两整段时平分，缩短补零
+        }
+        const int m2 = std::min(m_fftStep, remaining - m1);
+
+        const double *segA = w + done;
+        const double *segB = w + done + m1;
+        const int lenA = history + m1;
+        const int lenB = m2 > 0 ? history + m2 : 0;
+        for (int j = 0; j < n; ++j) {
+            buf[j] = std::complex<double>(j < lenA ? segA[j] : 0.0, j < lenB ? segB[j] : 0.0);
+        }
+
+        // 逆变换：IFFT(X) = conj(FFT(conj(X)))，1/N已并入系数频谱
+        fftInPlace(buf, n, m_bitReverse, m_twiddles);
+        for (int j = 0; j < n; ++j) {
+            buf[j] = std::conj(cmul(buf[j], m_fftKernel[size_t(j)]));
+        }
+        fftInPlace(buf, n, m_bitReverse, m_twiddles);
+
+        double *out = output + done;
+        for (int j = 0; j < m1; ++j) {
+            out[j] = buf[history + j].real();
+        }
+        for (int j = 0; j < m2; ++j) {
+            out[m1 + j] = -buf[history + j].imag();
+        }
+        done += m1 + m2;
+    }
+
+    if (history > 0) {
+        std::memmove(w, w + count, size_t(history) * sizeof(double));
+    }
+}
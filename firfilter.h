@@ -0,0 +1,70 @@
+#ifndef FIRFILTER_H
+#define FIRFILTER_H
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+// 多通道分块FIR滤波引擎
+//
+// 以数据块为单位处理每个通道：每个通道保存一段长度为(阶数)的历史样本，
+// 与新数据块拼接后一次性计算整块输出，每块只移动一次历史数据。
+// 短滤波器使用直接卷积（运行时选择AVX2/FMA或SSE2内核，同时计算多个输出点），
+// 长滤波器在数据块足够长时自动切换到FFT重叠保留法（overlap-save）。两种方式均无额外延迟，
+// 输出与逐点卷积 y[n] = sum(h[k] * x[n-k]) 一致（仅有浮点舍入误差）。
+class BlockFirFilter
+{
+public:
+    enum class Method {
+        Direct,     // 直接卷积（SIMD）
+        FFT         // FFT重叠保留法
+    };
+
+    BlockFirFilter();
+
+    // 设置滤波器系数；抽头数不变时保留各通道历史数据
+    void setCoefficients(const std::vector<double> &coefficients);
+    // 设置通道数（会清空历史数据）
+    void setChannelCount(int channels);
+    // 清空所有通道的历史数据
+    void reset();
+
+    // 抽头数大于等于该值、且数据块长度不小于4倍抽头数时使用FFT方法（默认256）
+    void setFftThreshold(int taps);
+
+    int channelCount() const { return int(m_channels.size()); }
+    int tapCount() const { return int(m_taps.size()); }
+    Method method() const { return m_method; }
+
+    // 处理一个通道的数据块，input与output可以指向同一块内存
+    void process(int channel, const double *input, double *output, int count);
+
+    // 当前CPU是否使用AVX2内核
+    static bool usesAvx2();
+
+private:
+    struct ChannelState {
+        std::vector<double> work;                 // [历史(taps-1) | 当前块]
+        std::vector<std::complex<double>> fftBuf; // FFT工作区
+    };
+
+    void chooseMethod();
+    void prepareFft(int blockSize);
+    void processDirect(ChannelState &state, const double *input, double *output, int count);
+    void processFft(ChannelState &state, const double *input, double *output, int count);
+
+    std::vector<double> m_taps;           // 原始系数h[k]
+    std::vector<double> m_reversed;       // 反序系数，直接卷积使用
+    std::vector<ChannelState> m_channels;
+    Method m_method;
+    int m_fftThreshold;
+
+    // FFT重叠保留法参数
+    int m_fftSize;                                  // FFT长度N
+    int m_fftStep;                                  // 每段新样本数 L = N - (taps-1)
+    std::vector<std::complex<double>> m_fftKernel;  // 系数频谱H
+    std::vector<std::complex<double>> m_twiddles;   // 旋转因子
+    std::vector<int> m_bitReverse;                  // 位反转索引
+};
+
+#endif // FIRFILTER_H
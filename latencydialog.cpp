@@ -0,0 +1,126 @@
+#include "latencydialog.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QVBoxLayout>
+
+namespace {
+
+enum Column {
+    StageColumn,
+    CountColumn,
+    MeanColumn,
+    P50Column,
+    P90Column,
+    P99Column,
+    P999Column,
+    MaxColumn,
+    RecentP99Column,
+    ColumnCount
+};
+
+QString formatMs(qint64 ns)
+{
+    return QString::number(PipelineClock::toMilliseconds(ns), 'f', 3);
+}
+
+} // namespace
+
+LatencyDialog::LatencyDialog(QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle(tr("管线延迟统计"));
+    resize(900, 480);
+
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+    table = new QTableWidget(PipelineLatency::StageCount, ColumnCount);
+    table->setHorizontalHeaderLabels({tr("阶段"), tr("计数"), tr("平均(ms)"), tr("P50(ms)"), tr("P90(ms)"),
+                                      tr("P99(ms)"), tr("P99.9(ms)"), tr("最大(ms)"), tr("最近1秒P99(ms)")});
+    table->verticalHeader()->setVisible(false);
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionMode(QAbstractItemView::NoSelection);
+    for (int s = 0; s < PipelineLatency::StageCount; ++s) {
+        table->setItem(s, StageColumn, new QTableWidgetItem(PipelineLatency::stageName(PipelineLatency::Stage(s))));
+        for (int c = CountColumn; c < ColumnCount; ++c) {
+            QTableWidgetItem *item = new QTableWidgetItem();
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            table->setItem(s, c, item);
+        }
+    }
+    mainLayout->addWidget(table);
+
+    statusLabel = new QLabel();
+    mainLayout->addWidget(statusLabel);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout();
+    resetButton = new QPushButton(tr("重置统计"));
+    exportButton = new QPushButton(tr("导出..."));
+    closeButton = new QPushButton(tr("关闭"));
+    buttonLayout->addWidget(resetButton);
+    buttonLayout->addWidget(exportButton);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(closeButton);
+    mainLayout->addLayout(buttonLayout);
+
+    connect(resetButton, &QPushButton::clicked, this, &LatencyDialog::resetStatistics);
+    connect(exportButton, &QPushButton::clicked, this, &LatencyDialog::exportReport);
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::close);
+    connect(&refreshTimer, &QTimer::timeout, this, &LatencyDialog::refresh);
+
+    previous.resize(PipelineLatency::StageCount);
+    refresh();
+    refreshTimer.start(1000);
+}
+
+void LatencyDialog::refresh()
+{
+    try {
+        for (int s = 0; s < PipelineLatency::StageCount; ++s) {
+            const LatencyHistogram::Snapshot h = PipelineLatency::histogram(PipelineLatency::Stage(s)).snapshot();
+            const LatencyHistogram::Snapshot recent = h.since(previous[s]);
+            table->item(s, CountColumn)->setText(QString::number(h.total));
+            table->item(s, MeanColumn)->setText(QString::number(h.meanNs() / 1e6, 'f', 3));
+            table->item(s, P50Column)->setText(formatMs(h.percentile(50.0)));
+            table->item(s, P90Column)->setText(formatMs(h.percentile(90.0)));
+            table->item(s, P99Column)->setText(formatMs(h.percentile(99.0)));
+            table->item(s, P999Column)->setText(formatMs(h.percentile(99.9)));
+            table->item(s, MaxColumn)->setText(formatMs(h.maxNs));
+            table->item(s, RecentP99Column)->setText(recent.total > 0 ? formatMs(recent.percentile(99.0)) : QString("-"));
+            previous[s] = h;
+        }
+        statusLabel->setText(tr("更新于 %1").arg(QDateTime::currentDateTime().toString("hh:mm:ss")));
+    } catch (const std::exception &e) {
+        qDebug() << "[LatencyDialog] 刷新延迟统计时出错:" << e.what();
+    }
+}
+
+void LatencyDialog::resetStatistics()
+{
+    PipelineLatency::resetAll();
+    for (LatencyHistogram::Snapshot &snapshot : previous) {
+        snapshot = LatencyHistogram::Snapshot();
+    }
+    refresh();
+}
+
+void LatencyDialog::exportReport()
+{
+    const QString defaultPath = QCoreApplication::applicationDirPath()
+        + QString("/latency_%1.txt").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"));
+    const QString filePath = QFileDialog::getSaveFileName(this, tr("导出延迟统计"), defaultPath, tr("文本文件 (*.txt)"));
+    if (filePath.isEmpty()) {
+        return;
+    }
+    QString error;
+    if (!PipelineLatency::dumpToFile(filePath, &error)) {
+        QMessageBox::warning(this, tr("错误"), tr("导出延迟统计失败: %1").arg(error));
+        return;
+    }
+    statusLabel->setText(tr("已导出到 %1").arg(filePath));
+}
@@ -0,0 +1,38 @@
+#ifndef LATENCYDIALOG_H
+#define LATENCYDIALOG_H
+
+#include <QDialog>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVector>
+#include "pipelinelatency.h"
+
+// 采集管线延迟统计面板
+//
+// 每秒刷新一次PipelineLatency各阶段的直方图：累计的计数、平均值、P50/P90/P99/P99.9、最大值，
+// 以及最近一个刷新周期内的P99（用于观察尾部延迟的实时变化）。可重置统计或导出到文件。
+class LatencyDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit LatencyDialog(QWidget *parent = nullptr);
+
+private slots:
+    void refresh();
+    void resetStatistics();
+    void exportReport();
+
+private:
+    QTableWidget *table;
+    QLabel *statusLabel;
+    QPushButton *resetButton;
+    QPushButton *exportButton;
+    QPushButton *closeButton;
+    QTimer refreshTimer;
+    QVector<LatencyHistogram::Snapshot> previous;   // 上次刷新时各阶段的计数，用于计算最近周期
+};
+
+#endif // LATENCYDIALOG_H
@@ -215,6 +215,9 @@ MainWindow::MainWindow(QWidget *parent)
     daqTh = new DAQThread;
     daqTh->moveToThread(daqThread);
 
+    // 创建DAQ记录线程（自带线程，数据块在DAQ线程中直接入队）
+    daqRecorder = new DAQRecorder;
+
     // 创建ECU子线程对象
     ecuTh = new ECUThread;
     ecuTh->moveToThread(ecuThread);
@@ -232,16 +235,7 @@ MainWindow::MainWindow(QWidget *parent)
     QElapsedTimer *masterTimer = new QElapsedTimer();
     masterTimer->start();
 
-    // 创建统一主定时器，取代之前的snapshotTimer和ModbusTimer
-    mainTimer = new QTimer(this);
-    mainTimer->setInterval(10); // 设置基本间隔为10ms
-    connect(mainTimer, &QTimer::timeout, this, &MainWindow::onMainTimerTimeout);
-
-    // 初始化定时器相关变量
-    modbusReadRequested = false;
-    modbusReading = false;
-    lastModbusReadTime = 0;
-    lastSnapshotTime = 0;
+    // 初始化定时器相关变量（Modbus读取由Modbus线程内的轮询调度器按截止时间驱动，不再使用界面定时器）
     lastPlotUpdateTime = 0;
 
     // 初始化当前数据快照
@@ -279,9 +273,6 @@ MainWindow::MainWindow(QWidget *parent)
     daqSampleRate = 10000;
 
 
-    //发送modbus命令
-    connect(this,&MainWindow::sendModbusCommand,mbTh,&modbusThread::getModbusResult);
-
     // 添加串口参数设置的信号与槽连接
     connect(this,&MainWindow::sendModbusInfo,mbTh,&modbusThread::setModbusPortInfo);
 
@@ -326,6 +317,28 @@ MainWindow::MainWindow(QWidget *parent)
     // connect(daqTh, &DAQThread::dataReady, this, &MainWindow::handleDAQData);
     connect(daqTh, &DAQThread::acquisitionStatus, this, &MainWindow::handleDAQStatus);
     connect(daqTh, &DAQThread::error, this, &MainWindow::handleDAQError);
+    // 显示DAQ回调环形缓冲区的溢出情况
+    connect(daqTh, &DAQThread::ringStatistics, this, [this](quint64 overruns, quint64 blocksWritten, int fillLevel, int capacity) {
+        if (overruns > 0) {
+            statusBar()->showMessage(QString("DAQ缓冲区溢出: 已丢弃%1个数据块 (已写入%2, 占用%3/%4)")
+                                     .arg(overruns).arg(blocksWritten).arg(fillLevel).arg(capacity), 3000);
+        }
+    });
+
+    // 全速率记录：DirectConnection，在DAQ线程中只把数据块放入记录队列
+    connect(daqTh, &DAQThread::dataBlockReady, daqRecorder, &DAQRecorder::enqueueBlock, Qt::DirectConnection);
+    connect(daqRecorder, &DAQRecorder::recordingError, this, [this](const QString &message) {
+        statusBar()->showMessage(message, 5000);
+    });
+    connect(daqRecorder, &DAQRecorder::recorderStatistics, this, [this](quint64 blocksDropped, qint64 queuedBytes, double) {
+        if (blocksDropped > 0) {
+            statusBar()->showMessage(QString("DAQ记录队列已满: 已丢弃%1个数据块 (队列%2 MB)")
+                                     .arg(blocksDropped).arg(queuedBytes / 1e6, 0, 'f', 1), 3000);
+        }
+    });
+    connect(daqRecorder, &DAQRecorder::recordingStopped, this, [this](const QString &filePath, qint64 samplesPerChannel, qint64) {
+        qDebug() << "DAQ记录已保存:" << filePath << "每通道样本" << samplesPerChannel;
+    });
 
     // 连接ECU信号与槽
     // connect(ecuTh, &ECUThread::ecuDataReady, this, &MainWindow::handleECUData);
@@ -346,6 +359,7 @@ MainWindow::MainWindow(QWidget *parent)
     // 启动子线程
     SubThread_Modbus->start();
     daqThread->start();
+    daqRecorder->start();
     ecuThread->start(); // 启动ECU线程
 
     // WebSocket不使用单独线程，直接在主线程启动服务器
@@ -393,6 +407,13 @@ MainWindow::MainWindow(QWidget *parent)
     connect(actionLoadInitial, &QAction::triggered, this, &MainWindow::on_actionLoadInitial_triggered);
     connect(actionSaveInitial, &QAction::triggered, this, &MainWindow::on_actionSaveInitial_triggered);
 
+    // 诊断菜单：管线延迟统计
+    QMenu *diagnosticsMenu = new QMenu("诊断", this);
+    menuBar()->addMenu(diagnosticsMenu);
+    QAction *actionLatency = new QAction("管线延迟统计", this);
+    diagnosticsMenu->addAction(actionLatency);
+    connect(actionLatency, &QAction::triggered, this, &MainWindow::showLatencyDialog);
+
     // 连接Dashboard双击信号
     QList<Dashboard*> dashboards = this->findChildren<Dashboard*>();
     for (Dashboard* dashboard : dashboards) {
@@ -414,13 +435,20 @@ MainWindow::MainWindow(QWidget *parent)
 
 
 
-    // 添加定时器信号槽连接
-    connect(mainTimer, &QTimer::timeout, [=]() {
-        // 确保只在"结束"状态下发送命令（即正在循环读取状态）
-        if (ui->btnSend->text() == "结束") {
-            emit sendModbusCommand(ui->lineServerAddress->text().toInt(),
-                                  ui->lineSegAddress->text().toInt(),
-                                  ui->lineSegNum->text().toInt());
+    // Modbus轮询由Modbus线程内的调度器按轮询表驱动（见on_btnSend_clicked），不再由界面定时器触发
+    connect(mbTh, &modbusThread::tcpDeviceStatus, this, [this](int, bool, QString message) {
+        ui->plainReceive->appendPlainText(message);
+    });
+    connect(mbTh, &modbusThread::pollPlanChanged, this, [this](int requests, int channels, double busLoad) {
+        ui->plainReceive->appendPlainText(QString("Modbus请求计划：%1个通道合并为%2个请求，估计总线占用%3%")
+                                          .arg(channels).arg(requests).arg(busLoad * 100.0, 0, 'f', 1));
+    });
+    connect(mbTh, &modbusThread::pollStatistics, this,
+            [this](quint64, quint64 missedCycles, quint64 failedRequests, qint64 maxLatenessNs) {
+        if (missedCycles > 0 || failedRequests > 0) {
+            statusBar()->showMessage(QString("Modbus轮询: 跳过%1个周期，失败%2个请求，最近1秒最大延迟%3 ms")
+                                     .arg(missedCycles).arg(failedRequests)
+                                     .arg(PipelineClock::toMilliseconds(maxLatenessNs), 0, 'f', 2), 3000);
         }
     });
 
@@ -558,8 +586,66 @@ MainWindow::MainWindow(QWidget *parent)
     // --- 结束调试 ---
 
     // 连接信号和槽
-    // 将主线程的triggerProcessDataSnapshots信号连接到SnapshotThread的processDataSnapshots槽
-    connect(this, &MainWindow::triggerProcessDataSnapshots, snpTh, &SnapshotThread::processDataSnapshots);
+    // 快照由SnapshotThread内部的调度器按固定速率生成，速率取自dashboard_settings.ini的[Snapshot]RateHz；
+    // 各数据源按采集时间戳重采样到快照时刻：[Snapshot]ModbusResample/DAQResample/ECUResample（hold或linear，默认hold），
+    // AlignmentDelayMs为快照时刻的延后量（默认0）。linear需要快照时刻之后的一帧，AlignmentDelayMs不小于该数据源的
+    // 更新周期（如Modbus轮询周期）时才会插值，延后量为0时与hold相同
+    {
+        QSettings snapshotSettings(QCoreApplication::applicationDirPath() + "/dashboard_settings.ini", QSettings::IniFormat);
+        snpTh->setSnapshotRate(snapshotSettings.value("Snapshot/RateHz", 10.0).toDouble());
+        snpTh->setAlignmentDelay(snapshotSettings.value("Snapshot/AlignmentDelayMs", 0.0).toDouble());
+        for (const QString &source : {QString("Modbus"), QString("DAQ"), QString("ECU")}) {
+            snpTh->setResampleMode(source, snapshotSettings.value("Snapshot/" + source + "Resample", "hold").toString());
+        }
+        // 快照历史的保存时长：[Snapshot]HistorySeconds（绘图、WebSocket补发、校准对话框共用同一份历史）
+        snpTh->setHistoryDuration(snapshotSettings.value("Snapshot/HistorySeconds", 3600.0).toDouble());
+        // 会话日志在独立线程中写盘：[Logging]QueueCapacity（快照个数）、FlushIntervalMs、BufferKB
+        snpTh->setLogWriterOptions(snapshotSettings.value("Logging/QueueCapacity", 4096).toInt(),
+                                   snapshotSettings.value("Logging/FlushIntervalMs", 1000).toInt(),
+                                   snapshotSettings.value("Logging/BufferKB", 1024).toInt());
+        // 分段与压缩：[Logging]SegmentSeconds、SegmentMB、CompressionLevel（0不压缩）
+        snpTh->setLogSegmentOptions(snapshotSettings.value("Logging/SegmentSeconds", 600.0).toDouble(),
+                                    snapshotSettings.value("Logging/SegmentMB", 256).toInt(),
+                                    snapshotSettings.value("Logging/CompressionLevel", 6).toInt());
+    }
+    connect(snpTh, &SnapshotThread::schedulerStatistics, this, [this](quint64, quint64 missedDeadlines, double maxLatenessMs) {
+        if (missedDeadlines > 0) {
+            statusBar()->showMessage(QString("快照调度: 已错过%1个截止时间 (最大延迟%2 ms)")
+                                     .arg(missedDeadlines).arg(maxLatenessMs, 0, 'f', 2), 3000);
+        }
+    });
+
+    connect(snpTh, &SnapshotThread::loggerStatistics, this, [this](quint64 snapshotsDropped, int queued, int, double, double maxWriteMs) {
+        if (snapshotsDropped > 0) {
+            statusBar()->showMessage(QString("快照日志写入过慢: 已丢弃%1个快照 (队列%2, 最长写入%3 ms)")
+                                     .arg(snapshotsDropped).arg(queued).arg(maxWriteMs, 0, 'f', 1), 3000);
+        }
+    });
+
+    // 派生通道（customData，仪表盘变量D_n）：dashboard_settings.ini的[DerivedChannels]数组，每项Name/Unit/Formula，
+    // 未配置时使用默认的5个通道。公式在快照线程中编译一次，有误时保留原定义并在状态栏提示
+    connect(snpTh, &SnapshotThread::derivedChannelsChanged, wsTh, &WebSocketThread::setCustomChannelNames);
+    connect(snpTh, &SnapshotThread::derivedChannelsError, this, [this](const QString &errorMessage) {
+        statusBar()->showMessage("派生通道公式有误: " + errorMessage, 5000);
+    });
+    {
+        QSettings derivedSettings(QCoreApplication::applicationDirPath() + "/dashboard_settings.ini", QSettings::IniFormat);
+        QVector<DerivedChannel> derivedChannels;
+        const int count = derivedSettings.beginReadArray("DerivedChannels");
+        for (int i = 0; i < count; ++i) {
+            derivedSettings.setArrayIndex(i);
+            DerivedChannel channel;
+            channel.name = derivedSettings.value("Name", QString("Custom_%1").arg(i)).toString();
+            channel.unit = derivedSettings.value("Unit").toString();
+            channel.formula = derivedSettings.value("Formula", "0").toString();
+            derivedChannels.append(channel);
+        }
+        derivedSettings.endArray();
+        if (derivedChannels.isEmpty()) {
+            derivedChannels = DerivedChannelProgram::defaultChannels();
+        }
+        snpTh->setDerivedChannels(derivedChannels);
+    }
 
     // 接收SnapshotThread处理后的数据
     connect(snpTh, &SnapshotThread::snapshotProcessed, this, &MainWindow::handleSnapshotProcessed);
@@ -569,8 +655,8 @@ MainWindow::MainWindow(QWidget *parent)
     connect(mbTh, &modbusThread::sendModbusResult, snpTh, &SnapshotThread::handleModbusData);
 
     // 修改DAQ数据处理连接
-    // 从主线程接收改为直接连接到SnapshotThread
-    connect(daqTh, &DAQThread::dataReady, snpTh, &SnapshotThread::handleDAQData);
+    // 从主线程接收改为直接连接到SnapshotThread，只传递每次回调新增的数据块
+    connect(daqTh, &DAQThread::dataBlockReady, snpTh, &SnapshotThread::handleDAQBlock);
 
     // 修改ECU数据处理连接
     // 从主线程接收改为直接连接到SnapshotThread
@@ -591,6 +677,8 @@ MainWindow::MainWindow(QWidget *parent)
 
     // 添加新的数据快照WebSocket连接
     connect(snpTh, &SnapshotThread::snapshotForWebSocket, wsTh, &WebSocketThread::handleDataSnapshot);
+    // 客户端请求的历史数据从快照历史中查询
+    wsTh->setSnapshotHistory(snpTh->snapshotHistory());
 
     // 正确的位置打印组合的连接结果
     qDebug() << "===> ECU Signal Connection Results: ecuData->snpTh=" << ecuDataConnectResult
@@ -643,13 +731,6 @@ MainWindow::~MainWindow()
     saveDashboardMappings(settings);
     qDebug() << "已保存仪表盘设置到:" << settingsFile;
 
-    // 停止主定时器
-    if (mainTimer) {
-        mainTimer->stop();
-        delete mainTimer;
-        mainTimer = nullptr;
-    }
-
     delete ui;
     //析构时结束子线程
     SubThread_Modbus->quit();
@@ -660,6 +741,13 @@ MainWindow::~MainWindow()
     daqThread->wait();
     daqThread->deleteLater();
 
+    // DAQ线程停止后再停止记录线程（关闭文件并写入块索引）
+    if (daqRecorder) {
+        daqRecorder->stopThread();
+        delete daqRecorder;
+        daqRecorder = nullptr;
+    }
+
     ecuThread->quit();
     ecuThread->wait();
     ecuThread->deleteLater(); // 清理ECU线程
@@ -693,6 +781,12 @@ MainWindow::~MainWindow()
         delete calibrationDialog;
         calibrationDialog = nullptr;
     }
+
+    // 各线程停止后保存本次运行的管线延迟统计
+    QString latencyError;
+    if (!PipelineLatency::dumpToFile(QCoreApplication::applicationDirPath() + "/latency_report.txt", &latencyError)) {
+        qDebug() << "[MainWindow] 保存管线延迟统计失败:" << latencyError;
+    }
 }
 
 // DAQ相关实现
@@ -942,6 +1036,8 @@ void MainWindow::handleDAQStatus(bool isRunning, QString message)
         qDebug() << "DAQ采集已启动，正在等待数据...";
     } else {
         qDebug() << "DAQ采集已停止";
+        // 写完队列中剩余的数据块后关闭记录文件
+        daqRecorder->stopRecording();
     }
 }
 
@@ -969,8 +1065,8 @@ void MainWindow::on_startDAQButton_clicked()
 
     daqSampleRate = sampleRate;
 
-    // 解析通道
-    QStringList parts = channelStr.split("/", Qt::SkipEmptyParts);
+    // 解析通道（多设备时各设备的通道用';'分隔）
+    QStringList parts = QString(channelStr).replace(";", "/").split("/", Qt::SkipEmptyParts);
     int numChannels = parts.size();
 
     if (numChannels == 0) {
@@ -1013,8 +1109,20 @@ void MainWindow::on_startDAQButton_clicked()
                      << "截止频率:" << cutoffFrequency << "Hz";
         }
 
+        // 全速率原始数据记录：dashboard_settings.ini的[Recording]Enabled（默认关闭，16通道10kHz时约4.6 GB/h）、
+        // Directory（记录目录，相对路径相对程序目录，默认DAQRecords）
+        QSettings recordingSettings(QCoreApplication::applicationDirPath() + "/dashboard_settings.ini", QSettings::IniFormat);
+        const bool recordingEnabled = recordingSettings.value("Recording/Enabled", false).toBool();
+        const QString recordingDirectory = QDir(QCoreApplication::applicationDirPath())
+                                               .absoluteFilePath(recordingSettings.value("Recording/Directory", "DAQRecords").toString());
+
         // 使用QTimer确保initDAQ完成后再开始采集
         QTimer::singleShot(50, this, [=]() {
+            // 先开始记录，保证第一个数据块也写入文件
+            if (recordingEnabled) {
+                daqRecorder->startRecording(recordingDirectory,
+                                            QString("device=%1;channels=%2;rate=%3").arg(deviceName, channelStr).arg(sampleRate));
+            }
             // 开始采集
             daqTh->startAcquisition();
         });
@@ -1129,8 +1237,9 @@ void MainWindow::on_btnSend_clicked()
 {
     //qDebug() << "on_btnSend_clicked from thread:" << QThread::currentThread();
 
-    // 检查串口是否已连接，如果未连接，提示用户并返回
-    if (!ui->radioButton->isChecked()) {
+    // 检查串口是否已连接，如果未连接，提示用户并返回（只使用Modbus TCP设备时不需要串口）
+    const QVector<ModbusTcpDevice> tcpDevices = buildModbusTcpDevices();
+    if (!ui->radioButton->isChecked() && tcpDevices.isEmpty()) {
         QMessageBox::warning(this, "错误", "串口未连接，请先打开串口！");
         return;
     }
@@ -1139,9 +1248,11 @@ void MainWindow::on_btnSend_clicked()
     if (ui->btnSend->text() == "读取") {
         // 当前状态为"读取"，要开始数据采集
 
-        // 获取寄存器数量
-        int registerCount = ui->lineSegNum->text().toInt();
-        if (registerCount < 1) {
+        // 通道表：dashboard_settings.ini中按通道配置的地址，由Modbus线程合并请求；
+        // 未配置时使用轮询表（多从站轮询表或界面上的单个寄存器段）
+        const QVector<ModbusChannelSpec> pollChannels = buildModbusPollChannels();
+        const QVector<ModbusPollBlock> pollTable = buildModbusPollTable();
+        if (pollChannels.isEmpty() && pollTable.isEmpty()) {
             ui->plainReceive->appendPlainText("错误：寄存器数量必须大于0");
             return;
         }
@@ -1160,17 +1271,17 @@ void MainWindow::on_btnSend_clicked()
         qDebug() << "滤波器状态: " << (ui->filterEnabledCheckBox->isChecked() ? "开启" : "关闭")
                  << "，时间常数: " << ui->lineTimeLoop->text().toDouble() << "ms";
 
-        // 设置Modbus读取标志，之后的读取将由主定时器触发
-        modbusReadRequested = true;
-
-        // 计算下一个整百+50的时间点，等待第一次触发
-        // 修改为使用本地临时变量，而不是成员变量
-        QElapsedTimer *tempTimer = new QElapsedTimer();
-        tempTimer->start();
-        qint64 currentTime = tempTimer->elapsed();
-        qint64 nextReadTime = ((currentTime / 100) * 100) + 150; // 下一个整百+50
-        delete tempTimer;
-        qDebug() << "Modbus读取将在下一个整百+50毫秒时间点触发: " << nextReadTime << "ms";
+        // 由Modbus线程按轮询表循环读取；[Modbus]PollMode为back-to-back时连续读取，否则按各块的周期
+        QSettings settings(QCoreApplication::applicationDirPath() + "/dashboard_settings.ini", QSettings::IniFormat);
+        const QString pollMode = settings.value("Modbus/PollMode", "cycle").toString();
+        mbTh->setPollMode(pollMode.compare("back-to-back", Qt::CaseInsensitive) == 0);
+        mbTh->setTcpDevices(tcpDevices);
+        if (!pollChannels.isEmpty()) {
+            mbTh->setPollChannels(pollChannels);
+        } else {
+            mbTh->setPollTable(pollTable);
+        }
+        mbTh->startPolling();
 
         // 改变按钮文字为"结束"
         ui->btnSend->setText("结束");
@@ -1185,9 +1296,7 @@ void MainWindow::on_btnSend_clicked()
     } else {
         // 当前状态为"结束"，要停止数据采集
 
-        // 清除Modbus读取标志
-        modbusReadRequested = false;
-        modbusReading = false;
+        mbTh->stopPolling();
 
         // 改变按钮文字为"读取"
         ui->btnSend->setText("读取");
@@ -1218,7 +1327,7 @@ void MainWindow::myplotInit(QCustomPlot *customPlot)
     customPlot->yAxis->setLabel("数值");
 
     // 获取当前的通道数量
-    int numChannels = ui->lineSegNum->text().toInt();
+    int numChannels = modbusChannelCount();
     if (numChannels <= 0) {
         numChannels = 1; // 默认至少显示一个通道
     }
@@ -2326,6 +2435,19 @@ void MainWindow::updateDashboardByMapping(const QVector<double> &modbusData,
         }
     }
 
+    // 2.1 DAQ窗口统计 (B_x.min / B_x.max / B_x.mean / B_x.rms)
+    if (snapshot.daqValid) {
+        const QVector<double> *stats[] = {&snapshot.daqMin, &snapshot.daqMax, &snapshot.daqMean, &snapshot.daqRms};
+        const char *suffixes[] = {"min", "max", "mean", "rms"};
+        for (int k = 0; k < 4; ++k) {
+            for (int i = 0; i < stats[k]->size(); i++) {
+                QString varName = QString("B_%1.%2").arg(i).arg(suffixes[k]);
+                currentVarMap[varName] = stats[k]->at(i);
+                updatedVars.insert(varName);
+            }
+        }
+    }
+
     // 3. ECU数据 (C_x)
     currentVarMap["C_0"] = ecuData.throttle;
     currentVarMap["C_1"] = ecuData.engineSpeed;
@@ -2347,6 +2469,13 @@ void MainWindow::updateDashboardByMapping(const QVector<double> &modbusData,
     updatedVars.insert("C_7");
     updatedVars.insert("C_8");
 
+    // 4. 派生通道 (D_x)
+    for (int i = 0; i < snapshot.customData.size(); i++) {
+        QString varName = QString("D_%1").arg(i);
+        currentVarMap[varName] = snapshot.customData[i];
+        updatedVars.insert(varName);
+    }
+
     // 更新持久性变量表，只更新有变化的变量
     for (auto it = currentVarMap.begin(); it != currentVarMap.end(); ++it) {
         if (!persistentVarMap.contains(it.key()) || persistentVarMap[it.key()] != it.value()) {
@@ -3253,6 +3382,117 @@ QList<Dashboard*> MainWindow::getAllDashboards()
 }
 
 
+// Modbus轮询表
+// dashboard_settings.ini的[ModbusPollTable]数组，每项Device/Slave/Function/Start/Count/PeriodMs/Priority
+// （Device为0表示串口总线，n表示[ModbusTcpDevices]的第n项；Priority数值越大越优先）；
+// 未配置时为界面上的从站地址、功能码、起始地址和数量组成的单个块，周期为[Modbus]PollPeriodMs（默认10 ms）
+QVector<ModbusPollBlock> MainWindow::buildModbusPollTable() const
+{
+    QVector<ModbusPollBlock> table;
+    QSettings settings(QCoreApplication::applicationDirPath() + "/dashboard_settings.ini", QSettings::IniFormat);
+    const int count = settings.beginReadArray("ModbusPollTable");
+    for (int i = 0; i < count; ++i) {
+        settings.setArrayIndex(i);
+        ModbusPollBlock block;
+        block.device = settings.value("Device", 0).toInt();
+        block.slave = settings.value("Slave", 1).toInt();
+        block.functionCode = settings.value("Function", 3).toInt();
+        block.start = settings.value("Start", 0).toInt();
+        block.count = settings.value("Count", 1).toInt();
+        block.periodMs = settings.value("PeriodMs", 100.0).toDouble();
+        block.priority = settings.value("Priority", 0).toInt();
+        if (block.count > 0) {
+            table.append(block);
+        }
+    }
+    settings.endArray();
+
+    if (table.isEmpty()) {
+        ModbusPollBlock block;
+        block.slave = ui->lineServerAddress->text().toInt();
+        block.functionCode = ui->comboAction->currentText().toInt();
+        if (ModbusPollScheduler::maxCountPerRequest(block.functionCode) == 0) {
+            block.functionCode = 3;
+        }
+        block.start = ui->lineSegAddress->text().toInt();
+        block.count = ui->lineSegNum->text().toInt();
+        block.periodMs = settings.value("Modbus/PollPeriodMs", 10.0).toDouble();
+        if (block.count > 0) {
+            table.append(block);
+        }
+    }
+    return table;
+}
+
+// Modbus通道表
+// dashboard_settings.ini的[ModbusChannels]数组，每项Device/Slave/Function/Address/PeriodMs/Priority，
+// 以及数值格式Type（u16/i16/u32/i32/f32/f64，默认u16）/WordSwap（低位字在前）/ByteSwap（低字节在前）/
+// Scale（寄存器默认0.01，线圈/离散输入默认1）/Offset，值 = 原始值 × Scale + Offset。
+// 通道A_n按数组顺序编号。配置后Modbus线程按链路代价把各通道的地址合并为读请求，[ModbusPollTable]不再使用
+QVector<ModbusChannelSpec> MainWindow::buildModbusPollChannels() const
+{
+    QVector<ModbusChannelSpec> channels;
+    QSettings settings(QCoreApplication::applicationDirPath() + "/dashboard_settings.ini", QSettings::IniFormat);
+    const int count = settings.beginReadArray("ModbusChannels");
+    for (int i = 0; i < count; ++i) {
+        settings.setArrayIndex(i);
+        ModbusChannelSpec channel;
+        channel.device = settings.value("Device", 0).toInt();
+        channel.slave = settings.value("Slave", 1).toInt();
+        channel.functionCode = settings.value("Function", 3).toInt();
+        channel.address = settings.value("Address", 0).toInt();
+        channel.periodMs = settings.value("PeriodMs", 100.0).toDouble();
+        channel.priority = settings.value("Priority", 0).toInt();
+        const QString typeName = settings.value("Type", "u16").toString();
+        if (!ModbusValueFormat::parseType(typeName, &channel.format.type)) {
+            qDebug() << "[MainWindow] Modbus通道" << i << "的类型无法识别，按u16处理:" << typeName;
+        }
+        channel.format.wordSwap = settings.value("WordSwap", false).toBool();
+        channel.format.byteSwap = settings.value("ByteSwap", false).toBool();
+        const bool bits = channel.functionCode == 1 || channel.functionCode == 2;
+        channel.format.scale = settings.value("Scale", bits ? 1.0 : 0.01).toDouble();
+        channel.format.offset = settings.value("Offset", 0.0).toDouble();
+        channels.append(channel);
+    }
+    settings.endArray();
+    return channels;
+}
+
+// Modbus TCP设备表
+// dashboard_settings.ini的[ModbusTcpDevices]数组，每项Host/Port/MaxInFlight（同时进行的请求数）/TimeoutMs，
+// 在轮询表和通道表中按Device=1..N引用
+QVector<ModbusTcpDevice> MainWindow::buildModbusTcpDevices() const
+{
+    QVector<ModbusTcpDevice> devices;
+    QSettings settings(QCoreApplication::applicationDirPath() + "/dashboard_settings.ini", QSettings::IniFormat);
+    const int count = settings.beginReadArray("ModbusTcpDevices");
+    for (int i = 0; i < count; ++i) {
+        settings.setArrayIndex(i);
+        ModbusTcpDevice device;
+        device.host = settings.value("Host", "127.0.0.1").toString();
+        device.port = settings.value("Port", 502).toInt();
+        device.maxInFlight = settings.value("MaxInFlight", 4).toInt();
+        device.timeoutMs = settings.value("TimeoutMs", 1000).toInt();
+        devices.append(device);
+    }
+    settings.endArray();
+    return devices;
+}
+
+// Modbus通道数：配置了通道表时为通道数，否则为轮询表中各块数量之和（即合并后通道向量的长度）
+int MainWindow::modbusChannelCount() const
+{
+    const QVector<ModbusChannelSpec> pollChannels = buildModbusPollChannels();
+    if (!pollChannels.isEmpty()) {
+        return pollChannels.size();
+    }
+    int channels = 0;
+    for (const ModbusPollBlock &block : buildModbusPollTable()) {
+        channels += block.count;
+    }
+    return channels;
+}
+
 // 新增：根据Modbus寄存器地址和数量更新Modbus通道
 void MainWindow::updateModbusChannels()
 {
@@ -4046,14 +4286,101 @@ void MainWindow::handleDashForceSettingsChanged(const QString &dashboardName, co
 //     }
 // }
 
+// 从DAQ历史存储更新DAQ图表：显示最近displayWindowSeconds秒（采集时间），点数超过图表宽度的2倍时按最小/最大值抽取。
+// 优先读取绘图速率（1kHz）的抗混叠抽取历史，抽取器没有绘图速率级时读取全速率历史。
+// 历史存储保存未校准的电压，抽取后的点再按当前校准参数换算（与快照中的DAQ窗口统计一致，校准多项式单调时峰值准确）
+void MainWindow::updateDAQPlotFromHistory(double displayWindowSeconds)
+{
+    if (!snpTh) {
+        return;
+    }
+    std::shared_ptr<const DAQHistoryStore> store = snpTh->daqPlotHistoryStore();
+    if (!store) {
+        store = snpTh->daqHistoryStore();
+    }
+    if (!store || store->channelCount() <= 0 || store->sampleRate() <= 0.0) {
+        return;
+    }
+
+    QCustomPlot *plot = ui->daqCustomPlot;
+    const int channels = store->channelCount();
+    const std::int64_t end = store->endIndex();
+    const std::int64_t from = end - std::int64_t(std::llround(displayWindowSeconds * store->sampleRate()));
+    const std::size_t maxPoints = std::size_t(qMax(200, plot->width() * 2));
+    daqPlotIndices.resize(maxPoints);
+    daqPlotValues.resize(maxPoints);
+
+    while (plot->graphCount() < channels) {
+        plot->addGraph();
+    }
+    while (plot->graphCount() > channels) {
+        plot->removeGraph(plot->graphCount() - 1);
+    }
+
+    for (int ch = 0; ch < channels; ++ch) {
+        const std::size_t points = store->envelope(ch, from, end, maxPoints, daqPlotIndices.data(), daqPlotValues.data());
+        const CalibrationParams params = snpTh->getCalibrationParams("DAQ", ch);
+        QVector<double> time(int(points));
+        QVector<double> values(int(points));
+        for (int i = 0; i < int(points); ++i) {
+            const double x = daqPlotValues[size_t(i)];
+            time[i] = store->timeOf(daqPlotIndices[size_t(i)]);
+            values[i] = ((params.a * x + params.b) * x + params.c) * x + params.d;
+        }
+        plot->graph(ch)->setData(time, values, true);
+    }
+
+    // 前displayWindowSeconds秒固定从0开始，之后跟随最新样本
+    const double latest = store->timeOf(end);
+    if (latest <= displayWindowSeconds) {
+        plot->xAxis->setRange(0, displayWindowSeconds);
+    } else {
+        plot->xAxis->setRange(latest - displayWindowSeconds, latest);
+    }
+    plot->yAxis->rescale();
+    plot->replot(QCustomPlot::rpQueuedReplot);
+}
+
 // 新增函数：更新所有图表
+// 各图表显示快照历史中最近displayWindowSeconds秒的数据（DAQ图表读取DAQ历史存储），点数超过图表宽度的2倍时按最小/最大值抽取
 void MainWindow::updateAllPlots(const DataSnapshot &snapshot, int snapshotCount)
 {
+    Q_UNUSED(snapshotCount);
     // +++ Add check for calibration mode +++
     if (currentRunMode == RunMode::Calibration) {
         return; // Don't update main window plots during calibration
     }
-    const int maxDataPoints = 600; // Increase buffer size to ~60 seconds
+
+    const std::shared_ptr<const SnapshotHistory> history = snpTh ? snpTh->snapshotHistory() : nullptr;
+    if (!history) {
+        return;
+    }
+    // 快照速率较高时限制刷新频率，每次刷新都查询整个显示窗口
+    if (plotRefreshTimer.isValid() && plotRefreshTimer.elapsed() < 33) {
+        return;
+    }
+    plotRefreshTimer.start();
+
+    const double displayWindowSeconds = 60.0;
+    const double latestTimestamp = snapshot.timestamp;
+
+    // 查询一个数据来源最近一个显示窗口的数据
+    const auto queryWindow = [&](QCustomPlot *plot, SessionLog::ColumnKind kind, int channelCount) {
+        QVector<SnapshotHistory::Channel> channels;
+        for (int ch = 0; ch < channelCount; ++ch) {
+            channels.append({kind, ch});
+        }
+        return history->query(latestTimestamp - displayWindowSeconds, latestTimestamp, channels,
+                              qMax(200, plot->width() * 2));
+    };
+    // 优化X轴范围：前displayWindowSeconds秒固定从0开始，之后跟随最新时间
+    const auto setTimeRange = [&](QCustomPlot *plot) {
+        if (latestTimestamp <= displayWindowSeconds) {
+            plot->xAxis->setRange(0, displayWindowSeconds);
+        } else {
+            plot->xAxis->setRange(latestTimestamp - displayWindowSeconds, latestTimestamp);
+        }
+    };
 
     // Update customVarCustomPlot chart
     if (snapshot.customData.size() > 0 && ui->customVarCustomPlot) {
@@ -4078,32 +4405,11 @@ void MainWindow::updateAllPlots(const DataSnapshot &snapshot, int snapshotCount)
             }
         }
 
-        // 使用成员变量保存历史数据
-        // 确保 customValues 大小与通道数量匹配
         int customChannelCount = snapshot.customData.size();
-        if (customValues.size() != customChannelCount) {
-            customValues.resize(customChannelCount);
-        }
-
-        // Add new time point
-        customTimeData.append(snapshot.timestamp);
-
-        // Add new data points for each channel
-        for (int ch = 0; ch < customChannelCount; ++ch) {
-            customValues[ch].append(snapshot.customData[ch]);
-            // Limit data points
-            while (customValues[ch].size() > maxDataPoints) {
-                customValues[ch].removeFirst();
-            }
-        }
-
-        // Limit time data points
-        while (customTimeData.size() > maxDataPoints) {
-            customTimeData.removeFirst();
-        }
+        const SnapshotHistory::QueryResult custom = queryWindow(ui->customVarCustomPlot, SessionLog::CustomValue, customChannelCount);
 
         // Update chart data
-        if (!customTimeData.isEmpty()) {
+        if (!custom.time.isEmpty()) {
             // Ensure graph count matches data size
             while (ui->customVarCustomPlot->graphCount() < customChannelCount) {
                 QCPGraph *graph = ui->customVarCustomPlot->addGraph();
@@ -4117,17 +4423,10 @@ void MainWindow::updateAllPlots(const DataSnapshot &snapshot, int snapshotCount)
 
             // Set data for each graph
             for (int ch = 0; ch < customChannelCount; ++ch) {
-                ui->customVarCustomPlot->graph(ch)->setData(customTimeData, customValues[ch], true);
+                ui->customVarCustomPlot->graph(ch)->setData(custom.time, custom.values[ch], true);
             }
 
-            // Optimize X-axis range
-            double latestTimestampCustom = snapshot.timestamp;
-            double displayWindowSecondsCustom = 60.0;
-            if (latestTimestampCustom <= displayWindowSecondsCustom) {
-                ui->customVarCustomPlot->xAxis->setRange(0, displayWindowSecondsCustom);
-            } else {
-                ui->customVarCustomPlot->xAxis->setRange(latestTimestampCustom - displayWindowSecondsCustom, latestTimestampCustom);
-            }
+            setTimeRange(ui->customVarCustomPlot);
 
             // Rescale Y-axis and replot
             ui->customVarCustomPlot->yAxis->rescale();
@@ -4144,32 +4443,11 @@ void MainWindow::updateAllPlots(const DataSnapshot &snapshot, int snapshotCount)
             qDebug() << "初始化Modbus图表，图表数量：" << ui->modbusCustomPlot->graphCount();
         }
 
-        // 使用成员变量保存历史数据
-        // 确保 modbusValues 大小与通道数量匹配
         int currentModbusRegs = snapshot.modbusData.size(); // 使用快照中的实际大小
-        if (modbusValues.size() != currentModbusRegs) {
-            modbusValues.resize(currentModbusRegs);
-        }
+        const SnapshotHistory::QueryResult modbus = queryWindow(ui->modbusCustomPlot, SessionLog::ModbusValue, currentModbusRegs);
 
-        // 添加新的时间点
-        modbusTimeData.append(snapshot.timestamp);
-
-        // 添加新的数据点
-        for (int ch = 0; ch < currentModbusRegs; ++ch) {
-            modbusValues[ch].append(snapshot.modbusData[ch]);
-            // 限制数据点数量
-            while (modbusValues[ch].size() > maxDataPoints) {
-                modbusValues[ch].removeFirst();
-            }
-        }
-
-        // 限制时间数据点数量
-        while (modbusTimeData.size() > maxDataPoints) {
-            modbusTimeData.removeFirst();
-        }
-
-        // 更新图表数据
-        if (!modbusTimeData.isEmpty()) {
+        // 更新图表数据（数据无效的时间段为NaN，曲线在此断开）
+        if (!modbus.time.isEmpty()) {
             // Ensure graph count matches data size
             while(ui->modbusCustomPlot->graphCount() < currentModbusRegs) {
                 ui->modbusCustomPlot->addGraph(); // Add missing graphs
@@ -4180,23 +4458,16 @@ void MainWindow::updateAllPlots(const DataSnapshot &snapshot, int snapshotCount)
             }
 
             for (int ch = 0; ch < currentModbusRegs; ++ch) {
-                ui->modbusCustomPlot->graph(ch)->setData(modbusTimeData, modbusValues[ch], true); // Use sorted data flag
-            }
-            // 优化X轴范围
-            double latestTimestamp = snapshot.timestamp;
-            double displayWindowSeconds = 60.0;
-            if (latestTimestamp <= displayWindowSeconds) {
-                ui->modbusCustomPlot->xAxis->setRange(0, displayWindowSeconds);
-            } else {
-                ui->modbusCustomPlot->xAxis->setRange(latestTimestamp - displayWindowSeconds, latestTimestamp);
+                ui->modbusCustomPlot->graph(ch)->setData(modbus.time, modbus.values[ch], true); // Use sorted data flag
             }
+            setTimeRange(ui->modbusCustomPlot);
             ui->modbusCustomPlot->yAxis->rescale();
             // 重绘图表 (queued)
             ui->modbusCustomPlot->replot(QCustomPlot::rpQueuedReplot);
         }
     }
 
-    // 更新DAQ图表
+    // 更新DAQ图表（从DAQ历史存储读取，时间轴为采集时间）
     if (snapshot.daqValid && ui->daqCustomPlot) {
         // 确保DAQ图表已初始化
         if (ui->daqCustomPlot->graphCount() == 0) {
@@ -4204,56 +4475,7 @@ void MainWindow::updateAllPlots(const DataSnapshot &snapshot, int snapshotCount)
             setupDAQPlot();
             qDebug() << "初始化DAQ图表，图表数量：" << ui->daqCustomPlot->graphCount();
         }
-
-        // 使用成员变量保存历史数据
-        // 获取实际通道数量
-        int currentDaqChannels = snapshot.daqData.size();
-        if (daqValues.size() != currentDaqChannels) {
-            daqValues.resize(currentDaqChannels);
-            // 可选：如果通道数量变化很大，清除旧图表
-        }
-
-        // 添加新的时间点
-        daqTimeData.append(snapshot.timestamp);
-
-        // 添加新的数据点
-        for (int ch = 0; ch < currentDaqChannels; ++ch) {
-            daqValues[ch].append(snapshot.daqData[ch]);
-            while (daqValues[ch].size() > maxDataPoints) {
-                daqValues[ch].removeFirst();
-            }
-        }
-        while (daqTimeData.size() > maxDataPoints) {
-            daqTimeData.removeFirst();
-        }
-
-        // 更新图表数据
-        if (!daqTimeData.isEmpty()) {
-             // Ensure graph count matches data size
-            while(ui->daqCustomPlot->graphCount() < currentDaqChannels) {
-                ui->daqCustomPlot->addGraph(); // Add missing graphs
-                 // Optionally set name/pen here
-            }
-            while(ui->daqCustomPlot->graphCount() > currentDaqChannels) {
-                ui->daqCustomPlot->removeGraph(ui->daqCustomPlot->graphCount() - 1); // Remove extra graphs
-            }
-
-            for (int ch = 0; ch < currentDaqChannels; ++ch) {
-                 ui->daqCustomPlot->graph(ch)->setData(daqTimeData, daqValues[ch], true);
-            }
-
-            // ui->daqCustomPlot->xAxis->setRange(snapshot.timestamp - 60, snapshot.timestamp); // Show last 60 seconds
-            // Apply the same logic for DAQ plot X-axis range
-            double latestTimestampDaq = snapshot.timestamp;
-            double displayWindowSecondsDaq = 60.0;
-            if (latestTimestampDaq <= displayWindowSecondsDaq) {
-                ui->daqCustomPlot->xAxis->setRange(0, displayWindowSecondsDaq);
-            } else {
-                ui->daqCustomPlot->xAxis->setRange(latestTimestampDaq - displayWindowSecondsDaq, latestTimestampDaq);
-            }
-            ui->daqCustomPlot->yAxis->rescale();
-            ui->daqCustomPlot->replot(QCustomPlot::rpQueuedReplot);
-        }
+        updateDAQPlotFromHistory(displayWindowSeconds);
     }
 
     // ECU数据绘图
@@ -4267,45 +4489,21 @@ void MainWindow::updateAllPlots(const DataSnapshot &snapshot, int snapshotCount)
 
         // 检查图表是否初始化成功 - 不要限制为9，使用实际的图表数量
         if (ui->ECUCustomPlot->graphCount() > 0) {
-            // 使用成员变量保存历史数据
             const int ecuChannelCount = 9; // ECU通道数量固定
+            const SnapshotHistory::QueryResult ecu = queryWindow(ui->ECUCustomPlot, SessionLog::ECUValue, ecuChannelCount);
 
-            if (ecuValues.size() != ecuChannelCount) {
-                ecuValues.resize(ecuChannelCount);
-            }
-
-            ecuTimeData.append(snapshot.timestamp);
-
-            for (int i = 0; i < ecuChannelCount && i < snapshot.ecuData.size(); ++i) {
-                ecuValues[i].append(snapshot.ecuData[i]);
-                while (ecuValues[i].size() > maxDataPoints) {
-                    ecuValues[i].removeFirst();
-                }
-            }
-            while (ecuTimeData.size() > maxDataPoints) {
-                ecuTimeData.removeFirst();
-            }
-
-            if (!ecuTimeData.isEmpty() && ui->ECUCustomPlot->graphCount() == ecuChannelCount) { // Check if initialized
+            if (!ecu.time.isEmpty() && ui->ECUCustomPlot->graphCount() == ecuChannelCount) { // Check if initialized
                 for (int i = 0; i < ecuChannelCount; ++i) {
-                    if (!ecuValues[i].isEmpty()) {
-                        ui->ECUCustomPlot->graph(i)->setData(ecuTimeData, ecuValues[i], true);
-                    }
+                    ui->ECUCustomPlot->graph(i)->setData(ecu.time, ecu.values[i], true);
                 }
 
                 // 设置X轴范围
-                double latestTimestampEcu = snapshot.timestamp;
-                double displayWindowSecondsEcu = 60.0;
-                if (latestTimestampEcu <= displayWindowSecondsEcu) {
-                    ui->ECUCustomPlot->xAxis->setRange(0, displayWindowSecondsEcu);
-                } else {
-                    ui->ECUCustomPlot->xAxis->setRange(latestTimestampEcu - displayWindowSecondsEcu, latestTimestampEcu);
-                }
+                setTimeRange(ui->ECUCustomPlot);
 
-                // 获取转速通道的最大值（索引 1）
+                // 获取转速通道的最大值（索引 1），抽取保留了每个区间的最大值
                 double maxSpeed = 0;
-                if (ecuValues.size() > 1 && !ecuValues[1].isEmpty()) {
-                    for (double speed : ecuValues[1]) {
+                for (double speed : ecu.values[1]) {
+                    if (!std::isnan(speed)) {
                         maxSpeed = qMax(maxSpeed, speed);
                     }
                 }
@@ -4395,60 +4593,6 @@ void MainWindow::updateDashboardData(const QVector<double> &timeData, const Data
 }
 
 
-// 实现主定时器的超时处理函数
-void MainWindow::onMainTimerTimeout()
-{
-    qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
-    static qint64 programStartTime = currentTime; // 记录程序启动时间
-
-    // 计算程序运行时间
-    qint64 runTime = currentTime - programStartTime;
-
-    try {
-        // 处理Modbus读取请求 - 在整百毫秒+50的时间点触发
-        if (modbusReadRequested && !modbusReading) {
-            // 计算当前毫秒数在100ms周期中的位置
-            qint64 msInCycle = runTime % 100;
-
-            // 在接近50ms位置时触发(45-55ms之间)
-            if (msInCycle >= 45 && msInCycle <= 55) {
-                // 只有在上次读取完成后才触发新的读取
-                if (currentTime - lastModbusReadTime >= ui->lineTimeLoop->text().toInt()) {
-                    // 设置读取标志和时间戳
-                    modbusReading = true;
-                    lastModbusReadTime = currentTime;
-
-                    // 发送Modbus读取命令
-                    emit sendModbusCommand(ui->lineServerAddress->text().toInt(),
-                                          ui->lineSegAddress->text().toInt(),
-                                          ui->lineSegNum->text().toInt());
-                }
-            }
-        }
-
-        // 处理快照 - 在整百毫秒的时间点触发
-        if (runTime - lastSnapshotTime >= 100) { // 每100ms处理一次快照
-            // 计算当前毫秒数在100ms周期中的位置
-            qint64 msInCycle = runTime % 100;
-
-            // 当接近0ms位置时触发(90-10ms之间)
-            if (msInCycle >= 90 || msInCycle <= 10) {
-                // 更新时间戳
-                lastSnapshotTime = runTime;
-
-                // 触发数据快照处理
-                emit triggerProcessDataSnapshots();
-            }
-        }
-    }
-    catch (const std::exception& e) {
-        qDebug() << "主定时器处理时出错: " << e.what();
-    }
-    catch (...) {
-        qDebug() << "主定时器处理时发生未知错误";
-    }
-}
-
 // 添加新的函数: 处理Modbus数据，包括滤波处理，不含绘图功能
 // 注释掉handleModbusData函数，已移至SnapshotThread
 /*
@@ -4516,21 +4660,7 @@ void MainWindow::handleModbusData(QVector<double> resultdata, qint64 readTimeInt
 // 清除所有图表数据数组
 void MainWindow::clearAllPlotDataArrays()
 {
-    // 清除Modbus图表数据
-    modbusTimeData.clear();
-    modbusValues.clear();
-
-    // 清除DAQ图表数据
-    daqTimeData.clear();
-    daqValues.clear();
-
-    // 清除ECU图表数据
-    ecuTimeData.clear();
-    ecuValues.clear();
-
-    // 清除自定义变量图表数据
-    customTimeData.clear();
-    customValues.clear();
+    // Modbus/DAQ/ECU/自定义变量图表从快照历史查询，快照线程重置主计时器时清空历史
 
     // 清除dash1plot数据
     dashForceTimeData.clear();
@@ -4652,7 +4782,7 @@ void MainWindow::on_btnStartAll_clicked()
         }
 
         // --- Configure SnapshotThread ---
-        int modbusCount = ui->lineSegNum->text().toInt();
+        int modbusCount = modbusChannelCount();
         QStringList daqParts = ui->channelsEdit->text().split('/', Qt::SkipEmptyParts);
         int daqCount = daqParts.size();
         emit sendConfigCounts(modbusCount, daqCount);
@@ -4673,7 +4803,6 @@ void MainWindow::on_btnStartAll_clicked()
 
         // --- Start Timers and Update UI ---
         allCaptureRunning = true; // Keep this flag for internal logic if needed, but mode is primary
-        mainTimer->start(10); // Ensure timer interval is set
         ui->btnStartAll->setText("停止所有采集");
 
         // Disable Calibrate Sensor menu option during data collection
@@ -4692,8 +4821,7 @@ void MainWindow::on_btnStartAll_clicked()
         currentRunMode = RunMode::Idle; // Set to Idle regardless of previous state
         qDebug() << "[MainWindow] Stopping all tasks from mode:" << previousMode;
 
-        // --- Stop Processing and Timers FIRST ---
-        mainTimer->stop();
+        // --- Stop Processing FIRST ---
         if (snpTh) {
             // Disable processing FIRST to prevent further snapshot handling
             QMetaObject::invokeMethod(snpTh, "setProcessingEnabled", Qt::QueuedConnection, Q_ARG(bool, false));
@@ -4735,9 +4863,12 @@ void MainWindow::on_btnStartAll_clicked()
 }
 
 // 添加新函数：处理从SnapshotThread接收的数据
-void MainWindow::handleSnapshotProcessed(const DataSnapshot &snapshot, int snapshotCount)
+void MainWindow::handleSnapshotProcessed(const SnapshotHandle &handle, int snapshotCount)
 {
     try {
+        // 与快照线程、WebSocket线程共享同一份只读快照
+        const DataSnapshot &snapshot = *handle;
+
         // 从快照创建时间向量
         QVector<double> timeData;
         timeData.append(snapshot.timestamp);
@@ -4756,6 +4887,9 @@ void MainWindow::handleSnapshotProcessed(const DataSnapshot &snapshot, int snaps
             // 更新所有图表
             updateAllPlots(snapshot, snapshotCount);
         }
+
+        PipelineLatency::recordSince(PipelineLatency::UiPaint, snapshot.publishedNs);
+        PipelineLatency::recordSince(PipelineLatency::EndToEndUi, snapshot.acquiredNs);
     } catch (const std::exception& e) {
         qDebug() << "处理快照数据时出错: " << e.what();
     } catch (...) {
@@ -4763,6 +4897,17 @@ void MainWindow::handleSnapshotProcessed(const DataSnapshot &snapshot, int snaps
     }
 }
 
+// 打开管线延迟统计面板
+void MainWindow::showLatencyDialog()
+{
+    if (!latencyDialog) {
+        latencyDialog = new LatencyDialog(this);
+    }
+    latencyDialog->show();
+    latencyDialog->raise();
+    latencyDialog->activateWindow();
+}
+
 // 创建校准菜单
 void MainWindow::createCalibrationMenu()
 {
@@ -4899,7 +5044,7 @@ void MainWindow::handleStartCalibrationRequest()
     }
 
     // --- Configure SnapshotThread (Counts & Timer Reset) FIRST ---
-    int modbusCount = ui->lineSegNum->text().toInt();
+    int modbusCount = modbusChannelCount();
     QStringList daqParts = ui->channelsEdit->text().split('/', Qt::SkipEmptyParts);
     int daqCount = daqParts.size();
     emit sendConfigCounts(modbusCount, daqCount);
@@ -4986,7 +5131,6 @@ void MainWindow::handleStartCalibrationRequest()
 
         // --- Start Timers and Update UI ---
         allCaptureRunning = true;
-        mainTimer->start(10);
         ui->btnStartAll->setText("采集中 (校准模式)");
         ui->btnStartAll->setEnabled(false); // Disable main start/stop during calibration
         QAction *calibrateSensorAction = findChild<QAction*>("actionCalibrateSensor");
@@ -5008,8 +5152,7 @@ void MainWindow::handleStopCalibrationRequest()
     qDebug() << "[MainWindow] Stopping Calibration Run...";
     currentRunMode = RunMode::Idle;
 
-    // --- Stop Processing and Timers FIRST ---
-    mainTimer->stop();
+    // --- Stop Processing FIRST ---
     if (snpTh) {
         QMetaObject::invokeMethod(snpTh, "setProcessingEnabled", Qt::QueuedConnection, Q_ARG(bool, false));
         snpTh->setDataLoggingEnabled(false); // Ensure logging is off
@@ -25,6 +25,7 @@
 #include <modbusthread.h>
 #include <canthread.h>
 #include <daqthread.h>
+#include "daqrecorder.h"
 #include <plotthread.h>
 #include <QCoreApplication>
 #include <QHBoxLayout>
@@ -63,6 +64,9 @@ class DashboardCalculator;
 // 新增：引入CalibrationDialog
 #include "calibrationdialog.h"
 
+// 管线延迟统计面板
+#include "latencydialog.h"
+
 // 新增: 运行模式枚举
 enum RunMode { Idle, Normal, Calibration };
 
@@ -159,7 +163,7 @@ private slots:
     // 注释掉已移至SnapshotThread的函数，改为新的处理函数
     // void handleModbusData(QVector<double> resultdata, qint64 readTimeInterval);
     // 新增：接收快照线程处理后的数据
-    void handleSnapshotProcessed(const DataSnapshot &snapshot, int snapshotCount);
+    void handleSnapshotProcessed(const SnapshotHandle &handle, int snapshotCount);
 
     void on_btnCanOpenDevice_clicked();
 
@@ -217,9 +221,6 @@ private slots:
     // WebSocket相关槽函数
     void on_btnWebSocketTest_clicked();
 
-    // 主计时器超时槽函数
-    void onMainTimerTimeout();
-
     // 新增菜单项槽函数
     void on_actionSetupInitial_triggered();
     void on_actionLoadInitial_triggered();
@@ -260,6 +261,7 @@ private slots:
 
     // DAQ相关函数
     void setupDAQPlot();
+    void updateDAQPlotFromHistory(double displayWindowSeconds);
     void on_startDAQButton_clicked();
     void on_stopDAQButton_clicked();
 
@@ -288,13 +290,14 @@ private slots:
     // 新增校准传感器菜单动作处理槽
     void on_actionCalibrateSensor_triggered();
 
+    // 打开管线延迟统计面板
+    void showLatencyDialog();
+
     // 新增：校准请求处理槽
     void handleStartCalibrationRequest();
     void handleStopCalibrationRequest();
 
 signals:
-    void triggerProcessDataSnapshots();
-    void sendModbusCommand(int serverAddress, int startAddress, int length);
     void sendModbusInfo(QString portName, int baudRateIndex, int stopBitsIndex, int dataBitsIndex, int parityIndex);
     void closeModbusConnection();
     void resetModbusTimer();
@@ -307,6 +310,12 @@ private:
     // 创建校准菜单
     void createCalibrationMenu();
 
+    // Modbus轮询表（配置文件或界面上的寄存器段）及其合并后的通道数
+    QVector<ModbusPollBlock> buildModbusPollTable() const;
+    QVector<ModbusChannelSpec> buildModbusPollChannels() const;
+    QVector<ModbusTcpDevice> buildModbusTcpDevices() const;
+    int modbusChannelCount() const;
+
     Ui::MainWindow *ui;
     QThread *SubThread_Modbus;
     QThread *SubThread_Can;
@@ -347,6 +356,7 @@ private:
     // 添加DAQ相关成员
     QThread *daqThread;
     DAQThread *daqTh;
+    DAQRecorder *daqRecorder;     // 全速率DAQ数据记录线程
 
     // 仅保留用于UI参考的变量
     int daqNumChannels;           // 保留，用于UI参考
@@ -406,12 +416,6 @@ private:
     QTimer *snapshotTimer;                 // 数据快照定时器，保留用于触发信号
     int maxQueueSize = 1000;               // 最大队列长度，防止内存占用过多
 
-    // 添加统一定时器相关变量
-    QTimer *mainTimer;          // 主定时器
-    bool modbusReadRequested;   // 是否请求了Modbus读取
-    bool modbusReading;         // 是否正在读取Modbus数据
-    qint64 lastModbusReadTime;  // 上次Modbus读取时间
-    qint64 lastSnapshotTime;    // 上次快照时间
     qint64 lastPlotUpdateTime;  // 上次绘图更新时间
 
     // 标记所有采集任务是否在运行中
@@ -420,6 +424,9 @@ private:
     // 校准对话框
     CalibrationDialog *calibrationDialog = nullptr; // 初始化为nullptr
 
+    // 管线延迟统计面板（非模态，关闭后保留）
+    LatencyDialog *latencyDialog = nullptr;
+
     // 保存原始的数据记录状态
     bool originalDataLoggingState = true;
 
@@ -429,22 +436,10 @@ private:
     // 标记初始化状态（通过设置初始化或读取初始化文件）
     bool initializationCompleted = false;
 
-    // 图表数据成员变量
-    // Modbus图表数据
-    QVector<double> modbusTimeData;
-    QVector<QVector<double>> modbusValues;
-
-    // DAQ图表数据
-    QVector<double> daqTimeData;
-    QVector<QVector<double>> daqValues;
-
-    // ECU图表数据
-    QVector<double> ecuTimeData;
-    QVector<QVector<double>> ecuValues;
-
-    // 自定义变量图表数据
-    QVector<double> customTimeData;
-    QVector<QVector<double>> customValues;
+    // 图表数据从SnapshotThread的快照历史查询，不再在此保存副本
+    QElapsedTimer plotRefreshTimer;        // 限制图表刷新频率
+    std::vector<std::int64_t> daqPlotIndices; // DAQ图表读取历史存储的缓冲区（样本序号）
+    std::vector<double> daqPlotValues;        // DAQ图表读取历史存储的缓冲区（数值）
 
     // 添加清除所有图表数据数组的函数
     void clearAllPlotDataArrays();
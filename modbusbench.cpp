@@ -0,0 +1,250 @@
+// Modbus TCP轮询基准测试
+//
+// 在回环地址上启动若干个Modbus TCP替身服务器（每个模拟一个带多个从站的网关），由modbusThread按通道表轮询，
+// 无需硬件即可测量不同的同时请求数下的轮询吞吐量，并校验读回的寄存器值。
+// 替身服务器对功能码3/4返回 (地址×7 + 从站地址) & 0xFFFF，按--latency-ms延迟应答，
+// 同一连接上的多个请求并发处理（与支持流水线的网关一致）。
+//
+// 示例：modbusbench --devices 4 --slaves 8 --channels 16 --latency-ms 2 --inflight 1,8 --seconds 5
+//       modbusbench --period-ms 20 --inflight 4     （按周期轮询，观察跳过的周期和轮询抖动）
+#include "modbusthread.h"
+#include "pipelinelatency.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <memory>
+#include <vector>
+
+namespace {
+
+quint16 registerValue(int slave, int address)
+{
+    return quint16((address * 7 + slave) & 0xFFFF);
+}
+
+// Modbus TCP替身服务器：解析MBAP帧，按固定延迟应答
+class StandInServer : public QObject
+{
+public:
+    explicit StandInServer(int latencyMs, QObject *parent = nullptr)
+        : QObject(parent), latencyMs(latencyMs)
+    {
+        connect(&server, &QTcpServer::newConnection, this, [this]() {
+            while (QTcpSocket *socket = server.nextPendingConnection()) {
+                auto buffer = std::make_shared<QByteArray>();
+                connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+                connect(socket, &QTcpSocket::readyRead, this, [this, socket, buffer]() {
+                    buffer->append(socket->readAll());
+                    handleFrames(socket, *buffer);
+                });
+            }
+        });
+    }
+
+    bool listen() { return server.listen(QHostAddress::LocalHost, 0); }
+    quint16 port() const { return server.serverPort(); }
+    quint64 requests() const { return requestCount; }
+
+private:
+    QTcpServer server;
+    int latencyMs;
+    quint64 requestCount = 0;
+
+    void handleFrames(QTcpSocket *socket, QByteArray &buffer)
+    {
+        // MBAP头：事务号2、协议号2、长度2（单元号起的字节数）
+        while (buffer.size() >= 7) {
+            const uchar *b = reinterpret_cast<const uchar *>(buffer.constData());
+            const int length = (b[4] << 8) | b[5];
+            if (buffer.size() < 6 + length) {
+                break;
+            }
+            const QByteArray frame = buffer.left(6 + length);
+            buffer.remove(0, 6 + length);
+            ++requestCount;
+
+            const uchar *f = reinterpret_cast<const uchar *>(frame.constData());
+            const int unit = f[6];
+            const int functionCode = frame.size() > 7 ? f[7] : 0;
+            QByteArray pdu;
+            if ((functionCode == 3 || functionCode == 4) && frame.size() >= 12) {
+                const int start = (f[8] << 8) | f[9];
+                const int count = (f[10] << 8) | f[11];
+                pdu.append(char(functionCode));
+                pdu.append(char(count * 2));
+                for (int i = 0; i < count; ++i) {
+                    const quint16 value = registerValue(unit, start + i);
+                    pdu.append(char(value >> 8));
+                    pdu.append(char(value & 0xFF));
+                }
+            } else {
+                // 不支持的功能码：异常应答01
+                pdu.append(char(functionCode | 0x80));
+                pdu.append(char(0x01));
+            }
+
+            QByteArray reply = frame.left(4);
+            const int replyLength = pdu.size() + 1;
+            reply.append(char(replyLength >> 8));
+            reply.append(char(replyLength & 0xFF));
+            reply.append(char(unit));
+            reply.append(pdu);
+            if (latencyMs > 0) {
+                QTimer::singleShot(latencyMs, socket, [socket, reply]() { socket->write(reply); });
+            } else {
+                socket->write(reply);
+            }
+        }
+    }
+};
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("modbusbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("在回环地址上用Modbus TCP替身服务器测试轮询吞吐量");
+    parser.addHelpOption();
+    QCommandLineOption devicesOption("devices", "TCP设备（替身服务器）数", "n", "2");
+    QCommandLineOption slavesOption("slaves", "每个设备后的从站数", "n", "8");
+    QCommandLineOption channelsOption("channels", "每个从站的通道数", "n", "16");
+    QCommandLineOption gapOption("gap", "相邻通道的地址间隔", "n", "4");
+    QCommandLineOption periodOption("period-ms", "轮询周期（ms），0表示尽快读取", "ms", "0");
+    QCommandLineOption latencyOption("latency-ms", "替身服务器的应答延迟（ms）", "ms", "2");
+    QCommandLineOption inFlightOption("inflight", "每个连接同时进行的请求数，逗号分隔时依次测试", "list", "1,8");
+    QCommandLineOption secondsOption("seconds", "每轮运行时间（秒）", "s", "3");
+    QCommandLineOption backToBackOption("back-to-back", "连续模式：忽略周期，应答后立即发出下一个请求");
+    parser.addOptions({devicesOption, slavesOption, channelsOption, gapOption, periodOption, latencyOption,
+                       inFlightOption, secondsOption, backToBackOption});
+    parser.process(app);
+
+    const int deviceCount = qMax(1, parser.value(devicesOption).toInt());
+    const int slaveCount = qBound(1, parser.value(slavesOption).toInt(), 247);
+    const int channelsPerSlave = qMax(1, parser.value(channelsOption).toInt());
+    const int gap = qMax(1, parser.value(gapOption).toInt());
+    const double periodMs = qMax(0.0, parser.value(periodOption).toDouble());
+    const int latencyMs = qMax(0, parser.value(latencyOption).toInt());
+    const double seconds = qMax(0.1, parser.value(secondsOption).toDouble());
+    QVector<int> inFlightList;
+    for (const QString &value : parser.value(inFlightOption).split(',', Qt::SkipEmptyParts)) {
+        inFlightList.append(qMax(1, value.trimmed().toInt()));
+    }
+    if (inFlightList.isEmpty()) {
+        inFlightList.append(1);
+    }
+
+    std::vector<std::unique_ptr<StandInServer>> servers;
+    for (int d = 0; d < deviceCount; ++d) {
+        servers.push_back(std::make_unique<StandInServer>(latencyMs));
+        if (!servers.back()->listen()) {
+            qCritical().noquote() << "错误: 无法在回环地址上监听";
+            return 1;
+        }
+    }
+
+    // 通道表：每个设备的每个从站上按固定间隔分布的寄存器
+    QVector<ModbusChannelSpec> channels;
+    QVector<double> expected;
+    for (int d = 1; d <= deviceCount; ++d) {
+        for (int slave = 1; slave <= slaveCount; ++slave) {
+            for (int c = 0; c < channelsPerSlave; ++c) {
+                ModbusChannelSpec channel;
+                channel.device = d;
+                channel.slave = slave;
+                channel.functionCode = 3;
+                channel.address = c * gap;
+                channel.periodMs = periodMs;
+                channels.append(channel);
+                expected.append(registerValue(slave, channel.address) * 0.01);
+            }
+        }
+    }
+
+    modbusThread poller;
+    poller.initModbusClient();
+    poller.setPollMode(parser.isSet(backToBackOption));
+
+    quint64 results = 0;
+    quint64 wrongValues = 0;
+    int requestsPerCycle = 0;
+    QObject::connect(&poller, &modbusThread::sendModbusResult, &app, [&](QVector<double> values, long long, qint64) {
+        ++results;
+        for (int i = 0; i < values.size() && i < expected.size(); ++i) {
+            // 尚未读到的通道为0，读取失败为-9999
+            if (values[i] != 0.0 && values[i] != -9999 && qAbs(values[i] - expected[i]) > 1e-9) {
+                ++wrongValues;
+            }
+        }
+    });
+    QObject::connect(&poller, &modbusThread::pollPlanChanged, &app,
+                     [&](int requests, int, double) { requestsPerCycle = requests; });
+    quint64 failed = 0;
+    quint64 missed = 0;
+    qint64 maxLatenessNs = 0;
+    QObject::connect(&poller, &modbusThread::pollStatistics, &app,
+                     [&](quint64, quint64 missedCycles, quint64 failedRequests, qint64 latenessNs) {
+                         failed = failedRequests;
+                         missed = missedCycles;
+                         maxLatenessNs = qMax(maxLatenessNs, latenessNs);
+                     });
+
+    qInfo().noquote() << QString("设备 %1，每设备从站 %2，每从站通道 %3（间隔 %4），应答延迟 %5 ms，周期 %6")
+                             .arg(deviceCount).arg(slaveCount).arg(channelsPerSlave).arg(gap).arg(latencyMs)
+                             .arg(periodMs > 0.0 ? QString("%1 ms").arg(periodMs) : QString("尽快"));
+
+    double baseline = 0.0;
+    for (int inFlight : inFlightList) {
+        QVector<ModbusTcpDevice> devices;
+        for (const auto &server : servers) {
+            ModbusTcpDevice device;
+            device.host = "127.0.0.1";
+            device.port = server->port();
+            device.maxInFlight = inFlight;
+            devices.append(device);
+        }
+        poller.setTcpDevices(devices);
+        poller.setPollChannels(channels);
+
+        results = 0;
+        wrongValues = 0;
+        failed = 0;
+        missed = 0;
+        maxLatenessNs = 0;
+        QElapsedTimer clock;
+        clock.start();
+        poller.startPolling();
+        QTimer::singleShot(int(seconds * 1000), &app, [&]() { app.quit(); });
+        app.exec();
+        poller.stopPolling();
+        const double elapsed = clock.nsecsElapsed() / 1e9;
+
+        const double rate = results / elapsed;
+        if (baseline <= 0.0) {
+            baseline = rate;
+        }
+        // 每个轮询周期发送一次通道向量
+        qInfo().noquote() << QString("同时请求数 %1：%2 个请求/周期，%3 个周期/s（%4倍），%5 个通道值/s，错误值 %6，失败 %7")
+                                 .arg(inFlight, 2).arg(requestsPerCycle).arg(rate, 0, 'f', 0)
+                                 .arg(baseline > 0.0 ? rate / baseline : 0.0, 0, 'f', 1)
+                                 .arg(rate * channels.size(), 0, 'f', 0)
+                                 .arg(wrongValues).arg(failed);
+        if (periodMs > 0.0 && !parser.isSet(backToBackOption)) {
+            const LatencyHistogram::Snapshot lateness =
+                PipelineLatency::histogram(PipelineLatency::ModbusPollLateness).snapshot();
+            qInfo().noquote() << QString("    跳过周期 %1，轮询抖动（ms）：p50 %2，p99 %3，最大 %4")
+                                     .arg(missed)
+                                     .arg(PipelineClock::toMilliseconds(lateness.percentile(50.0)), 0, 'f', 3)
+                                     .arg(PipelineClock::toMilliseconds(lateness.percentile(99.0)), 0, 'f', 3)
+                                     .arg(PipelineClock::toMilliseconds(qMax(maxLatenessNs, lateness.maxNs)), 0, 'f', 3);
+        }
+        PipelineLatency::resetAll();
+    }
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include "modbusdecode.h"
+#include <cstring>
+
+int ModbusValueFormat::registerCount() const
+{
+    switch (type) {
+    case UInt32:
+    case Int32:
+    case Float32:
+        return 2;
+    case Float64:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+bool ModbusValueFormat::parseType(const QString &name, Type *type)
+{
+    const QString key = name.trimmed().toLower();
+    if (key == "u16" || key == "uint16") {
+        *type = UInt16;
+    } else if (key == "i16" || key == "int16") {
+        *type = Int16;
+    } else if (key == "u32" || key == "uint32") {
+        *type = UInt32;
+    } else if (key == "i32" || key == "int32") {
+        *type = Int32;
+    } else if (key == "f32" || key == "float" || key == "float32") {
+        *type = Float32;
+    } else if (key == "f64" || key == "double" || key == "float64") {
+        *type = Float64;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+template <bool ByteSwap>
+inline quint16 readWord(const quint16 *raw, int index)
+{
+    const quint16 word = raw[index];
+    return ByteSwap ? quint16((word >> 8) | (word << 8)) : word;
+}
+
+template <ModbusValueFormat::Type Type, bool ByteSwap>
+inline double decodeValue(const quint16 *raw, const int *word)
+{
+    if constexpr (Type == ModbusValueFormat::UInt16) {
+        return readWord<ByteSwap>(raw, word[0]);
+    } else if constexpr (Type == ModbusValueFormat::Int16) {
+        return qint16(readWord<ByteSwap>(raw, word[0]));
+    } else if constexpr (Type == ModbusValueFormat::UInt32 || Type == ModbusValueFormat::Int32
+                         || Type == ModbusValueFormat::Float32) {
+        const quint32 bits = (quint32(readWord<ByteSwap>(raw, word[0])) << 16) | readWord<ByteSwap>(raw, word[1]);
+        if constexpr (Type == ModbusValueFormat::UInt32) {
+            return bits;
+        } else if constexpr (Type == ModbusValueFormat::Int32) {
+            return qint32(bits);
+        } else {
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+    } else {
+        const quint64 bits = (quint64(readWord<ByteSwap>(raw, word[0])) << 48)
+                             | (quint64(readWord<ByteSwap>(raw, word[1])) << 32)
+                             | (quint64(readWord<ByteSwap>(raw, word[2])) << 16) | readWord<ByteSwap>(raw, word[3]);
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+}
+
+template <ModbusValueFormat::Type Type, bool ByteSwap, class Item>
+void decodeGroup(const std::vector<Item> &items, const quint16 *raw, double *out)
+{
+    for (const Item &item : items) {
+        out[item.out] = decodeValue<Type, ByteSwap>(raw, item.word) * item.scale + item.offset;
+    }
+}
+
+template <ModbusValueFormat::Type Type, class Item>
+void decodeGroup(const std::vector<Item> &items, bool byteSwap, const quint16 *raw, double *out)
+{
+    if (byteSwap) {
+        decodeGroup<Type, true>(items, raw, out);
+    } else {
+        decodeGroup<Type, false>(items, raw, out);
+    }
+}
+
+} // namespace
+
+ModbusDecodePlan ModbusDecodePlan::compile(const QVector<int> &offsets, const QVector<ModbusValueFormat> &formats)
+{
+    ModbusDecodePlan plan;
+    plan.m_channelCount = offsets.size();
+    for (int c = 0; c < offsets.size(); ++c) {
+        const ModbusValueFormat format = c < formats.size() ? formats[c] : ModbusValueFormat();
+        if (offsets[c] < 0) {
+            plan.m_unmapped.push_back(c);
+            continue;
+        }
+
+        Group *group = nullptr;
+        for (Group &candidate : plan.m_groups) {
+            if (candidate.type == format.type && candidate.byteSwap == format.byteSwap) {
+                group = &candidate;
+                break;
+            }
+        }
+        if (!group) {
+            plan.m_groups.push_back(Group());
+            group = &plan.m_groups.back();
+            group->type = format.type;
+            group->byteSwap = format.byteSwap;
+        }
+
+        Item item;
+        const int count = format.registerCount();
+        for (int w = 0; w < count; ++w) {
+            // 默认高位字在前；wordSwap时低位字在前
+            item.word[w] = offsets[c] + (format.wordSwap ? count - 1 - w : w);
+        }
+        item.out = c;
+        item.scale = format.scale;
+        item.offset = format.offset;
+        group->items.push_back(item);
+
+        Span span;
+        span.first = offsets[c];
+        span.count = count;
+        span.out = c;
+        plan.m_spans.push_back(span);
+    }
+    return plan;
+}
+
+void ModbusDecodePlan::decode(const quint16 *raw, const quint8 *valid, double *out) const
+{
+    for (const Group &group : m_groups) {
+        switch (group.type) {
+        case ModbusValueFormat::UInt16: decodeGroup<ModbusValueFormat::UInt16>(group.items, group.byteSwap, raw, out); break;
+        case ModbusValueFormat::Int16: decodeGroup<ModbusValueFormat::Int16>(group.items, group.byteSwap, raw, out); break;
+        case ModbusValueFormat::UInt32: decodeGroup<ModbusValueFormat::UInt32>(group.items, group.byteSwap, raw, out); break;
+        case ModbusValueFormat::Int32: decodeGroup<ModbusValueFormat::Int32>(group.items, group.byteSwap, raw, out); break;
+        case ModbusValueFormat::Float32: decodeGroup<ModbusValueFormat::Float32>(group.items, group.byteSwap, raw, out); break;
+        case ModbusValueFormat::Float64: decodeGroup<ModbusValueFormat::Float64>(group.items, group.byteSwap, raw, out); break;
+        }
+    }
+    for (int c : m_unmapped) {
+        out[c] = -9999;
+    }
+    if (valid) {
+        for (const Span &span : m_spans) {
+            for (int i = 0; i < span.count; ++i) {
+                if (!valid[span.first + i]) {
+                    out[span.out] = -9999;
+                    break;
+                }
+            }
+        }
+    }
+}
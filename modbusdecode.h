@@ -0,0 +1,72 @@
+#ifndef MODBUSDECODE_H
+#define MODBUSDECODE_H
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <vector>
+
+// 一个Modbus通道的数值格式：寄存器按类型组合后换算为 值 × scale + offset
+struct ModbusValueFormat {
+    enum Type {
+        UInt16,
+        Int16,
+        UInt32,
+        Int32,
+        Float32,
+        Float64
+    };
+
+    Type type = UInt16;
+    bool wordSwap = false;      // 多寄存器类型低位字在前（默认高位字在前）
+    bool byteSwap = false;      // 寄存器内低字节在前（默认高字节在前）
+    double scale = 0.01;
+    double offset = 0.0;
+
+    // 类型占用的寄存器数
+    int registerCount() const;
+    // 按名称（u16/i16/u32/i32/f32/f64，不区分大小写）解析类型，无法识别时返回false
+    static bool parseType(const QString &name, Type *type);
+};
+
+// Modbus解码计划
+//
+// 编译时按(类型, 字节序)把通道分组，字序在编译时折算为各寄存器的位置；解码时每组一个专门的循环，
+// 循环内没有按类型或字节序的分支，也不分配内存。原始寄存器向量按ModbusRequestPlan的布局（各块按顺序拼接）。
+class ModbusDecodePlan
+{
+public:
+    // offsets为每个通道第一个寄存器在原始向量中的位置（-1为无效通道），formats与之一一对应
+    static ModbusDecodePlan compile(const QVector<int> &offsets, const QVector<ModbusValueFormat> &formats);
+
+    int channelCount() const { return m_channelCount; }
+
+    // 解码全部通道到out（channelCount()个）。valid非空时为每个寄存器的有效标记，
+    // 任一寄存器无效的通道输出-9999；无效通道总是输出-9999
+    void decode(const quint16 *raw, const quint8 *valid, double *out) const;
+
+private:
+    struct Item {
+        int word[4] = {0, 0, 0, 0};   // 按从高位到低位的顺序排列的寄存器位置
+        int out = 0;
+        double scale = 1.0;
+        double offset = 0.0;
+    };
+    struct Group {
+        ModbusValueFormat::Type type = ModbusValueFormat::UInt16;
+        bool byteSwap = false;
+        std::vector<Item> items;
+    };
+    struct Span {
+        int first = 0;
+        int count = 0;
+        int out = 0;
+    };
+
+    std::vector<Group> m_groups;
+    std::vector<Span> m_spans;          // 各通道占用的寄存器，用于按有效标记修正
+    std::vector<int> m_unmapped;        // 无效通道
+    int m_channelCount = 0;
+};
+
+#endif // MODBUSDECODE_H
@@ -0,0 +1,140 @@
+#include "modbuspollscheduler.h"
+#include <QStringList>
+#include <cmath>
+
+int ModbusPollScheduler::maxCountPerRequest(int functionCode)
+{
+    switch (functionCode) {
+    case 1:
+    case 2:
+        return 2000;
+    case 3:
+    case 4:
+        return 125;
+    default:
+        return 0;
+    }
+}
+
+bool ModbusPollScheduler::isValidBlock(const ModbusPollBlock &block)
+{
+    return block.device >= 0 && maxCountPerRequest(block.functionCode) > 0 && block.count > 0 && block.start >= 0
+           && block.start + block.count <= 65536 && block.slave >= 0 && block.slave <= 247;
+}
+
+void ModbusPollScheduler::setTable(const QVector<ModbusPollBlock> &blocks, QString *error)
+{
+    m_table.clear();
+    m_entries.clear();
+    m_channelCount = 0;
+
+    QStringList problems;
+    for (int b = 0; b < blocks.size(); ++b) {
+        const ModbusPollBlock &block = blocks[b];
+        const int maxCount = maxCountPerRequest(block.functionCode);
+        if (!isValidBlock(block)) {
+            problems.append(QString("第%1项（从站%2，功能码%3，地址%4，数量%5）无效")
+                                .arg(b).arg(block.slave).arg(block.functionCode).arg(block.start).arg(block.count));
+            continue;
+        }
+        m_table.append(block);
+
+        const qint64 periodNs = block.periodMs > 0.0 ? qint64(std::llround(block.periodMs * 1e6)) : 0;
+        for (int offset = 0; offset < block.count; offset += maxCount) {
+            Entry entry;
+            entry.request.entry = int(m_entries.size());
+            entry.request.slave = block.slave;
+            entry.request.functionCode = block.functionCode;
+            entry.request.start = block.start + offset;
+            entry.request.count = qMin(maxCount, block.count - offset);
+            entry.request.channelOffset = m_channelCount + offset;
+            entry.periodNs = periodNs;
+            entry.priority = block.priority;
+            m_entries.push_back(entry);
+        }
+        m_channelCount += block.count;
+    }
+
+    if (error) {
+        *error = problems.join("; ");
+    }
+}
+
+void ModbusPollScheduler::reset(qint64 nowNs)
+{
+    for (Entry &entry : m_entries) {
+        entry.dueNs = nowNs;
+        entry.inFlight = false;
+    }
+}
+
+bool ModbusPollScheduler::next(qint64 nowNs, Request *request, qint64 *nextDueNs)
+{
+    Entry *best = nullptr;
+    qint64 earliest = -1;
+    for (Entry &entry : m_entries) {
+        if (entry.inFlight) {
+            continue;
+        }
+        if (!m_backToBack && entry.dueNs > nowNs + m_toleranceNs) {
+            if (earliest < 0 || entry.dueNs < earliest) {
+                earliest = entry.dueNs;
+            }
+            continue;
+        }
+        if (!best) {
+            best = &entry;
+        } else if (m_backToBack) {
+            // 连续模式下所有项总是到期，先按上次发出的先后轮流，优先级只决定同时可发的项的先后，
+            // 否则优先级最高的项会一直占用总线
+            if (entry.dueNs < best->dueNs || (entry.dueNs == best->dueNs && entry.priority > best->priority)) {
+                best = &entry;
+            }
+        } else if (entry.priority > best->priority
+                   || (entry.priority == best->priority && entry.dueNs < best->dueNs)) {
+            best = &entry;
+        }
+    }
+
+    if (!best) {
+        if (nextDueNs) {
+            *nextDueNs = earliest;
+        }
+        return false;
+    }
+
+    // 周期项的截止时间按周期推进（不随发出时刻漂移）；已落后超过一个周期时跳到当前时刻之后
+    const bool periodic = best->periodNs > 0 && !m_backToBack;
+    const qint64 deadlineNs = periodic ? best->dueNs : -1;
+    if (periodic) {
+        m_maxLatenessNs = qMax(m_maxLatenessNs, nowNs - best->dueNs);
+        best->dueNs += best->periodNs;
+        if (best->dueNs <= nowNs) {
+            const qint64 behind = (nowNs - best->dueNs) / best->periodNs + 1;
+            m_missed += quint64(behind);
+            best->dueNs += behind * best->periodNs;
+        }
+    } else {
+        // 不按周期的项排到同一时刻到期的其他项之后，保证轮流读取；连续模式下dueNs即上次发出的时刻
+        best->dueNs = qMax(nowNs, best->dueNs + 1);
+    }
+    best->inFlight = true;
+    ++m_issued;
+    *request = best->request;
+    request->deadlineNs = deadlineNs;
+    return true;
+}
+
+void ModbusPollScheduler::complete(int entry)
+{
+    if (entry >= 0 && entry < int(m_entries.size())) {
+        m_entries[size_t(entry)].inFlight = false;
+    }
+}
+
+void ModbusPollScheduler::resetStatistics()
+{
+    m_issued = 0;
+    m_missed = 0;
+    m_maxLatenessNs = 0;
+}
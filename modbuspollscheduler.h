@@ -0,0 +1,104 @@
+#ifndef MODBUSPOLLSCHEDULER_H
+#define MODBUSPOLLSCHEDULER_H
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <vector>
+
+// Modbus轮询表的一项：按固定周期读取一个从站的一段连续地址
+struct ModbusPollBlock {
+    int device = 0;             // 链路：0为串口RTU总线，n>=1为第n个Modbus TCP设备
+    int slave = 1;
+    int functionCode = 3;       // 1读线圈 2读离散输入 3读保持寄存器 4读输入寄存器
+    int start = 0;
+    int count = 1;
+    double periodMs = 100.0;    // 轮询周期，<= 0 表示总线空闲时立即再次读取
+    int priority = 0;           // 数值越大越优先
+
+    bool operator==(const ModbusPollBlock &other) const
+    {
+        return device == other.device && slave == other.slave && functionCode == other.functionCode && start == other.start
+               && count == other.count && periodMs == other.periodMs && priority == other.priority;
+    }
+    bool operator!=(const ModbusPollBlock &other) const { return !(*this == other); }
+};
+
+// Modbus轮询调度器
+//
+// 轮询表在设置时展开为请求项：超过单个读请求上限（寄存器125个、线圈/离散输入2000个）的块拆分为多个请求，
+// 长的慢速块不会长时间占用总线，快速块可以插在它的分段之间。各块的结果按表中顺序拼接为一个通道向量，
+// 块i的第一个通道位于之前各块数量之和处。
+// 每个请求项有自己的截止时间；总线空闲时选择已到期项中优先级最高的，同优先级取截止时间最早的，
+// 没有到期项时等待最早的截止时间。落后超过一个周期的项不补发，跳过的周期计入missedCycles()。
+// 连续模式（setBackToBack）下忽略周期，所有项总是到期，按上次发出的先后轮流读取，上次发出时刻相同的项
+// 优先级高的在前；各项读取的次数相同，不会因优先级低而读不到。
+// 单线程使用（Modbus线程）。
+class ModbusPollScheduler
+{
+public:
+    // 一次读请求
+    struct Request {
+        int entry = -1;          // 请求项序号，完成时传给complete()
+        int slave = 1;
+        int functionCode = 3;
+        int start = 0;
+        int count = 0;
+        int channelOffset = 0;   // 结果在通道向量中的起始位置
+        qint64 deadlineNs = -1;  // 本次请求对应的截止时间（PipelineClock纳秒）；不按周期读取时为-1
+    };
+
+    // 功能码对应的单个读请求数量上限；不支持的功能码返回0
+    static int maxCountPerRequest(int functionCode);
+    // 块是否有效：链路>=0、功能码支持、数量>0、地址不越界、从站地址0~247
+    static bool isValidBlock(const ModbusPollBlock &block);
+
+    // 设置轮询表；无效的项（功能码不支持、数量<=0、地址越界）被忽略，error非空时给出说明
+    void setTable(const QVector<ModbusPollBlock> &blocks, QString *error = nullptr);
+    const QVector<ModbusPollBlock> &table() const { return m_table; }
+    int channelCount() const { return m_channelCount; }
+    int entryCount() const { return int(m_entries.size()); }
+    bool isEmpty() const { return m_entries.empty(); }
+
+    // 所有请求项在nowNs到期，清除进行中标记
+    void reset(qint64 nowNs);
+    // 连续模式：上一个请求完成后立即发出下一个，不按周期等待
+    void setBackToBack(bool enabled) { m_backToBack = enabled; }
+    bool isBackToBack() const { return m_backToBack; }
+    // 截止时间在nowNs之后toleranceNs以内的项也视为到期，弥补定时器的唤醒粒度
+    void setEarlyTolerance(qint64 toleranceNs) { m_toleranceNs = qMax<qint64>(0, toleranceNs); }
+    // 取下一个要发出的请求并标记该项为进行中。没有到期项时返回false，
+    // *nextDueNs为未在进行中的项的最早截止时间（全部进行中时为-1）
+    bool next(qint64 nowNs, Request *request, qint64 *nextDueNs);
+    // 请求完成（应答、出错或发送失败）
+    void complete(int entry);
+
+    // ---- 统计 ----
+    quint64 issuedRequests() const { return m_issued; }
+    quint64 missedCycles() const { return m_missed; }
+    // 请求发出时刻相对截止时间的最大延迟（纳秒），自上次resetStatistics()或resetMaxLateness()以来；
+    // 周期<=0的项和连续模式下不统计
+    qint64 maxLatenessNs() const { return m_maxLatenessNs; }
+    void resetMaxLateness() { m_maxLatenessNs = 0; }
+    void resetStatistics();
+
+private:
+    struct Entry {
+        Request request;
+        qint64 periodNs = 0;
+        int priority = 0;
+        qint64 dueNs = 0;
+        bool inFlight = false;
+    };
+
+    QVector<ModbusPollBlock> m_table;
+    std::vector<Entry> m_entries;
+    int m_channelCount = 0;
+    bool m_backToBack = false;
+    qint64 m_toleranceNs = 0;
+    quint64 m_issued = 0;
+    quint64 m_missed = 0;
+    qint64 m_maxLatenessNs = 0;
+};
+
+#endif // MODBUSPOLLSCHEDULER_H
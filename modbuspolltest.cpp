@@ -0,0 +1,124 @@
+// Modbus轮询调度器测试
+//
+// 模拟一条链路按调度器发出请求、每个请求固定耗时后完成，检查各请求项的发出次数：
+// 连续模式下不同优先级的块都要被读取且次数相同；按周期模式下各块按各自的周期读取。
+// 失败时返回1，由ctest运行。
+#include "modbuspollscheduler.h"
+
+#include <QDebug>
+#include <QMap>
+#include <QtGlobal>
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const QString &message)
+{
+    if (!condition) {
+        ++failures;
+        qCritical().noquote() << "失败：" << message;
+    }
+}
+
+// 从startNs开始模拟durationNs，同时进行的请求不超过maxInFlight，每个请求耗时requestNs；返回各请求项的发出次数
+QMap<int, int> simulate(ModbusPollScheduler &scheduler, int maxInFlight, qint64 requestNs, qint64 durationNs)
+{
+    QMap<int, int> issued;
+    QVector<QPair<qint64, int>> inFlight;   // (完成时刻, 请求项)
+    qint64 nowNs = 0;
+    scheduler.reset(nowNs);
+    while (nowNs < durationNs) {
+        while (inFlight.size() < maxInFlight) {
+            ModbusPollScheduler::Request request;
+            qint64 nextDueNs = -1;
+            if (!scheduler.next(nowNs, &request, &nextDueNs)) {
+                break;
+            }
+            ++issued[request.entry];
+            inFlight.append(qMakePair(nowNs + requestNs, request.entry));
+        }
+        // 前进到最早完成的请求；没有进行中的请求时前进到下一个截止时间
+        if (!inFlight.isEmpty()) {
+            int first = 0;
+            for (int i = 1; i < inFlight.size(); ++i) {
+                if (inFlight[i].first < inFlight[first].first) {
+                    first = i;
+                }
+            }
+            nowNs = inFlight[first].first;
+            scheduler.complete(inFlight[first].second);
+            inFlight.remove(first);
+        } else {
+            ModbusPollScheduler::Request request;
+            qint64 nextDueNs = -1;
+            scheduler.next(nowNs, &request, &nextDueNs);
+            if (nextDueNs < 0) {
+                break;
+            }
+            nowNs = nextDueNs;
+        }
+    }
+    return issued;
+}
+
+ModbusPollBlock block(int start, double periodMs, int priority)
+{
+    ModbusPollBlock b;
+    b.start = start;
+    b.count = 10;
+    b.periodMs = periodMs;
+    b.priority = priority;
+    return b;
+}
+
+// 连续模式、一次一个请求（RTU总线）：高优先级块不能独占总线
+void testBackToBackPriorities()
+{
+    ModbusPollScheduler scheduler;
+    scheduler.setTable({block(0, 100.0, 5), block(100, 100.0, 0)});
+    scheduler.setBackToBack(true);
+    const QMap<int, int> issued = simulate(scheduler, 1, 1000000, 100000000);
+    const int high = issued.value(0);
+    const int low = issued.value(1);
+    check(high > 0 && low > 0, QString("连续模式下两个优先级的块都应被读取（高 %1 次，低 %2 次）").arg(high).arg(low));
+    check(qAbs(high - low) <= 1, QString("连续模式下各块应轮流读取（高 %1 次，低 %2 次）").arg(high).arg(low));
+}
+
+// 连续模式、同一连接上多个请求同时进行（TCP）：每个块都被读取
+void testBackToBackInFlight()
+{
+    ModbusPollScheduler scheduler;
+    scheduler.setTable({block(0, 100.0, 2), block(100, 100.0, 1), block(200, 100.0, 0)});
+    scheduler.setBackToBack(true);
+    const QMap<int, int> issued = simulate(scheduler, 2, 1000000, 100000000);
+    for (int entry = 0; entry < 3; ++entry) {
+        check(issued.value(entry) > 0, QString("连续模式下请求项%1应被读取").arg(entry));
+    }
+}
+
+// 按周期模式：各块按各自的周期读取，总线足够时不跳过周期
+void testPeriodic()
+{
+    ModbusPollScheduler scheduler;
+    scheduler.setTable({block(0, 10.0, 1), block(100, 50.0, 0)});
+    const QMap<int, int> issued = simulate(scheduler, 1, 1000000, 1000000000);
+    check(qAbs(issued.value(0) - 100) <= 1, QString("10ms周期的块1秒内应读取约100次，实际 %1 次").arg(issued.value(0)));
+    check(qAbs(issued.value(1) - 20) <= 1, QString("50ms周期的块1秒内应读取约20次，实际 %1 次").arg(issued.value(1)));
+    check(scheduler.missedCycles() == 0, QString("总线空闲时不应跳过周期，实际跳过 %1 个").arg(scheduler.missedCycles()));
+}
+
+} // namespace
+
+int main()
+{
+    testBackToBackPriorities();
+    testBackToBackInFlight();
+    testPeriodic();
+    if (failures > 0) {
+        qCritical().noquote() << QString("%1 项检查失败").arg(failures);
+        return 1;
+    }
+    qInfo().noquote() << "全部通过";
+    return 0;
+}
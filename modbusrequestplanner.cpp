@@ -0,0 +1,222 @@
+#include "modbusrequestplanner.h"
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <tuple>
+#include <vector>
+
+ModbusLinkCost ModbusLinkCost::fromSerial(int baudRate, int bitsPerChar, double overheadMs)
+{
+    ModbusLinkCost cost;
+    if (baudRate > 0 && bitsPerChar > 0) {
+        cost.byteNs = double(bitsPerChar) / double(baudRate) * 1e9;
+    }
+    cost.overheadNs = qMax(0.0, overheadMs) * 1e6;
+    return cost;
+}
+
+ModbusLinkCost ModbusLinkCost::forTcp(double roundTripMs)
+{
+    ModbusLinkCost cost;
+    // 按100 Mbit/s以太网计，每字节约0.1 us，再计入MBAP头与帧间静默在帧字符数中的差异，取1 us
+    cost.byteNs = 1000.0;
+    cost.overheadNs = qMax(0.0, roundTripMs) * 1e6;
+    return cost;
+}
+
+int ModbusLinkCost::frameBytes(int functionCode, int count)
+{
+    const int dataBytes = (functionCode == 1 || functionCode == 2) ? (count + 7) / 8 : count * 2;
+    // 请求：从站、功能码、起始地址2、数量2、CRC2；应答：从站、功能码、字节数、数据、CRC2；两帧间各3.5字符静默
+    return 8 + 5 + dataBytes + 7;
+}
+
+void ModbusLinkEstimator::addSample(int frameBytes, qint64 durationNs)
+{
+    if (durationNs <= 0) {
+        return;
+    }
+    // 指数衰减：有效样本数约为1/(1-Decay)
+    constexpr double Decay = 0.995;
+    const double x = frameBytes;
+    const double y = double(durationNs);
+    m_n = m_n * Decay + 1.0;
+    m_sumX = m_sumX * Decay + x;
+    m_sumY = m_sumY * Decay + y;
+    m_sumXX = m_sumXX * Decay + x * x;
+    m_sumXY = m_sumXY * Decay + x * y;
+}
+
+bool ModbusLinkEstimator::estimate(const ModbusLinkCost &nominal, ModbusLinkCost *result) const
+{
+    constexpr double MinSamples = 8.0;
+    if (m_n < MinSamples) {
+        return false;
+    }
+    const double meanX = m_sumX / m_n;
+    const double meanY = m_sumY / m_n;
+    const double varX = m_sumXX / m_n - meanX * meanX;
+
+    ModbusLinkCost cost = nominal;
+    // 帧长的标准差至少4个字符才拟合斜率，且斜率需在名义值的一半到四倍之间（排除抖动造成的异常拟合）
+    if (varX >= 16.0) {
+        const double slope = (m_sumXY / m_n - meanX * meanY) / varX;
+        if (slope >= nominal.byteNs * 0.5 && slope <= nominal.byteNs * 4.0) {
+            cost.byteNs = slope;
+        }
+    }
+    cost.overheadNs = qMax(0.0, meanY - cost.byteNs * meanX);
+    *result = cost;
+    return true;
+}
+
+void ModbusLinkEstimator::reset()
+{
+    m_n = m_sumX = m_sumY = m_sumXX = m_sumXY = 0.0;
+}
+
+namespace {
+
+const ModbusLinkCost &costForDevice(const QVector<ModbusLinkCost> &costs, int device)
+{
+    static const ModbusLinkCost defaultCost;
+    if (device >= 0 && device < costs.size()) {
+        return costs[device];
+    }
+    return costs.isEmpty() ? defaultCost : costs[0];
+}
+
+} // namespace
+
+ModbusRequestPlan ModbusRequestPlan::compile(const QVector<ModbusChannelSpec> &channels,
+                                             const QVector<ModbusLinkCost> &costs, QString *error)
+{
+    ModbusRequestPlan plan;
+    plan.m_offsets.fill(-1, channels.size());
+
+    // 分组键：(链路, 从站, 功能码, 周期, 优先级)；周期不同的通道不合并，否则慢通道会被按快周期读取
+    using GroupKey = std::tuple<int, int, int, double, int>;
+    std::map<GroupKey, std::vector<int>> groups;
+    QStringList problems;
+    for (int c = 0; c < channels.size(); ++c) {
+        const ModbusChannelSpec &ch = channels[c];
+        const int maxCount = ModbusPollScheduler::maxCountPerRequest(ch.functionCode);
+        const int count = ch.format.registerCount();
+        if (maxCount == 0 || count > maxCount || ch.address < 0 || ch.address + count > 65536
+            || ch.slave < 0 || ch.slave > 247 || ch.device < 0) {
+            problems.append(QString("通道%1（链路%2，从站%3，功能码%4，地址%5，数量%6）无效")
+                                .arg(c).arg(ch.device).arg(ch.slave).arg(ch.functionCode).arg(ch.address).arg(count));
+            continue;
+        }
+        groups[GroupKey(ch.device, ch.slave, ch.functionCode, ch.periodMs, ch.priority)].push_back(c);
+    }
+
+    for (auto &group : groups) {
+        const int device = std::get<0>(group.first);
+        const int slave = std::get<1>(group.first);
+        const int functionCode = std::get<2>(group.first);
+        const double periodMs = std::get<3>(group.first);
+        const int priority = std::get<4>(group.first);
+        const ModbusLinkCost &cost = costForDevice(costs, device);
+        const int maxCount = ModbusPollScheduler::maxCountPerRequest(functionCode);
+        std::vector<int> &members = group.second;
+        std::sort(members.begin(), members.end(), [&channels](int a, int b) {
+            return channels[a].address < channels[b].address;
+        });
+
+        // 重叠或相邻的地址段先并为连续段[begin, end)，它们总是在同一个请求里读取
+        struct Run { int begin; int end; };
+        std::vector<Run> runs;
+        for (int c : members) {
+            const int begin = channels[c].address;
+            const int end = begin + channels[c].format.registerCount();
+            if (!runs.empty() && begin <= runs.back().end && end - runs.back().begin <= maxCount) {
+                runs.back().end = qMax(runs.back().end, end);
+            } else {
+                runs.push_back({begin, end});
+            }
+        }
+
+        // best[j]：前j个连续段的最小总耗时；请求覆盖第i..j-1段时耗时为requestNs(跨度)，跨度不超过数量上限
+        const int n = int(runs.size());
+        std::vector<double> best(size_t(n + 1), std::numeric_limits<double>::infinity());
+        std::vector<int> from(size_t(n + 1), 0);
+        best[0] = 0.0;
+        for (int j = 1; j <= n; ++j) {
+            for (int i = j - 1; i >= 0; --i) {
+                const int span = runs[size_t(j - 1)].end - runs[size_t(i)].begin;
+                if (span > maxCount) {
+                    break;
+                }
+                const double total = best[size_t(i)] + cost.requestNs(functionCode, span);
+                if (total < best[size_t(j)]) {
+                    best[size_t(j)] = total;
+                    from[size_t(j)] = i;
+                }
+            }
+        }
+
+        std::vector<ModbusPollBlock> groupBlocks;
+        for (int j = n; j > 0; j = from[size_t(j)]) {
+            ModbusPollBlock block;
+            block.device = device;
+            block.slave = slave;
+            block.functionCode = functionCode;
+            block.start = runs[size_t(from[size_t(j)])].begin;
+            block.count = runs[size_t(j - 1)].end - block.start;
+            block.periodMs = periodMs;
+            block.priority = priority;
+            groupBlocks.push_back(block);
+        }
+        std::reverse(groupBlocks.begin(), groupBlocks.end());
+
+        // 按块拼接原始值向量，并为组内每个通道定位到完整包含它的块
+        for (int c : members) {
+            int blockBase = plan.m_rawCount;
+            for (const ModbusPollBlock &block : groupBlocks) {
+                if (channels[c].address >= block.start
+                    && channels[c].address + channels[c].format.registerCount() <= block.start + block.count) {
+                    plan.m_offsets[c] = blockBase + channels[c].address - block.start;
+                    break;
+                }
+                blockBase += block.count;
+            }
+        }
+        for (const ModbusPollBlock &block : groupBlocks) {
+            plan.m_blocks.append(block);
+            plan.m_rawCount += block.count;
+            if (block.periodMs > 0.0) {
+                plan.m_busLoad += cost.requestNs(functionCode, block.count) / (block.periodMs * 1e6);
+            }
+        }
+    }
+
+    if (error) {
+        *error = problems.join("; ");
+    }
+    return plan;
+}
+
+ModbusRequestPlan ModbusRequestPlan::fromBlocks(const QVector<ModbusPollBlock> &blocks,
+                                                const QVector<ModbusLinkCost> &costs)
+{
+    ModbusRequestPlan plan;
+    for (const ModbusPollBlock &block : blocks) {
+        // 与ModbusPollScheduler::setTable一致地跳过无效块，原始值向量的布局与调度器相同
+        if (!ModbusPollScheduler::isValidBlock(block)) {
+            continue;
+        }
+        plan.m_blocks.append(block);
+        for (int i = 0; i < block.count; ++i) {
+            plan.m_offsets.append(plan.m_rawCount + i);
+        }
+        plan.m_rawCount += block.count;
+        if (block.periodMs > 0.0) {
+            plan.m_busLoad += costForDevice(costs, block.device).requestNs(block.functionCode, block.count)
+                              / (block.periodMs * 1e6);
+        }
+    }
+    return plan;
+}
@@ -0,0 +1,87 @@
+#ifndef MODBUSREQUESTPLANNER_H
+#define MODBUSREQUESTPLANNER_H
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include "modbuspollscheduler.h"
+#include "modbusdecode.h"
+
+// 一个Modbus通道需要读取的地址段
+struct ModbusChannelSpec {
+    int device = 0;             // 链路：0为串口RTU总线，n>=1为第n个Modbus TCP设备
+    int slave = 1;
+    int functionCode = 3;       // 1读线圈 2读离散输入 3读保持寄存器 4读输入寄存器
+    int address = 0;            // 通道的第一个地址，占用的地址数由format的类型决定
+    double periodMs = 100.0;
+    int priority = 0;
+    ModbusValueFormat format;
+};
+
+// 链路代价模型：一次读请求的耗时 ≈ overheadNs + frameBytes × byteNs
+// overheadNs为从站响应时间（转向时间）、网络往返等与帧长无关的部分，帧间静默按字符数计入frameBytes
+struct ModbusLinkCost {
+    double byteNs = 11.0 / 9600.0 * 1e9;
+    double overheadNs = 5e6;
+
+    // 按串口参数计算名义代价；bitsPerChar含起始位、数据位、校验位和停止位
+    static ModbusLinkCost fromSerial(int baudRate, int bitsPerChar, double overheadMs);
+    // Modbus TCP的名义代价：传输时间可忽略，主要是往返和设备处理时间
+    static ModbusLinkCost forTcp(double roundTripMs);
+    // RTU一次读请求在总线上占用的字符数：请求帧8字节 + 应答帧5字节和数据 + 两帧之间的3.5字符静默
+    static int frameBytes(int functionCode, int count);
+
+    double requestNs(int functionCode, int count) const { return overheadNs + frameBytes(functionCode, count) * byteNs; }
+};
+
+// 根据实际应答耗时估计链路代价
+//
+// 对(帧字符数, 请求到应答的耗时)做最小二乘拟合 t = overhead + bytes × byteNs。请求长度变化不足以确定斜率时
+// 沿用名义的byteNs，只估计overhead。样本按指数衰减，链路条件变化后估计能跟上。
+class ModbusLinkEstimator
+{
+public:
+    void addSample(int frameBytes, qint64 durationNs);
+    // 样本不足时返回false
+    bool estimate(const ModbusLinkCost &nominal, ModbusLinkCost *result) const;
+    int sampleCount() const { return int(m_n); }
+    void reset();
+
+private:
+    double m_n = 0.0;
+    double m_sumX = 0.0;
+    double m_sumY = 0.0;
+    double m_sumXX = 0.0;
+    double m_sumXY = 0.0;
+};
+
+// Modbus请求计划：把各通道需要的地址合并为尽量少的读请求
+//
+// 通道按(链路, 从站, 功能码, 周期, 优先级)分组，组内地址排序后用动态规划选择分段：
+// 把两个相邻地址段合并为一个请求要多读中间的空隙，代价为空隙的传输时间；分开读则多一次请求的固定开销。
+// 每个请求不超过功能码的数量上限。计划给出轮询块和每个通道在原始值向量（各块按顺序拼接）中的位置。
+// costs按链路编号给出各链路的代价，缺少的链路使用costs[0]。
+class ModbusRequestPlan
+{
+public:
+    static ModbusRequestPlan compile(const QVector<ModbusChannelSpec> &channels, const QVector<ModbusLinkCost> &costs,
+                                     QString *error = nullptr);
+    // 直接使用给定的轮询块（不合并），通道与原始值一一对应；costs只用于估计总线占用率
+    static ModbusRequestPlan fromBlocks(const QVector<ModbusPollBlock> &blocks, const QVector<ModbusLinkCost> &costs);
+
+    const QVector<ModbusPollBlock> &blocks() const { return m_blocks; }
+    // 通道i的值在原始值向量中的位置；无效通道为-1
+    const QVector<int> &channelOffsets() const { return m_offsets; }
+    int channelCount() const { return m_offsets.size(); }
+    int rawCount() const { return m_rawCount; }
+    // 按代价模型估计的总线占用率（各请求耗时/周期之和，周期<=0的块不计；多条链路时为各链路之和）
+    double busLoad() const { return m_busLoad; }
+
+private:
+    QVector<ModbusPollBlock> m_blocks;
+    QVector<int> m_offsets;
+    int m_rawCount = 0;
+    double m_busLoad = 0.0;
+};
+
+#endif // MODBUSREQUESTPLANNER_H
@@ -1,4 +1,13 @@
 #include "modbusthread.h"
+#include "pipelinelatency.h"
+#include <algorithm>
+
+namespace {
+
+// 截止时间前这一范围内的请求项视为到期，定时器只需毫秒级唤醒
+constexpr qint64 PollEarlyToleranceNs = 500000;
+
+} // namespace
 
 modbusThread::modbusThread(QObject *parent)
     : QObject{parent}
@@ -24,6 +33,31 @@ void modbusThread::initModbusClient()
             emit modbusConnectionStatus(false, "串口连接状态已变更为未连接");
         }
     });
+
+    // 链路0：串口RTU总线，一次一个请求；串口参数设置后按波特率更新名义代价
+    if (links.empty()) {
+        addLink(modbusClient, 1, ModbusLinkCost());
+    } else {
+        links[0].client = modbusClient;
+    }
+}
+
+int modbusThread::addLink(QModbusClient *client, int maxInFlight, const ModbusLinkCost &nominalCost)
+{
+    const int index = int(links.size());
+    PollLink link;
+    link.client = client;
+    link.maxInFlight = qMax(1, maxInFlight);
+    link.nominalCost = nominalCost;
+    link.planCost = nominalCost;
+    link.timer = new QTimer(this);
+    link.timer->setSingleShot(true);
+    link.timer->setTimerType(Qt::PreciseTimer);
+    link.scheduler.setBackToBack(backToBack);
+    link.scheduler.setEarlyTolerance(PollEarlyToleranceNs);
+    connect(link.timer, &QTimer::timeout, this, [this, index]() { issueNextRequests(index); });
+    links.push_back(link);
+    return index;
 }
 
 // 实现重置计时器的方法
@@ -42,62 +76,474 @@ void modbusThread::resetTimer()
     }
 }
 
-void modbusThread::getModbusResult(int serverAddr, int startRegister, int registerCount)
+// 设置Modbus TCP设备
+void modbusThread::setTcpDevices(const QVector<ModbusTcpDevice> &devices)
 {
-    //qDebug() << "getModbusResult running in thread:" << QThread::currentThread();
-    // 准备存储寄存器值的向量
-    QVector<double> resultdata(registerCount);
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, devices]() { setTcpDevices(devices); }, Qt::QueuedConnection);
+        return;
+    }
+    // 移除原有的TCP链路；其进行中请求的应答随客户端一起删除
+    for (size_t i = 1; i < links.size(); ++i) {
+        links[i].timer->stop();
+        links[i].timer->deleteLater();
+        links[i].client->disconnectDevice();
+        links[i].client->deleteLater();
+    }
+    if (links.empty()) {
+        addLink(modbusClient, 1, ModbusLinkCost());
+    } else if (links.size() > 1) {
+        links.resize(1);
+    }
 
-    // 精密计时器
-    currentTime = realTimer->elapsed();
-    interval = currentTime - lastTime;
+    for (const ModbusTcpDevice &device : devices) {
+        QModbusTcpClient *client = new QModbusTcpClient(this);
+        client->setConnectionParameter(QModbusDevice::NetworkAddressParameter, device.host);
+        client->setConnectionParameter(QModbusDevice::NetworkPortParameter, device.port);
+        client->setTimeout(qMax(10, device.timeoutMs));
+        // 超时的请求不重发，下一个周期会再次读取
+        client->setNumberOfRetries(0);
+        const int index = addLink(client, qBound(1, device.maxInFlight, 64), ModbusLinkCost::forTcp(1.0));
+        const QString name = QString("%1:%2").arg(device.host).arg(device.port);
+        connect(client, &QModbusDevice::stateChanged, this, [this, index, name](QModbusDevice::State state) {
+            if (state == QModbusDevice::ConnectedState) {
+                emit tcpDeviceStatus(index, true, QString("Modbus TCP设备%1（%2）已连接").arg(index).arg(name));
+                issueNextRequests(index);
+            } else if (state == QModbusDevice::UnconnectedState) {
+                emit tcpDeviceStatus(index, false, QString("Modbus TCP设备%1（%2）未连接").arg(index).arg(name));
+            }
+        });
+        connect(client, &QModbusDevice::errorOccurred, this, [client, name](QModbusDevice::Error error) {
+            if (error == QModbusDevice::ConnectionError) {
+                qDebug() << "[modbusThread] Modbus TCP设备" << name << "连接错误:" << client->errorString();
+            }
+        });
+        client->connectDevice();
+    }
+    qDebug() << "[modbusThread] Modbus TCP设备:" << devices.size();
 
-    // 创建读取请求，读取多个寄存器
-    QModbusDataUnit readUnit(QModbusDataUnit::HoldingRegisters, startRegister, registerCount);
+    // 按新的链路重新分配当前计划
+    if (!pollChannels.isEmpty()) {
+        setPollChannels(pollChannels);
+    } else {
+        applyPlan(requestPlan);
+    }
+}
 
-    if (auto *reply = modbusClient->sendReadRequest(readUnit, serverAddr))
-    {
-        // 使用信号槽方式处理完成信号
-        connect(reply, &QModbusReply::finished, this, [this, reply, registerCount, resultdata = std::move(resultdata)]() mutable {
-            if (reply->error() == QModbusDevice::NoError)
-            {
-                const QModbusDataUnit resultUnit = reply->result();
-                
-                // 直接将每个寄存器的值存入结果向量
-                for (int i = 0; i < resultUnit.valueCount(); i++)
-                {
-                    // 转换为实际值 (乘以0.01)
-                    resultdata[i] = resultUnit.value(i) * 0.01;
-                }
+// 设置轮询表
+void modbusThread::setPollTable(const QVector<ModbusPollBlock> &blocks)
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, blocks]() { setPollTable(blocks); }, Qt::QueuedConnection);
+        return;
+    }
+    pollChannels.clear();
+    applyPlan(ModbusRequestPlan::fromBlocks(blocks, linkCosts(false)));
+}
+
+// 设置通道表并合并请求
+void modbusThread::setPollChannels(const QVector<ModbusChannelSpec> &channels)
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, channels]() { setPollChannels(channels); }, Qt::QueuedConnection);
+        return;
+    }
+    pollChannels = channels;
+    QString error;
+    const ModbusRequestPlan plan = ModbusRequestPlan::compile(pollChannels, linkCosts(true), &error);
+    if (!error.isEmpty()) {
+        qDebug() << "[modbusThread] 通道表中的无效项已忽略:" << error;
+    }
+    applyPlan(plan);
+}
+
+// 各链路的代价：estimated为true时优先使用应答耗时的估计值
+QVector<ModbusLinkCost> modbusThread::linkCosts(bool estimated) const
+{
+    QVector<ModbusLinkCost> costs;
+    for (const PollLink &link : links) {
+        ModbusLinkCost cost = link.nominalCost;
+        if (estimated) {
+            link.estimator.estimate(link.nominalCost, &cost);
+        }
+        costs.append(cost);
+    }
+    return costs;
+}
+
+// 启用新的请求计划：各块按链路分给对应的调度器；进行中的请求的应答按旧计划丢弃
+void modbusThread::applyPlan(const ModbusRequestPlan &plan)
+{
+    requestPlan = plan;
+    ++planGeneration;
+    rawRegisters.fill(0, requestPlan.rawCount());
+    rawValid.fill(1, requestPlan.rawCount());
+    invalidRegisters = 0;
+    pollValues.fill(0.0, requestPlan.channelCount());
+
+    // 解码格式：通道表中的格式；直接使用轮询表时寄存器按0.01换算，线圈/离散输入为0或1
+    QVector<ModbusValueFormat> formats;
+    if (!pollChannels.isEmpty()) {
+        for (const ModbusChannelSpec &channel : pollChannels) {
+            formats.append(channel.format);
+        }
+    } else {
+        for (const ModbusPollBlock &block : requestPlan.blocks()) {
+            ModbusValueFormat format;
+            format.scale = (block.functionCode == 1 || block.functionCode == 2) ? 1.0 : 0.01;
+            for (int i = 0; i < block.count; ++i) {
+                formats.append(format);
+            }
+        }
+    }
+    decodePlan = ModbusDecodePlan::compile(requestPlan.channelOffsets(), formats);
+
+    const int linkCount = int(links.size());
+    QVector<QVector<ModbusPollBlock>> linkBlocks(linkCount);
+    QVector<QVector<int>> linkOffsets(linkCount);
+    int rawBase = 0;
+    int unassigned = 0;
+    for (const ModbusPollBlock &block : requestPlan.blocks()) {
+        if (block.device < linkCount) {
+            linkBlocks[block.device].append(block);
+            for (int i = 0; i < block.count; ++i) {
+                linkOffsets[block.device].append(rawBase + i);
+            }
+        } else {
+            // 链路未配置：这些通道保持错误值
+            ++unassigned;
+            for (int i = 0; i < block.count; ++i) {
+                rawValid[rawBase + i] = 0;
+            }
+            invalidRegisters += block.count;
+        }
+        rawBase += block.count;
+    }
+    if (unassigned > 0) {
+        qDebug() << "[modbusThread]" << unassigned << "个轮询块所在的链路未配置，已忽略";
+    }
+
+    const QVector<ModbusLinkCost> costs = linkCosts(true);
+    const qint64 nowNs = PipelineClock::nowNs();
+    int entries = 0;
+    for (int l = 0; l < linkCount; ++l) {
+        PollLink &link = links[size_t(l)];
+        QString error;
+        link.scheduler.setTable(linkBlocks[l], &error);
+        if (!error.isEmpty()) {
+            qDebug() << "[modbusThread] 轮询表中的无效项已忽略:" << error;
+        }
+        link.rawOffset = linkOffsets[l];
+        link.planCost = costs[l];
+        link.scheduler.reset(nowNs);
+        entries += link.scheduler.entryCount();
+    }
+    resetPollCycle();
+    qDebug() << "[modbusThread] 请求计划:" << requestPlan.blocks().size() << "块," << entries << "个请求,"
+             << requestPlan.channelCount() << "个通道，估计总线占用"
+             << QString::number(requestPlan.busLoad() * 100.0, 'f', 1) << "%";
+    emit pollPlanChanged(entries, requestPlan.channelCount(), requestPlan.busLoad());
+
+    if (polling) {
+        for (int l = 0; l < linkCount; ++l) {
+            issueNextRequests(l);
+        }
+    }
+}
+
+// 某条链路的代价估计值与当前计划所用的代价相差超过20%时重新合并；合并结果不变时只更新代价，不打断轮询
+void modbusThread::replanIfLinkChanged()
+{
+    if (pollChannels.isEmpty()) {
+        return;
+    }
+    bool changed = false;
+    for (const PollLink &link : links) {
+        ModbusLinkCost estimated;
+        if (!link.estimator.estimate(link.nominalCost, &estimated)) {
+            continue;
+        }
+        if (qAbs(estimated.byteNs - link.planCost.byteNs) > link.planCost.byteNs * 0.2
+            || qAbs(estimated.overheadNs - link.planCost.overheadNs) > link.planCost.overheadNs * 0.2 + 500000.0) {
+            changed = true;
+        }
+    }
+    if (!changed) {
+        return;
+    }
+    const QVector<ModbusLinkCost> costs = linkCosts(true);
+    const ModbusRequestPlan plan = ModbusRequestPlan::compile(pollChannels, costs);
+    if (plan.blocks() == requestPlan.blocks()) {
+        for (size_t l = 0; l < links.size(); ++l) {
+            links[l].planCost = costs[int(l)];
+        }
+        return;
+    }
+    qDebug() << "[modbusThread] 链路代价变化，重新合并请求";
+    applyPlan(plan);
+}
+
+// 设置轮询方式
+void modbusThread::setPollMode(bool enabled)
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, enabled]() { setPollMode(enabled); }, Qt::QueuedConnection);
+        return;
+    }
+    backToBack = enabled;
+    const qint64 nowNs = PipelineClock::nowNs();
+    for (PollLink &link : links) {
+        link.scheduler.setBackToBack(backToBack);
+        link.scheduler.reset(nowNs);
+    }
+    qDebug() << "[modbusThread] 轮询方式:" << (backToBack ? "连续" : "按周期");
+    if (polling) {
+        for (int l = 0; l < int(links.size()); ++l) {
+            issueNextRequests(l);
+        }
+    }
+}
+
+void modbusThread::startPolling()
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, &modbusThread::startPolling, Qt::QueuedConnection);
+        return;
+    }
+    bool empty = true;
+    for (const PollLink &link : links) {
+        empty = empty && link.scheduler.isEmpty();
+    }
+    if (empty) {
+        qDebug() << "[modbusThread] 轮询表为空，无法开始轮询";
+        return;
+    }
+    polling = true;
+    failedRequests = 0;
+    const qint64 nowNs = PipelineClock::nowNs();
+    lastStatisticsNs = nowNs;
+    for (PollLink &link : links) {
+        link.scheduler.resetStatistics();
+        link.scheduler.reset(nowNs);
+    }
+    resetPollCycle();
+    for (int l = 0; l < int(links.size()); ++l) {
+        issueNextRequests(l);
+    }
+}
+
+void modbusThread::stopPolling()
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, &modbusThread::stopPolling, Qt::QueuedConnection);
+        return;
+    }
+    polling = false;
+    for (PollLink &link : links) {
+        link.timer->stop();
+    }
+}
+
+// 约每秒一次汇总各链路的轮询统计
+void modbusThread::emitPollStatistics()
+{
+    const qint64 nowNs = PipelineClock::nowNs();
+    if (nowNs - lastStatisticsNs < 1000000000LL) {
+        return;
+    }
+    lastStatisticsNs = nowNs;
+    quint64 issued = 0;
+    quint64 missed = 0;
+    qint64 maxLateness = 0;
+    for (PollLink &link : links) {
+        issued += link.scheduler.issuedRequests();
+        missed += link.scheduler.missedCycles();
+        maxLateness = qMax(maxLateness, link.scheduler.maxLatenessNs());
+        link.scheduler.resetMaxLateness();
+    }
+    emit pollStatistics(issued, missed, failedRequests, maxLateness);
+}
+
+// 开始新的轮询周期：各链路的请求项都标记为本轮尚未完成
+void modbusThread::resetPollCycle()
+{
+    for (PollLink &link : links) {
+        link.cycleAcquiredNs.assign(size_t(link.scheduler.entryCount()), -1);
+        link.cyclePending = link.scheduler.entryCount();
+    }
+}
+
+// 已连接的链路上的请求项都已完成时结束本轮，acquiredNs为其中最早的采集时刻（快照给出的时效不会偏小），
+// 然后开始新的一轮。未连接的链路不参与，以免一台设备断开使其他设备的数据不再发送
+bool modbusThread::takePollCycle(qint64 *acquiredNs)
+{
+    qint64 earliest = -1;
+    for (const PollLink &link : links) {
+        if (!link.client || link.scheduler.isEmpty() || link.client->state() != QModbusDevice::ConnectedState) {
+            continue;
+        }
+        if (link.cyclePending > 0) {
+            return false;
+        }
+        for (qint64 entryNs : link.cycleAcquiredNs) {
+            if (earliest < 0 || entryNs < earliest) {
+                earliest = entryNs;
             }
-            else
-            {
-                qDebug() << "Modbus读取错误: " << reply->errorString();
-                // 错误情况下填充无效数据
-                for (int i = 0; i < registerCount; i++) {
-                    resultdata[i] = -9999; // 使用一个特殊值表示错误
-                }
+        }
+    }
+    if (earliest < 0) {
+        return false;
+    }
+    *acquiredNs = earliest;
+    resetPollCycle();
+    return true;
+}
+
+// 在链路有空位时发出到期的请求，直到达到同时进行的上限；没有到期项时定时到最早的截止时间
+void modbusThread::issueNextRequests(int index)
+{
+    if (!polling || index < 0 || index >= int(links.size())) {
+        return;
+    }
+    PollLink &link = links[size_t(index)];
+    if (!link.client || link.scheduler.isEmpty()) {
+        return;
+    }
+    if (link.client->state() != QModbusDevice::ConnectedState) {
+        // 未连接时按较长间隔重试，不占用CPU；TCP设备断开后自动重连
+        if (index > 0 && link.client->state() == QModbusDevice::UnconnectedState) {
+            link.client->connectDevice();
+        }
+        link.timer->start(index > 0 ? 1000 : 100);
+        return;
+    }
+    emitPollStatistics();
+
+    while (link.inFlight < link.maxInFlight) {
+        const qint64 nowNs = PipelineClock::nowNs();
+        ModbusPollScheduler::Request request;
+        qint64 nextDueNs = -1;
+        if (!link.scheduler.next(nowNs, &request, &nextDueNs)) {
+            if (nextDueNs >= 0) {
+                // 等待时间向上取整到毫秒：唤醒时最早的项已在容差范围内，不会因截断为0毫秒而反复唤醒空转；
+                // 取整最多使请求比截止时间晚0.5毫秒
+                const qint64 waitNs = nextDueNs - nowNs - PollEarlyToleranceNs;
+                link.timer->start(int(qMax<qint64>(0, (waitNs + 999999) / 1000000)));
             }
-            
-            // 更新时间并发送结果
-            lastTime = currentTime;
-            emit sendModbusResult(resultdata, interval);
-            
-            reply->deleteLater();
+            return;
+        }
+
+        QModbusDataUnit::RegisterType type = QModbusDataUnit::HoldingRegisters;
+        switch (request.functionCode) {
+        case 1: type = QModbusDataUnit::Coils; break;
+        case 2: type = QModbusDataUnit::DiscreteInputs; break;
+        case 4: type = QModbusDataUnit::InputRegisters; break;
+        default: type = QModbusDataUnit::HoldingRegisters; break;
+        }
+
+        const qint64 requestNs = PipelineClock::nowNs();
+        if (request.deadlineNs >= 0) {
+            PipelineLatency::record(PipelineLatency::ModbusPollLateness, requestNs - request.deadlineNs);
+        }
+        QModbusReply *reply = link.client->sendReadRequest(QModbusDataUnit(type, request.start, quint16(request.count)),
+                                                           request.slave);
+        if (!reply) {
+            qDebug() << "[modbusThread] 链路" << index << "无法发送Modbus请求:" << link.client->errorString();
+            ++failedRequests;
+            link.scheduler.complete(request.entry);
+            link.timer->start(10);
+            return;
+        }
+        ++link.inFlight;
+        QModbusClient *client = link.client;
+        const quint32 generation = planGeneration;
+        if (reply->isFinished()) {
+            // 广播请求等立即完成的应答，留到事件循环中处理，避免在发送循环中递归
+            QMetaObject::invokeMethod(this, [this, index, client, reply, request, requestNs, generation]() {
+                handlePollReply(index, client, reply, request, requestNs, generation);
+            }, Qt::QueuedConnection);
+            continue;
+        }
+        connect(reply, &QModbusReply::finished, this, [this, index, client, reply, request, requestNs, generation]() {
+            handlePollReply(index, client, reply, request, requestNs, generation);
         });
     }
-    else
-    {
-        qDebug() << "无法发送Modbus请求: " << modbusClient->errorString();
-        // 请求失败情况下填充无效数据
-        for (int i = 0; i < registerCount; i++) {
-            resultdata[i] = -9999; // 使用一个特殊值表示错误
+}
+
+// 把一个请求的应答写入原始值向量，一轮完成时按计划取出通道向量发给SnapshotThread，然后补发该链路上到期的请求
+void modbusThread::handlePollReply(int index, QModbusClient *client, QModbusReply *reply,
+                                   const ModbusPollScheduler::Request &request, qint64 requestNs, quint32 generation)
+{
+    const qint64 replyNs = PipelineClock::nowNs();
+    const qint64 acquiredNs = requestNs + (replyNs - requestNs) / 2;
+    PipelineLatency::record(PipelineLatency::ModbusAcquire, replyNs - requestNs);
+    reply->deleteLater();
+
+    if (index >= int(links.size()) || links[size_t(index)].client != client) {
+        // 链路已被替换
+        return;
+    }
+    PollLink &link = links[size_t(index)];
+    link.inFlight = qMax(0, link.inFlight - 1);
+    if (generation != planGeneration) {
+        // 请求发出后计划已更新，应答的位置不再有效
+        issueNextRequests(index);
+        return;
+    }
+
+    // 只保存原始寄存器（线圈/离散输入为0或1），换算由解码计划完成
+    const int rawBase = link.rawOffset[request.channelOffset];
+    quint16 *registers = rawRegisters.data() + rawBase;
+    quint8 *valid = rawValid.data() + rawBase;
+    int validBefore = 0;
+    for (int i = 0; i < request.count; ++i) {
+        validBefore += valid[i];
+    }
+    if (reply->error() == QModbusDevice::NoError) {
+        const QModbusDataUnit unit = reply->result();
+        const int count = qMin(request.count, int(unit.valueCount()));
+        for (int i = 0; i < count; ++i) {
+            registers[i] = unit.value(i);
         }
-        
-        // 更新时间并发送结果
+        std::fill(valid, valid + request.count, quint8(1));
+        invalidRegisters -= request.count - validBefore;
+        link.estimator.addSample(ModbusLinkCost::frameBytes(request.functionCode, request.count), replyNs - requestNs);
+    } else {
+        qDebug() << "[modbusThread] 链路" << index << "从站" << request.slave << "读取错误:" << reply->errorString();
+        ++failedRequests;
+        // 读取失败的寄存器所在的通道输出-9999
+        std::fill(valid, valid + request.count, quint8(0));
+        invalidRegisters += validBefore;
+    }
+    link.scheduler.complete(request.entry);
+    if (request.entry >= 0 && request.entry < int(link.cycleAcquiredNs.size())) {
+        qint64 &entryNs = link.cycleAcquiredNs[size_t(request.entry)];
+        if (entryNs < 0) {
+            --link.cyclePending;
+        }
+        entryNs = acquiredNs;
+    }
+
+    // 每个轮询周期只解码和发送一次：逐个应答发送会把其他块未更新的通道当作新数据重新标记时间，
+    // 并且在多个请求同时进行时使快照线程的处理次数成倍增加
+    qint64 cycleAcquiredNs = 0;
+    if (takePollCycle(&cycleAcquiredNs)) {
+        // 有读取失败的寄存器时才逐通道检查有效标记
+        decodePlan.decode(rawRegisters.constData(), invalidRegisters > 0 ? rawValid.constData() : nullptr,
+                          pollValues.data());
+
+        currentTime = realTimer->isValid() ? realTimer->elapsed() : 0;
+        interval = currentTime - lastTime;
         lastTime = currentTime;
-        emit sendModbusResult(resultdata, interval);
+        emit sendModbusResult(pollValues, interval, cycleAcquiredNs);
+    }
+
+    // 每条链路每32个请求检查一次链路代价
+    if (link.scheduler.issuedRequests() % 32 == 0) {
+        replanIfLinkChanged();
     }
+
+    issueNextRequests(index);
 }
 
 // 设置串口参数的函数实现
@@ -144,6 +590,20 @@ void modbusThread::setModbusPortInfo(QString portName, int baudRateIndex, int st
     default: modbusClient->setConnectionParameter(QModbusDevice::SerialParityParameter, QSerialPort::NoParity); break;
     }
     
+    // 名义链路代价：每字符位数 = 起始位 + 数据位 + 校验位 + 停止位（1.5位按2位计）；从站响应时间先按5 ms估计，
+    // 运行中由应答耗时修正
+    const int baudRates[] = {9600, 19200, 38400, 57600};
+    const int dataBits[] = {8, 7, 6, 5};
+    const int bitsPerChar = 1 + dataBits[(dataBitsIndex >= 0 && dataBitsIndex <= 3) ? dataBitsIndex : 0]
+                            + ((parityIndex == 1 || parityIndex == 2) ? 1 : 0) + (stopBitsIndex == 0 ? 1 : 2);
+    if (!links.empty()) {
+        links[0].nominalCost = ModbusLinkCost::fromSerial(baudRates[qBound(0, baudRateIndex, 3)], bitsPerChar, 5.0);
+        links[0].estimator.reset();
+        if (!pollChannels.isEmpty()) {
+            setPollChannels(pollChannels);
+        }
+    }
+
     // 连接设备
     if (modbusClient->connectDevice())
     {
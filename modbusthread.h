@@ -5,6 +5,7 @@
 #include <QSerialPort>
 #include <QSerialPortInfo>
 #include <QModbusRtuSerialClient>
+#include <QModbusTcpClient>
 #include <QModbusDataUnit>
 #include <QModbusReply>
 #include <QCoreApplication>
@@ -13,7 +14,20 @@
 #include <QElapsedTimer>
 #include <QDebug>
 #include <QVariant>
+#include <QTimer>
+#include "pipelineclock.h"
+#include "modbuspollscheduler.h"
+#include "modbusrequestplanner.h"
+#include "modbusdecode.h"
+#include <vector>
 
+// Modbus TCP设备（链路编号从1开始，按配置顺序）
+struct ModbusTcpDevice {
+    QString host;
+    int port = 502;
+    int maxInFlight = 4;        // 同一连接上同时进行的请求数
+    int timeoutMs = 1000;
+};
 
 class modbusThread : public QObject
 {
@@ -27,13 +41,68 @@ public:
 
 signals:
     //传递modbus读数 - 改为传递多个寄存器数据
-    void sendModbusResult(QVector<double> result, long long readTimeInterval);
+    // 每个轮询周期（各已连接链路上的每个请求项都完成一次）发送一次。
+    // acquiredNs：向量中最早的一次读取的采集时刻（请求发出与应答到达的中点，PipelineClock纳秒）
+    void sendModbusResult(QVector<double> result, long long readTimeInterval, qint64 acquiredNs);
     
     // 添加信号用于传递串口连接状态
     void modbusConnectionStatus(bool connected, QString message);
 
+    // 轮询统计，约每秒一次：已发出请求数、跳过的周期数、失败的请求数（自开始轮询以来），
+    // 以及上一统计周期内请求发出时刻相对截止时间的最大延迟（纳秒）
+    void pollStatistics(quint64 requests, quint64 missedCycles, quint64 failedRequests, qint64 maxLatenessNs);
+
+    // 请求计划已更新：请求数、通道数、估计的总线占用率（0~1）
+    void pollPlanChanged(int requests, int channels, double busLoad);
+
+    // Modbus TCP设备连接状态，device从1开始
+    void tcpDeviceStatus(int device, bool connected, QString message);
+
 private:
-    QModbusRtuSerialClient *modbusClient;
+    QModbusRtuSerialClient *modbusClient = nullptr;
+
+    // 一条轮询链路：0为串口RTU总线，1..N为Modbus TCP设备连接。每条链路有自己的调度器和代价估计，
+    // 同时进行的请求数不超过maxInFlight（RTU总线为1），有空位时立即发出下一个到期的请求，没有到期项时定时等待
+    struct PollLink {
+        QModbusClient *client = nullptr;
+        QTimer *timer = nullptr;
+        ModbusPollScheduler scheduler;
+        QVector<int> rawOffset;        // 调度器通道位置 -> rawRegisters中的位置
+        int maxInFlight = 1;
+        int inFlight = 0;
+        ModbusLinkCost nominalCost;
+        ModbusLinkCost planCost;
+        ModbusLinkEstimator estimator;
+        std::vector<qint64> cycleAcquiredNs;   // 本轮各请求项的采集时刻，-1为本轮尚未完成
+        int cyclePending = 0;                  // 本轮尚未完成的请求项数
+    };
+    std::vector<PollLink> links;
+    bool polling = false;
+    bool backToBack = false;
+    quint64 failedRequests = 0;
+    qint64 lastStatisticsNs = 0;
+
+    // 请求计划：按通道表合并出的轮询块，或直接使用的轮询表。各块读到的寄存器按顺序拼接在rawRegisters中，
+    // 每个轮询周期结束时由解码计划按各通道的格式一次解码为发送的通道向量pollValues
+    ModbusRequestPlan requestPlan;
+    ModbusDecodePlan decodePlan;
+    QVector<ModbusChannelSpec> pollChannels;   // 非空时按通道表合并请求
+    QVector<quint16> rawRegisters;
+    QVector<quint8> rawValid;                  // 寄存器最近一次读取是否成功
+    int invalidRegisters = 0;
+    QVector<double> pollValues;
+    quint32 planGeneration = 0;                // 计划更新后，旧计划下发出的请求的应答被丢弃
+
+    int addLink(QModbusClient *client, int maxInFlight, const ModbusLinkCost &nominalCost);
+    QVector<ModbusLinkCost> linkCosts(bool estimated) const;
+    void applyPlan(const ModbusRequestPlan &plan);
+    void replanIfLinkChanged();
+    void emitPollStatistics();
+    void resetPollCycle();
+    bool takePollCycle(qint64 *acquiredNs);
+    void issueNextRequests(int link);
+    void handlePollReply(int link, QModbusClient *client, QModbusReply *reply,
+                         const ModbusPollScheduler::Request &request, qint64 requestNs, quint32 generation);
 
     qint64 currentTime;
     qint64 lastTime;
@@ -47,9 +116,6 @@ public slots:
     // 添加初始化ModbusClient的槽函数
     void initModbusClient();
     
-    //更新函数来读取单一从机的多个寄存器
-    void getModbusResult(int serverAddr, int startRegister, int registerCount);
-    
     // 添加新的槽函数用于设置串口参数
     void setModbusPortInfo(QString portName, int baudRateIndex, int stopBitsIndex, int dataBitsIndex, int parityIndex);
     
@@ -58,6 +124,18 @@ public slots:
 
     // 添加重置计时器的方法
     void resetTimer();
+
+    // 设置轮询表（可从任意线程调用，在Modbus线程中生效）；轮询中修改时从新表的第一个周期重新开始
+    void setPollTable(const QVector<ModbusPollBlock> &blocks);
+    // 设置通道表，按链路代价把各通道的地址合并为最少耗时的读请求；通道向量按通道表顺序
+    void setPollChannels(const QVector<ModbusChannelSpec> &channels);
+    // 设置Modbus TCP设备并连接（链路1..N）；之后需重新设置轮询表或通道表
+    void setTcpDevices(const QVector<ModbusTcpDevice> &devices);
+    // 轮询方式：false按各块的周期（截止时间）读取；true为连续模式，上一个请求完成后立即发出下一个
+    void setPollMode(bool backToBack);
+    // 开始/停止按轮询表循环读取
+    void startPolling();
+    void stopPolling();
 };
 
 #endif // MODBUSTHREAD_H
@@ -0,0 +1,31 @@
+#ifndef PIPELINECLOCK_H
+#define PIPELINECLOCK_H
+
+#include <QtGlobal>
+#include <chrono>
+
+// 采集管线统一时钟
+//
+// 单调时钟（std::chrono::steady_clock，Windows上为QueryPerformanceCounter），以纳秒计，
+// 不受系统时间调整影响；各线程读取的是同一时间基准，可直接比较和相减。
+namespace PipelineClock {
+
+inline qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline double toSeconds(qint64 ns)
+{
+    return ns / 1e9;
+}
+
+inline double toMilliseconds(qint64 ns)
+{
+    return ns / 1e6;
+}
+
+} // namespace PipelineClock
+
+#endif // PIPELINECLOCK_H
@@ -0,0 +1,200 @@
+#include "pipelinelatency.h"
+#include <QDateTime>
+#include <QFile>
+#include <QTextStream>
+#include <QtAlgorithms>
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+int LatencyHistogram::bucketIndex(qint64 ns)
+{
+    if (ns < SubBuckets) {
+        return ns < 0 ? 0 : int(ns);
+    }
+    const int magnitude = 63 - int(qCountLeadingZeroBits(quint64(ns)));
+    if (magnitude >= MaxMagnitude) {
+        return BucketCount - 1;
+    }
+    const int shift = magnitude - SubBucketBits;
+    return SubBuckets * shift + int(ns >> shift);
+}
+
+qint64 LatencyHistogram::bucketUpperBound(int index)
+{
+    if (index < SubBuckets) {
+        return index;
+    }
+    const int shift = index / SubBuckets - 1;
+    const qint64 sub = index % SubBuckets + SubBuckets;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(qint64 ns)
+{
+    if (ns < 0) {
+        ns = 0;
+    }
+    m_counts[bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(ns, std::memory_order_relaxed);
+    qint64 current = m_max.load(std::memory_order_relaxed);
+    while (ns > current && !m_max.compare_exchange_weak(current, ns, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const
+{
+    Snapshot result;
+    result.counts.resize(BucketCount);
+    quint64 total = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        result.counts[size_t(i)] = m_counts[i].load(std::memory_order_relaxed);
+        total += result.counts[size_t(i)];
+    }
+    // 以各桶计数之和为总数，百分位数与桶计数一致
+    result.total = total;
+    result.sumNs = m_sum.load(std::memory_order_relaxed);
+    result.maxNs = m_max.load(std::memory_order_relaxed);
+    return result;
+}
+
+void LatencyHistogram::reset()
+{
+    for (std::atomic<quint64> &count : m_counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+qint64 LatencyHistogram::Snapshot::percentile(double p) const
+{
+    if (total == 0) {
+        return 0;
+    }
+    const double rank = qBound(0.0, p, 100.0) / 100.0 * double(total);
+    const quint64 target = qMax<quint64>(1, quint64(rank + 0.999999));
+    quint64 seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= target) {
+            return qMin(bucketUpperBound(int(i)), maxNs);
+        }
+    }
+    return maxNs;
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::Snapshot::since(const Snapshot &earlier) const
+{
+    Snapshot result;
+    result.counts.resize(counts.size());
+    for (size_t i = 0; i < counts.size(); ++i) {
+        const quint64 before = i < earlier.counts.size() ? earlier.counts[i] : 0;
+        result.counts[i] = counts[i] >= before ? counts[i] - before : counts[i];
+        result.total += result.counts[i];
+    }
+    result.sumNs = sumNs >= earlier.sumNs ? sumNs - earlier.sumNs : sumNs;
+    result.maxNs = maxNs;
+    return result;
+}
+
+namespace PipelineLatency {
+
+namespace {
+
+LatencyHistogram histograms[StageCount];
+
+} // namespace
+
+QString stageName(Stage stage)
+{
+    switch (stage) {
+    case ModbusAcquire: return "Modbus采集";
+    case ModbusPollLateness: return "Modbus轮询抖动";
+    case DAQAcquire: return "DAQ采集";
+    case ECUAcquire: return "ECU采集";
+    case ModbusEnqueue: return "Modbus入队";
+    case DAQEnqueue: return "DAQ入队";
+    case ECUEnqueue: return "ECU入队";
+    case SnapshotBuild: return "快照生成";
+    case Calibrate: return "校准";
+    case Log: return "日志写入";
+    case Publish: return "WebSocket发布";
+    case UiPaint: return "界面更新";
+    case EndToEndLog: return "端到端-日志";
+    case EndToEndPublish: return "端到端-WebSocket";
+    case EndToEndUi: return "端到端-界面";
+    default: return "未知";
+    }
+}
+
+LatencyHistogram &histogram(Stage stage)
+{
+    return histograms[stage >= 0 && stage < StageCount ? stage : 0];
+}
+
+void resetAll()
+{
+    for (LatencyHistogram &h : histograms) {
+        h.reset();
+    }
+}
+
+QString formatReport()
+{
+    QString report;
+    QTextStream out(&report);
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8\n")
+               .arg("阶段", -18).arg("计数", 10).arg("平均ms", 10).arg("P50ms", 10)
+               .arg("P90ms", 10).arg("P99ms", 10).arg("P99.9ms", 10).arg("最大ms", 10);
+    for (int s = 0; s < StageCount; ++s) {
+        const LatencyHistogram::Snapshot h = histograms[s].snapshot();
+        out << QString("%1 %2 %3 %4 %5 %6 %7 %8\n")
+                   .arg(stageName(Stage(s)), -18)
+                   .arg(h.total, 10)
+                   .arg(h.meanNs() / 1e6, 10, 'f', 3)
+                   .arg(PipelineClock::toMilliseconds(h.percentile(50.0)), 10, 'f', 3)
+                   .arg(PipelineClock::toMilliseconds(h.percentile(90.0)), 10, 'f', 3)
+                   .arg(PipelineClock::toMilliseconds(h.percentile(99.0)), 10, 'f', 3)
+                   .arg(PipelineClock::toMilliseconds(h.percentile(99.9)), 10, 'f', 3)
+                   .arg(PipelineClock::toMilliseconds(h.maxNs), 10, 'f', 3);
+    }
+    return report;
+}
+
+bool dumpToFile(const QString &filePath, QString *errorMessage)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+        if (errorMessage) {
+            *errorMessage = file.errorString();
+        }
+        return false;
+    }
+    QTextStream out(&file);
+    out << "# 采集管线延迟统计 " << QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss") << "\n";
+    out << formatReport();
+    // 直方图明细：每个阶段的非零桶，便于离线比较尾部分布
+    out << "\n# stage,bucketUpperNs,count\n";
+    for (int s = 0; s < StageCount; ++s) {
+        const LatencyHistogram::Snapshot h = histograms[s].snapshot();
+        for (size_t i = 0; i < h.counts.size(); ++i) {
+            if (h.counts[i] > 0) {
+                out << stageName(Stage(s)) << ',' << LatencyHistogram::bucketUpperBound(int(i)) << ','
+                    << h.counts[i] << '\n';
+            }
+        }
+    }
+    out.flush();
+    if (file.error() != QFileDevice::NoError) {
+        if (errorMessage) {
+            *errorMessage = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+} // namespace PipelineLatency
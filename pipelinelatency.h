@@ -0,0 +1,108 @@
+#ifndef PIPELINELATENCY_H
+#define PIPELINELATENCY_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <vector>
+#include "pipelineclock.h"
+
+// 无锁延迟直方图（HDR风格，对数-线性分桶）
+//
+// 纳秒值按2的幂分段，每段再等分为SubBuckets个桶，相对误差不超过1/SubBuckets（约3%），
+// 0 ~ 2^MaxMagnitude ns（约18分钟）共1152个桶，超出范围的值计入最后一个桶。
+// record()只做几次relaxed原子加法，可在任意线程（包括设备回调线程）中并发调用；
+// 读取时复制各桶计数得到Snapshot，与写入并发时各计数之间可能相差正在进行的几次记录。
+class LatencyHistogram
+{
+public:
+    static constexpr int SubBucketBits = 5;
+    static constexpr int SubBuckets = 1 << SubBucketBits;
+    static constexpr int MaxMagnitude = 40;
+    static constexpr int BucketCount = SubBuckets * (MaxMagnitude - SubBucketBits + 1);
+
+    // 某一时刻的计数副本
+    struct Snapshot {
+        std::vector<quint64> counts;    // [BucketCount]
+        quint64 total = 0;
+        qint64 sumNs = 0;
+        qint64 maxNs = 0;
+
+        // 百分位数（0~100），返回所在桶的上界（不超过最大值）；没有记录时为0
+        qint64 percentile(double p) const;
+        double meanNs() const { return total > 0 ? double(sumNs) / double(total) : 0.0; }
+        // 自earlier以来新增的记录（最大值取本副本的累计最大值）
+        Snapshot since(const Snapshot &earlier) const;
+    };
+
+    LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    void record(qint64 ns);
+    Snapshot snapshot() const;
+    // 清零（与并发记录之间不保证原子性，仅用于手动重置统计）
+    void reset();
+
+    static int bucketIndex(qint64 ns);
+    static qint64 bucketUpperBound(int index);
+
+private:
+    std::atomic<quint64> m_counts[BucketCount];
+    std::atomic<qint64> m_sum;
+    std::atomic<qint64> m_max;
+};
+
+// 采集管线各阶段的延迟统计
+//
+// 各阶段的起止时刻均为PipelineClock纳秒，数据在线程间传递时携带采集时刻（ModbusThread的acquiredNs、
+// DAQDataBlock::timestampNs、ECUData::acquiredNs）和快照的各阶段时刻（DataSnapshot::acquiredNs等），
+// 在阶段结束的线程中记录到全局直方图。
+namespace PipelineLatency {
+
+enum Stage {
+    ModbusAcquire,      // Modbus请求发出到应答到达
+    ModbusPollLateness, // Modbus请求的发出时刻相对其轮询截止时间的延迟（轮询抖动）
+    DAQAcquire,         // DAQ回调读出数据块到数据块发出（环形缓冲区等待、滤波）
+    ECUAcquire,         // ECU串口数据读出到数据帧解析完成
+    ModbusEnqueue,      // Modbus采集时刻到快照线程收到
+    DAQEnqueue,         // DAQ数据块读出到快照线程收到
+    ECUEnqueue,         // ECU数据帧解析完成到快照线程收到
+    SnapshotBuild,      // 快照调度触发到原始快照（含派生通道）生成
+    Calibrate,          // 原始快照生成到校准完成（快照发布时刻）
+    Log,                // 快照发布到会话日志写入线程写入该行
+    Publish,            // 快照发布到WebSocket广播完成
+    UiPaint,            // 快照发布到主线程仪表盘和图表更新完成
+    EndToEndLog,        // 快照所用数据中最早的采集时刻到写入会话日志
+    EndToEndPublish,    // 同上，到WebSocket广播完成
+    EndToEndUi,         // 同上，到界面更新完成
+    StageCount
+};
+
+QString stageName(Stage stage);
+LatencyHistogram &histogram(Stage stage);
+
+inline void record(Stage stage, qint64 ns)
+{
+    histogram(stage).record(ns);
+}
+
+// 记录从startNs到当前时刻的延迟；startNs <= 0（时刻未知）时不记录
+inline void recordSince(Stage stage, qint64 startNs)
+{
+    if (startNs > 0) {
+        histogram(stage).record(PipelineClock::nowNs() - startNs);
+    }
+}
+
+// 清零全部阶段
+void resetAll();
+// 文本报告：每个阶段一行，计数、平均、P50/P90/P99/P99.9、最大值（毫秒）
+QString formatReport();
+// 把文本报告和各阶段非零桶（上界ns、计数）写入文件
+bool dumpToFile(const QString &filePath, QString *errorMessage = nullptr);
+
+} // namespace PipelineLatency
+
+#endif // PIPELINELATENCY_H
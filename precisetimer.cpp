@@ -0,0 +1,127 @@
+#include "precisetimer.h"
+#include <QThread>
+#include <cmath>
+
+PreciseTimer::PreciseTimer(QObject *parent)
+    : QObject(parent)
+    , m_timer(this)
+    , m_active(false)
+    , m_periodNs(100000000)
+    , m_spinNs(200000)
+    , m_epochNs(0)
+    , m_tick(0)
+    , m_tickBase(0)
+    , m_nextDeadlineNs(0)
+    , m_ticks(0)
+    , m_missed(0)
+    , m_maxLatenessNs(0)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &PreciseTimer::onTimer);
+}
+
+void PreciseTimer::setRate(double hz)
+{
+    if (!(hz > 0.0)) {
+        return;
+    }
+    const qint64 period = qint64(std::llround(1e9 / qBound(0.1, hz, 1000.0)));
+    if (period == m_periodNs) {
+        return;
+    }
+    const qint64 lastDeadline = m_nextDeadlineNs - m_periodNs;
+    m_periodNs = period;
+    if (m_active) {
+        // 以上一次截止时间为新起点，之后按新周期排列，序号连续
+        m_tickBase += m_tick - 1;
+        m_epochNs = lastDeadline;
+        m_tick = 1;
+        m_nextDeadlineNs = m_epochNs + m_periodNs;
+        arm();
+    }
+}
+
+void PreciseTimer::resetStatistics()
+{
+    m_ticks = 0;
+    m_missed = 0;
+    m_maxLatenessNs = 0;
+}
+
+void PreciseTimer::start()
+{
+    startAt(PipelineClock::nowNs());
+}
+
+void PreciseTimer::startAt(qint64 epochNs)
+{
+    m_active = true;
+    m_epochNs = epochNs;
+    m_tick = 1;
+    m_tickBase = 0;
+    m_nextDeadlineNs = m_epochNs + m_periodNs;
+    resetStatistics();
+    arm();
+}
+
+void PreciseTimer::stop()
+{
+    m_active = false;
+    m_timer.stop();
+}
+
+void PreciseTimer::arm()
+{
+    if (!m_active) {
+        return;
+    }
+    // 提前到截止时间前spinThreshold唤醒（四舍五入到毫秒），剩余部分自旋等待
+    const qint64 remaining = m_nextDeadlineNs - PipelineClock::nowNs() - m_spinNs;
+    const int ms = remaining > 0 ? int((remaining + 500000) / 1000000) : 0;
+    m_timer.start(ms);
+}
+
+void PreciseTimer::onTimer()
+{
+    if (!m_active) {
+        return;
+    }
+
+    qint64 now = PipelineClock::nowNs();
+    if (m_nextDeadlineNs - now > m_spinNs) {
+        // 系统定时器提前唤醒：重新等待（期间处理其他事件）
+        arm();
+        return;
+    }
+    while (now < m_nextDeadlineNs) {
+        QThread::yieldCurrentThread();
+        now = PipelineClock::nowNs();
+    }
+
+    // 延迟超过一个周期：跳过已错过的截止时间，只触发最近的一次
+    qint64 lateness = now - m_nextDeadlineNs;
+    if (lateness >= m_periodNs) {
+        const quint64 skipped = quint64(lateness / m_periodNs);
+        m_missed += skipped;
+        m_tick += skipped;
+        m_nextDeadlineNs = m_epochNs + qint64(m_tick) * m_periodNs;
+        lateness = now - m_nextDeadlineNs;
+    }
+    if (lateness > m_maxLatenessNs) {
+        m_maxLatenessNs = lateness;
+    }
+
+    const qint64 deadline = m_nextDeadlineNs;
+    const quint64 tick = m_tickBase + m_tick;
+    ++m_ticks;
+    ++m_tick;
+    m_nextDeadlineNs = m_epochNs + qint64(m_tick) * m_periodNs;
+
+    emit timeout(deadline, tick);
+
+    // 槽函数中可能已停止或重新开始
+    if (m_active && !m_timer.isActive()) {
+        arm();
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef PRECISETIMER_H
+#define PRECISETIMER_H
+
+#include <QObject>
+#include <QTimer>
+#include "pipelineclock.h"
+
+// 按绝对截止时间触发的周期定时器
+//
+// 第k次触发的截止时间为 起点 + k * 周期（整数纳秒），不会因处理耗时或定时器误差累积漂移。
+// 底层使用Qt::PreciseTimer单次定时器唤醒，距截止时间不足spinThreshold时让出CPU自旋等待，
+// 因此可用于最高约1kHz的速率。处理耗时超过一个周期时跳过已错过的截止时间并计数，
+// 不会连续补发。必须在所属线程的事件循环中使用。
+class PreciseTimer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PreciseTimer(QObject *parent = nullptr);
+
+    // 触发速率（Hz），0.1~1000；运行中修改从下一次触发起生效
+    void setRate(double hz);
+    double rate() const { return 1e9 / double(m_periodNs); }
+    qint64 periodNs() const { return m_periodNs; }
+    // 截止时间前自旋等待的时长（纳秒），默认200us；0表示完全依赖系统定时器
+    void setSpinThreshold(qint64 ns) { m_spinNs = qMax<qint64>(0, ns); }
+
+    bool isActive() const { return m_active; }
+
+    // ---- 统计 ----
+    quint64 tickCount() const { return m_ticks; }
+    // 错过（被跳过）的截止时间数
+    quint64 missedDeadlines() const { return m_missed; }
+    // 触发时刻相对截止时间的最大延迟（纳秒），自开始或上次resetMaxLateness()以来
+    qint64 maxLatenessNs() const { return m_maxLatenessNs; }
+    void resetMaxLateness() { m_maxLatenessNs = 0; }
+    void resetStatistics();
+
+public slots:
+    // 从当前时刻起开始，第一次触发在一个周期之后
+    void start();
+    // 以指定时刻（PipelineClock纳秒）为起点开始
+    void startAt(qint64 epochNs);
+    void stop();
+
+signals:
+    // deadlineNs：本次的截止时间（PipelineClock纳秒）；tick：从起点开始的序号（含被跳过的）
+    void timeout(qint64 deadlineNs, quint64 tick);
+
+private slots:
+    void onTimer();
+
+private:
+    void arm();
+
+    QTimer m_timer;
+    bool m_active;
+    qint64 m_periodNs;
+    qint64 m_spinNs;
+    qint64 m_epochNs;          // 当前速率下的起点
+    quint64 m_tick;            // 下一次触发的序号（相对m_epochNs）
+    quint64 m_tickBase;        // 修改速率前已经过的序号数
+    qint64 m_nextDeadlineNs;
+
+    quint64 m_ticks;
+    quint64 m_missed;
+    qint64 m_maxLatenessNs;
+};
+
+#endif // PRECISETIMER_H
@@ -0,0 +1,170 @@
+#include "samplescaling.h"
+#include "cpufeatures.h"
+
+namespace {
+
+void convertScalar(const std::int16_t *codes, int begin, int count, double scale, double offset, double *out)
+{
+    for (int i = begin; i < count; ++i) {
+        out[i] = codes[i] * scale + offset;
+    }
+}
+
+#ifdef SIMD_HAVE_SSE2
+// SSE2：每次换算8个码值
+int convertSse2(const std::int16_t *codes, int count, double scale, double offset, double *out)
+{
+    const __m128d s = _mm_set1_pd(scale);
+    const __m128d o = _mm_set1_pd(offset);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i *>(codes + i));
+        // 符号扩展为32位
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(raw, raw), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(raw, raw), 16);
+        _mm_storeu_pd(out + i, _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(lo), s), o));
+        _mm_storeu_pd(out + i + 2, _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(lo, 8)), s), o));
+        _mm_storeu_pd(out + i + 4, _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(hi), s), o));
+        _mm_storeu_pd(out + i + 6, _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(hi, 8)), s), o));
+    }
+    return i;
+}
+#endif
+
+#ifdef SIMD_HAVE_X86
+// AVX2/FMA：每次换算16个码值
+SIMD_TARGET_AVX2 int convertAvx2(const std::int16_t *codes, int count, double scale, double offset, double *out)
+{
+    const __m256d s = _mm256_set1_pd(scale);
+    const __m256d o = _mm256_set1_pd(offset);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256i raw = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(codes + i));
+        const __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(raw));
+        const __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(raw, 1));
+        _mm256_storeu_pd(out + i, _mm256_fmadd_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(lo)), s, o));
+        _mm256_storeu_pd(out + i + 4, _mm256_fmadd_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(lo, 1)), s, o));
+        _mm256_storeu_pd(out + i + 8, _mm256_fmadd_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(hi)), s, o));
+        _mm256_storeu_pd(out + i + 12, _mm256_fmadd_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(hi, 1)), s, o));
+    }
+    return i;
+}
+#endif
+
+void transposeScalar(const double *scans, int channels, double *out, std::size_t outStride,
+                     int chBegin, int chEnd, int scanBegin, int scanEnd)
+{
+    for (int ch = chBegin; ch < chEnd; ++ch) {
+        double *row = out + std::size_t(ch) * outStride;
+        for (int i = scanBegin; i < scanEnd; ++i) {
+            row[i] = scans[std::size_t(i) * std::size_t(channels) + std::size_t(ch)];
+        }
+    }
+}
+
+#ifdef SIMD_HAVE_SSE2
+// SSE2：2x2分块转置，返回已处理的扫描数（通道数需为偶数部分）
+int transposeSse2(const double *scans, int scanCount, int channels, double *out, std::size_t outStride)
+{
+    const int chEnd = channels & ~1;
+    const int scanEnd = scanCount & ~1;
+    for (int i = 0; i < scanEnd; i += 2) {
+        const double *r0 = scans + std::size_t(i) * std::size_t(channels);
+        const double *r1 = r0 + channels;
+        for (int ch = 0; ch < chEnd; ch += 2) {
+            const __m128d a = _mm_loadu_pd(r0 + ch);
+            const __m128d b = _mm_loadu_pd(r1 + ch);
+            _mm_storeu_pd(out + std::size_t(ch) * outStride + i, _mm_unpacklo_pd(a, b));
+            _mm_storeu_pd(out + std::size_t(ch + 1) * outStride + i, _mm_unpackhi_pd(a, b));
+        }
+    }
+    return scanEnd;
+}
+#endif
+
+#ifdef SIMD_HAVE_X86
+// AVX：4x4分块转置，返回已处理的扫描数
+SIMD_TARGET_AVX2 int transposeAvx2(const double *scans, int scanCount, int channels, double *out, std::size_t outStride)
+{
+    const int chEnd = channels & ~3;
+    const int scanEnd = scanCount & ~3;
+    for (int i = 0; i < scanEnd; i += 4) {
+        const double *r0 = scans + std::size_t(i) * std::size_t(channels);
+        const double *r1 = r0 + channels;
+        const double *r2 = r1 + channels;
+        const double *r3 = r2 + channels;
+        for (int ch = 0; ch < chEnd; ch += 4) {
+            const __m256d a = _mm256_loadu_pd(r0 + ch);
+            const __m256d b = _mm256_loadu_pd(r1 + ch);
+            const __m256d c = _mm256_loadu_pd(r2 + ch);
+            const __m256d d = _mm256_loadu_pd(r3 + ch);
+            const __m256d ab0 = _mm256_unpacklo_pd(a, b);   // a0 b0 a2 b2
+            const __m256d ab1 = _mm256_unpackhi_pd(a, b);   // a1 b1 a3 b3
+            const __m256d cd0 = _mm256_unpacklo_pd(c, d);
+            const __m256d cd1 = _mm256_unpackhi_pd(c, d);
+            double *o = out + std::size_t(ch) * outStride + i;
+            _mm256_storeu_pd(o, _mm256_permute2f128_pd(ab0, cd0, 0x20));
+            _mm256_storeu_pd(o + outStride, _mm256_permute2f128_pd(ab1, cd1, 0x20));
+            _mm256_storeu_pd(o + 2 * outStride, _mm256_permute2f128_pd(ab0, cd0, 0x31));
+            _mm256_storeu_pd(o + 3 * outStride, _mm256_permute2f128_pd(ab1, cd1, 0x31));
+        }
+    }
+    return scanEnd;
+}
+#endif
+
+} // namespace
+
+void convertInt16ToVolts(const std::int16_t *codes, int count, double scale, double offset, double *out)
+{
+    if (!codes || !out || count <= 0) {
+        return;
+    }
+
+    int done = 0;
+#ifdef SIMD_HAVE_X86
+    if (cpuHasAvx2Fma()) {
+        done = convertAvx2(codes, count, scale, offset, out);
+    } else
+#endif
+    {
+#ifdef SIMD_HAVE_SSE2
+        done = convertSse2(codes, count, scale, offset, out);
+#endif
+    }
+    convertScalar(codes, done, count, scale, offset, out);
+}
+
+void deinterleaveInt16(const std::int16_t *codes, int stride, int count, std::int16_t *out)
+{
+    for (int i = 0; i < count; ++i) {
+        out[i] = codes[i * stride];
+    }
+}
+
+void transposeScans(const double *scans, int scanCount, int channels, double *out, std::size_t outStride)
+{
+    if (!scans || !out || scanCount <= 0 || channels <= 0) {
+        return;
+    }
+
+    // 内核处理[0, scanDone)次扫描中的前chDone个通道，其余部分逐点处理
+    int scanDone = 0;
+    int chDone = 0;
+#ifdef SIMD_HAVE_X86
+    if (cpuHasAvx2Fma() && channels >= 4) {
+        scanDone = transposeAvx2(scans, scanCount, channels, out, outStride);
+        chDone = channels & ~3;
+    } else
+#endif
+    {
+#ifdef SIMD_HAVE_SSE2
+        if (channels >= 2) {
+            scanDone = transposeSse2(scans, scanCount, channels, out, outStride);
+            chDone = channels & ~1;
+        }
+#endif
+    }
+    transposeScalar(scans, channels, out, outStride, chDone, channels, 0, scanCount);
+    transposeScalar(scans, channels, out, outStride, 0, chDone, scanDone, scanCount);
+}
@@ -0,0 +1,18 @@
+#ifndef SAMPLESCALING_H
+#define SAMPLESCALING_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 原始ADC码值到电压的批量换算：out[i] = codes[i] * scale + offset
+// （运行时选择AVX2/FMA或SSE2内核）
+void convertInt16ToVolts(const std::int16_t *codes, int count, double scale, double offset, double *out);
+
+// 从交错存储（按扫描分组）的码值中取出一个通道：out[i] = codes[i * stride]
+void deinterleaveInt16(const std::int16_t *codes, int stride, int count, std::int16_t *out);
+
+// 将交错存储（按扫描分组）的样本块转置为通道优先：out[ch * outStride + i] = scans[i * channels + ch]
+// （按4x4/2x2分块转置，运行时选择AVX2或SSE2内核）
+void transposeScans(const double *scans, int scanCount, int channels, double *out, std::size_t outStride);
+
+#endif // SAMPLESCALING_H
@@ -0,0 +1,84 @@
+#include "sampletrack.h"
+#include <algorithm>
+
+SampleTrack::SampleTrack(int depth)
+    : m_depth(std::max(2, depth))
+    , m_channels(0)
+    , m_head(0)
+    , m_size(0)
+    , m_timestamps(size_t(m_depth), 0)
+{
+}
+
+void SampleTrack::reset()
+{
+    m_head = 0;
+    m_size = 0;
+}
+
+qint64 SampleTrack::latestTimestampNs() const
+{
+    return m_size > 0 ? m_timestamps[size_t(slot(m_size - 1))] : 0;
+}
+
+bool SampleTrack::append(qint64 timestampNs, const double *values, int count)
+{
+    if (count <= 0) {
+        return false;
+    }
+    if (count != m_channels) {
+        m_channels = count;
+        m_values.assign(size_t(m_depth) * size_t(count), 0.0);
+        reset();
+    }
+    if (m_size > 0 && timestampNs < latestTimestampNs()) {
+        return false;
+    }
+
+    m_timestamps[size_t(m_head)] = timestampNs;
+    std::copy(values, values + count, m_values.begin() + std::ptrdiff_t(m_head) * count);
+    m_head = (m_head + 1) % m_depth;
+    m_size = std::min(m_size + 1, m_depth);
+    return true;
+}
+
+bool SampleTrack::sample(qint64 t, ResampleMode mode, double *out, int count, qint64 *ageNs) const
+{
+    if (m_size == 0) {
+        return false;
+    }
+    const int n = std::min(count, m_channels);
+
+    // 从最新一帧向前找t之前（含）最近的一帧
+    int before = m_size - 1;
+    while (before >= 0 && m_timestamps[size_t(slot(before))] > t) {
+        --before;
+    }
+
+    if (before < 0) {
+        // t早于全部帧：使用最早一帧
+        std::copy(frame(0), frame(0) + n, out);
+        if (ageNs) {
+            *ageNs = t - m_timestamps[size_t(slot(0))];
+        }
+        return true;
+    }
+
+    const qint64 t0 = m_timestamps[size_t(slot(before))];
+    const double *v0 = frame(before);
+    if (ageNs) {
+        *ageNs = t - t0;
+    }
+
+    if (mode == ResampleMode::Linear && before + 1 < m_size) {
+        const qint64 t1 = m_timestamps[size_t(slot(before + 1))];
+        const double *v1 = frame(before + 1);
+        const double w = t1 > t0 ? double(t - t0) / double(t1 - t0) : 0.0;
+        for (int ch = 0; ch < n; ++ch) {
+            out[ch] = v0[ch] + (v1[ch] - v0[ch]) * w;
+        }
+    } else {
+        std::copy(v0, v0 + n, out);
+    }
+    return true;
+}
@@ -0,0 +1,52 @@
+#ifndef SAMPLETRACK_H
+#define SAMPLETRACK_H
+
+#include <QtGlobal>
+#include <cstddef>
+#include <vector>
+
+// 重采样方式
+enum class ResampleMode {
+    ZeroOrderHold,   // 取时刻t之前（含）最近一帧的值
+    Linear           // 在包围时刻t的两帧之间线性插值；t晚于最新一帧时保持最新值（不外推）
+};
+
+// 单个数据源带采集时间戳的最近若干帧（多通道，固定容量环形存储）
+//
+// 数据源线程/槽函数按时间顺序追加帧，快照构建时把各通道重采样到快照时刻，
+// 并给出所用数据的时效（快照时刻 - 时刻之前最近一帧的采集时间）。
+// 时间戳统一为PipelineClock纳秒。单线程使用。
+class SampleTrack
+{
+public:
+    explicit SampleTrack(int depth = 8);
+
+    // 清空全部帧（通道数不变）
+    void reset();
+    int channelCount() const { return m_channels; }
+    int depth() const { return m_depth; }
+    bool isEmpty() const { return m_size == 0; }
+    qint64 latestTimestampNs() const;
+
+    // 追加一帧；通道数变化时先清空。时间戳早于最新一帧的帧被丢弃并返回false
+    bool append(qint64 timestampNs, const double *values, int count);
+
+    // 把时刻t各通道的值写入out（count个，超出通道数的部分不写）。
+    // ageNs返回t与t之前（含）最近一帧的时间差；t早于全部帧时使用最早一帧，ageNs为负。
+    // 没有数据时返回false
+    bool sample(qint64 t, ResampleMode mode, double *out, int count, qint64 *ageNs = nullptr) const;
+
+private:
+    // 第i帧（0为最早）在环形存储中的位置
+    int slot(int i) const { return (m_head + m_depth - m_size + i) % m_depth; }
+    const double *frame(int i) const { return m_values.data() + std::size_t(slot(i)) * std::size_t(m_channels); }
+
+    int m_depth;
+    int m_channels;
+    int m_head;                       // 下一帧的写入位置
+    int m_size;
+    std::vector<qint64> m_timestamps;
+    std::vector<double> m_values;     // [帧][通道]
+};
+
+#endif // SAMPLETRACK_H
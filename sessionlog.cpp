@@ -0,0 +1,806 @@
+#include "sessionlog.h"
+#include <QBuffer>
+#include <QDateTime>
+#include <QDebug>
+#include <QStringList>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+const char FileMagic[8] = {'S', 'E', 'S', 'S', 'L', 'O', 'G', '1'};
+const char CompressedMagic[8] = {'S', 'L', 'O', 'G', 'Z', '1', '\0', '\0'};
+const qint64 CompressedHeaderBytes = 20;
+const qint64 CompressionChunkBytes = 4 << 20;   // 每段压缩前的大小
+const quint32 BlockMagic = 0x4B4C4253;   // "SBLK"
+const quint32 IndexMagic = 0x58444953;   // "SIDX"
+const quint32 FileVersion = 1;
+const qint64 HeaderPatchOffset = 32;     // 块索引偏移、块数、总行数在文件头中的位置
+const qint64 BlockHeaderBytes = 16;
+
+template <typename T>
+void appendLE(QByteArray &out, T value)
+{
+    const T le = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&le), sizeof(T));
+}
+
+void appendF64(QByteArray &out, double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    appendLE<quint64>(out, bits);
+}
+
+void appendString(QByteArray &out, const QString &text)
+{
+    const QByteArray utf8 = text.toUtf8();
+    appendLE<quint32>(out, quint32(utf8.size()));
+    out.append(utf8);
+}
+
+// 追加定宽数组（小端主机直接复制）
+template <typename T>
+void appendArray(QByteArray &out, const T *data, int count)
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    out.append(reinterpret_cast<const char *>(data), qsizetype(count) * qsizetype(sizeof(T)));
+#else
+    for (int i = 0; i < count; ++i) {
+        T value;
+        std::memcpy(&value, data + i, sizeof(T));
+        out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+        std::reverse(out.end() - qsizetype(sizeof(T)), out.end());
+    }
+#endif
+}
+
+template <typename T>
+void readArray(const char *src, T *data, int count)
+{
+    std::memcpy(data, src, size_t(count) * sizeof(T));
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+    for (int i = 0; i < count; ++i) {
+        char *bytes = reinterpret_cast<char *>(data + i);
+        std::reverse(bytes, bytes + sizeof(T));
+    }
+#endif
+}
+
+// 顺序解析小端字段
+class FieldReader
+{
+public:
+    FieldReader(const char *data, qint64 size) : m_data(data), m_size(size), m_pos(0), m_ok(true) {}
+
+    template <typename T>
+    T read()
+    {
+        if (m_pos + qint64(sizeof(T)) > m_size) {
+            m_ok = false;
+            return T();
+        }
+        T value = qFromLittleEndian<T>(m_data + m_pos);
+        m_pos += sizeof(T);
+        return value;
+    }
+    double readF64()
+    {
+        const quint64 bits = read<quint64>();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    QString readString()
+    {
+        const quint32 length = read<quint32>();
+        if (!m_ok || m_pos + qint64(length) > m_size) {
+            m_ok = false;
+            return QString();
+        }
+        const QString text = QString::fromUtf8(m_data + m_pos, int(length));
+        m_pos += length;
+        return text;
+    }
+    bool ok() const { return m_ok; }
+    qint64 pos() const { return m_pos; }
+
+private:
+    const char *m_data;
+    qint64 m_size;
+    qint64 m_pos;
+    bool m_ok;
+};
+
+// 数据块（不含块头）的字节数
+qint64 blockBodyBytes(int rows, int columns)
+{
+    return qint64(rows) * (8 + 4 + 1) + qint64(columns) * ((rows + 7) / 8) + qint64(columns) * rows * 8;
+}
+
+const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+} // namespace
+
+QVector<SessionLog::Column> SessionLog::snapshotColumns(int modbusChannels, int daqChannels,
+                                                        const QStringList &customNames, const QStringList &customUnits,
+                                                        const CalibrationTable &calibration)
+{
+    QVector<Column> columns;
+    const auto add = [&](ColumnKind kind, int channel, const QString &name, const QString &unit,
+                         CalibrationTable::Source source) {
+        Column column;
+        column.kind = kind;
+        column.channel = channel;
+        column.name = name;
+        column.unit = unit;
+        column.calibration = calibration.params(source, channel);
+        columns.append(column);
+    };
+
+    for (int i = 0; i < modbusChannels; ++i) {
+        add(ModbusValue, i, QString("Modbus_%1").arg(i), QString(), CalibrationTable::Modbus);
+    }
+    for (int i = 0; i < daqChannels; ++i) {
+        // 未校准的DAQ通道单位为伏特，校准后的工程单位未知
+        const CalibrationParams params = calibration.params(CalibrationTable::DAQ, i);
+        const bool identity = params.a == 0.0 && params.b == 0.0 && params.c == 1.0 && params.d == 0.0;
+        add(DAQValue, i, QString("DAQ_%1").arg(i), identity ? QString("V") : QString(), CalibrationTable::DAQ);
+    }
+    for (int i = 0; i < daqChannels; ++i) {
+        const QString unit = columns[modbusChannels + i].unit;
+        add(DAQMin, i, QString("DAQ_%1_Min").arg(i), unit, CalibrationTable::DAQ);
+        add(DAQMax, i, QString("DAQ_%1_Max").arg(i), unit, CalibrationTable::DAQ);
+        add(DAQMean, i, QString("DAQ_%1_Mean").arg(i), unit, CalibrationTable::DAQ);
+        add(DAQRms, i, QString("DAQ_%1_RMS").arg(i), unit, CalibrationTable::DAQ);
+    }
+    const QStringList ecuNames = {"Throttle", "EngineSpeed", "CylinderTemp", "ExhaustTemp", "AxleTemp",
+                                  "FuelPressure", "IntakeTemp", "AtmPressure", "FlightTime"};
+    const QStringList ecuUnits = {"%", "rpm", "°C", "°C", "°C", "kPa", "°C", "kPa", "min"};
+    for (int i = 0; i < ecuNames.size(); ++i) {
+        add(ECUValue, i, QString("ECU_%1").arg(ecuNames[i]), ecuUnits[i], CalibrationTable::ECU);
+    }
+    for (int i = 0; i < customNames.size(); ++i) {
+        add(CustomValue, i, customNames[i].isEmpty() ? QString("Custom_%1").arg(i) : customNames[i],
+            i < customUnits.size() ? customUnits[i] : QString(), CalibrationTable::Custom);
+    }
+    return columns;
+}
+
+bool SessionLog::compressFile(const QString &sourcePath, const QString &targetPath, int level, QString *error)
+{
+    QFile source(sourcePath);
+    QFile target(targetPath);
+    if (!source.open(QIODevice::ReadOnly)) {
+        *error = QString("无法打开 %1: %2").arg(sourcePath, source.errorString());
+        return false;
+    }
+    if (!target.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        *error = QString("无法创建 %1: %2").arg(targetPath, target.errorString());
+        return false;
+    }
+
+    QByteArray header;
+    header.append(CompressedMagic, sizeof(CompressedMagic));
+    appendLE<quint32>(header, quint32(CompressionChunkBytes));
+    appendLE<quint64>(header, quint64(source.size()));
+    bool ok = target.write(header) == header.size();
+
+    QByteArray chunk;
+    while (ok && !source.atEnd()) {
+        chunk = source.read(CompressionChunkBytes);
+        if (chunk.isEmpty()) {
+            ok = false;
+            break;
+        }
+        const QByteArray packed = qCompress(chunk, level);
+        QByteArray length;
+        appendLE<quint32>(length, quint32(packed.size()));
+        ok = target.write(length) == length.size() && target.write(packed) == packed.size();
+    }
+    if (!ok) {
+        *error = QString("压缩 %1 失败: %2").arg(sourcePath, target.errorString());
+        target.close();
+        target.remove();
+        return false;
+    }
+    target.close();
+    return true;
+}
+
+bool SessionLog::isCompressedFile(const QString &filePath)
+{
+    QFile file(filePath);
+    char magic[sizeof(CompressedMagic)];
+    return file.open(QIODevice::ReadOnly) && file.read(magic, sizeof(magic)) == qint64(sizeof(magic))
+           && std::memcmp(magic, CompressedMagic, sizeof(magic)) == 0;
+}
+
+bool SessionLog::decompressFile(const QString &filePath, QByteArray *data, QString *error)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = QString("无法打开 %1: %2").arg(filePath, file.errorString());
+        return false;
+    }
+    const QByteArray header = file.read(CompressedHeaderBytes);
+    if (header.size() != CompressedHeaderBytes || std::memcmp(header.constData(), CompressedMagic, sizeof(CompressedMagic)) != 0) {
+        *error = QString("%1 不是压缩的会话日志").arg(filePath);
+        return false;
+    }
+    FieldReader fields(header.constData() + sizeof(CompressedMagic), CompressedHeaderBytes - qint64(sizeof(CompressedMagic)));
+    fields.read<quint32>();
+    const qint64 rawSize = qint64(fields.read<quint64>());
+
+    data->clear();
+    data->reserve(int(rawSize));
+    while (!file.atEnd()) {
+        char length[4];
+        if (file.read(length, sizeof(length)) != qint64(sizeof(length))) {
+            break;
+        }
+        const quint32 packedSize = qFromLittleEndian<quint32>(length);
+        const QByteArray packed = file.read(packedSize);
+        const QByteArray chunk = packed.size() == int(packedSize) ? qUncompress(packed) : QByteArray();
+        if (chunk.isEmpty()) {
+            break;   // 截断或损坏：保留已解压的部分，读取端按块头扫描恢复
+        }
+        data->append(chunk);
+    }
+    if (data->size() != rawSize) {
+        qDebug() << "[SessionLog] Compressed log truncated:" << filePath << data->size() << "of" << rawSize << "bytes";
+    }
+    if (data->isEmpty()) {
+        *error = QString("%1 解压失败").arg(filePath);
+        return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// SessionLogWriter
+
+SessionLogWriter::SessionLogWriter()
+    : m_rowsPerBlock(256)
+    , m_rowsWritten(0)
+    , m_bytesWritten(0)
+    , m_blockRows(0)
+    , m_outputLimit(1 << 20)
+{
+}
+
+SessionLogWriter::~SessionLogWriter()
+{
+    close();
+}
+
+bool SessionLogWriter::open(const QString &filePath, const QVector<SessionLog::Column> &columns,
+                            const QString &description, int rowsPerBlock)
+{
+    close();
+    m_error.clear();
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_error = QString("无法创建会话日志 %1: %2").arg(filePath, m_file.errorString());
+        return false;
+    }
+
+    m_columns = columns;
+    m_rowsPerBlock = qMax(1, rowsPerBlock);
+    m_rowsWritten = 0;
+    m_bytesWritten = 0;
+    m_blockRows = 0;
+    m_index.clear();
+
+    // 预分配当前数据块，追加行时不再分配内存
+    const size_t columnCount = size_t(m_columns.size());
+    const size_t rows = size_t(m_rowsPerBlock);
+    m_timestamps.assign(rows, 0.0);
+    m_indices.assign(rows, 0);
+    m_flags.assign(rows, 0);
+    m_values.assign(columnCount * rows, 0.0);
+    m_validBits.assign(columnCount * ((rows + 7) / 8), 0);
+    m_current.minimum.assign(columnCount, NaN);
+    m_current.maximum.assign(columnCount, NaN);
+    m_output.resize(0);
+    m_output.reserve(int(m_outputLimit + BlockHeaderBytes + blockBodyBytes(m_rowsPerBlock, int(columnCount))));
+
+    QByteArray header;
+    header.append(FileMagic, sizeof(FileMagic));
+    appendLE<quint32>(header, FileVersion);
+    appendLE<quint32>(header, 0);                        // 文件头长度，稍后填写
+    appendLE<quint32>(header, quint32(m_rowsPerBlock));
+    appendLE<quint32>(header, quint32(columnCount));
+    appendLE<qint64>(header, QDateTime::currentMSecsSinceEpoch());
+    appendLE<quint64>(header, 0);                        // 块索引偏移（关闭时回填）
+    appendLE<quint32>(header, 0);                        // 块数（关闭时回填）
+    appendLE<quint64>(header, 0);                        // 总行数（关闭时回填）
+    appendString(header, description);
+    for (const SessionLog::Column &column : m_columns) {
+        appendLE<quint8>(header, quint8(column.kind));
+        appendLE<qint32>(header, column.channel);
+        appendString(header, column.name);
+        appendString(header, column.unit);
+        appendF64(header, column.calibration.a);
+        appendF64(header, column.calibration.b);
+        appendF64(header, column.calibration.c);
+        appendF64(header, column.calibration.d);
+    }
+    const quint32 headerSize = qToLittleEndian(quint32(header.size()));
+    std::memcpy(header.data() + 12, &headerSize, sizeof(headerSize));
+
+    // 文件头立即写出，异常退出时读取端仍能按块头扫描恢复
+    if (!writeAll(header) || !writeOutput()) {
+        m_file.close();
+        return false;
+    }
+    return true;
+}
+
+double SessionLogWriter::columnValue(const SessionLog::Column &column, const DataSnapshot &snapshot, bool *valid) const
+{
+    const auto pick = [&](bool sourceValid, const QVector<double> &values) {
+        *valid = sourceValid && column.channel < values.size();
+        return *valid ? values[column.channel] : NaN;
+    };
+    switch (column.kind) {
+    case SessionLog::ModbusValue: return pick(snapshot.modbusValid, snapshot.modbusData);
+    case SessionLog::DAQValue: return pick(snapshot.daqValid, snapshot.daqData);
+    case SessionLog::DAQMin: return pick(snapshot.daqValid, snapshot.daqMin);
+    case SessionLog::DAQMax: return pick(snapshot.daqValid, snapshot.daqMax);
+    case SessionLog::DAQMean: return pick(snapshot.daqValid, snapshot.daqMean);
+    case SessionLog::DAQRms: return pick(snapshot.daqValid, snapshot.daqRms);
+    case SessionLog::ECUValue: return pick(snapshot.ecuValid, snapshot.ecuData);
+    case SessionLog::CustomValue:
+        return pick(column.channel < snapshot.customValid.size() && snapshot.customValid[column.channel], snapshot.customData);
+    }
+    *valid = false;
+    return NaN;
+}
+
+bool SessionLogWriter::appendSnapshot(const DataSnapshot &snapshot)
+{
+    if (!m_file.isOpen()) {
+        return false;
+    }
+
+    const int row = m_blockRows;
+    const size_t rows = size_t(m_rowsPerBlock);
+    const size_t bitmapStride = (rows + 7) / 8;
+    if (row == 0) {
+        m_current.firstRow = m_rowsWritten;
+        m_current.firstTime = snapshot.timestamp;
+        std::fill(m_current.minimum.begin(), m_current.minimum.end(), NaN);
+        std::fill(m_current.maximum.begin(), m_current.maximum.end(), NaN);
+        std::fill(m_validBits.begin(), m_validBits.end(), quint8(0));
+    }
+
+    m_timestamps[size_t(row)] = snapshot.timestamp;
+    m_indices[size_t(row)] = snapshot.snapshotIndex;
+    m_flags[size_t(row)] = quint8((snapshot.modbusValid ? SessionLog::ModbusValidFlag : 0)
+                                  | (snapshot.daqValid ? SessionLog::DAQValidFlag : 0)
+                                  | (snapshot.daqRunning ? SessionLog::DAQRunningFlag : 0)
+                                  | (snapshot.ecuValid ? SessionLog::ECUValidFlag : 0));
+
+    for (int c = 0; c < m_columns.size(); ++c) {
+        bool valid = false;
+        const double value = columnValue(m_columns[c], snapshot, &valid);
+        m_values[size_t(c) * rows + size_t(row)] = value;
+        if (valid) {
+            m_validBits[size_t(c) * bitmapStride + size_t(row / 8)] |= quint8(1u << (row % 8));
+            double &lo = m_current.minimum[size_t(c)];
+            double &hi = m_current.maximum[size_t(c)];
+            if (std::isnan(lo) || value < lo) {
+                lo = value;
+            }
+            if (std::isnan(hi) || value > hi) {
+                hi = value;
+            }
+        }
+    }
+
+    m_current.lastTime = snapshot.timestamp;
+    ++m_blockRows;
+    ++m_rowsWritten;
+    if (m_blockRows >= m_rowsPerBlock) {
+        return writeBlock();
+    }
+    return true;
+}
+
+void SessionLogWriter::setOutputBufferBytes(qint64 bytes)
+{
+    m_outputLimit = qBound<qint64>(0, bytes, 64 << 20);
+}
+
+bool SessionLogWriter::flush()
+{
+    if (!m_file.isOpen()) {
+        return false;
+    }
+    if (m_blockRows > 0 && !writeBlock()) {
+        return false;
+    }
+    if (!writeOutput()) {
+        return false;
+    }
+    m_file.flush();
+    return true;
+}
+
+bool SessionLogWriter::flushOutput()
+{
+    if (!m_file.isOpen()) {
+        return false;
+    }
+    if (!writeOutput()) {
+        return false;
+    }
+    m_file.flush();
+    return true;
+}
+
+bool SessionLogWriter::writeBlock()
+{
+    const int rows = m_blockRows;
+    const int columns = int(m_columns.size());
+    const size_t stride = size_t(m_rowsPerBlock);
+    const size_t bitmapStride = (stride + 7) / 8;
+    const int bitmapBytes = (rows + 7) / 8;
+
+    // 直接序列化到写出缓冲区末尾
+    const int start = m_output.size();
+    appendLE<quint32>(m_output, BlockMagic);
+    appendLE<quint32>(m_output, quint32(rows));
+    appendLE<quint64>(m_output, quint64(m_current.firstRow));
+    appendArray(m_output, m_timestamps.data(), rows);
+    appendArray(m_output, m_indices.data(), rows);
+    appendArray(m_output, m_flags.data(), rows);
+    for (int c = 0; c < columns; ++c) {
+        appendArray(m_output, m_validBits.data() + size_t(c) * bitmapStride, bitmapBytes);
+    }
+    for (int c = 0; c < columns; ++c) {
+        appendArray(m_output, m_values.data() + size_t(c) * stride, rows);
+    }
+
+    m_current.fileOffset = m_bytesWritten;
+    m_current.rowCount = rows;
+    m_blockRows = 0;
+    m_bytesWritten += m_output.size() - start;
+    m_index.push_back(m_current);
+    return m_output.size() >= m_outputLimit ? writeOutput() : true;
+}
+
+bool SessionLogWriter::writeAll(const QByteArray &data)
+{
+    m_output.append(data);
+    m_bytesWritten += data.size();
+    return m_output.size() >= m_outputLimit ? writeOutput() : true;
+}
+
+bool SessionLogWriter::writeOutput()
+{
+    if (m_output.isEmpty()) {
+        return true;
+    }
+    const bool ok = m_file.write(m_output) == m_output.size();
+    if (!ok) {
+        m_error = QString("写入会话日志失败: %1").arg(m_file.errorString());
+    }
+    m_output.resize(0);   // 保留容量，下次复用
+    return ok;
+}
+
+void SessionLogWriter::close()
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+    if (m_blockRows > 0) {
+        writeBlock();
+    }
+
+    // 块索引
+    const qint64 indexOffset = m_bytesWritten;
+    QByteArray index;
+    appendLE<quint32>(index, IndexMagic);
+    appendLE<quint32>(index, quint32(m_index.size()));
+    for (const SessionLog::BlockInfo &info : m_index) {
+        appendLE<quint64>(index, quint64(info.fileOffset));
+        appendLE<quint64>(index, quint64(info.firstRow));
+        appendLE<quint32>(index, quint32(info.rowCount));
+        appendF64(index, info.firstTime);
+        appendF64(index, info.lastTime);
+        for (size_t c = 0; c < info.minimum.size(); ++c) {
+            appendF64(index, info.minimum[c]);
+            appendF64(index, info.maximum[c]);
+        }
+    }
+
+    if (writeAll(index) && writeOutput()) {
+        QByteArray patch;
+        appendLE<quint64>(patch, quint64(indexOffset));
+        appendLE<quint32>(patch, quint32(m_index.size()));
+        appendLE<quint64>(patch, quint64(m_rowsWritten));
+        if (m_file.seek(HeaderPatchOffset)) {
+            m_file.write(patch);
+        }
+    }
+    m_output.resize(0);
+    m_file.close();
+    m_index.clear();
+}
+
+// ---------------------------------------------------------------------------
+// SessionLogReader
+
+SessionLogReader::SessionLogReader()
+    : m_startTimeMs(0)
+    , m_rowCount(0)
+    , m_rowsPerBlock(0)
+    , m_headerBytes(0)
+    , m_complete(false)
+{
+}
+
+bool SessionLogReader::open(const QString &filePath)
+{
+    close();
+    if (SessionLog::isCompressedFile(filePath)) {
+        QByteArray data;
+        if (!SessionLog::decompressFile(filePath, &data, &m_error)) {
+            return false;
+        }
+        return openData(data);
+    }
+    auto file = std::make_unique<QFile>(filePath);
+    if (!file->open(QIODevice::ReadOnly)) {
+        m_error = QString("无法打开会话日志 %1: %2").arg(filePath, file->errorString());
+        return false;
+    }
+    m_device = std::move(file);
+    return parse();
+}
+
+bool SessionLogReader::openData(const QByteArray &data)
+{
+    close();
+    auto buffer = std::make_unique<QBuffer>();
+    buffer->setData(data);
+    buffer->open(QIODevice::ReadOnly);
+    m_device = std::move(buffer);
+    return parse();
+}
+
+void SessionLogReader::close()
+{
+    m_device.reset();
+    m_error.clear();
+    m_columns.clear();
+    m_description.clear();
+    m_startTimeMs = 0;
+    m_rowCount = 0;
+    m_rowsPerBlock = 0;
+    m_headerBytes = 0;
+    m_complete = false;
+    m_index.clear();
+}
+
+bool SessionLogReader::readExact(char *data, qint64 size)
+{
+    return m_device && m_device->read(data, size) == size;
+}
+
+bool SessionLogReader::parse()
+{
+    if (!readHeader()) {
+        m_device.reset();
+        return false;
+    }
+    return true;
+}
+
+bool SessionLogReader::readHeader()
+{
+    char fixed[52];
+    if (!readExact(fixed, sizeof(fixed)) || std::memcmp(fixed, FileMagic, sizeof(FileMagic)) != 0) {
+        m_error = "不是会话日志文件";
+        return false;
+    }
+    FieldReader fields(fixed + 8, sizeof(fixed) - 8);
+    const quint32 version = fields.read<quint32>();
+    const quint32 headerBytes = fields.read<quint32>();
+    m_rowsPerBlock = fields.read<quint32>();
+    const quint32 columnCount = fields.read<quint32>();
+    m_startTimeMs = fields.read<qint64>();
+    const quint64 indexOffset = fields.read<quint64>();
+    const quint32 blockCount = fields.read<quint32>();
+    m_rowCount = qint64(fields.read<quint64>());
+    if (version != FileVersion || headerBytes < sizeof(fixed)) {
+        m_error = QString("不支持的会话日志版本 %1").arg(version);
+        return false;
+    }
+
+    QByteArray rest(int(headerBytes - sizeof(fixed)), Qt::Uninitialized);
+    if (!readExact(rest.data(), rest.size())) {
+        m_error = "会话日志文件头不完整";
+        return false;
+    }
+    FieldReader reader(rest.constData(), rest.size());
+    m_description = reader.readString();
+    for (quint32 i = 0; i < columnCount && reader.ok(); ++i) {
+        SessionLog::Column column;
+        column.kind = SessionLog::ColumnKind(reader.read<quint8>());
+        column.channel = reader.read<qint32>();
+        column.name = reader.readString();
+        column.unit = reader.readString();
+        column.calibration.a = reader.readF64();
+        column.calibration.b = reader.readF64();
+        column.calibration.c = reader.readF64();
+        column.calibration.d = reader.readF64();
+        m_columns.append(column);
+    }
+    if (!reader.ok()) {
+        m_error = "会话日志列定义损坏";
+        return false;
+    }
+    m_headerBytes = headerBytes;
+
+    if (indexOffset > 0 && readIndex(qint64(indexOffset), blockCount)) {
+        m_complete = true;
+        return true;
+    }
+    // 没有正常关闭：按块头顺序扫描恢复块索引
+    qDebug() << "[SessionLogReader] Index missing, scanning blocks";
+    m_complete = false;
+    return scanBlocks(m_headerBytes);
+}
+
+bool SessionLogReader::readIndex(qint64 offset, quint32 count)
+{
+    const int columns = int(m_columns.size());
+    const qint64 entryBytes = 8 + 8 + 4 + 8 + 8 + qint64(columns) * 16;
+    QByteArray data(int(8 + qint64(count) * entryBytes), Qt::Uninitialized);
+    if (!m_device->seek(offset) || !readExact(data.data(), data.size())) {
+        return false;
+    }
+    FieldReader reader(data.constData(), data.size());
+    if (reader.read<quint32>() != IndexMagic || reader.read<quint32>() != count) {
+        return false;
+    }
+    m_index.resize(count);
+    for (SessionLog::BlockInfo &info : m_index) {
+        info.fileOffset = qint64(reader.read<quint64>());
+        info.firstRow = qint64(reader.read<quint64>());
+        info.rowCount = int(reader.read<quint32>());
+        info.firstTime = reader.readF64();
+        info.lastTime = reader.readF64();
+        info.minimum.resize(size_t(columns));
+        info.maximum.resize(size_t(columns));
+        for (int c = 0; c < columns; ++c) {
+            info.minimum[size_t(c)] = reader.readF64();
+            info.maximum[size_t(c)] = reader.readF64();
+        }
+    }
+    return reader.ok();
+}
+
+bool SessionLogReader::scanBlocks(qint64 offset)
+{
+    m_index.clear();
+    m_rowCount = 0;
+    const int columns = int(m_columns.size());
+    SessionLog::Block block;
+    while (m_device->seek(offset)) {
+        char header[BlockHeaderBytes];
+        if (!readExact(header, sizeof(header))) {
+            break;
+        }
+        FieldReader fields(header, sizeof(header));
+        if (fields.read<quint32>() != BlockMagic) {
+            break;
+        }
+        const int rows = int(fields.read<quint32>());
+        const qint64 size = BlockHeaderBytes + blockBodyBytes(rows, columns);
+        if (rows <= 0 || m_device->size() - offset < size) {
+            break;   // 最后一个数据块未写完
+        }
+
+        SessionLog::BlockInfo info;
+        info.fileOffset = offset;
+        info.rowCount = rows;
+        m_index.push_back(info);
+        if (!readBlock(int(m_index.size()) - 1, &block)) {
+            m_index.pop_back();
+            break;
+        }
+
+        SessionLog::BlockInfo &entry = m_index.back();
+        entry.firstRow = block.firstRow;
+        entry.firstTime = block.timestamps.front();
+        entry.lastTime = block.timestamps.back();
+        entry.minimum.assign(size_t(columns), NaN);
+        entry.maximum.assign(size_t(columns), NaN);
+        for (int c = 0; c < columns; ++c) {
+            for (int r = 0; r < rows; ++r) {
+                if (!block.isValid(c, r)) {
+                    continue;
+                }
+                const double value = block.value(c, r);
+                if (std::isnan(entry.minimum[size_t(c)]) || value < entry.minimum[size_t(c)]) {
+                    entry.minimum[size_t(c)] = value;
+                }
+                if (std::isnan(entry.maximum[size_t(c)]) || value > entry.maximum[size_t(c)]) {
+                    entry.maximum[size_t(c)] = value;
+                }
+            }
+        }
+        m_rowCount += rows;
+        offset += size;
+    }
+    return true;
+}
+
+int SessionLogReader::findBlock(double time) const
+{
+    if (m_index.empty()) {
+        return -1;
+    }
+    const auto it = std::lower_bound(m_index.begin(), m_index.end(), time,
+                                     [](const SessionLog::BlockInfo &info, double t) { return info.lastTime < t; });
+    return it == m_index.end() ? int(m_index.size()) - 1 : int(it - m_index.begin());
+}
+
+bool SessionLogReader::readBlock(int block, SessionLog::Block *out)
+{
+    if (!m_device || !out || block < 0 || block >= int(m_index.size())) {
+        m_error = "数据块序号无效";
+        return false;
+    }
+    const SessionLog::BlockInfo &info = m_index[size_t(block)];
+    const int columns = int(m_columns.size());
+
+    char header[BlockHeaderBytes];
+    if (!m_device->seek(info.fileOffset) || !readExact(header, sizeof(header))) {
+        m_error = "读取数据块失败";
+        return false;
+    }
+    FieldReader fields(header, sizeof(header));
+    const quint32 magic = fields.read<quint32>();
+    const int rows = int(fields.read<quint32>());
+    const qint64 firstRow = qint64(fields.read<quint64>());
+    if (magic != BlockMagic || rows != info.rowCount) {
+        m_error = "数据块损坏";
+        return false;
+    }
+
+    QByteArray body(int(blockBodyBytes(rows, columns)), Qt::Uninitialized);
+    if (!readExact(body.data(), body.size())) {
+        m_error = "数据块不完整";
+        return false;
+    }
+
+    out->firstRow = firstRow;
+    out->rowCount = rows;
+    out->timestamps.resize(size_t(rows));
+    out->snapshotIndices.resize(size_t(rows));
+    out->flags.resize(size_t(rows));
+    out->validBits.resize(size_t(columns) * size_t(out->bitmapBytes()));
+    out->values.resize(size_t(columns) * size_t(rows));
+
+    const char *src = body.constData();
+    readArray(src, out->timestamps.data(), rows);
+    src += qsizetype(rows) * 8;
+    readArray(src, out->snapshotIndices.data(), rows);
+    src += qsizetype(rows) * 4;
+    readArray(src, out->flags.data(), rows);
+    src += rows;
+    readArray(src, out->validBits.data(), int(out->validBits.size()));
+    src += qsizetype(out->validBits.size());
+    readArray(src, out->values.data(), int(out->values.size()));
+    return true;
+}
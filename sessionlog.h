@@ -0,0 +1,208 @@
+#ifndef SESSIONLOG_H
+#define SESSIONLOG_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include <vector>
+#include "calibrationtable.h"
+#include "datasnapshot.h"
+
+// 二进制列式会话日志（*.slog）
+//
+// 替代逐行CSV文本记录：快照按行追加到内存中的列式数据块，数据块写满后整体写出，
+// 每行不分配内存、不做数值到文本的转换。文件格式（小端）：
+//   文件头：magic "SESSLOG1"、版本、文件头长度、每块行数、列数、开始时间（ms since epoch）、
+//          块索引偏移、块数、总行数（后三项关闭时回填）、说明文字（UTF-8），
+//          每列：列类型、通道号、名称、单位（UTF-8）、校准系数a/b/c/d（记录值已校准）
+//   数据块：magic "SBLK"、行数、第一行的行号，随后依次为
+//          时间戳（f64 × 行数）、快照序号（i32 × 行数）、状态标志（u8 × 行数），
+//          每列的有效位图（每列 ceil(行数/8) 字节，第i行对应第i位），
+//          每列的值（f64 × 行数，定宽；无效值为NaN）
+//   块索引：magic "SIDX"、块数，每块（文件偏移、第一行行号、行数、首末时间戳、每列最小值与最大值）
+// 块索引在关闭时写入；异常退出时块索引偏移为0，读取端按块头顺序扫描恢复。
+namespace SessionLog {
+
+// 列的数据来源
+enum ColumnKind : quint8 {
+    ModbusValue = 1,
+    DAQValue = 2,
+    DAQMin = 3,
+    DAQMax = 4,
+    DAQMean = 5,
+    DAQRms = 6,
+    ECUValue = 7,
+    CustomValue = 8
+};
+
+// 行状态标志
+enum RowFlag : quint8 {
+    ModbusValidFlag = 0x01,
+    DAQValidFlag = 0x02,
+    DAQRunningFlag = 0x04,
+    ECUValidFlag = 0x08
+};
+
+struct Column {
+    ColumnKind kind = ModbusValue;
+    qint32 channel = 0;
+    QString name;
+    QString unit;
+    CalibrationParams calibration;
+};
+
+// 按快照布局生成列定义：Modbus、DAQ、DAQ窗口统计（Min/Max/Mean/RMS）、ECU（9个）、派生通道（customNames的个数，
+// 名称为空时为Custom_n），与原CSV的列顺序一致
+QVector<Column> snapshotColumns(int modbusChannels, int daqChannels, const QStringList &customNames,
+                                const QStringList &customUnits, const CalibrationTable &calibration);
+
+// 块索引项
+struct BlockInfo {
+    qint64 fileOffset = 0;
+    qint64 firstRow = 0;
+    int rowCount = 0;
+    double firstTime = 0.0;
+    double lastTime = 0.0;
+    std::vector<double> minimum;   // 每列有效值的最小值，没有有效值时为NaN
+    std::vector<double> maximum;
+};
+
+// 读出的一个数据块
+struct Block {
+    qint64 firstRow = 0;
+    int rowCount = 0;
+    std::vector<double> timestamps;
+    std::vector<qint32> snapshotIndices;
+    std::vector<quint8> flags;
+    std::vector<quint8> validBits;   // [列][ceil(行数/8)]
+    std::vector<double> values;      // [列][行]
+
+    int bitmapBytes() const { return (rowCount + 7) / 8; }
+    bool isValid(int column, int row) const
+    {
+        return (validBits[size_t(column) * size_t(bitmapBytes()) + size_t(row / 8)] >> (row % 8)) & 1;
+    }
+    double value(int column, int row) const { return values[size_t(column) * size_t(rowCount) + size_t(row)]; }
+};
+
+// 压缩的会话日志（*.slog.z）：magic "SLOGZ1\0\0"、分段大小、原始字节数，
+// 随后为若干压缩段（压缩长度u32 + qCompress数据），逐段压缩/解压，内存占用与分段大小相当
+bool compressFile(const QString &sourcePath, const QString &targetPath, int level, QString *error);
+bool isCompressedFile(const QString &filePath);
+bool decompressFile(const QString &filePath, QByteArray *data, QString *error);
+
+} // namespace SessionLog
+
+// 会话日志写入器（单线程使用）
+class SessionLogWriter
+{
+public:
+    SessionLogWriter();
+    ~SessionLogWriter();
+
+    SessionLogWriter(const SessionLogWriter &) = delete;
+    SessionLogWriter &operator=(const SessionLogWriter &) = delete;
+
+    // 创建文件并写入文件头。rowsPerBlock为每个数据块的行数
+    bool open(const QString &filePath, const QVector<SessionLog::Column> &columns,
+              const QString &description, int rowsPerBlock = 256);
+    bool isOpen() const { return m_file.isOpen(); }
+    QString filePath() const { return m_file.fileName(); }
+    QString errorString() const { return m_error; }
+
+    // 写出缓冲区大小（默认1MB）：数据块先序列化到缓冲区，累计到该大小时一次写入文件，0为每块写入
+    void setOutputBufferBytes(qint64 bytes);
+
+    // 追加一行（按列定义取快照中的值）；数据块写满时序列化到写出缓冲区
+    bool appendSnapshot(const DataSnapshot &snapshot);
+    // 结束未满的数据块，把写出缓冲区写入文件并刷新
+    bool flush();
+    // 只把写出缓冲区中已完成的数据块写入文件并刷新，未满的数据块继续累积（周期性刷新用，不产生短块）
+    bool flushOutput();
+    // 写出剩余数据、块索引并回填文件头，关闭文件
+    void close();
+
+    int columnCount() const { return int(m_columns.size()); }
+    qint64 rowsWritten() const { return m_rowsWritten; }
+    // 文件总字节数（含尚在写出缓冲区中的部分）
+    qint64 bytesWritten() const { return m_bytesWritten; }
+    qint64 pendingBytes() const { return m_output.size(); }
+    // 当前未满的数据块中的行数（尚未序列化）
+    int pendingRows() const { return m_blockRows; }
+
+private:
+    bool writeBlock();
+    bool writeAll(const QByteArray &data);
+    bool writeOutput();
+    double columnValue(const SessionLog::Column &column, const DataSnapshot &snapshot, bool *valid) const;
+
+    QFile m_file;
+    QString m_error;
+    QVector<SessionLog::Column> m_columns;
+    int m_rowsPerBlock;
+    qint64 m_rowsWritten;         // 已写出和缓冲中的总行数
+    qint64 m_bytesWritten;
+
+    // 当前数据块（列优先，容量m_rowsPerBlock行）
+    int m_blockRows;
+    std::vector<double> m_timestamps;
+    std::vector<qint32> m_indices;
+    std::vector<quint8> m_flags;
+    std::vector<double> m_values;
+    std::vector<quint8> m_validBits;
+    SessionLog::BlockInfo m_current;
+
+    QByteArray m_output;          // 写出缓冲区（复用，保留容量）
+    qint64 m_outputLimit;
+
+    std::vector<SessionLog::BlockInfo> m_index;
+};
+
+// 会话日志读取器：打开时只读取文件头和块索引，数据块按需读取（流式）
+class SessionLogReader
+{
+public:
+    SessionLogReader();
+
+    // 打开文件（压缩的日志先解压到内存）；data版本用于已在内存中的日志
+    bool open(const QString &filePath);
+    bool openData(const QByteArray &data);
+    void close();
+    QString errorString() const { return m_error; }
+
+    const QVector<SessionLog::Column> &columns() const { return m_columns; }
+    QString description() const { return m_description; }
+    qint64 startTimeMs() const { return m_startTimeMs; }
+    qint64 rowCount() const { return m_rowCount; }
+    // 文件是否正常关闭（有块索引）；否则块索引由扫描恢复
+    bool isComplete() const { return m_complete; }
+
+    int blockCount() const { return int(m_index.size()); }
+    const SessionLog::BlockInfo &blockInfo(int block) const { return m_index[size_t(block)]; }
+    // 包含时刻time的数据块（time在两块之间时返回后一块，晚于全部数据时返回最后一块），没有数据时返回-1
+    int findBlock(double time) const;
+    // 读取一个数据块
+    bool readBlock(int block, SessionLog::Block *out);
+
+private:
+    bool parse();
+    bool readHeader();
+    bool readIndex(qint64 offset, quint32 count);
+    bool scanBlocks(qint64 offset);
+    bool readExact(char *data, qint64 size);
+
+    std::unique_ptr<QIODevice> m_device;
+    QString m_error;
+    QVector<SessionLog::Column> m_columns;
+    QString m_description;
+    qint64 m_startTimeMs;
+    qint64 m_rowCount;
+    quint32 m_rowsPerBlock;
+    qint64 m_headerBytes;
+    bool m_complete;
+    std::vector<SessionLog::BlockInfo> m_index;
+};
+
+#endif // SESSIONLOG_H
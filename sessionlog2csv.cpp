@@ -0,0 +1,236 @@
+// 会话日志（*.slog、*.slog.z或分段会话目录）导出为CSV
+//
+// 输出与原快照CSV日志相同的列：Timestamp、SnapshotIndex、各有效标志、Modbus、DAQ、DAQ窗口统计、ECU、自定义，
+// 无效值为空。数据块按需读取，只导出与时间范围相交的数据块；会话目录按清单顺序导出各分段，
+// 并跳过时间范围之外的分段（压缩的分段逐个解压到内存）。
+//
+// 示例：sessionlog2csv 20250330_101500 -o run.csv
+//       sessionlog2csv 20250330_101500/segment_0003.slog.z --from 120 --to 180 --columns DAQ_0,DAQ_0_RMS
+#include "sessionlog.h"
+#include "sessionmanifest.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <cmath>
+#include <limits>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("sessionlog2csv");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("把二进制会话日志导出为CSV");
+    parser.addHelpOption();
+    parser.addPositionalArgument("input", "会话日志文件（*.slog、*.slog.z）或会话目录");
+    QCommandLineOption outputOption({"o", "output"}, "输出CSV文件（默认与输入同名，扩展名为.csv；\"-\"为标准输出）", "file");
+    QCommandLineOption fromOption("from", "起始时间戳（秒，含）", "s");
+    QCommandLineOption toOption("to", "结束时间戳（秒，含）", "s");
+    QCommandLineOption columnsOption("columns", "只导出指定的列（逗号分隔的列名）", "names");
+    QCommandLineOption infoOption("info", "只显示文件信息和列定义");
+    parser.addOptions({outputOption, fromOption, toOption, columnsOption, infoOption});
+    parser.process(app);
+
+    const QStringList positional = parser.positionalArguments();
+    if (positional.size() != 1) {
+        parser.showHelp(1);
+    }
+    const QString inputPath = positional.first();
+
+    // 输入为会话目录（或其中的manifest.json）时按清单导出全部分段
+    QFileInfo inputInfo(inputPath);
+    const QString sessionDirectory = inputInfo.isDir() ? inputInfo.filePath()
+                                     : inputInfo.fileName() == SessionManifest::FileName ? inputInfo.path()
+                                                                                         : QString();
+    SessionManifest manifest;
+    QStringList segmentPaths;
+    if (!sessionDirectory.isEmpty()) {
+        QString error;
+        if (!manifest.load(sessionDirectory, &error)) {
+            qCritical().noquote() << "错误:" << error;
+            return 1;
+        }
+        for (const SessionSegment &segment : manifest.segments) {
+            segmentPaths.append(QDir(sessionDirectory).filePath(segment.fileName));
+        }
+        if (segmentPaths.isEmpty()) {
+            qCritical().noquote() << "错误: 会话中没有分段";
+            return 1;
+        }
+    } else {
+        segmentPaths.append(inputPath);
+    }
+
+    SessionLogReader reader;
+    if (!reader.open(segmentPaths.first())) {
+        qCritical().noquote() << "错误:" << reader.errorString();
+        return 1;
+    }
+    const QVector<SessionLog::Column> columns = reader.columns();
+
+    if (parser.isSet(infoOption)) {
+        QTextStream out(stdout);
+        if (!sessionDirectory.isEmpty()) {
+            out << "会话: " << manifest.description << (manifest.complete ? "" : "（未正常结束）") << "\n";
+            out << "分段: " << manifest.segments.size() << "，行数: " << manifest.totalRows()
+                << "，未压缩 " << QString::number(manifest.rawBytes() / 1e6, 'f', 1) << " MB，磁盘占用 "
+                << QString::number(manifest.storedBytes() / 1e6, 'f', 1) << " MB\n";
+            for (const SessionSegment &segment : manifest.segments) {
+                if (!segment.closed) {
+                    out << "  " << segment.fileName << "  未关闭（正在写入或未正常结束）\n";
+                    continue;
+                }
+                out << "  " << segment.fileName << "  " << QString::number(segment.firstTime, 'f', 3) << " - "
+                    << QString::number(segment.lastTime, 'f', 3) << " s，" << segment.rowCount << " 行，"
+                    << QString::number(segment.storedBytes / 1e6, 'f', 2) << " MB\n";
+            }
+        }
+        out << "说明: " << reader.description() << "\n";
+        out << "开始时间: " << QDateTime::fromMSecsSinceEpoch(reader.startTimeMs()).toString(Qt::ISODateWithMs) << "\n";
+        out << "行数: " << reader.rowCount() << "，数据块: " << reader.blockCount()
+            << (reader.isComplete() ? "" : "（未正常关闭，块索引由扫描恢复）") << "\n";
+        if (reader.blockCount() > 0) {
+            out << "时间范围: " << QString::number(reader.blockInfo(0).firstTime, 'f', 6) << " - "
+                << QString::number(reader.blockInfo(reader.blockCount() - 1).lastTime, 'f', 6) << " s\n";
+        }
+        for (const SessionLog::Column &column : columns) {
+            out << column.name << (column.unit.isEmpty() ? QString() : QString(" [%1]").arg(column.unit))
+                << "  校准 a=" << column.calibration.a << " b=" << column.calibration.b
+                << " c=" << column.calibration.c << " d=" << column.calibration.d << "\n";
+        }
+        return 0;
+    }
+
+    // 选择导出的列
+    QVector<int> selected;
+    if (parser.isSet(columnsOption)) {
+        for (const QString &name : parser.value(columnsOption).split(',', Qt::SkipEmptyParts)) {
+            int found = -1;
+            for (int c = 0; c < columns.size(); ++c) {
+                if (columns[c].name == name.trimmed()) {
+                    found = c;
+                    break;
+                }
+            }
+            if (found < 0) {
+                qCritical().noquote() << "错误: 没有名为" << name << "的列";
+                return 1;
+            }
+            selected.append(found);
+        }
+    } else {
+        for (int c = 0; c < columns.size(); ++c) {
+            selected.append(c);
+        }
+    }
+
+    const double from = parser.isSet(fromOption) ? parser.value(fromOption).toDouble()
+                                                 : -std::numeric_limits<double>::infinity();
+    const double to = parser.isSet(toOption) ? parser.value(toOption).toDouble()
+                                             : std::numeric_limits<double>::infinity();
+
+    QString outputPath = parser.value(outputOption);
+    if (outputPath.isEmpty()) {
+        QString base = sessionDirectory.isEmpty() ? inputPath : QDir::cleanPath(sessionDirectory);
+        for (const QString &suffix : {QString(".z"), QString(".slog")}) {
+            if (base.endsWith(suffix)) {
+                base.chop(suffix.size());
+            }
+        }
+        outputPath = base + ".csv";
+    }
+    const bool toStdout = outputPath == "-";
+    QFile outputFile(toStdout ? QString() : outputPath);
+    const bool opened = toStdout ? outputFile.open(stdout, QIODevice::WriteOnly)
+                                 : outputFile.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    if (!opened) {
+        qCritical().noquote() << "错误: 无法创建" << outputPath << outputFile.errorString();
+        return 1;
+    }
+    QTextStream out(&outputFile);
+
+    QStringList header = {"Timestamp", "SnapshotIndex", "ModbusValid", "DAQValid", "DAQRunning", "ECUValid"};
+    for (int c : selected) {
+        header << columns[c].name;
+    }
+    out << header.join(",") << "\n";
+
+    // 每类列的小数位数与原CSV日志一致
+    const auto precision = [](SessionLog::ColumnKind kind) {
+        switch (kind) {
+        case SessionLog::ModbusValue:
+        case SessionLog::CustomValue:
+            return 4;
+        case SessionLog::ECUValue:
+            return 2;
+        default:
+            return 6;
+        }
+    };
+
+    qint64 rowsExported = 0;
+    bool allComplete = true;
+    SessionLog::Block block;
+    for (int s = 0; s < segmentPaths.size(); ++s) {
+        // 清单中记录了已关闭分段的时间范围，范围之外的分段不打开；未关闭的分段没有时间范围，总是打开
+        if (!sessionDirectory.isEmpty()) {
+            const SessionSegment &segment = manifest.segments[s];
+            if (segment.closed && (segment.lastTime < from || segment.firstTime > to)) {
+                continue;
+            }
+        }
+        if (s > 0 && !reader.open(segmentPaths[s])) {
+            qCritical().noquote() << "错误:" << reader.errorString();
+            return 1;
+        }
+        if (reader.columns().size() != columns.size()) {
+            qCritical().noquote() << "错误:" << segmentPaths[s] << "的列定义与第一个分段不同";
+            return 1;
+        }
+        allComplete = allComplete && reader.isComplete();
+
+        const int firstBlock = std::isinf(from) ? 0 : reader.findBlock(from);
+        for (int b = qMax(0, firstBlock); b < reader.blockCount(); ++b) {
+            if (reader.blockInfo(b).firstTime > to) {
+                break;
+            }
+            if (!reader.readBlock(b, &block)) {
+                qCritical().noquote() << "错误:" << reader.errorString();
+                return 1;
+            }
+            for (int r = 0; r < block.rowCount; ++r) {
+                const double timestamp = block.timestamps[size_t(r)];
+                if (timestamp < from || timestamp > to) {
+                    continue;
+                }
+                const quint8 flags = block.flags[size_t(r)];
+                out << QString::number(timestamp, 'f', 6) << ',' << block.snapshotIndices[size_t(r)]
+                    << ',' << ((flags & SessionLog::ModbusValidFlag) ? '1' : '0')
+                    << ',' << ((flags & SessionLog::DAQValidFlag) ? '1' : '0')
+                    << ',' << ((flags & SessionLog::DAQRunningFlag) ? '1' : '0')
+                    << ',' << ((flags & SessionLog::ECUValidFlag) ? '1' : '0');
+                for (int c : selected) {
+                    out << ',';
+                    if (block.isValid(c, r)) {
+                        out << QString::number(block.value(c, r), 'f', precision(columns[c].kind));
+                    }
+                }
+                out << '\n';
+                ++rowsExported;
+            }
+        }
+    }
+    out.flush();
+
+    if (!toStdout) {
+        qInfo().noquote() << QString("导出 %1 行，%2 列到 %3%4")
+                                 .arg(rowsExported).arg(selected.size()).arg(outputPath)
+                                 .arg(allComplete ? "" : "（日志未正常关闭）");
+    }
+    return 0;
+}
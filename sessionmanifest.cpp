@@ -0,0 +1,120 @@
+#include "sessionmanifest.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+const char *SessionManifest::FileName = "manifest.json";
+
+qint64 SessionManifest::totalRows() const
+{
+    qint64 rows = 0;
+    for (const SessionSegment &segment : segments) {
+        rows += segment.rowCount;
+    }
+    return rows;
+}
+
+qint64 SessionManifest::rawBytes() const
+{
+    qint64 bytes = 0;
+    for (const SessionSegment &segment : segments) {
+        bytes += segment.rawBytes;
+    }
+    return bytes;
+}
+
+qint64 SessionManifest::storedBytes() const
+{
+    qint64 bytes = 0;
+    for (const SessionSegment &segment : segments) {
+        bytes += segment.storedBytes;
+    }
+    return bytes;
+}
+
+bool SessionManifest::save(const QString &directory, QString *error) const
+{
+    QJsonArray segmentArray;
+    for (const SessionSegment &segment : segments) {
+        QJsonObject item;
+        item["file"] = segment.fileName;
+        item["firstRow"] = double(segment.firstRow);
+        item["rows"] = double(segment.rowCount);
+        item["firstTime"] = segment.firstTime;
+        item["lastTime"] = segment.lastTime;
+        item["rawBytes"] = double(segment.rawBytes);
+        item["storedBytes"] = double(segment.storedBytes);
+        item["compressed"] = segment.compressed;
+        item["closed"] = segment.closed;
+        segmentArray.append(item);
+    }
+
+    QJsonObject root;
+    root["format"] = "SESSLOG1-segments";
+    root["version"] = 1;
+    root["description"] = description;
+    root["startTime"] = QDateTime::fromMSecsSinceEpoch(startTimeMs).toString(Qt::ISODateWithMs);
+    root["startTimeMs"] = double(startTimeMs);
+    root["segmentSeconds"] = segmentSeconds;
+    root["segmentBytes"] = double(segmentBytes);
+    root["compressionLevel"] = compressionLevel;
+    root["complete"] = complete;
+    root["totalRows"] = double(totalRows());
+    root["rawBytes"] = double(rawBytes());
+    root["storedBytes"] = double(storedBytes());
+    root["segments"] = segmentArray;
+
+    QSaveFile file(QDir(directory).filePath(FileName));
+    if (!file.open(QIODevice::WriteOnly)) {
+        *error = QString("无法写入清单 %1: %2").arg(file.fileName(), file.errorString());
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    if (!file.commit()) {
+        *error = QString("无法写入清单 %1: %2").arg(file.fileName(), file.errorString());
+        return false;
+    }
+    return true;
+}
+
+bool SessionManifest::load(const QString &directory, QString *error)
+{
+    QFile file(QDir(directory).filePath(FileName));
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = QString("无法打开清单 %1: %2").arg(file.fileName(), file.errorString());
+        return false;
+    }
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    const QJsonObject root = doc.object();
+    if (root.value("format").toString() != "SESSLOG1-segments") {
+        *error = QString("%1 不是会话日志清单").arg(file.fileName());
+        return false;
+    }
+
+    description = root.value("description").toString();
+    startTimeMs = qint64(root.value("startTimeMs").toDouble());
+    segmentSeconds = root.value("segmentSeconds").toDouble();
+    segmentBytes = qint64(root.value("segmentBytes").toDouble());
+    compressionLevel = root.value("compressionLevel").toInt();
+    complete = root.value("complete").toBool();
+    segments.clear();
+    for (const QJsonValue &value : root.value("segments").toArray()) {
+        const QJsonObject item = value.toObject();
+        SessionSegment segment;
+        segment.fileName = item.value("file").toString();
+        segment.firstRow = qint64(item.value("firstRow").toDouble());
+        segment.rowCount = qint64(item.value("rows").toDouble());
+        segment.firstTime = item.value("firstTime").toDouble();
+        segment.lastTime = item.value("lastTime").toDouble();
+        segment.rawBytes = qint64(item.value("rawBytes").toDouble());
+        segment.storedBytes = qint64(item.value("storedBytes").toDouble());
+        segment.compressed = item.value("compressed").toBool();
+        segment.closed = item.value("closed").toBool(true);
+        segments.append(segment);
+    }
+    return true;
+}
@@ -0,0 +1,44 @@
+#ifndef SESSIONMANIFEST_H
+#define SESSIONMANIFEST_H
+
+#include <QString>
+#include <QVector>
+
+// 分段会话日志的一个分段
+struct SessionSegment {
+    QString fileName;          // 相对会话目录的文件名（压缩完成后为*.slog.z）
+    qint64 firstRow = 0;       // 在整个会话中的第一行行号
+    qint64 rowCount = 0;
+    double firstTime = 0.0;
+    double lastTime = 0.0;
+    qint64 rawBytes = 0;       // 未压缩的文件大小
+    qint64 storedBytes = 0;    // 磁盘上的文件大小
+    bool compressed = false;
+    bool closed = true;        // 分段已关闭；为false时正在写入（或程序异常退出），行数、时间范围和大小尚未填写
+};
+
+// 分段会话日志的清单（会话目录下的manifest.json）
+//
+// 一次记录对应一个目录，按时长或大小切分为segment_0000.slog、segment_0001.slog……，
+// 每个分段关闭后在后台压缩为*.slog.z。清单在分段打开、关闭和压缩完成时整体重写（QSaveFile）；
+// 分段打开时即加入清单（closed为false），程序异常退出时正在写入的分段也在清单中，由读取时扫描恢复。
+struct SessionManifest {
+    static const char *FileName;
+
+    QString description;
+    qint64 startTimeMs = 0;
+    double segmentSeconds = 0.0;
+    qint64 segmentBytes = 0;
+    int compressionLevel = 0;
+    bool complete = false;     // 记录已正常结束（压缩可能仍在进行）
+    QVector<SessionSegment> segments;
+
+    qint64 totalRows() const;
+    qint64 rawBytes() const;
+    qint64 storedBytes() const;
+
+    bool save(const QString &directory, QString *error) const;
+    bool load(const QString &directory, QString *error);
+};
+
+#endif // SESSIONMANIFEST_H
@@ -0,0 +1,266 @@
+#include "simulateddaqdevice.h"
+#include <QDebug>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+
+// splitmix64：按样本序号随机访问的伪随机数
+std::uint64_t mix64(std::uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// 模拟的触发线：主设备开始时在终端上发布起始时刻，从设备等待后使用同一时刻
+struct TriggerBus {
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::map<std::string, std::chrono::steady_clock::time_point> fired;
+};
+
+TriggerBus &triggerBus()
+{
+    static TriggerBus bus;
+    return bus;
+}
+
+} // namespace
+
+SimulatedDAQDevice::SimulatedDAQDevice()
+    : m_realTime(true)
+    , m_samplesCallback(nullptr)
+    , m_doneCallback(nullptr)
+    , m_context(nullptr)
+    , m_running(false)
+    , m_generated(0)
+    , m_readPosition(0)
+{
+}
+
+SimulatedDAQDevice::~SimulatedDAQDevice()
+{
+    stop();
+}
+
+// 默认信号：按通道序号轮流使用正弦、扫频、噪声、阶跃，频率随通道号变化
+SimulatedDAQDevice::Signal SimulatedDAQDevice::defaultSignal(int index, int channel)
+{
+    Signal signal;
+    signal.waveform = Waveform(index % 4);
+    signal.amplitude = 1.0 + 0.5 * (channel % 8);
+    signal.frequency = 5.0 * (channel + 1);
+    signal.chirpEndFrequency = 500.0;
+    signal.chirpPeriod = 2.0;
+    return signal;
+}
+
+void SimulatedDAQDevice::setSignal(int index, const Signal &signal)
+{
+    if (index >= 0 && index < int(m_signals.size())) {
+        m_signals[size_t(index)] = signal;
+    }
+}
+
+void SimulatedDAQDevice::setRealTime(bool realTime)
+{
+    m_realTime = realTime;
+}
+
+bool SimulatedDAQDevice::configure(const DAQDeviceConfig &config)
+{
+    stop();
+    if (config.channels.isEmpty() || config.sampleRate <= 0.0 || config.samplesPerChannel <= 0
+        || config.rangeMax <= config.rangeMin) {
+        m_lastError = "模拟设备配置无效";
+        return false;
+    }
+
+    m_config = config;
+    m_signals.clear();
+    for (int i = 0; i < config.channels.size(); ++i) {
+        m_signals.push_back(defaultSignal(i, config.channels[i]));
+    }
+    qDebug() << "[SimulatedDAQDevice] 已配置:" << config.channels.size() << "个通道，采样率"
+             << config.sampleRate << "Hz，块大小" << config.samplesPerChannel;
+    return true;
+}
+
+bool SimulatedDAQDevice::start(SamplesCallback samplesCallback, DoneCallback doneCallback, void *context)
+{
+    if (m_signals.empty()) {
+        m_lastError = "模拟设备未配置";
+        return false;
+    }
+    stop();
+
+    m_samplesCallback = samplesCallback;
+    m_doneCallback = doneCallback;
+    m_context = context;
+    m_generated.store(0, std::memory_order_relaxed);
+    m_readPosition = 0;
+    m_running.store(true, std::memory_order_release);
+    m_thread = std::thread(&SimulatedDAQDevice::run, this);
+    return true;
+}
+
+void SimulatedDAQDevice::stop()
+{
+    // 与ClearTask一致：返回后不会再有回调
+    m_running.store(false, std::memory_order_release);
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    // 主设备停止时撤销触发，下次开始时从设备重新等待
+    if (m_config.syncRole == DAQSyncRole::Master && !m_config.startTriggerTerminal.isEmpty()) {
+        TriggerBus &bus = triggerBus();
+        std::lock_guard<std::mutex> lock(bus.mutex);
+        bus.fired.erase(triggerLine(m_config.startTriggerTerminal));
+    }
+}
+
+std::string SimulatedDAQDevice::triggerLine(const QString &terminal)
+{
+    return terminal.section('/', -1).toStdString();
+}
+
+// 设备线程：每采满一块触发一次回调。实时模式按绝对时刻节拍，避免累计漂移
+void SimulatedDAQDevice::run()
+{
+    using Clock = std::chrono::steady_clock;
+    const int blockSize = m_config.samplesPerChannel;
+    const auto blockPeriod = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(blockSize / m_config.sampleRate));
+    Clock::time_point startTime = Clock::now();
+    std::int64_t blocks = 0;
+
+    // 多设备同步：主设备发出开始触发，从设备等待触发后与主设备使用同一起始时刻
+    if (!m_config.startTriggerTerminal.isEmpty() && m_config.syncRole != DAQSyncRole::Standalone) {
+        TriggerBus &bus = triggerBus();
+        const std::string line = triggerLine(m_config.startTriggerTerminal);
+        std::unique_lock<std::mutex> lock(bus.mutex);
+        if (m_config.syncRole == DAQSyncRole::Master) {
+            bus.fired[line] = startTime;
+            bus.condition.notify_all();
+        } else {
+            while (m_running.load(std::memory_order_acquire) && bus.fired.find(line) == bus.fired.end()) {
+                bus.condition.wait_for(lock, std::chrono::milliseconds(50));
+            }
+            if (!m_running.load(std::memory_order_acquire)) {
+                return;
+            }
+            startTime = bus.fired[line];
+        }
+    }
+
+    while (m_running.load(std::memory_order_acquire)) {
+        if (m_realTime) {
+            std::this_thread::sleep_until(startTime + blockPeriod * (blocks + 1));
+            if (!m_running.load(std::memory_order_acquire)) {
+                break;
+            }
+        }
+        ++blocks;
+        m_generated.fetch_add(blockSize, std::memory_order_release);
+        if (m_samplesCallback) {
+            m_samplesCallback(m_context, blockSize);
+        }
+        if (!m_realTime) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+double SimulatedDAQDevice::sampleValue(int index, std::int64_t sampleIndex) const
+{
+    const Signal &signal = m_signals[size_t(index)];
+    const double rate = m_config.sampleRate;
+    double value = 0.0;
+
+    switch (signal.waveform) {
+    case Waveform::Sine: {
+        // 先取小数周期再求正弦，长时间运行时相位精度不下降
+        const double cycles = signal.frequency * double(sampleIndex) / rate;
+        value = std::sin(2.0 * M_PI * (cycles - std::floor(cycles)));
+        break;
+    }
+    case Waveform::Chirp: {
+        const std::int64_t periodSamples = std::max<std::int64_t>(1, std::llround(signal.chirpPeriod * rate));
+        const double t = double(sampleIndex % periodSamples) / rate;
+        const double k = (signal.chirpEndFrequency - signal.frequency) / signal.chirpPeriod;
+        const double cycles = signal.frequency * t + 0.5 * k * t * t;
+        value = std::sin(2.0 * M_PI * (cycles - std::floor(cycles)));
+        break;
+    }
+    case Waveform::Noise: {
+        const std::uint64_t seed = std::uint64_t(m_config.channels[index]) << 48;
+        const std::uint64_t bits = mix64(seed ^ std::uint64_t(sampleIndex));
+        value = double(bits >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+        break;
+    }
+    case Waveform::Step: {
+        const std::int64_t halfPeriods = std::int64_t(std::floor(2.0 * signal.frequency * double(sampleIndex) / rate));
+        value = (halfPeriods & 1) ? -1.0 : 1.0;
+        break;
+    }
+    }
+    return signal.offset + signal.amplitude * value;
+}
+
+int SimulatedDAQDevice::readAnalog(int scans, double *buffer, std::uint32_t bufferSize, int *scansRead)
+{
+    const int channels = int(m_signals.size());
+    const std::int64_t available = m_generated.load(std::memory_order_acquire) - m_readPosition;
+    const int count = int(std::min<std::int64_t>({std::int64_t(scans), available,
+                                                   std::int64_t(bufferSize / std::uint32_t(channels))}));
+    for (int i = 0; i < count; ++i) {
+        for (int ch = 0; ch < channels; ++ch) {
+            buffer[size_t(i) * size_t(channels) + size_t(ch)] = sampleValue(ch, m_readPosition + i);
+        }
+    }
+    m_readPosition += count;
+    *scansRead = count;
+    return 0;
+}
+
+int SimulatedDAQDevice::readBinary(int scans, std::int16_t *buffer, std::uint32_t bufferSize, int *scansRead)
+{
+    const int channels = int(m_signals.size());
+    const std::int64_t available = m_generated.load(std::memory_order_acquire) - m_readPosition;
+    const int count = int(std::min<std::int64_t>({std::int64_t(scans), available,
+                                                   std::int64_t(bufferSize / std::uint32_t(channels))}));
+
+    // 按量程量化为16位码值：码值 = (电压 - 中点) / (量程 / 65536)
+    const double scale = 65536.0 / (m_config.rangeMax - m_config.rangeMin);
+    const double center = (m_config.rangeMax + m_config.rangeMin) / 2.0;
+    for (int i = 0; i < count; ++i) {
+        for (int ch = 0; ch < channels; ++ch) {
+            const double code = std::round((sampleValue(ch, m_readPosition + i) - center) * scale);
+            buffer[size_t(i) * size_t(channels) + size_t(ch)] = std::int16_t(std::clamp(code, -32768.0, 32767.0));
+        }
+    }
+    m_readPosition += count;
+    *scansRead = count;
+    return 0;
+}
+
+bool SimulatedDAQDevice::channelRange(int index, double *minValue, double *maxValue)
+{
+    if (index < 0 || index >= int(m_signals.size())) {
+        return false;
+    }
+    *minValue = m_config.rangeMin;
+    *maxValue = m_config.rangeMax;
+    return true;
+}
@@ -0,0 +1,82 @@
+#ifndef SIMULATEDDAQDEVICE_H
+#define SIMULATEDDAQDEVICE_H
+
+#include "daqdevice.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 模拟采集设备
+//
+// 用软件生成确定性的多通道波形，按配置的采样率和块大小在独立线程中触发回调，
+// 线程模型与ArtDAQ驱动一致（回调线程 -> 环形缓冲区 -> DAQ线程），可在没有硬件的Linux上
+// 运行和测试完整的采集管线。样本值只取决于通道和样本序号，每次运行结果相同。
+// 多设备同步时，从设备在start()后等待主设备在同名终端上发出的开始触发，并与主设备使用同一起始时刻，
+// 模拟共享开始触发/采样时钟的接线。
+class SimulatedDAQDevice : public DAQDevice
+{
+public:
+    enum class Waveform {
+        Sine,   // 正弦
+        Chirp,  // 线性扫频，在chirpPeriod内从frequency扫到chirpEndFrequency后重复
+        Noise,  // 均匀分布伪随机噪声（按通道固定种子）
+        Step    // 方波阶跃，周期为1/frequency
+    };
+
+    struct Signal {
+        Waveform waveform = Waveform::Sine;
+        double amplitude = 1.0;             // 峰值（V）
+        double offset = 0.0;                // 直流偏置（V）
+        double frequency = 10.0;            // Hz
+        double chirpEndFrequency = 1000.0;  // Hz
+        double chirpPeriod = 1.0;           // s
+    };
+
+    SimulatedDAQDevice();
+    ~SimulatedDAQDevice() override;
+
+    QString backendName() const override { return "Simulated"; }
+
+    // 设置指定通道（按config.channels中的序号）的信号，需在configure()之后、start()之前调用；
+    // 未设置的通道按序号轮流使用四种波形
+    void setSignal(int index, const Signal &signal);
+    // 实时模式按采样率节拍触发回调；关闭后尽快生成，用于吞吐量测试。需在start()之前调用
+    void setRealTime(bool realTime);
+
+    bool configure(const DAQDeviceConfig &config) override;
+    bool start(SamplesCallback samplesCallback, DoneCallback doneCallback, void *context) override;
+    void stop() override;
+
+    int readAnalog(int scans, double *buffer, std::uint32_t bufferSize, int *scansRead) override;
+    int readBinary(int scans, std::int16_t *buffer, std::uint32_t bufferSize, int *scansRead) override;
+
+    bool channelRange(int index, double *minValue, double *maxValue) override;
+
+    // 指定通道在全局样本序号sampleIndex处的值（V），可用于校验
+    double sampleValue(int index, std::int64_t sampleIndex) const;
+
+    // 已生成的每通道样本数
+    std::int64_t samplesGenerated() const { return m_generated.load(std::memory_order_acquire); }
+
+private:
+    void run();
+    static Signal defaultSignal(int index, int channel);
+    // 终端名称去掉设备前缀（"/Dev1/PFI0" -> "PFI0"），作为模拟接线的键
+    static std::string triggerLine(const QString &terminal);
+
+    DAQDeviceConfig m_config;
+    std::vector<Signal> m_signals;
+    bool m_realTime;
+
+    SamplesCallback m_samplesCallback;
+    DoneCallback m_doneCallback;
+    void *m_context;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    std::atomic<std::int64_t> m_generated;   // 已生成的样本数（设备"缓冲区"写位置）
+    std::int64_t m_readPosition;             // 已读取的样本数（仅回调线程使用）
+};
+
+#endif // SIMULATEDDAQDEVICE_H
@@ -0,0 +1,322 @@
+#include "snapshothistory.h"
+#include <QDebug>
+#include <QReadLocker>
+#include <QWriteLocker>
+#include <algorithm>
+#include <limits>
+#include <new>
+
+namespace {
+
+const float NaN = std::numeric_limits<float>::quiet_NaN();
+
+// 某数据来源在快照中的数组及其有效标志
+const QVector<double> &sourceValues(int kind, const DataSnapshot &snapshot, bool *valid)
+{
+    switch (kind) {
+    case SessionLog::ModbusValue: *valid = snapshot.modbusValid; return snapshot.modbusData;
+    case SessionLog::DAQValue: *valid = snapshot.daqValid; return snapshot.daqData;
+    case SessionLog::DAQMin: *valid = snapshot.daqValid; return snapshot.daqMin;
+    case SessionLog::DAQMax: *valid = snapshot.daqValid; return snapshot.daqMax;
+    case SessionLog::DAQMean: *valid = snapshot.daqValid; return snapshot.daqMean;
+    case SessionLog::DAQRms: *valid = snapshot.daqValid; return snapshot.daqRms;
+    case SessionLog::ECUValue: *valid = snapshot.ecuValid; return snapshot.ecuData;
+    default: *valid = true; return snapshot.customData;
+    }
+}
+
+} // namespace
+
+SnapshotHistory::SnapshotHistory()
+    : m_columns(0)
+    , m_maxRows(36000)
+    , m_maxBytes(256ll << 20)
+    , m_capacity(0)
+    , m_start(0)
+    , m_size(0)
+{
+    std::fill(m_count, m_count + KindCount, 0);
+    std::fill(m_offset, m_offset + KindCount, 0);
+}
+
+void SnapshotHistory::setLimits(qint64 rows, qint64 maxBytes)
+{
+    QWriteLocker locker(&m_lock);
+    m_maxRows = qMax<qint64>(1, rows);
+    m_maxBytes = qMax<qint64>(1 << 20, maxBytes);
+    // 布局未知（尚未追加快照）时在第一次追加时分配
+    if (m_columns > 0 && effectiveCapacity(m_count) != m_capacity) {
+        reallocate(m_count);
+    }
+}
+
+void SnapshotHistory::clear()
+{
+    QWriteLocker locker(&m_lock);
+    m_start = 0;
+    m_size = 0;
+}
+
+qint64 SnapshotHistory::effectiveCapacity(const int *counts) const
+{
+    qint64 columns = 0;
+    for (int k = 0; k < KindCount; ++k) {
+        columns += counts[k];
+    }
+    const qint64 rowBytes = qint64(sizeof(double)) + columns * qint64(sizeof(float));
+    return qMax<qint64>(1, qMin(m_maxRows, m_maxBytes / rowBytes));
+}
+
+// 按新的列数和容量重新分配，保留最近的行
+void SnapshotHistory::reallocate(const int *counts)
+{
+    const qint64 capacity = effectiveCapacity(counts);
+    int offset[KindCount];
+    int columns = 0;
+    for (int k = 0; k < KindCount; ++k) {
+        offset[k] = columns;
+        columns += counts[k];
+    }
+
+    std::vector<double> time;
+    std::vector<float> values;
+    try {
+        time.resize(size_t(capacity));
+        values.assign(size_t(capacity) * size_t(columns), NaN);
+    } catch (const std::bad_alloc &) {
+        qDebug() << "[SnapshotHistory] 分配快照历史失败:" << columns << "列," << capacity << "行";
+        m_time.clear();
+        m_values.clear();
+        m_capacity = 0;
+        m_start = 0;
+        m_size = 0;
+        return;
+    }
+
+    const qint64 keep = qMin(m_size, capacity);
+    for (qint64 r = 0; r < keep; ++r) {
+        const qint64 src = physical(m_size - keep + r);
+        time[size_t(r)] = m_time[size_t(src)];
+        for (int k = 0; k < KindCount; ++k) {
+            for (int c = 0; c < m_count[k]; ++c) {
+                values[size_t(offset[k] + c) * size_t(capacity) + size_t(r)] =
+                    m_values[size_t(m_offset[k] + c) * size_t(m_capacity) + size_t(src)];
+            }
+        }
+    }
+
+    m_time.swap(time);
+    m_values.swap(values);
+    std::copy(counts, counts + KindCount, m_count);
+    std::copy(offset, offset + KindCount, m_offset);
+    m_columns = columns;
+    m_capacity = capacity;
+    m_start = 0;
+    m_size = keep;
+    qDebug() << "[SnapshotHistory] 快照历史:" << columns << "列，" << capacity << "行，占用"
+             << (m_time.size() * sizeof(double) + m_values.size() * sizeof(float)) / (1 << 20) << "MB";
+}
+
+void SnapshotHistory::append(const DataSnapshot &snapshot)
+{
+    QWriteLocker locker(&m_lock);
+
+    // 某数据来源的通道数超过现有列数时扩展布局
+    int counts[KindCount];
+    bool grow = m_capacity == 0;
+    for (int k = 0; k < KindCount; ++k) {
+        bool valid = false;
+        counts[k] = k == 0 ? 0 : qMax(m_count[k], int(sourceValues(k, snapshot, &valid).size()));
+        grow = grow || counts[k] != m_count[k];
+    }
+    if (grow) {
+        reallocate(counts);
+        if (m_capacity == 0) {
+            return;
+        }
+    }
+
+    if (m_size > 0 && snapshot.timestamp < m_time[size_t(physical(m_size - 1))]) {
+        m_start = 0;
+        m_size = 0;
+    }
+
+    qint64 pos;
+    if (m_size < m_capacity) {
+        pos = physical(m_size);
+        ++m_size;
+    } else {
+        pos = m_start;
+        m_start = (m_start + 1) % m_capacity;
+    }
+
+    m_time[size_t(pos)] = snapshot.timestamp;
+    for (int k = 1; k < KindCount; ++k) {
+        bool valid = false;
+        const QVector<double> &source = sourceValues(k, snapshot, &valid);
+        const int available = valid ? int(source.size()) : 0;
+        // 派生通道逐通道有效，其他来源整体有效
+        const QVector<bool> *channelValid = k == SessionLog::CustomValue ? &snapshot.customValid : nullptr;
+        float *column = m_values.data() + size_t(m_offset[k]) * size_t(m_capacity) + size_t(pos);
+        for (int c = 0; c < m_count[k]; ++c, column += m_capacity) {
+            const bool ok = c < available && (!channelValid || (c < channelValid->size() && (*channelValid)[c]));
+            *column = ok ? float(source[c]) : NaN;
+        }
+    }
+}
+
+qint64 SnapshotHistory::size() const
+{
+    QReadLocker locker(&m_lock);
+    return m_size;
+}
+
+qint64 SnapshotHistory::capacity() const
+{
+    QReadLocker locker(&m_lock);
+    return m_capacity;
+}
+
+qint64 SnapshotHistory::memoryBytes() const
+{
+    QReadLocker locker(&m_lock);
+    return qint64(m_time.size() * sizeof(double) + m_values.size() * sizeof(float));
+}
+
+bool SnapshotHistory::timeRange(double *first, double *last) const
+{
+    QReadLocker locker(&m_lock);
+    if (m_size == 0) {
+        return false;
+    }
+    *first = m_time[size_t(m_start)];
+    *last = m_time[size_t(physical(m_size - 1))];
+    return true;
+}
+
+int SnapshotHistory::channelCount(SessionLog::ColumnKind kind) const
+{
+    QReadLocker locker(&m_lock);
+    return kind > 0 && kind < KindCount ? m_count[kind] : 0;
+}
+
+qint64 SnapshotHistory::lowerBound(double t) const
+{
+    qint64 lo = 0;
+    qint64 hi = m_size;
+    while (lo < hi) {
+        const qint64 mid = lo + (hi - lo) / 2;
+        if (m_time[size_t(physical(mid))] < t) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+qint64 SnapshotHistory::upperBound(double t) const
+{
+    qint64 lo = 0;
+    qint64 hi = m_size;
+    while (lo < hi) {
+        const qint64 mid = lo + (hi - lo) / 2;
+        if (m_time[size_t(physical(mid))] <= t) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+SnapshotHistory::QueryResult SnapshotHistory::query(double t0, double t1, const QVector<Channel> &channels,
+                                                    int maxPoints) const
+{
+    QueryResult result;
+    result.values.resize(channels.size());
+
+    QReadLocker locker(&m_lock);
+    const qint64 begin = lowerBound(t0);
+    const qint64 end = upperBound(t1);
+    if (end <= begin) {
+        return result;
+    }
+    const qint64 rows = end - begin;
+    result.sourceRows = rows;
+
+    // 各查询通道的列数据起点，不存在的通道为nullptr
+    QVector<const float *> columns(channels.size(), nullptr);
+    for (int i = 0; i < channels.size(); ++i) {
+        const int kind = channels[i].kind;
+        if (kind > 0 && kind < KindCount && channels[i].channel >= 0 && channels[i].channel < m_count[kind]) {
+            columns[i] = m_values.data() + size_t(m_offset[kind] + channels[i].channel) * size_t(m_capacity);
+        }
+    }
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    if (maxPoints <= 0 || rows <= maxPoints) {
+        result.time.reserve(int(rows));
+        for (QVector<double> &values : result.values) {
+            values.reserve(int(rows));
+        }
+        for (qint64 r = begin; r < end; ++r) {
+            const qint64 pos = physical(r);
+            result.time.append(m_time[size_t(pos)]);
+            for (int i = 0; i < columns.size(); ++i) {
+                result.values[i].append(columns[i] ? double(columns[i][pos]) : nan);
+            }
+        }
+        return result;
+    }
+
+    // 最小/最大值抽取：每个区间输出两个点
+    const qint64 buckets = qMax(1, maxPoints / 2);
+    result.decimated = true;
+    result.time.reserve(int(buckets * 2));
+    for (QVector<double> &values : result.values) {
+        values.reserve(int(buckets * 2));
+    }
+    for (qint64 b = 0; b < buckets; ++b) {
+        const qint64 r0 = begin + rows * b / buckets;
+        const qint64 r1 = begin + rows * (b + 1) / buckets;
+        result.time.append(m_time[size_t(physical(r0))]);
+        result.time.append(m_time[size_t(physical(r1 - 1))]);
+
+        for (int i = 0; i < columns.size(); ++i) {
+            const float *column = columns[i];
+            float minValue = NaN;
+            float maxValue = NaN;
+            qint64 minRow = -1;
+            qint64 maxRow = -1;
+            if (column) {
+                for (qint64 r = r0; r < r1; ++r) {
+                    const float v = column[physical(r)];
+                    if (v != v) {
+                        continue;
+                    }
+                    if (minRow < 0 || v < minValue) {
+                        minValue = v;
+                        minRow = r;
+                    }
+                    if (maxRow < 0 || v > maxValue) {
+                        maxValue = v;
+                        maxRow = r;
+                    }
+                }
+            }
+            QVector<double> &values = result.values[i];
+            if (minRow < 0) {
+                values.append(nan);
+                values.append(nan);
+            } else if (minRow <= maxRow) {
+                values.append(minValue);
+                values.append(maxValue);
+            } else {
+                values.append(maxValue);
+                values.append(minValue);
+            }
+        }
+    }
+    return result;
+}
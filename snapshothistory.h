@@ -0,0 +1,85 @@
+#ifndef SNAPSHOTHISTORY_H
+#define SNAPSHOTHISTORY_H
+
+#include <QReadWriteLock>
+#include <QVector>
+#include <vector>
+#include "datasnapshot.h"
+#include "sessionlog.h"
+
+// 按时间索引的快照历史
+//
+// 快照线程每生成一个快照追加一行，绘图、WebSocket补发历史数据、校准对话框都从这里按时间范围查询，
+// 不再各自保存副本。存储为列优先的定长环形区域：时间戳为double，各列数值为float（无效值为NaN），
+// 每行约 8 + 4×列数 字节，默认布局（16路Modbus、16路DAQ及其窗口统计、ECU、自定义）每小时（10Hz）约16MB。
+// 列按数据来源分组（SessionLog::ColumnKind），列数取各数据源出现过的最大通道数，
+// 通道数增加时保留已有数据重新分配。
+// 单写者（快照线程）、多读者：读写锁保护，查询期间写者等待，查询按抽取后的点数控制耗时。
+class SnapshotHistory
+{
+public:
+    // 查询的通道：数据来源和通道号
+    struct Channel {
+        SessionLog::ColumnKind kind = SessionLog::ModbusValue;
+        int channel = 0;
+    };
+
+    // 查询结果：time与values[i]等长；通道不存在或数据无效时为NaN
+    struct QueryResult {
+        QVector<double> time;
+        QVector<QVector<double>> values;   // [查询通道][点]
+        qint64 sourceRows = 0;             // 时间范围内的原始行数
+        bool decimated = false;            // 是否经过最小/最大值抽取
+    };
+
+    SnapshotHistory();
+
+    SnapshotHistory(const SnapshotHistory &) = delete;
+    SnapshotHistory &operator=(const SnapshotHistory &) = delete;
+
+    // 容量：最多保存rows行，且占用内存不超过maxBytes（按当前列数折算）；保留最近的数据
+    void setLimits(qint64 rows, qint64 maxBytes);
+    // 清空历史（保留布局和容量）
+    void clear();
+
+    // ---- 写端（单写者）----
+    // 追加一个快照。时间戳早于最后一行（主计时器重置）时先清空
+    void append(const DataSnapshot &snapshot);
+
+    // ---- 读端（任意线程）----
+    qint64 size() const;
+    qint64 capacity() const;
+    qint64 memoryBytes() const;
+    // 最早和最新一行的时间戳；历史为空时返回false
+    bool timeRange(double *first, double *last) const;
+    // 某数据来源的通道数
+    int channelCount(SessionLog::ColumnKind kind) const;
+    // 时间戳在[t0, t1]内的行。maxPoints > 0 且行数超过它时，按行数等分为 maxPoints/2 个区间，
+    // 每个区间输出两个点（区间首尾行的时间），各通道取区间内的最小值和最大值，按出现的先后顺序排列，
+    // 峰值不会因抽取而丢失。maxPoints <= 0 时返回全部行
+    QueryResult query(double t0, double t1, const QVector<Channel> &channels, int maxPoints) const;
+
+private:
+    static constexpr int KindCount = SessionLog::CustomValue + 1;
+
+    // 以下方法在持有锁时调用（reallocate需要写锁）
+    void reallocate(const int *counts);
+    qint64 effectiveCapacity(const int *counts) const;
+    qint64 physical(qint64 row) const { return (m_start + row) % m_capacity; }
+    qint64 lowerBound(double t) const;   // 第一个时间戳 >= t 的行
+    qint64 upperBound(double t) const;   // 第一个时间戳 > t 的行
+
+    mutable QReadWriteLock m_lock;
+    int m_count[KindCount];              // 每种数据来源的列数
+    int m_offset[KindCount];             // 每种数据来源的第一列
+    int m_columns;
+    qint64 m_maxRows;
+    qint64 m_maxBytes;
+    qint64 m_capacity;
+    qint64 m_start;                      // 最早一行的物理位置
+    qint64 m_size;
+    std::vector<double> m_time;          // [容量]
+    std::vector<float> m_values;         // [列][容量]
+};
+
+#endif // SNAPSHOTHISTORY_H
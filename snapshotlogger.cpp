@@ -0,0 +1,447 @@
+#include "snapshotlogger.h"
+#include "pipelinelatency.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+namespace {
+
+const int DrainIntervalMs = 20;   // 写入线程取队列的周期
+const int PartialBlockFlushes = 10;   // 未满的数据块最多等待的刷新间隔数，之后结束为短块写出
+
+} // namespace
+
+SnapshotLogger::SnapshotLogger(QObject *parent)
+    : QThread(parent)
+    , m_queueCapacity(4096)
+    , m_flushIntervalMs(1000)
+    , m_bufferBytes(1 << 20)
+    , m_segmentSeconds(600.0)
+    , m_segmentBytes(256ll << 20)
+    , m_compressionLevel(6)
+    , m_logging(false)
+    , m_snapshotsDropped(0)
+    , m_stopRequested(false)
+    , m_sessionSegmentSeconds(0.0)
+    , m_sessionSegmentBytes(0)
+    , m_sessionCompressionLevel(0)
+    , m_segmentIndex(0)
+    , m_sessionRows(0)
+    , m_sessionBytes(0)
+    , m_segmentFirstTime(0.0)
+    , m_segmentLastTime(0.0)
+    , m_partialBlockFirstRow(-1)
+    , m_statsBytes(0)
+    , m_maxWriteNs(0)
+{
+    m_queue.allocate(size_t(m_queueCapacity));
+    m_compressionPool.setMaxThreadCount(1);
+}
+
+SnapshotLogger::~SnapshotLogger()
+{
+    stopThread();
+}
+
+void SnapshotLogger::setQueueCapacity(int snapshots)
+{
+    if (isRunning()) {
+        qDebug() << "[SnapshotLogger] 写入线程运行中，忽略队列容量设置";
+        return;
+    }
+    m_queueCapacity = qBound(64, snapshots, 1 << 20);
+    m_queue.allocate(size_t(m_queueCapacity));
+}
+
+void SnapshotLogger::setFlushInterval(int ms)
+{
+    m_flushIntervalMs.store(qBound(DrainIntervalMs, ms, 60000), std::memory_order_relaxed);
+}
+
+void SnapshotLogger::setBufferBytes(qint64 bytes)
+{
+    m_bufferBytes.store(qBound<qint64>(0, bytes, 64 << 20), std::memory_order_relaxed);
+}
+
+void SnapshotLogger::setSegmentLimits(double seconds, qint64 bytes)
+{
+    m_segmentSeconds.store(qMax(0.0, seconds), std::memory_order_relaxed);
+    m_segmentBytes.store(qMax<qint64>(0, bytes), std::memory_order_relaxed);
+}
+
+void SnapshotLogger::setCompressionLevel(int level)
+{
+    m_compressionLevel.store(qBound(0, level, 9), std::memory_order_relaxed);
+}
+
+void SnapshotLogger::stopThread()
+{
+    {
+        QMutexLocker locker(&m_wakeMutex);
+        m_stopRequested = true;
+        m_wakeCondition.wakeAll();
+    }
+    if (isRunning()) {
+        wait();
+    }
+    m_compressionPool.waitForDone();
+}
+
+bool SnapshotLogger::pushControl(QueueItem &&item)
+{
+    // 控制项使用为其保留的空位
+    if (!m_queue.tryPush(std::move(item))) {
+        qDebug() << "[SnapshotLogger] 队列已满，无法传递开始/停止请求";
+        return false;
+    }
+    return true;
+}
+
+void SnapshotLogger::startLogging(const QString &directory, const QVector<SessionLog::Column> &columns,
+                                  const QString &description, int rowsPerBlock)
+{
+    auto request = std::make_shared<StartRequest>();
+    request->directory = directory;
+    request->columns = columns;
+    request->description = description;
+    request->rowsPerBlock = rowsPerBlock;
+
+    QueueItem item;
+    item.kind = QueueItem::Start;
+    item.start = std::move(request);
+    if (!pushControl(std::move(item))) {
+        emit loggingError(QString("无法开始记录 %1：日志队列已满").arg(directory));
+        return;
+    }
+    m_logging = true;
+    m_snapshotsDropped.store(0, std::memory_order_relaxed);
+}
+
+void SnapshotLogger::stopLogging()
+{
+    if (!m_logging) {
+        return;
+    }
+    QueueItem item;
+    item.kind = QueueItem::Stop;
+    if (pushControl(std::move(item))) {
+        m_logging = false;
+    }
+}
+
+// 运行在快照线程：只入队句柄，不复制数据，不加锁，队列满时丢弃
+bool SnapshotLogger::enqueueSnapshot(const SnapshotHandle &snapshot)
+{
+    if (!m_logging) {
+        return false;
+    }
+    QueueItem item;
+    item.snapshot = snapshot;
+    if (!m_queue.tryPush(std::move(item), ControlReserve)) {
+        m_snapshotsDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void SnapshotLogger::run()
+{
+    qDebug() << "[SnapshotLogger] 写入线程已启动";
+    m_flushTimer.start();
+    m_statsTimer.start();
+    m_statsBytes = 0;
+    m_maxWriteNs = 0;
+
+    forever {
+        bool stop = false;
+        {
+            QMutexLocker locker(&m_wakeMutex);
+            if (!m_stopRequested) {
+                m_wakeCondition.wait(&m_wakeMutex, DrainIntervalMs);
+            }
+            stop = m_stopRequested;
+        }
+
+        drainQueue();
+
+        if (m_writer.isOpen() && m_flushTimer.elapsed() >= m_flushIntervalMs.load(std::memory_order_relaxed)) {
+            writeOutput();
+        }
+
+        // 约每秒报告一次状态
+        if (m_statsTimer.elapsed() >= 1000) {
+            const double seconds = m_statsTimer.restart() / 1000.0;
+            const quint64 dropped = m_snapshotsDropped.load(std::memory_order_relaxed);
+            if (m_writer.isOpen() || dropped > 0) {
+                emit loggerStatistics(dropped, int(m_queue.size()), int(m_queue.highWater()),
+                                      m_statsBytes / seconds / 1e6, m_maxWriteNs / 1e6);
+            }
+            m_queue.resetHighWater();
+            m_statsBytes = 0;
+            m_maxWriteNs = 0;
+        }
+
+        if (stop) {
+            break;
+        }
+    }
+
+    drainQueue();
+    closeSession();
+    qDebug() << "[SnapshotLogger] 写入线程已停止";
+}
+
+void SnapshotLogger::drainQueue()
+{
+    QueueItem item;
+    while (m_queue.tryPop(item)) {
+        try {
+            switch (item.kind) {
+            case QueueItem::Start:
+                closeSession();
+                openSession(item.start);
+                break;
+            case QueueItem::Stop:
+                closeSession();
+                break;
+            case QueueItem::Snapshot:
+                appendSnapshot(*item.snapshot);
+                break;
+            }
+        } catch (const std::exception &e) {
+            qDebug() << "[SnapshotLogger] 写入快照时出错:" << e.what();
+        }
+    }
+    // 释放最后一个快照句柄，槽位尽早回到对象池
+    item = QueueItem();
+}
+
+void SnapshotLogger::appendSnapshot(const DataSnapshot &snapshot)
+{
+    if (!m_writer.isOpen()) {
+        return;
+    }
+
+    // 达到分段时长或大小时切换分段（主计时器重置导致时间戳回退时也开始新分段）
+    if (m_writer.rowsWritten() > 0) {
+        const double elapsed = snapshot.timestamp - m_segmentFirstTime;
+        if ((m_sessionSegmentSeconds > 0.0 && elapsed >= m_sessionSegmentSeconds) || elapsed < 0.0
+            || (m_sessionSegmentBytes > 0 && m_writer.bytesWritten() >= m_sessionSegmentBytes)) {
+            closeSegment();
+            if (!openSegment()) {
+                return;
+            }
+        }
+    }
+    if (m_writer.rowsWritten() == 0) {
+        m_segmentFirstTime = snapshot.timestamp;
+    }
+    m_segmentLastTime = snapshot.timestamp;
+
+    // 追加时可能触发写出缓冲区写入文件，按单次调用计时
+    const qint64 before = m_writer.bytesWritten();
+    QElapsedTimer writeTimer;
+    writeTimer.start();
+    const bool ok = m_writer.appendSnapshot(snapshot);
+    m_maxWriteNs = qMax(m_maxWriteNs, writeTimer.nsecsElapsed());
+    m_statsBytes += m_writer.bytesWritten() - before;
+    if (!ok) {
+        emit loggingError(m_writer.errorString());
+        closeSession();
+        return;
+    }
+    PipelineLatency::recordSince(PipelineLatency::Log, snapshot.publishedNs);
+    PipelineLatency::recordSince(PipelineLatency::EndToEndLog, snapshot.acquiredNs);
+}
+
+void SnapshotLogger::ManifestState::save()
+{
+    QString error;
+    if (!manifest.save(directory, &error)) {
+        qDebug() << "[SnapshotLogger]" << error;
+    }
+}
+
+void SnapshotLogger::openSession(const std::shared_ptr<const StartRequest> &request)
+{
+    if (!QDir().mkpath(request->directory)) {
+        const QString message = QString("无法创建会话目录 %1").arg(request->directory);
+        qDebug() << "[SnapshotLogger]" << message;
+        emit loggingError(message);
+        return;
+    }
+
+    m_session = request;
+    m_sessionSegmentSeconds = m_segmentSeconds.load(std::memory_order_relaxed);
+    m_sessionSegmentBytes = m_segmentBytes.load(std::memory_order_relaxed);
+    m_sessionCompressionLevel = m_compressionLevel.load(std::memory_order_relaxed);
+    m_segmentIndex = 0;
+    m_sessionRows = 0;
+    m_sessionBytes = 0;
+
+    m_manifest = std::make_shared<ManifestState>();
+    m_manifest->directory = request->directory;
+    m_manifest->manifest.description = request->description;
+    m_manifest->manifest.startTimeMs = QDateTime::currentMSecsSinceEpoch();
+    m_manifest->manifest.segmentSeconds = m_sessionSegmentSeconds;
+    m_manifest->manifest.segmentBytes = m_sessionSegmentBytes;
+    m_manifest->manifest.compressionLevel = m_sessionCompressionLevel;
+    m_manifest->save();
+
+    if (!openSegment()) {
+        m_session.reset();
+        m_manifest.reset();
+        return;
+    }
+    qDebug() << "[SnapshotLogger] 开始记录:" << request->directory;
+    emit loggingStarted(request->directory);
+}
+
+void SnapshotLogger::closeSession()
+{
+    if (!m_session) {
+        return;
+    }
+    closeSegment();
+    {
+        QMutexLocker locker(&m_manifest->mutex);
+        m_manifest->manifest.complete = true;
+        m_manifest->save();
+    }
+    qDebug() << "[SnapshotLogger] 记录已结束:" << m_session->directory << "分段:" << m_segmentIndex
+             << "行数:" << m_sessionRows << "字节:" << m_sessionBytes;
+    emit loggingStopped(m_session->directory, m_sessionRows, m_sessionBytes);
+    m_session.reset();
+    m_manifest.reset();
+}
+
+bool SnapshotLogger::openSegment()
+{
+    const QString fileName = QString("segment_%1.slog").arg(m_segmentIndex, 4, 10, QChar('0'));
+    const QString filePath = QDir(m_session->directory).filePath(fileName);
+    m_writer.setOutputBufferBytes(m_bufferBytes.load(std::memory_order_relaxed));
+    if (!m_writer.open(filePath, m_session->columns,
+                       QString("%1, segment %2").arg(m_session->description).arg(m_segmentIndex),
+                       m_session->rowsPerBlock)) {
+        qDebug() << "[SnapshotLogger]" << m_writer.errorString();
+        emit loggingError(m_writer.errorString());
+        return false;
+    }
+    m_flushTimer.restart();
+    m_partialBlockFirstRow = -1;
+
+    // 打开时即加入清单，程序异常退出时正在写入的分段也能被找到
+    SessionSegment segment;
+    segment.fileName = fileName;
+    segment.firstRow = m_sessionRows;
+    segment.closed = false;
+    {
+        QMutexLocker locker(&m_manifest->mutex);
+        m_manifest->manifest.segments.append(segment);
+        m_manifest->save();
+    }
+    return true;
+}
+
+void SnapshotLogger::closeSegment()
+{
+    if (!m_writer.isOpen()) {
+        return;
+    }
+    const qint64 rowCount = m_writer.rowsWritten();
+    m_writer.close();
+    const qint64 rawBytes = m_writer.bytesWritten();
+
+    m_sessionRows += rowCount;
+    m_sessionBytes += rawBytes;
+    ++m_segmentIndex;
+
+    // 填写openSegment()加入清单的项（正在写入的分段总是最后一项）
+    int index = 0;
+    {
+        QMutexLocker locker(&m_manifest->mutex);
+        index = m_manifest->manifest.segments.size() - 1;
+        SessionSegment &segment = m_manifest->manifest.segments[index];
+        segment.rowCount = rowCount;
+        segment.firstTime = m_segmentFirstTime;
+        segment.lastTime = m_segmentLastTime;
+        segment.rawBytes = rawBytes;
+        segment.storedBytes = rawBytes;
+        segment.closed = true;
+        m_manifest->save();
+    }
+
+    // 在后台压缩，写入线程继续写下一个分段
+    if (m_sessionCompressionLevel > 0 && rowCount > 0) {
+        const std::shared_ptr<ManifestState> state = m_manifest;
+        const int level = m_sessionCompressionLevel;
+        m_compressionPool.start([this, state, index, level]() { compressSegment(state, index, level); });
+    }
+}
+
+// 运行在压缩线程：压缩成功后删除未压缩的分段并更新清单
+void SnapshotLogger::compressSegment(const std::shared_ptr<ManifestState> &state, int segment, int level)
+{
+    QString sourcePath;
+    {
+        QMutexLocker locker(&state->mutex);
+        sourcePath = QDir(state->directory).filePath(state->manifest.segments[segment].fileName);
+    }
+    const QString targetPath = sourcePath + ".z";
+
+    QString error;
+    QElapsedTimer timer;
+    timer.start();
+    if (!SessionLog::compressFile(sourcePath, targetPath, level, &error)) {
+        qDebug() << "[SnapshotLogger]" << error;
+        emit loggingError(error);
+        return;
+    }
+    const qint64 rawBytes = QFileInfo(sourcePath).size();
+    const qint64 storedBytes = QFileInfo(targetPath).size();
+    QFile::remove(sourcePath);
+
+    {
+        QMutexLocker locker(&state->mutex);
+        SessionSegment &entry = state->manifest.segments[segment];
+        entry.fileName = QFileInfo(targetPath).fileName();
+        entry.storedBytes = storedBytes;
+        entry.compressed = true;
+        state->save();
+    }
+    qDebug() << "[SnapshotLogger] 分段已压缩:" << targetPath << rawBytes << "->" << storedBytes << "字节,"
+             << timer.elapsed() << "ms";
+    emit segmentCompressed(targetPath, rawBytes, storedBytes);
+}
+
+// 把写出缓冲区中已完成的数据块写入文件。未满的数据块一般不在这里结束，否则周期性刷新会把块切短，
+// 块索引的开销随之成倍增加；未满的块在写满、分段切换或关闭时写出。快照速率低、一个块长时间写不满时，
+// 等待PartialBlockFlushes个刷新间隔后结束为短块，异常退出时最多丢失这段时间的数据
+void SnapshotLogger::writeOutput()
+{
+    bool closeBlock = false;
+    if (m_writer.pendingRows() > 0) {
+        const qint64 firstRow = m_writer.rowsWritten() - m_writer.pendingRows();
+        if (firstRow != m_partialBlockFirstRow) {
+            m_partialBlockFirstRow = firstRow;
+            m_partialBlockTimer.restart();
+        } else {
+            closeBlock = m_partialBlockTimer.elapsed()
+                         >= qint64(PartialBlockFlushes) * m_flushIntervalMs.load(std::memory_order_relaxed);
+        }
+    }
+
+    const qint64 before = m_writer.bytesWritten();
+    QElapsedTimer writeTimer;
+    writeTimer.start();
+    const bool ok = closeBlock ? m_writer.flush() : m_writer.flushOutput();
+    m_statsBytes += m_writer.bytesWritten() - before;
+    m_maxWriteNs = qMax(m_maxWriteNs, writeTimer.nsecsElapsed());
+    m_flushTimer.restart();
+    if (!ok) {
+        emit loggingError(m_writer.errorString());
+        closeSession();
+    }
+}
@@ -0,0 +1,151 @@
+#ifndef SNAPSHOTLOGGER_H
+#define SNAPSHOTLOGGER_H
+
+#include <QThread>
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QDebug>
+#include <atomic>
+#include <memory>
+#include "datasnapshot.h"
+#include "sessionlog.h"
+#include "sessionmanifest.h"
+#include "spscqueue.h"
+
+// 快照日志写入线程
+//
+// 快照线程只把快照句柄（共享，不复制数据）放入单生产者/单消费者无锁有界队列，
+// 入队不加锁、不分配内存，队列满时丢弃该快照并计数，快照生成永远不会等待磁盘。
+// 写入线程定期取出队列中的快照，序列化为会话日志数据块并累积到写出缓冲区，
+// 缓冲区达到设定大小或到达刷新间隔时一次写入文件。
+// 开始/停止记录也通过同一队列按顺序传递，队列为它们保留少量空位。
+//
+// 每次记录写入一个会话目录，按时长或大小切分为多个分段（见SessionManifest）；
+// 分段关闭后由单线程后台池压缩，压缩期间下一个分段继续写入，快照线程不受影响。
+class SnapshotLogger : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit SnapshotLogger(QObject *parent = nullptr);
+    ~SnapshotLogger();
+
+    // 队列容量（快照个数，默认4096），须在start()之前设置
+    void setQueueCapacity(int snapshots);
+    // 刷新间隔（ms，默认1000）：已完成的数据块最迟在该间隔后写入文件。未满的数据块等到写满再写出，
+    // 但最多等待约10个刷新间隔，之后结束为短块写出（快照速率低时限制异常退出丢失的数据）
+    void setFlushInterval(int ms);
+    // 写出缓冲区大小（字节，默认1MB），下一个文件生效
+    void setBufferBytes(qint64 bytes);
+    // 分段条件（下一次记录生效）：时长（秒，默认600）或未压缩大小（字节，默认256MB），达到任一条件时切换分段；0为不限
+    void setSegmentLimits(double seconds, qint64 bytes);
+    // 分段压缩级别（下一次记录生效）：0不压缩，1-9为zlib压缩级别（默认6）
+    void setCompressionLevel(int level);
+
+    bool isLogging() const { return m_logging; }
+
+    // 线程停止执行（会先写完队列中的快照、关闭当前分段并等待压缩完成）
+    void stopThread();
+
+    // 以下三个方法只能在同一个生产者线程（快照线程）中调用
+    // 开始记录：后续快照写入会话目录directory（不存在时创建）；文件在写入线程中创建
+    void startLogging(const QString &directory, const QVector<SessionLog::Column> &columns,
+                      const QString &description, int rowsPerBlock);
+    // 停止记录：写完已入队的快照后关闭最后一个分段
+    void stopLogging();
+    // 入队一个快照；未在记录或队列已满时返回false
+    bool enqueueSnapshot(const SnapshotHandle &snapshot);
+
+signals:
+    void loggingStarted(QString directory);
+    // 记录结束：会话目录、总行数、未压缩的总字节数
+    void loggingStopped(QString directory, qint64 rows, qint64 bytesWritten);
+    // 一个分段压缩完成
+    void segmentCompressed(QString filePath, qint64 rawBytes, qint64 storedBytes);
+    void loggingError(QString errorMessage);
+    // 约每秒一次：累计丢弃的快照数、队列占用、本周期队列最高占用、写入速率（MB/s）、本周期最长单次写入耗时（ms）
+    void loggerStatistics(quint64 snapshotsDropped, int queued, int highWater, double writeMBps, double maxWriteMs);
+
+protected:
+    // 重写run方法，实现写入线程主循环
+    void run() override;
+
+private:
+    struct StartRequest {
+        QString directory;
+        QVector<SessionLog::Column> columns;
+        QString description;
+        int rowsPerBlock = 256;
+    };
+
+    struct QueueItem {
+        enum Kind { Snapshot, Start, Stop } kind = Snapshot;
+        SnapshotHandle snapshot;
+        std::shared_ptr<const StartRequest> start;
+    };
+
+    static constexpr int ControlReserve = 8;    // 为开始/停止保留的队列空位
+
+    // 会话清单，由写入线程和压缩线程共同更新
+    struct ManifestState {
+        QMutex mutex;
+        QString directory;
+        SessionManifest manifest;
+        void save();
+    };
+
+    bool pushControl(QueueItem &&item);
+
+    // 以下方法只在写入线程中调用
+    void drainQueue();
+    void appendSnapshot(const DataSnapshot &snapshot);
+    void openSession(const std::shared_ptr<const StartRequest> &request);
+    void closeSession();
+    bool openSegment();
+    void closeSegment();
+    void writeOutput();
+
+    // 运行在压缩线程
+    void compressSegment(const std::shared_ptr<ManifestState> &state, int segment, int level);
+
+    SpscQueue<QueueItem> m_queue;
+    int m_queueCapacity;
+    std::atomic<int> m_flushIntervalMs;
+    std::atomic<qint64> m_bufferBytes;
+    std::atomic<double> m_segmentSeconds;
+    std::atomic<qint64> m_segmentBytes;
+    std::atomic<int> m_compressionLevel;
+    bool m_logging;                             // 生产者线程的记录状态
+    std::atomic<quint64> m_snapshotsDropped;
+
+    // 停止线程（m_wakeMutex保护）
+    QMutex m_wakeMutex;
+    QWaitCondition m_wakeCondition;
+    bool m_stopRequested;
+
+    // 当前会话与分段（仅写入线程使用）
+    std::shared_ptr<const StartRequest> m_session;
+    std::shared_ptr<ManifestState> m_manifest;
+    double m_sessionSegmentSeconds;
+    qint64 m_sessionSegmentBytes;
+    int m_sessionCompressionLevel;
+    SessionLogWriter m_writer;
+    int m_segmentIndex;
+    qint64 m_sessionRows;
+    qint64 m_sessionBytes;
+    double m_segmentFirstTime;
+    double m_segmentLastTime;
+    QThreadPool m_compressionPool;              // 分段压缩（单线程，按分段顺序完成）
+    QElapsedTimer m_flushTimer;
+    qint64 m_partialBlockFirstRow;              // 上次刷新时未满数据块的第一行（分段内行号），-1为没有
+    QElapsedTimer m_partialBlockTimer;          // 自发现该未满数据块以来的时间
+    QElapsedTimer m_statsTimer;
+    qint64 m_statsBytes;
+    qint64 m_maxWriteNs;
+};
+
+#endif // SNAPSHOTLOGGER_H
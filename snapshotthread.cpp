@@ -1,15 +1,13 @@
 #include "snapshotthread.h"
+#include "pipelinelatency.h"
 #include <QDir> // Include for QDir::currentPath()
 #include <QSettings>   // +++ 新增 +++
 #include <QStringList> // +++ 新增 +++
 #include <cmath>       // 用于 std::pow 和 round
+#include <algorithm>
 #include <QCoreApplication> // <--- 添加头文件
-#include <QTextCodec> // <--- 添加头文件
-#include <QFile>       // <--- 添加头文件
-#include <QTextStream> // <--- 添加头文件
 
 SnapshotThread::SnapshotThread(QObject *parent) : QObject(parent),
-    logFile(nullptr), logStream(nullptr), snapshotsSinceLastWrite(0), // Initialize new members
     enableDataLogging(true) // 初始化为true，但会被setProcessingEnabled覆盖
 {
     // 初始化计时器
@@ -20,10 +18,34 @@ SnapshotThread::SnapshotThread(QObject *parent) : QObject(parent),
     realTimer->start();
     lastTimestamp = realTimer->elapsed();
 
+    // 快照调度器（作为子对象随本对象移动到快照线程），由setProcessingEnabled启停
+    snapshotScheduler = new PreciseTimer(this);
+    snapshotScheduler->setRate(snapshotRateHz);
+    connect(snapshotScheduler, &PreciseTimer::timeout, this, &SnapshotThread::onSnapshotTick);
+
+    // 派生通道（customData），MainWindow读取配置后通过setDerivedChannels替换
+    QString derivedError;
+    derivedProgram = std::make_shared<const DerivedChannelProgram>(
+        DerivedChannelProgram::compile(DerivedChannelProgram::defaultChannels(), &derivedError));
+
+    // 快照历史（第一个快照到达时按快照布局分配）
+    history = std::make_shared<SnapshotHistory>();
+    rawHistory = std::make_shared<SnapshotHistory>();
+    applyHistoryLimits();
+
+    // 会话日志写入线程（第一次开始记录时启动）
+    sessionLogger = new SnapshotLogger(this);
+    connect(sessionLogger, &SnapshotLogger::loggerStatistics, this, &SnapshotThread::loggerStatistics);
+    connect(sessionLogger, &SnapshotLogger::loggingError, this, [](const QString &message) {
+        qDebug() << "[SnapshotThread] Log writer error:" << message;
+    });
+
     // 初始化滤波相关变量
     filteredValues.resize(16, 0.0); // 默认支持16个通道
 
     // +++ 新增: 加载校准设置 +++
+    // 重新加载时在单线程后台池中构建校准表，多次请求按顺序完成
+    calibrationPool.setMaxThreadCount(1);
     QString calibFilePath = QCoreApplication::applicationDirPath() + "/calibration.ini"; // <--- 修改路径获取方式
     loadCalibrationSettings(calibFilePath);
     // +++ 结束新增 +++
@@ -31,7 +53,9 @@ SnapshotThread::SnapshotThread(QObject *parent) : QObject(parent),
 
 SnapshotThread::~SnapshotThread()
 {
+    calibrationPool.waitForDone(); // 等待正在构建的校准表
     closeLogFile(); // Ensure file is closed on destruction
+    sessionLogger->stopThread(); // 写完队列中的快照后关闭文件
     // 清理资源
     if (masterTimer) {
         delete masterTimer;
@@ -71,8 +95,14 @@ void SnapshotThread::resetMasterTimer()
         setupMasterTimer();
     }
     snapshotCount = 0; // Also reset snapshot count
-    // Reset data buffers if needed, e.g., snapshotQueue.clear(); - uncomment if desired
-    // snapshotQueue.clear();
+    // 调度器与主计时器重新对齐：第k个快照在重置后k个周期处触发
+    if (snapshotScheduler->isActive()) {
+        snapshotScheduler->start();
+        lastSchedulerReportNs = PipelineClock::nowNs();
+    }
+    // 时间戳从0重新开始，清空快照历史
+    history->clear();
+    rawHistory->clear();
 }
 
 // 应用一阶低通滤波器
@@ -115,8 +145,9 @@ QVector<double> SnapshotThread::applyFilterToResults(const QVector<double> &rawD
 }
 
 // 处理Modbus数据
-void SnapshotThread::handleModbusData(QVector<double> resultdata, qint64 readTimeInterval)
+void SnapshotThread::handleModbusData(QVector<double> resultdata, qint64 readTimeInterval, qint64 acquiredNs)
 {
+    PipelineLatency::recordSince(PipelineLatency::ModbusEnqueue, acquiredNs);
     // Add check for processing enabled flag
     if (!processingEnabled) {
         qDebug() << "[SnapshotThread] handleModbusData: Processing disabled, skipping.";
@@ -136,8 +167,6 @@ void SnapshotThread::handleModbusData(QVector<double> resultdata, qint64 readTim
             return;
         }
 
-        qDebug() << "处理Modbus数据: " << resultdata;
-
         // 确保modbusNumRegs与数据大小一致
         if (modbusNumRegs != resultdata.size()) {
             modbusNumRegs = resultdata.size();
@@ -152,6 +181,8 @@ void SnapshotThread::handleModbusData(QVector<double> resultdata, qint64 readTim
         // 更新currentSnapshot使用滤波后的数据
         currentSnapshot.modbusValid = true;
         currentSnapshot.modbusData = filteredData;
+        modbusTrack.append(acquiredNs > 0 ? acquiredNs : PipelineClock::nowNs(),
+                           filteredData.constData(), int(filteredData.size()));
 
         // 保持数据到modbusData，用于兼容其他可能使用它的代码
         // 确保modbusData已经初始化为正确大小
@@ -205,40 +236,36 @@ void SnapshotThread::handleDAQData(const QVector<double> &timeData, const QVecto
         daqIsAcquiring = true;
         daqNumChannels = channelData.size();
 
-        // 保存时间数据
-        daqTimeData = timeData;
-
-        // 确保daqChannelData大小正确
-        if (daqChannelData.size() != daqNumChannels) {
-            daqChannelData.resize(daqNumChannels);
+        // 完整窗口每次包含最近的全部样本，只追加时间晚于上次保存的部分
+        int newStart = 0;
+        while (newStart < timeData.size() && timeData[newStart] <= daqLastWindowTime) {
+            ++newStart;
         }
-
-        // 保存通道数据
-        for (int i = 0; i < daqNumChannels; i++) {
-            // 追加新数据
-            daqChannelData[i].append(channelData[i]);
-
-            // 限制数据点数量
-            const int maxPoints = 10000;
-            while (daqChannelData[i].size() > maxPoints) {
-                daqChannelData[i].removeFirst();
+        const int newCount = int(timeData.size()) - newStart;
+        const double sampleRate = timeData.size() > 1 ? 1.0 / (timeData[1] - timeData[0]) : 0.0;
+        if (newCount > 0 && sampleRate > 0.0 && ensureDAQHistory(daqNumChannels, sampleRate, newCount)) {
+            const qint64 firstIndex = qint64(std::llround(timeData[newStart] * sampleRate));
+            if (daqHistory->beginWrite(qMax(firstIndex, daqHistory->endIndex()), newCount)) {
+                for (int i = 0; i < daqNumChannels; i++) {
+                    if (channelData[i].size() == timeData.size()) {
+                        daqHistory->writeChannel(i, channelData[i].constData() + newStart);
+                    }
+                }
+                daqHistory->commitWrite();
             }
+            daqLastWindowTime = timeData.last();
         }
 
         // 更新当前快照中的DAQ数据
         currentSnapshot.daqValid = true;
         currentSnapshot.daqRunning = true;
 
-        // 如果daqChannelData不为空，更新快照中的DAQ数据
-        if (!daqChannelData.isEmpty()) {
+        // 如果历史不为空，使用最新的数据点更新快照中的DAQ数据
+        if (daqHistory && daqHistory->size() > 0) {
             currentSnapshot.daqData.resize(daqNumChannels);
             for (int i = 0; i < daqNumChannels; i++) {
-                if (!daqChannelData[i].isEmpty()) {
-                    // 使用最新的数据点
-                    currentSnapshot.daqData[i] = daqChannelData[i].last();
-                } else {
-                    currentSnapshot.daqData[i] = 0.0;
-                }
+                const HistorySpan latest = daqHistory->latest(i, 1);
+                currentSnapshot.daqData[i] = latest.isEmpty() ? 0.0 : latest.last();
             }
         }
 
@@ -249,9 +276,265 @@ void SnapshotThread::handleDAQData(const QVector<double> &timeData, const QVecto
     }
 }
 
+// 处理DAQ增量数据块
+void SnapshotThread::handleDAQBlock(const DAQDataBlock &block)
+{
+    PipelineLatency::recordSince(PipelineLatency::DAQEnqueue, block.timestampNs);
+    try {
+        if (block.numChannels <= 0 || block.samplesPerChannel <= 0) {
+            qDebug() << "警告: 收到空的DAQ数据块";
+            return;
+        }
+
+        // 序号为0表示新一轮采集开始，清空历史数据（换用新的存储，仍在读取旧存储的线程不受影响）
+        if (block.sequence == 0) {
+            std::atomic_store(&daqHistory, std::shared_ptr<DAQHistoryStore>());
+            daqNextBlockSequence = 0;
+            daqLostBlocks = 0;
+            daqDecimatorDirty = true;
+            daqWindowStats.clear();
+            daqTrack.reset();
+            daqClockValid = false;
+        } else if (block.sequence != daqNextBlockSequence) {
+            daqLostBlocks += block.sequence - daqNextBlockSequence;
+            qDebug() << "[SnapshotThread] DAQ数据块不连续: 期望" << daqNextBlockSequence
+                     << "收到" << block.sequence << "，累计丢失" << daqLostBlocks;
+        }
+        daqNextBlockSequence = block.sequence + 1;
+
+        // 更新DAQ状态
+        daqIsAcquiring = true;
+        daqNumChannels = block.numChannels;
+
+        // 全速率历史：通道数、采样率或块大小变化时重新分配
+        const bool historyReady = ensureDAQHistory(daqNumChannels, block.sampleRate, block.samplesPerChannel)
+                                  && daqHistory->beginWrite(block.firstSampleIndex, block.samplesPerChannel);
+
+        // 累加窗口统计（覆盖每一个全速率样本）
+        if (daqWindowStats.size() != daqNumChannels) {
+            daqWindowStats.resize(daqNumChannels);
+        }
+        if (daqDecimatorDirty || daqDecimatorChannels != daqNumChannels
+            || daqDecimatorInputRate != block.sampleRate) {
+            configureDAQDecimator(block);
+        }
+
+        // 逐通道处理：原始码值数据块先批量换算为电压（每通道只换算一次），
+        // 再追加到历史数据、累加统计并送入抗混叠抽取器
+        if (block.isRaw() && daqScratch.size() < block.samplesPerChannel) {
+            daqScratch.resize(block.samplesPerChannel);
+        }
+        for (int ch = 0; ch < daqNumChannels; ++ch) {
+            const double *src = block.channel(ch);
+            if (block.isRaw()) {
+                block.channelToVolts(ch, daqScratch.data());
+                src = daqScratch.constData();
+            }
+            if (historyReady) {
+                daqHistory->writeChannel(ch, src);
+            }
+            accumulateWindowStats(src, block.samplesPerChannel, &daqWindowStats[ch]);
+            if (daqDecimator.isConfigured()) {
+                daqDecimator.process(ch, src, block.samplesPerChannel);
+            }
+        }
+
+        if (historyReady) {
+            daqHistory->commitWrite();
+        }
+
+        // 更新当前快照中的DAQ数据（每个通道的最新值）：
+        // 优先使用快照速率的抽取输出，抽取器不可用时退回到原始最新样本
+        currentSnapshot.daqValid = true;
+        currentSnapshot.daqRunning = true;
+        currentSnapshot.daqData.resize(daqNumChannels);
+        for (int ch = 0; ch < daqNumChannels; ++ch) {
+            if (daqSnapshotStage >= 0) {
+                const std::vector<double> &out = daqDecimator.output(ch, daqSnapshotStage);
+                if (!out.empty()) {
+                    currentSnapshot.daqData[ch] = out.back();
+                }
+            } else {
+                const HistorySpan latest = daqHistory ? daqHistory->latest(ch, 1) : HistorySpan();
+                currentSnapshot.daqData[ch] = latest.isEmpty() ? 0.0 : latest.last();
+            }
+        }
+
+        appendDAQFrames(block);
+
+        // 绘图速率的抽取输出写入绘图历史（DAQ图表从中读取）
+        if (daqPlotStage >= 0 && daqPlotHistory) {
+            const int count = int(daqDecimator.output(0, daqPlotStage).size());
+            if (count > 0 && daqPlotHistory->beginWrite(daqDecimator.outputOffset(0, daqPlotStage), count)) {
+                for (int ch = 0; ch < daqNumChannels; ++ch) {
+                    daqPlotHistory->writeChannel(ch, daqDecimator.output(ch, daqPlotStage).data());
+                }
+                daqPlotHistory->commitWrite();
+            }
+        }
+
+    } catch (const std::exception& e) {
+        qDebug() << "处理DAQ数据块时出错: " << e.what();
+    } catch (...) {
+        qDebug() << "处理DAQ数据块时发生未知错误";
+    }
+}
+
+// 把DAQ数据块中快照速率的抽取输出（带采集时间）追加到时间对齐轨道
+void SnapshotThread::appendDAQFrames(const DAQDataBlock &block)
+{
+    if (block.sampleRate <= 0.0) {
+        return;
+    }
+
+    // DAQ时钟：每块的最后一个样本约在回调读出时刻采集，取各块估计的最小值以滤除回调延迟抖动
+    const qint64 lastIndex = block.firstSampleIndex + block.samplesPerChannel - 1;
+    const qint64 readNs = block.timestampNs > 0 ? block.timestampNs : PipelineClock::nowNs();
+    const qint64 offsetNs = readNs - qint64(std::llround(lastIndex * 1e9 / block.sampleRate));
+    if (!daqClockValid || offsetNs < daqClockOffsetNs) {
+        daqClockOffsetNs = offsetNs;
+        daqClockValid = true;
+    }
+
+    if (daqFrameScratch.size() != daqNumChannels) {
+        daqFrameScratch.resize(daqNumChannels);
+    }
+
+    if (daqSnapshotStage < 0) {
+        // 没有快照速率的抽取输出：追加最新的全速率样本
+        for (int ch = 0; ch < daqNumChannels; ++ch) {
+            daqFrameScratch[ch] = currentSnapshot.daqData.value(ch);
+        }
+        daqTrack.append(daqClockOffsetNs + qint64(std::llround(lastIndex * 1e9 / block.sampleRate)),
+                        daqFrameScratch.constData(), daqNumChannels);
+        return;
+    }
+
+    // 抽取输出第m个样本约对应输入序号 (m + 1) * 抽取比 - 1，再扣除抽取滤波器的群延迟；
+    // 只追加轨道能保存的最近几帧
+    const double outputRate = daqDecimator.stageOutputRate(daqSnapshotStage);
+    const double delaySeconds = daqDecimator.groupDelay(daqSnapshotStage) + 1.0 / block.sampleRate;
+    const int count = int(daqDecimator.output(0, daqSnapshotStage).size());
+    const qint64 firstOutput = daqDecimator.outputOffset(0, daqSnapshotStage);
+    for (int j = qMax(0, count - daqTrack.depth()); j < count; ++j) {
+        for (int ch = 0; ch < daqNumChannels; ++ch) {
+            daqFrameScratch[ch] = daqDecimator.output(ch, daqSnapshotStage)[size_t(j)];
+        }
+        const double seconds = (firstOutput + j + 1) / outputRate - delaySeconds;
+        daqTrack.append(daqClockOffsetNs + qint64(std::llround(seconds * 1e9)),
+                        daqFrameScratch.constData(), daqNumChannels);
+    }
+}
+
+// 设置DAQ抽取输出速率
+void SnapshotThread::setDAQHistoryDuration(double seconds)
+{
+    daqHistorySeconds = qMax(1.0, seconds);
+    qDebug() << "[SnapshotThread] DAQ历史保存时长设置为:" << daqHistorySeconds << "秒（下一轮采集生效）";
+}
+
+std::shared_ptr<const DAQHistoryStore> SnapshotThread::daqHistoryStore() const
+{
+    return std::atomic_load(&daqHistory);
+}
+
+std::shared_ptr<const DAQHistoryStore> SnapshotThread::daqPlotHistoryStore() const
+{
+    return std::atomic_load(&daqPlotHistory);
+}
+
+// 确保全速率历史存储与当前数据格式一致，需要时重新分配（旧存储由仍持有它的读者释放）
+bool SnapshotThread::ensureDAQHistory(int channels, double sampleRate, int blockSize)
+{
+    if (daqHistory && daqHistory->channelCount() == channels && daqHistory->sampleRate() == sampleRate
+        && daqHistory->maxBlockSize() >= size_t(blockSize)) {
+        return true;
+    }
+
+    // 按时长计算历史长度，并受内存上限约束
+    const double bytesPerSample = double(channels) * sizeof(double);
+    // 容量向上取整为2的幂，最多为历史长度的2倍
+    const double maxSamples = double(daqHistoryMaxBytes) / bytesPerSample / 2.0;
+    const size_t historySamples = size_t(qMax(1.0, qMin(daqHistorySeconds * sampleRate, maxSamples)));
+    const size_t maxBlock = size_t(qMax(blockSize, int(sampleRate / 10.0)));
+
+    auto store = std::make_shared<DAQHistoryStore>();
+    if (!store->allocate(channels, historySamples, maxBlock, sampleRate)) {
+        qDebug() << "[SnapshotThread] 分配DAQ历史存储失败:" << channels << "通道," << historySamples << "样本";
+        std::atomic_store(&daqHistory, std::shared_ptr<DAQHistoryStore>());
+        return false;
+    }
+    std::atomic_store(&daqHistory, store);
+    qDebug() << "[SnapshotThread] DAQ历史存储:" << channels << "通道，" << store->historyLength() << "样本/通道（"
+             << store->historyLength() / sampleRate << "秒），占用" << store->capacity() * channels * sizeof(double) / (1 << 20) << "MB";
+    return true;
+}
+
+void SnapshotThread::setDAQDecimationRates(double plotRate, double snapshotRate)
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, plotRate, snapshotRate]() { setDAQDecimationRates(plotRate, snapshotRate); },
+                                  Qt::QueuedConnection);
+        return;
+    }
+    daqPlotRate = plotRate;
+    daqSnapshotRate = snapshotRate;
+    daqDecimatorDirty = true;
+    qDebug() << "[SnapshotThread] DAQ抽取速率设置为: 绘图" << plotRate << "Hz, 快照" << snapshotRate << "Hz";
+}
+
+// 按数据块的采样率和通道数配置抽取器
+void SnapshotThread::configureDAQDecimator(const DAQDataBlock &block)
+{
+    daqDecimatorDirty = false;
+    daqDecimatorInputRate = block.sampleRate;
+    daqDecimatorChannels = block.numChannels;
+    daqPlotStage = -1;
+    daqSnapshotStage = -1;
+    std::atomic_store(&daqPlotHistory, std::shared_ptr<DAQHistoryStore>());
+
+    // 优先 全速率->绘图速率->快照速率；比例不为整数时只保留快照速率
+    std::vector<double> rates;
+    if (daqPlotRate > 0.0 && daqPlotRate < block.sampleRate) {
+        rates.push_back(daqPlotRate);
+    }
+    rates.push_back(daqSnapshotRate);
+    bool ok = daqDecimator.configure(block.sampleRate, rates, block.numChannels);
+    if (!ok && rates.size() > 1) {
+        ok = daqDecimator.configure(block.sampleRate, std::vector<double>{daqSnapshotRate}, block.numChannels);
+    }
+    if (!ok) {
+        qDebug() << "[SnapshotThread] 采样率" << block.sampleRate << "Hz无法整数抽取到快照速率"
+                 << daqSnapshotRate << "Hz，快照使用原始最新样本";
+        return;
+    }
+
+    daqPlotStage = daqDecimator.stageForRate(daqPlotRate);
+    daqSnapshotStage = daqDecimator.stageForRate(daqSnapshotRate);
+
+    // 绘图速率历史：与全速率历史保存相同时长；每块最多输出 块长/抽取比 + 1 个样本，
+    // 写入余量至少留1秒，数据块变长时不必重新配置
+    if (daqPlotStage >= 0) {
+        const double plotRate = daqDecimator.stageOutputRate(daqPlotStage);
+        const size_t historySamples = size_t(qMax(1.0, daqHistorySeconds * plotRate));
+        const size_t maxBlock = size_t(qMax(std::ceil(block.samplesPerChannel * plotRate / block.sampleRate) + 1.0,
+                                            plotRate));
+        auto store = std::make_shared<DAQHistoryStore>();
+        if (store->allocate(block.numChannels, historySamples, maxBlock, plotRate)) {
+            std::atomic_store(&daqPlotHistory, store);
+        } else {
+            qDebug() << "[SnapshotThread] 分配DAQ绘图历史失败:" << block.numChannels << "通道," << historySamples << "样本";
+        }
+    }
+    qDebug() << "[SnapshotThread] DAQ抽取器已配置:" << daqDecimator.stageCount() << "级, 每通道约"
+             << daqDecimator.macsPerSecond() << "次乘加/秒, 快照群延迟"
+             << (daqSnapshotStage >= 0 ? daqDecimator.groupDelay(daqSnapshotStage) : 0.0) << "秒";
+}
+
 // 处理ECU数据
 void SnapshotThread::handleECUData(const ECUData &data)
 {
+    PipelineLatency::recordSince(PipelineLatency::ECUEnqueue, data.acquiredNs);
     // 在 snapshotthread.cpp 的 handleECUData 开头
     qDebug() << "[SnapshotThread] handleECUData called. Received data isValid:" << data.isValid;
 
@@ -290,6 +573,8 @@ void SnapshotThread::handleECUData(const ECUData &data)
         // 更新当前快照，以便processDataSnapshots能够获取最新数据
         currentSnapshot.ecuValid = true;
         currentSnapshot.ecuData = ecuValues;
+        ecuTrack.append(data.acquiredNs > 0 ? data.acquiredNs : PipelineClock::nowNs(),
+                        ecuValues.constData(), int(ecuValues.size()));
 
         // 调试信息
         qDebug() << "收到ECU数据: 节气门=" << data.throttle
@@ -320,12 +605,13 @@ void SnapshotThread::handleECUConnectionStatus(bool connected, QString message)
 
         // 更新当前快照中的ECU状态
         currentSnapshot.ecuValid = false;
+        ecuTrack.reset();
     }
 
     qDebug() << "===> 更新后的ECU状态: 已连接=" << snapEcuIsConnected << ", 数据有效=" << ecuDataValid;
 
-    // 手动触发数据快照处理，确保状态变化立即反映
-    QMetaObject::invokeMethod(this, &SnapshotThread::processDataSnapshots, Qt::QueuedConnection);
+    // 不在这里额外生成快照：状态变化由调度器按固定速率生成的下一个快照反映，
+    // 额外的快照会打乱快照间隔，并把DAQ窗口统计在窗口中途截断
 }
 
 // 处理数据快照
@@ -342,43 +628,102 @@ void SnapshotThread::processDataSnapshots()
             return;
         }
 
-        double currentTime = (masterTimer->elapsed() / 1000.0);
-        double roundedTime = round(currentTime * 10.0) / 10.0;
+        // 快照时刻：当前时间减去对齐延后量（主计时器纳秒精度，不取整），各数据源重采样到这一时刻
+        const qint64 tickNs = PipelineClock::nowNs();
+        const qint64 snapshotNs = tickNs - alignmentDelayNs;
+        const double currentTime = (masterTimer->nsecsElapsed() - alignmentDelayNs) / 1e9;
 
-        // 创建一个快照用于存储原始数据
-        DataSnapshot rawSnapshot;
-        rawSnapshot.timestamp = roundedTime;
+        // 从快照池取一个快照用于存储原始数据（复用已分配的缓冲区，原地填充全部字段）
+        SnapshotHandle rawHandle = snapshotPool.acquire();
+        DataSnapshot &rawSnapshot = *rawHandle.uniqueData();
+        rawSnapshot.timestamp = currentTime;
         rawSnapshot.snapshotIndex = snapshotCount + 1; // Use upcoming index
+        rawSnapshot.tickNs = tickNs;
+        rawSnapshot.acquiredNs = 0;
+        rawSnapshot.builtNs = 0;
+        rawSnapshot.publishedNs = 0;
+        // 所用数据的采集时刻（快照时刻减去时效），取各数据源中最早的一个
+        auto noteAcquired = [&rawSnapshot, snapshotNs](qint64 ageNs) {
+            const qint64 acquiredNs = snapshotNs - ageNs;
+            if (rawSnapshot.acquiredNs == 0 || acquiredNs < rawSnapshot.acquiredNs) {
+                rawSnapshot.acquiredNs = acquiredNs;
+            }
+        };
 
         // 1. 填充 rawSnapshot (在应用滤波和校准之前)
         // Modbus (使用 currentSnapshot 中的滤波后但未校准的数据)
         rawSnapshot.modbusValid = currentSnapshot.modbusValid;
-        if(rawSnapshot.modbusValid) {
-            rawSnapshot.modbusData = currentSnapshot.modbusData; // Data after filter, before calibration
+        rawSnapshot.modbusAge = -1.0;
+        if (rawSnapshot.modbusValid && !modbusTrack.isEmpty()) {
+            // Data after filter, before calibration, resampled to the snapshot instant
+            qint64 ageNs = 0;
+            rawSnapshot.modbusData.resize(modbusTrack.channelCount());
+            modbusTrack.sample(snapshotNs, modbusResample, rawSnapshot.modbusData.data(),
+                               int(rawSnapshot.modbusData.size()), &ageNs);
+            rawSnapshot.modbusAge = PipelineClock::toSeconds(ageNs);
+            noteAcquired(ageNs);
+        } else if(rawSnapshot.modbusValid) {
+            DataSnapshot::assignValues(rawSnapshot.modbusData, currentSnapshot.modbusData); // Data after filter, before calibration
         } else {
             rawSnapshot.modbusData.fill(0.0, configuredModbusChannels > 0 ? configuredModbusChannels : 16);
         }
 
-        // DAQ (使用 currentSnapshot 中的最新原始数据)
+        // DAQ (使用 currentSnapshot 中经抗混叠抽取后的最新数据，未校准)
         rawSnapshot.daqValid = daqIsAcquiring && daqNumChannels > 0;
         rawSnapshot.daqRunning = daqIsAcquiring;
-        if (rawSnapshot.daqValid && !daqChannelData.isEmpty()) {
+        rawSnapshot.daqAge = -1.0;
+        if (rawSnapshot.daqValid && daqHistory && daqHistory->size() > 0) {
             rawSnapshot.daqData.resize(daqNumChannels);
-            for (int i = 0; i < daqNumChannels && i < daqChannelData.size(); ++i) {
-                if (!daqChannelData[i].isEmpty()) {
-                    rawSnapshot.daqData[i] = daqChannelData[i].last(); // Last raw point
-                } else {
-                    rawSnapshot.daqData[i] = 0.0;
+            if (daqTrack.channelCount() == daqNumChannels && !daqTrack.isEmpty()) {
+                qint64 ageNs = 0;
+                daqTrack.sample(snapshotNs, daqResample, rawSnapshot.daqData.data(), daqNumChannels, &ageNs);
+                rawSnapshot.daqAge = PipelineClock::toSeconds(ageNs);
+                noteAcquired(ageNs);
+            } else {
+                for (int i = 0; i < daqNumChannels; ++i) {
+                    rawSnapshot.daqData[i] = i < currentSnapshot.daqData.size() ? currentSnapshot.daqData[i] : 0.0;
                 }
             }
+
+            // 窗口统计：取出自上次快照以来的聚合值并开始新窗口；本窗口无新样本时保持上次的值
+            currentSnapshot.daqMin.resize(daqNumChannels);
+            currentSnapshot.daqMax.resize(daqNumChannels);
+            currentSnapshot.daqMean.resize(daqNumChannels);
+            currentSnapshot.daqRms.resize(daqNumChannels);
+            for (int i = 0; i < daqNumChannels && i < daqWindowStats.size(); ++i) {
+                WindowStats &stats = daqWindowStats[i];
+                if (!stats.isEmpty()) {
+                    currentSnapshot.daqMin[i] = stats.min;
+                    currentSnapshot.daqMax[i] = stats.max;
+                    currentSnapshot.daqMean[i] = stats.mean();
+                    currentSnapshot.daqRms[i] = stats.rms();
+                    stats.reset();
+                }
+            }
+            DataSnapshot::assignValues(rawSnapshot.daqMin, currentSnapshot.daqMin);
+            DataSnapshot::assignValues(rawSnapshot.daqMax, currentSnapshot.daqMax);
+            DataSnapshot::assignValues(rawSnapshot.daqMean, currentSnapshot.daqMean);
+            DataSnapshot::assignValues(rawSnapshot.daqRms, currentSnapshot.daqRms);
         } else {
-            rawSnapshot.daqData.fill(0.0, configuredDaqChannels > 0 ? configuredDaqChannels : 16);
+            const int daqChannels = configuredDaqChannels > 0 ? configuredDaqChannels : 16;
+            rawSnapshot.daqData.fill(0.0, daqChannels);
+            rawSnapshot.daqMin.fill(0.0, daqChannels);
+            rawSnapshot.daqMax.fill(0.0, daqChannels);
+            rawSnapshot.daqMean.fill(0.0, daqChannels);
+            rawSnapshot.daqRms.fill(0.0, daqChannels);
         }
 
         // ECU (使用 latestECUData 中的原始数据)
         rawSnapshot.ecuValid = snapEcuIsConnected && latestECUData.isValid;
         rawSnapshot.ecuData.resize(9);
-        if (rawSnapshot.ecuValid) {
+        rawSnapshot.ecuAge = -1.0;
+        if (rawSnapshot.ecuValid && !ecuTrack.isEmpty()) {
+            qint64 ageNs = 0;
+            rawSnapshot.ecuData.fill(0.0);
+            ecuTrack.sample(snapshotNs, ecuResample, rawSnapshot.ecuData.data(), 9, &ageNs);
+            rawSnapshot.ecuAge = PipelineClock::toSeconds(ageNs);
+            noteAcquired(ageNs);
+        } else if (rawSnapshot.ecuValid) {
             rawSnapshot.ecuData[0] = latestECUData.throttle;
             rawSnapshot.ecuData[1] = latestECUData.engineSpeed;
             rawSnapshot.ecuData[2] = latestECUData.cylinderTemp;
@@ -392,93 +737,79 @@ void SnapshotThread::processDataSnapshots()
             rawSnapshot.ecuData.fill(0.0);
         }
 
-        // Custom Data (计算基于 *原始* DAQ 和 ECU 数据)
-        rawSnapshot.customData.resize(5);
-        rawSnapshot.customData.fill(0.0);
-        if (rawSnapshot.daqValid && rawSnapshot.ecuValid && rawSnapshot.daqData.size() >= 3 && rawSnapshot.ecuData.size() >= 9) {
-            rawSnapshot.customData[0] = rawSnapshot.daqData[0] * rawSnapshot.ecuData[0]*10.0;
-            rawSnapshot.customData[1] = rawSnapshot.daqData[1] * rawSnapshot.ecuData[1];
-            rawSnapshot.customData[2] = rawSnapshot.daqData[2] * rawSnapshot.ecuData[2];
-            // rawSnapshot.customData[3] = 0.0; // Already filled
-            // rawSnapshot.customData[4] = 0.0; // Already filled
-        }
+        // Custom Data：派生通道（计算基于 *原始* 数据，校准、记录和发布之前只计算一次）
+        derivedProgram->evaluate(rawSnapshot, derivedRegisters);
+        rawSnapshot.builtNs = PipelineClock::nowNs();
+        PipelineLatency::record(PipelineLatency::SnapshotBuild, rawSnapshot.builtNs - tickNs);
 
         // +++ Emit raw snapshot signal +++
-        emit rawSnapshotReady(rawSnapshot);
+        // 发出后rawSnapshot由各接收者共享，不再修改
+        rawHistory->append(rawSnapshot);
+        emit rawSnapshotReady(rawHandle);
 
-        // 2. 创建用于处理和发送的快照 (从 rawSnapshot 开始)
-        DataSnapshot snapshot = rawSnapshot; // Start with a copy of the raw data
+        // 2. 创建用于处理和发送的快照 (从 rawSnapshot 原地复制)
+        SnapshotHandle handle = snapshotPool.acquire();
+        DataSnapshot &snapshot = *handle.uniqueData();
+        snapshot.copyFrom(rawSnapshot);
 
         // --- Apply Calibration --- (Apply to the 'snapshot' object)
+        // 每个快照都会经过这里（最高1kHz），不逐个打印快照数据
+        // 取当前校准表的引用，整个快照使用同一张表（重新加载时不会中途切换）
+        const std::shared_ptr<const CalibrationTable> table = std::atomic_load(&calibrationTable);
+        static const CalibrationTable emptyTable;
+        const CalibrationTable &calibration = table ? *table : emptyTable;
+
         // Modbus Calibration
         if (snapshot.modbusValid) {
-            for(int i = 0; i < snapshot.modbusData.size(); ++i) {
-                CalibrationParams params = getCalibrationParams("Modbus", i);
-                double rawValue = snapshot.modbusData[i]; // Value before calibration
-                snapshot.modbusData[i] = applyCalibration(rawValue, params); // Apply calibration
-            }
-            qDebug() << "快照" << snapshot.snapshotIndex << "Modbus数据有效 (已校准)，数据:" << snapshot.modbusData;
+            calibration.apply(CalibrationTable::Modbus, snapshot.modbusData.data(), int(snapshot.modbusData.size()));
         }
 
         // DAQ Calibration
         if (snapshot.daqValid) {
-            for(int i = 0; i < snapshot.daqData.size(); ++i) {
-                 CalibrationParams params = getCalibrationParams("DAQ", i);
-                 double rawValue = snapshot.daqData[i];
-                 snapshot.daqData[i] = applyCalibration(rawValue, params);
-            }
-            qDebug() << "快照" << snapshot.snapshotIndex << "DAQ数据有效 (已校准)，通道数:" << daqNumChannels << "数据:" << snapshot.daqData;
+            calibration.apply(CalibrationTable::DAQ, snapshot.daqData.data(), int(snapshot.daqData.size()));
+            applyCalibrationToDAQStats(snapshot, rawSnapshot.daqMean, rawSnapshot.daqRms, calibration);
         }
 
         // ECU Calibration
         if (snapshot.ecuValid) {
-            for(int i = 0; i < 9; ++i) {
-                CalibrationParams params = getCalibrationParams("ECU", i);
-                double rawValue = snapshot.ecuData[i];
-                snapshot.ecuData[i] = applyCalibration(rawValue, params);
-            }
-            qDebug() << "快照" << snapshot.snapshotIndex << "ECU数据有效 (已校准)，数据:" << snapshot.ecuData;
+            calibration.apply(CalibrationTable::ECU, snapshot.ecuData.data(), qMin(9, int(snapshot.ecuData.size())));
         }
 
         // Custom Data Calibration (Apply to the calculated custom values)
-        if (snapshot.daqValid && snapshot.ecuValid) { // Only apply if inputs were valid
-            for(int i = 0; i < 5; ++i) {
-                 snapshot.customData[i] = applyCalibration(snapshot.customData[i], getCalibrationParams("Custom", i));
+        // 无效的派生通道保持为0（customValid为false），记录和历史中为无效值
+        calibration.apply(CalibrationTable::Custom, snapshot.customData.data(), int(snapshot.customData.size()));
+        for (int i = 0; i < snapshot.customData.size(); ++i) {
+            if (!snapshot.customValid[i]) {
+                snapshot.customData[i] = 0.0;
             }
-            qDebug() << "[SnapshotThread] Calibrated customData:" << snapshot.customData;
         }
         // --- End Apply Calibration ---
 
+        snapshot.publishedNs = PipelineClock::nowNs();
+        PipelineLatency::record(PipelineLatency::Calibrate, snapshot.publishedNs - snapshot.builtNs);
+
         // 增加快照计数 (移到此处，确保在处理完成后增加)
         snapshotCount++;
         snapshot.snapshotIndex = snapshotCount; // Update index in the final snapshot
 
-        // 将 *校准后* 的快照添加到队列中
-        snapshotQueue.enqueue(snapshot);
-        while (snapshotQueue.size() > 300) {
-            snapshotQueue.dequeue();
-        }
+        // 将 *校准后* 的快照追加到快照历史（绘图、WebSocket补发从历史查询）
+        history->append(snapshot);
 
         // --- Logging Logic --- (Logs the *calibrated* snapshot)
-        if (enableDataLogging && logFile && logStream && logFile->isOpen()) {
-            writeSnapshotToFile(snapshot);
-            snapshotsSinceLastWrite++;
-            if (snapshotsSinceLastWrite >= writeThreshold) {
-                logStream->flush();
-                snapshotsSinceLastWrite = 0;
-            }
+        if (enableDataLogging && sessionLogger->isLogging()) {
+            writeSnapshotToFile(handle);
         } else {
-            if (!enableDataLogging && logFile && logFile->isOpen()) {
+            if (!enableDataLogging && sessionLogger->isLogging()) {
                 closeLogFile();
             }
         }
         // --- End Logging Logic ---
 
         // 发送 *校准后* 的数据快照到WebSocket
-        emit snapshotForWebSocket(snapshot, snapshotCount);
+        emit snapshotForWebSocket(handle, snapshotCount);
 
         // 发送 *校准后* 的处理好的快照，让主线程更新UI
-        emit snapshotProcessed(snapshot, snapshotCount);
+        emit snapshotProcessed(handle, snapshotCount);
 
     } catch (const std::exception& e) {
         qDebug() << "处理数据快照时出错: " << e.what();
@@ -506,12 +837,132 @@ void SnapshotThread::setFilterEnabled(bool enabled, double timeConstant)
              << "时间常数:" << filterTimeConstant << "秒";
 }
 
+// 设置快照速率
+void SnapshotThread::setSnapshotRate(double hz)
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, hz]() { setSnapshotRate(hz); }, Qt::QueuedConnection);
+        return;
+    }
+    if (!(hz > 0.0)) {
+        qDebug() << "[SnapshotThread] Invalid snapshot rate:" << hz;
+        return;
+    }
+    snapshotRateHz = qBound(0.1, hz, 1000.0);
+    snapshotScheduler->setRate(snapshotRateHz);
+    applyHistoryLimits();
+    // DAQ抽取器的快照级跟随快照速率，否则快照中的DAQ值仍是10Hz抽取输出
+    setDAQDecimationRates(daqPlotRate, snapshotRateHz);
+    qDebug() << "[SnapshotThread] Snapshot rate set to" << snapshotRateHz << "Hz";
+}
+
+// 替换派生通道定义：在本线程中编译，公式有误时保留原定义
+void SnapshotThread::setDerivedChannels(const QVector<DerivedChannel> &channels)
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, channels]() { setDerivedChannels(channels); }, Qt::QueuedConnection);
+        return;
+    }
+    QString error;
+    DerivedChannelProgram program = DerivedChannelProgram::compile(channels, &error);
+    if (!error.isEmpty()) {
+        qDebug() << "[SnapshotThread] 派生通道编译失败，保留原定义:" << error;
+        emit derivedChannelsError(error);
+        return;
+    }
+    derivedProgram = std::make_shared<const DerivedChannelProgram>(std::move(program));
+    qDebug() << "[SnapshotThread] 派生通道:" << derivedProgram->channelNames();
+    emit derivedChannelsChanged(derivedProgram->channelNames());
+}
+
+// 设置快照历史的保存时长
+void SnapshotThread::setHistoryDuration(double seconds)
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, seconds]() { setHistoryDuration(seconds); }, Qt::QueuedConnection);
+        return;
+    }
+    historySeconds = qMax(1.0, seconds);
+    applyHistoryLimits();
+    qDebug() << "[SnapshotThread] 快照历史保存时长设置为:" << historySeconds << "秒";
+}
+
+// 按保存时长和快照速率设置历史容量；原始快照历史只保存较短时长
+void SnapshotThread::applyHistoryLimits()
+{
+    history->setLimits(qint64(std::ceil(historySeconds * snapshotRateHz)), historyMaxBytes);
+    rawHistory->setLimits(qint64(std::ceil(qMin(historySeconds, rawHistorySeconds) * snapshotRateHz)), historyMaxBytes / 4);
+}
+
+// 设置数据源的重采样方式
+void SnapshotThread::setResampleMode(const QString &source, const QString &mode)
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, source, mode]() { setResampleMode(source, mode); }, Qt::QueuedConnection);
+        return;
+    }
+    const ResampleMode resample = mode.compare("hold", Qt::CaseInsensitive) == 0 ? ResampleMode::ZeroOrderHold
+                                                                                 : ResampleMode::Linear;
+    if (source.compare("Modbus", Qt::CaseInsensitive) == 0) {
+        modbusResample = resample;
+    } else if (source.compare("DAQ", Qt::CaseInsensitive) == 0) {
+        daqResample = resample;
+    } else if (source.compare("ECU", Qt::CaseInsensitive) == 0) {
+        ecuResample = resample;
+    } else {
+        qDebug() << "[SnapshotThread] Unknown resample source:" << source;
+        return;
+    }
+    qDebug() << "[SnapshotThread]" << source << "resample mode set to"
+             << (resample == ResampleMode::Linear ? "linear" : "hold");
+}
+
+// 设置快照时刻的对齐延后量
+void SnapshotThread::setAlignmentDelay(double ms)
+{
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, ms]() { setAlignmentDelay(ms); }, Qt::QueuedConnection);
+        return;
+    }
+    alignmentDelayNs = qint64(std::llround(qBound(0.0, ms, 10000.0) * 1e6));
+    qDebug() << "[SnapshotThread] Snapshot alignment delay set to" << PipelineClock::toMilliseconds(alignmentDelayNs) << "ms";
+}
+
+// 调度器触发：生成快照并定期报告错过的截止时间
+void SnapshotThread::onSnapshotTick(qint64 deadlineNs, quint64 tick)
+{
+    Q_UNUSED(tick);
+    processDataSnapshots();
+
+    if (deadlineNs - lastSchedulerReportNs >= 1000000000LL) {
+        lastSchedulerReportNs = deadlineNs;
+        const double maxLatenessMs = PipelineClock::toMilliseconds(snapshotScheduler->maxLatenessNs());
+        if (snapshotScheduler->missedDeadlines() > 0) {
+            qDebug() << "[SnapshotThread] Missed snapshot deadlines:" << snapshotScheduler->missedDeadlines()
+                     << "max lateness (ms):" << maxLatenessMs;
+        }
+        emit schedulerStatistics(snapshotScheduler->tickCount(), snapshotScheduler->missedDeadlines(), maxLatenessMs);
+        snapshotScheduler->resetMaxLateness();
+    }
+}
+
 // Modified slot to handle processing and logging state
 void SnapshotThread::setProcessingEnabled(bool enabled)
 {
     processingEnabled = enabled;
     qDebug() << "[SnapshotThread] Processing enabled set to:" << processingEnabled;
 
+    // 启停快照调度
+    if (enabled) {
+        if (!snapshotScheduler->isActive()) {
+            snapshotScheduler->start();
+            lastSchedulerReportNs = PipelineClock::nowNs();
+            qDebug() << "[SnapshotThread] Snapshot scheduler started at" << snapshotScheduler->rate() << "Hz";
+        }
+    } else {
+        snapshotScheduler->stop();
+    }
+
     // Link data logging enable state to processing state by default
     // setDataLoggingEnabled(enabled); // Let MainWindow manage logging explicitly for calibration
 
@@ -533,133 +984,70 @@ void SnapshotThread::setProcessingEnabled(bool enabled)
 
 bool SnapshotThread::initializeLogFile()
 {
-    if (logFile) { // Already initialized
+    if (sessionLogger->isLogging()) { // Already initialized
         return true;
     }
+    if (!sessionLogger->isRunning()) {
+        sessionLogger->start();
+    }
 
-    // Create filename with timestamp
+    // 每次记录一个以时间命名的会话目录，其中为分段日志和清单（manifest.json）
     QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
-    logFilePath = QDir::currentPath() + "/" + timestamp + ".csv"; // Store in executable directory
-
-    logFile = new QFile(logFilePath);
-    if (!logFile->open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Append )) {
-        qDebug() << "[SnapshotThread] Error: Could not open log file for writing:" << logFilePath << logFile->errorString();
-        delete logFile;
-        logFile = nullptr;
+    logFilePath = QDir::currentPath() + "/" + timestamp; // Store in executable directory
+
+    // 列定义中记录当前校准系数，数据块约每秒一个；文件在写入线程中创建，失败时由loggingError报告
+    const std::shared_ptr<const CalibrationTable> table = std::atomic_load(&calibrationTable);
+    const QVector<SessionLog::Column> columns =
+        SessionLog::snapshotColumns(configuredModbusChannels, configuredDaqChannels,
+                                    derivedProgram->channelNames(), derivedProgram->channelUnits(),
+                                    table ? *table : CalibrationTable());
+    const int rowsPerBlock = qBound(16, int(snapshotRateHz), 4096);
+    sessionLogger->startLogging(logFilePath, columns, QString("Snapshot log, %1 Hz").arg(snapshotRateHz), rowsPerBlock);
+    if (!sessionLogger->isLogging()) {
+        logFilePath.clear();
         return false;
     }
 
-    logStream = new QTextStream(logFile);
-
-    qDebug() << "[SnapshotThread] Log file initialized:" << logFilePath;
-
-    // Generate and write header
-    generateCsvHeader();
-    writeCsvHeader();
-    snapshotsSinceLastWrite = 0; // Reset counter
-
+    qDebug() << "[SnapshotThread] Log file initialized:" << logFilePath << "columns:" << columns.size();
     return true;
 }
 
-void SnapshotThread::generateCsvHeader()
+// 只把快照句柄交给写入线程，不在本线程中做任何文件操作
+void SnapshotThread::writeSnapshotToFile(const SnapshotHandle &snapshot)
 {
-    csvHeader.clear();
-    csvHeader << "Timestamp" << "SnapshotIndex" << "ModbusValid" << "DAQValid" << "DAQRunning" << "ECUValid";
-
-    // Add headers based on configured counts
-    const int MAX_ECU_CH = 9; // Fixed
-
-    for (int i = 0; i < configuredModbusChannels; ++i) { // Use configured count
-        csvHeader << QString("Modbus_%1").arg(i);
-    }
-    for (int i = 0; i < configuredDaqChannels; ++i) { // Use configured count
-        csvHeader << QString("DAQ_%1").arg(i);
-    }
-    QStringList ecuNames = {"Throttle", "EngineSpeed", "CylinderTemp", "ExhaustTemp", "AxleTemp", "FuelPressure", "IntakeTemp", "AtmPressure", "FlightTime"};
-    for (int i = 0; i < MAX_ECU_CH; ++i) {
-        csvHeader << QString("ECU_%1").arg(ecuNames.value(i, QString::number(i))); // Use names if available
-    }
-    // Add Custom Data headers
-    for (int i = 0; i < 5; ++i) { // Fixed size of 5
-        csvHeader << QString("Custom_%1").arg(i);
-    }
+    sessionLogger->enqueueSnapshot(snapshot);
 }
 
-void SnapshotThread::writeCsvHeader()
+void SnapshotThread::closeLogFile()
 {
-    if (logStream && !csvHeader.isEmpty()) {
-        *logStream << csvHeader.join(",") << Qt::endl;
-        logStream->flush(); // Write header immediately
+    if (sessionLogger->isLogging()) {
+        sessionLogger->stopLogging();
+        qDebug() << "[SnapshotThread] Log file closing:" << logFilePath;
     }
+    logFilePath.clear();
 }
 
-void SnapshotThread::writeSnapshotToFile(const DataSnapshot &snapshot)
+void SnapshotThread::setLogWriterOptions(int queueCapacity, int flushIntervalMs, int bufferKB)
 {
-    if (!logStream) return;
-
-    QStringList dataRow;
-    dataRow << QString::number(snapshot.timestamp, 'f', 3); // Timestamp with ms precision
-    dataRow << QString::number(snapshot.snapshotIndex);
-    dataRow << QString(snapshot.modbusValid ? "1" : "0");
-    dataRow << QString(snapshot.daqValid ? "1" : "0");
-    dataRow << QString(snapshot.daqRunning ? "1" : "0");
-    dataRow << QString(snapshot.ecuValid ? "1" : "0");
-
-    // Add Modbus data based on configured count
-    for (int i = 0; i < configuredModbusChannels; ++i) { // Use configured count
-        if (snapshot.modbusValid && i < snapshot.modbusData.size()) {
-            dataRow << QString::number(snapshot.modbusData[i], 'f', 4); // 4 decimal places for Modbus
-        } else {
-            dataRow << ""; // Empty string if invalid or channel doesn't exist
-        }
-    }
-
-    // Add DAQ data based on configured count
-    for (int i = 0; i < configuredDaqChannels; ++i) { // Use configured count
-        if (snapshot.daqValid && i < snapshot.daqData.size()) {
-            dataRow << QString::number(snapshot.daqData[i], 'f', 6); // 6 decimal places for DAQ
-        } else {
-            dataRow << "";
-        }
-    }
-
-    // Add ECU data (up to MAX_ECU_CH)
-    const int MAX_ECU_CH = 9;
-    for (int i = 0; i < MAX_ECU_CH; ++i) {
-        if (snapshot.ecuValid && i < snapshot.ecuData.size()) {
-            dataRow << QString::number(snapshot.ecuData[i], 'f', 2); // 2 decimal places for ECU
-        } else {
-            dataRow << "";
-        }
-    }
-    // Add Custom data (up to 5)
-    for (int i = 0; i < 5; ++i) {
-        if (i < snapshot.customData.size()) {
-             dataRow << QString::number(snapshot.customData[i], 'f', 4); // 4 decimal places for custom
-        } else {
-            dataRow << ""; // Should not happen due to fixed size
-        }
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this, queueCapacity, flushIntervalMs, bufferKB]() {
+            setLogWriterOptions(queueCapacity, flushIntervalMs, bufferKB);
+        }, Qt::QueuedConnection);
+        return;
     }
-
-    *logStream << dataRow.join(",") << Qt::endl;
+    sessionLogger->setQueueCapacity(queueCapacity);
+    sessionLogger->setFlushInterval(flushIntervalMs);
+    sessionLogger->setBufferBytes(qint64(bufferKB) * 1024);
+    qDebug() << "[SnapshotThread] Log writer: queue" << queueCapacity << "flush interval" << flushIntervalMs
+             << "ms, buffer" << bufferKB << "KB";
 }
 
-void SnapshotThread::closeLogFile()
+void SnapshotThread::setLogSegmentOptions(double segmentSeconds, int segmentMB, int compressionLevel)
 {
-    if (logStream) {
-        logStream->flush(); // Final flush
-        qDebug() << "[SnapshotThread] Final log flush.";
-    }
-    if (logFile && logFile->isOpen()) {
-        logFile->close();
-        qDebug() << "[SnapshotThread] Log file closed:" << logFilePath;
-    }
-    // Safely delete objects
-    delete logStream;
-    logStream = nullptr;
-    delete logFile;
-    logFile = nullptr;
-    logFilePath.clear();
+    sessionLogger->setSegmentLimits(segmentSeconds, qint64(segmentMB) << 20);
+    sessionLogger->setCompressionLevel(compressionLevel);
+    qDebug() << "[SnapshotThread] Log segments:" << segmentSeconds << "s /" << segmentMB << "MB, compression level"
+             << compressionLevel;
 }
 
 // --- End of Logging Helper Methods ---
@@ -675,129 +1063,21 @@ void SnapshotThread::setupLogging(int modbusCount, int daqCount)
 // +++ 新增: 加载校准文件实现 +++
 void SnapshotThread::loadCalibrationSettings(const QString& filePath)
 {
-    qDebug() << "[SnapshotThread] Attempting to load calibration settings from:" << filePath;
-    allCalibrationParams.clear(); // 清空旧参数
-
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly)) { // Read as raw bytes
-        qDebug() << "[SnapshotThread] Warning: Cannot open calibration file:" << filePath << file.errorString() << ". Using default calibration (y=x).";
-        return;
-    }
-
-    QByteArray fileContent = file.readAll();
-    file.close(); // Close file after reading
-
-    // Get UTF-8 codec
-    QTextCodec *codec = QTextCodec::codecForName("UTF-8");
-    QString contentString;
-    if(codec) {
-        contentString = codec->toUnicode(fileContent);
-        qDebug() << "[SnapshotThread] Read calibration file and converted to Unicode using UTF-8 codec.";
-    } else {
-        qDebug() << "[SnapshotThread] Warning: Could not find UTF-8 codec! Trying Latin1.";
-        // Fallback to Latin1 if UTF-8 is somehow unavailable
-         contentString = QString::fromLatin1(fileContent);
-    }
-
-    QStringList lines = contentString.split('\n', Qt::SkipEmptyParts); // Split content into lines
-
-    QString currentSourceType = "";
-    int lineNum = 0;
-
-    // Process lines
-    for (const QString &rawLine : lines) {
-        lineNum++;
-        QString line = rawLine.trimmed(); // Trim whitespace from each line
-
-        // Skip empty lines and comments (lines starting with ';' or '#')
-        if (line.isEmpty() || line.startsWith(';') || line.startsWith('#')) {
-            continue;
-        }
-
-        // Check for section header
-        if (line.startsWith('[') && line.endsWith(']')) {
-            currentSourceType = line.mid(1, line.length() - 2).trimmed();
-            qDebug() << "[SnapshotThread] Parsing section:" << currentSourceType;
-            continue;
-        }
-
-        // Parse key-value pairs within a section
-        if (!currentSourceType.isEmpty()) {
-            int equalsPos = line.indexOf('=');
-            if (equalsPos != -1) {
-                QString key = line.left(equalsPos).trimmed();
-                QString valueString = line.mid(equalsPos + 1).trimmed();
-
-                // 移除引号（如果存在）
-                if (valueString.startsWith('"') && valueString.endsWith('"')) {
-                    valueString = valueString.mid(1, valueString.length() - 2);
-                }
-
-                // 移除时间戳（如果存在）
-                // 时间戳格式如：; Timestamp: 2023-05-20 14:30:45
-                int timeStampStart = valueString.indexOf(QString("; Timestamp:"));
-                if (timeStampStart != -1) {
-                    valueString = valueString.left(timeStampStart).trimmed();
-                }
-
-                // Remove potential inline comments
-                int commentPos = valueString.indexOf(';');
-                if (commentPos != -1) {
-                    valueString = valueString.left(commentPos).trimmed();
-                }
-                int commentPosHash = valueString.indexOf('#');
-                 if (commentPosHash != -1) {
-                    valueString = valueString.left(commentPosHash).trimmed();
-                }
-
-                 qDebug() << "[SnapshotThread Debug] Reading Key:" << currentSourceType << "/" << key << "Raw Value String:'" << valueString << "'";
-
-                if (key.startsWith("Channel_")) {
-                    bool okIndex;
-                    int channelIndex = key.mid(8).toInt(&okIndex);
-
-                    if (okIndex) {
-                        QStringList coeffStrings = valueString.split(',', Qt::SkipEmptyParts);
-
-                        if (coeffStrings.size() >= 4) { // 至少需要4个系数
-                            bool okA, okB, okC, okD;
-                            CalibrationParams params;
-                            params.a = coeffStrings[0].trimmed().toDouble(&okA);
-                            params.b = coeffStrings[1].trimmed().toDouble(&okB);
-                            params.c = coeffStrings[2].trimmed().toDouble(&okC);
-                            params.d = coeffStrings[3].trimmed().toDouble(&okD);
-
-                            if (okA && okB && okC && okD) {
-                                // Ensure the map for the sourceType exists
-                                if (!allCalibrationParams.contains(currentSourceType)) {
-                                    allCalibrationParams[currentSourceType] = QMap<int, CalibrationParams>();
-                                }
-                                allCalibrationParams[currentSourceType][channelIndex] = params;
-                                qDebug() << "[SnapshotThread] Loaded calibration for" << currentSourceType << "Channel" << channelIndex
-                                         << ": a=" << params.a << ", b=" << params.b << ", c=" << params.c << ", d=" << params.d;
-                            } else {
-                                qDebug() << "[SnapshotThread] Warning: Invalid number format in calibration for" << currentSourceType << key << "at line" << lineNum << ". Using default.";
-                            }
-                        } else {
-                            qDebug() << "[SnapshotThread] Warning: Incorrect number of coefficients for" << currentSourceType << key << "at line" << lineNum << "(found" << coeffStrings.size() << ", expected 4). Using default.";
-                        }
-                    } else {
-                         qDebug() << "[SnapshotThread] Warning: Invalid channel index format for" << currentSourceType << key << "at line" << lineNum << ". Skipping.";
-                    }
-                }
-            }
-        }
-    }
-
-    qDebug() << "[SnapshotThread] Finished loading calibration settings manually.";
+    auto table = std::make_shared<const CalibrationTable>(CalibrationTable::compile(CalibrationTable::parseFile(filePath)));
+    std::atomic_store(&calibrationTable, table);
 }
 // +++ 结束新增 +++
 
 // +++ 新增: 获取校准参数实现 +++
 CalibrationParams SnapshotThread::getCalibrationParams(const QString& sourceType, int channelIndex)
 {
-    // 如果映射中不存在该源或通道，.value() 会返回默认构造的 CalibrationParams (a=0,b=0,c=1,d=0)
-    return allCalibrationParams.value(sourceType).value(channelIndex, CalibrationParams());
+    // 未配置的数据源或通道返回默认构造的 CalibrationParams (a=0,b=0,c=1,d=0)
+    const std::shared_ptr<const CalibrationTable> table = std::atomic_load(&calibrationTable);
+    const int source = CalibrationTable::sourceFromName(sourceType);
+    if (!table || source < 0) {
+        return CalibrationParams();
+    }
+    return table->params(CalibrationTable::Source(source), channelIndex);
 }
 // +++ 结束新增 +++
 
@@ -810,6 +1090,34 @@ double SnapshotThread::applyCalibration(double rawValue, const CalibrationParams
     double x3 = x2 * x;
     return params.a * x3 + params.b * x2 + params.c * x + params.d;
 }
+
+// 校准DAQ窗口统计。min/max/mean按校准表批量代入校准多项式（min/max在多项式单调时准确）；
+// RMS在线性校准(a=b=0)时由 E[(cx+d)^2] = c^2*E[x^2] + 2cd*E[x] + d^2 精确换算
+void SnapshotThread::applyCalibrationToDAQStats(DataSnapshot &snapshot, const QVector<double> &rawMean,
+                                                const QVector<double> &rawRms, const CalibrationTable &table)
+{
+    const int channels = qMin(qMin(snapshot.daqMin.size(), snapshot.daqMax.size()),
+                              qMin(rawMean.size(), rawRms.size()));
+    table.apply(CalibrationTable::DAQ, snapshot.daqMin.data(), channels);
+    table.apply(CalibrationTable::DAQ, snapshot.daqMax.data(), channels);
+    table.apply(CalibrationTable::DAQ, snapshot.daqMean.data(), qMin(channels, int(snapshot.daqMean.size())));
+
+    for (int channel = 0; channel < channels && channel < snapshot.daqRms.size(); ++channel) {
+        if (snapshot.daqMin[channel] > snapshot.daqMax[channel]) {
+            std::swap(snapshot.daqMin[channel], snapshot.daqMax[channel]); // 负斜率校准
+        }
+
+        const CalibrationParams params = table.params(CalibrationTable::DAQ, channel);
+        if (params.a == 0.0 && params.b == 0.0) {
+            const double meanSquare = params.c * params.c * rawRms[channel] * rawRms[channel]
+                                    + 2.0 * params.c * params.d * rawMean[channel]
+                                    + params.d * params.d;
+            snapshot.daqRms[channel] = std::sqrt(qMax(0.0, meanSquare));
+        } else {
+            snapshot.daqRms[channel] = std::fabs(applyCalibration(rawRms[channel], params));
+        }
+    }
+}
 // +++ 结束新增 +++
 
 // 新增：设置是否启用数据记录
@@ -822,7 +1130,7 @@ void SnapshotThread::setDataLoggingEnabled(bool enabled)
 
     if (enableDataLogging) {
         // Only initialize if processing is also enabled
-        if (processingEnabled && !logFile) {
+        if (processingEnabled && !sessionLogger->isLogging()) {
              if (!initializeLogFile()) {
                  qDebug() << "[SnapshotThread] Failed to initialize log file when enabling data logging.";
                  // Optionally set enableDataLogging back to false or notify
@@ -831,7 +1139,7 @@ void SnapshotThread::setDataLoggingEnabled(bool enabled)
         }
     } else {
         // If disabling logging, close the file if it's open
-        if (logFile && logFile->isOpen()) {
+        if (sessionLogger->isLogging()) {
             closeLogFile();
         }
     }
@@ -846,8 +1154,11 @@ bool SnapshotThread::isDataLoggingEnabled() const
 // 新增：实现公共方法用于重新加载校准文件
 void SnapshotThread::reloadCalibrationSettings(const QString& filePath)
 {
-    loadCalibrationSettings(filePath);
-    qDebug() << "[SnapshotThread] Calibration settings reloaded from:" << filePath;
+    // 解析和编译在后台线程完成，快照线程继续使用旧表，新表就绪后原子替换
+    calibrationPool.start([this, filePath]() {
+        loadCalibrationSettings(filePath);
+        qDebug() << "[SnapshotThread] Calibration settings reloaded from:" << filePath;
+    });
 }
 
 // ... other existing methods like setFilterEnabled ...
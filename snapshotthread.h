@@ -5,7 +5,6 @@
 #include <QThread>
 #include <QTimer>
 #include <QElapsedTimer>
-#include <QQueue>
 #include <QVector>
 #include <QDebug>
 #include <QMutex>
@@ -15,55 +14,29 @@
 #include <QMutexLocker>
 #include <QDateTime>
 #include <cmath> // For round
-#include <QFile>         // Added for file logging
-#include <QTextStream>   // Added for file logging
-#include <QStringList>   // Added for CSV header
+#include <QStringList>
 #include <QMap>
+#include <QThreadPool>
+#include <memory>
 
 // 包含ECU数据结构的定义
 #include "ecuthread.h"
+// 包含DAQ数据块的定义
+#include "daqthread.h"
+#include "daqhistory.h"
+#include "decimator.h"
+#include "sessionlog.h"
+#include "snapshotlogger.h"
+#include "windowstats.h"
+#include "calibrationtable.h"
+#include "datasnapshot.h"
+#include "precisetimer.h"
+#include "sampletrack.h"
+#include "snapshothistory.h"
+#include "derivedchannels.h"
 
 // Forward declaration or include ECUData definition here
 struct ECUData;
-class DataSnapshot; // Forward declaration
-
-// +++ 新增: 校准参数结构体 +++
-struct CalibrationParams {
-    double a = 0.0;
-    double b = 0.0;
-    double c = 1.0; // 默认 y=x
-    double d = 0.0;
-};
-// +++ 结束新增 +++
-
-// 使用与MainWindow相同的数据快照类
-class DataSnapshot {
-public: // 公开访问成员
-    double timestamp;                   // 时间戳（秒）
-    QVector<double> modbusData;         // Modbus数据(一维) - 每个寄存器的值
-    QVector<double> daqData;            // DAQ数据(一维) - 修改为一维，每个通道只保留最新值
-    QVector<double> ecuData;            // ECU数据(9通道)
-    QVector<double> customData;         // 新增：自定义计算数据
-    bool modbusValid;                   // Modbus数据有效标志
-    bool daqValid;                      // DAQ数据有效标志
-    bool ecuValid;                      // ECU数据有效标志
-    bool daqRunning;                    // DAQ运行状态标志
-    int snapshotIndex;                  // 快照索引（序号）
-
-    // 构造函数，初始化所有数据
-    DataSnapshot() {
-        timestamp = 0.0;                // 初始化为0秒
-        modbusData.resize(16, 0.0);     // 16个Modbus寄存器
-        daqData.resize(16, 0.0);        // 16个DAQ通道，每个通道只保存最新值
-        ecuData.resize(9, 0.0);         // 9个ECU通道
-        customData.resize(5, 0.0);      // 初始化自定义数据，预留5个位置
-        modbusValid = false;
-        daqValid = false;
-        ecuValid = false;
-        daqRunning = false;             // 初始化DAQ运行状态为false
-        snapshotIndex = 0;              // 初始化索引为0
-    }
-};
 
 class SnapshotThread : public QObject
 {
@@ -84,8 +57,15 @@ public:
     // 设置滤波状态和参数
     void setFilterEnabled(bool enabled, double timeConstant = 100.0);
     
-    // 新增: 公共方法用于重新加载校准文件
-    void reloadCalibrationSettings(const QString& filePath);
+    // DAQ全速率历史（通道优先环形存储），其他线程可持有并读取零拷贝视图；未开始采集时为空
+    std::shared_ptr<const DAQHistoryStore> daqHistoryStore() const;
+    // DAQ绘图速率（默认1kHz）的抗混叠抽取历史，DAQ图表从这里读取；抽取器没有绘图速率级时为空
+    std::shared_ptr<const DAQHistoryStore> daqPlotHistoryStore() const;
+
+    // 校准后快照的时间索引历史（绘图、WebSocket补发），任意线程可持有并查询
+    std::shared_ptr<const SnapshotHistory> snapshotHistory() const { return history; }
+    // 原始（未校准）快照历史，保存较短时长，供校准对话框按采集区间求平均
+    std::shared_ptr<const SnapshotHistory> rawSnapshotHistory() const { return rawHistory; }
 
     // +++ 新增: 公开获取校准参数的方法 +++
     CalibrationParams getCalibrationParams(const QString& sourceType, int channelIndex);
@@ -96,12 +76,30 @@ public:
     bool isDataLoggingEnabled() const;
 
 public slots:
+    // 重新加载校准文件：在后台线程解析并编译新校准表，完成后原子替换，快照处理不暂停
+    void reloadCalibrationSettings(const QString& filePath);
+
     // 处理Modbus数据
-    void handleModbusData(QVector<double> resultdata, qint64 readTimeInterval);
+    void handleModbusData(QVector<double> resultdata, qint64 readTimeInterval, qint64 acquiredNs = 0);
 
-    // 处理DAQ数据
+    // 处理DAQ数据（完整窗口模式）
     void handleDAQData(const QVector<double> &timeData, const QVector<QVector<double>> &channelData);
 
+    // 处理DAQ增量数据块
+    void handleDAQBlock(const DAQDataBlock &block);
+
+    // 设置DAQ抽取输出速率（绘图速率、快照速率），下一个数据块生效
+    void setDAQDecimationRates(double plotRate, double snapshotRate);
+
+    // 设置DAQ全速率历史的保存时长（秒），受内存上限约束，下一轮采集生效
+    void setDAQHistoryDuration(double seconds);
+
+    // 设置快照历史的保存时长（秒），按快照速率折算为行数并受内存上限约束，保留已有的最近数据
+    void setHistoryDuration(double seconds);
+
+    // 设置派生通道（customData）定义，编译成功后从下一个快照生效；公式有误时发出derivedChannelsError并保留原定义
+    void setDerivedChannels(const QVector<DerivedChannel> &channels);
+
     // 处理ECU数据
     void handleECUData(const ECUData &data);
 
@@ -120,22 +118,70 @@ public slots:
     // Public method to reset the master timer
     Q_INVOKABLE void resetMasterTimer();
 
+    // 快照速率（Hz，0.1~1000），运行中修改立即生效
+    void setSnapshotRate(double hz);
+    // 数据源（"Modbus"/"DAQ"/"ECU"）重采样到快照时刻的方式："hold"（零阶保持，默认）或"linear"（需配合setAlignmentDelay）
+    void setResampleMode(const QString &source, const QString &mode);
+    // 快照时刻相对当前时间的延后量（ms）。线性插值需要快照时刻之后的一帧，
+    // 延后量不小于数据源的更新周期时才能插值，否则退化为保持最新值
+    void setAlignmentDelay(double ms);
+    // 会话日志写入选项：队列容量（快照个数，写入线程启动前有效）、刷新间隔（ms）、写出缓冲区大小（KB）
+    void setLogWriterOptions(int queueCapacity, int flushIntervalMs, int bufferKB);
+    // 会话日志分段：按时长（秒）或未压缩大小（MB）切换分段（0为不限），分段在后台压缩（级别0-9，0不压缩）
+    void setLogSegmentOptions(double segmentSeconds, int segmentMB, int compressionLevel);
+
 signals:
     // 发送处理好的数据快照
-    void snapshotProcessed(const DataSnapshot &snapshot, int snapshotCount);
+    void snapshotProcessed(const SnapshotHandle &snapshot, int snapshotCount);
     void sendModbusResultToWebSocket(const QJsonObject &data, int interval);
     // 发送给WebSocket线程的统一快照信号 (新增)
-    void snapshotForWebSocket(const DataSnapshot &snapshot, int snapshotCount);
+    void snapshotForWebSocket(const SnapshotHandle &snapshot, int snapshotCount);
     // +++ 新增: 发送原始数据快照信号 +++
-    void rawSnapshotReady(const DataSnapshot &rawSnapshot);
+    void rawSnapshotReady(const SnapshotHandle &rawSnapshot);
+    // 快照调度统计，约每秒一次：已生成快照数、累计错过的截止时间数、本周期最大触发延迟（ms）
+    void schedulerStatistics(quint64 snapshots, quint64 missedDeadlines, double maxLatenessMs);
+    // 派生通道已更新（各通道名称，编号即customData下标）
+    void derivedChannelsChanged(const QStringList &names);
+    // 派生通道公式编译失败
+    void derivedChannelsError(QString errorMessage);
+    // 会话日志写入统计（转发自SnapshotLogger::loggerStatistics）
+    void loggerStatistics(quint64 snapshotsDropped, int queued, int highWater, double writeMBps, double maxWriteMs);
+
+private slots:
+    // 调度器按截止时间触发，生成一个快照
+    void onSnapshotTick(qint64 deadlineNs, quint64 tick);
 
 private:
     // 数据存储相关变量
     DataSnapshot currentSnapshot;          // 当前数据快照
-    QQueue<DataSnapshot> snapshotQueue;    // 数据快照队列
+    SnapshotPool snapshotPool;             // 快照对象池（原始/校准后快照复用）
+    std::shared_ptr<SnapshotHistory> history;     // 校准后快照历史（仅本线程写入）
+    std::shared_ptr<SnapshotHistory> rawHistory;  // 原始快照历史（仅本线程写入）
+    double historySeconds = 3600.0;               // 快照历史保存时长（秒）
+    double rawHistorySeconds = 120.0;             // 原始快照历史保存时长（秒）
+    qint64 historyMaxBytes = 256ll << 20;         // 快照历史占用内存上限
+    void applyHistoryLimits();
     QElapsedTimer *masterTimer;            // 主计时器，用于同步数据
     int maxQueueSize = 1000;               // 最大队列长度，防止内存占用过多
     int snapshotCount = 0;                 // 快照计数器
+
+    // 快照调度：在本线程中按绝对截止时间触发，不依赖GUI线程的定时器
+    PreciseTimer *snapshotScheduler;       // 快照调度器
+    double snapshotRateHz = 10.0;          // 快照速率（Hz）
+    qint64 lastSchedulerReportNs = 0;      // 上次发送调度统计的时间
+
+    // 时间对齐：各数据源最近若干帧（带采集时间戳），快照时重采样到同一时刻
+    SampleTrack modbusTrack{8};
+    SampleTrack daqTrack{64};              // 快照速率的抽取输出
+    SampleTrack ecuTrack{8};
+    ResampleMode modbusResample = ResampleMode::ZeroOrderHold;
+    ResampleMode daqResample = ResampleMode::ZeroOrderHold;
+    ResampleMode ecuResample = ResampleMode::ZeroOrderHold;
+    qint64 alignmentDelayNs = 0;           // 快照时刻相对当前时间的延后量
+    qint64 daqClockOffsetNs = 0;           // DAQ样本序号0对应的PipelineClock时间（各数据块估计的最小值）
+    bool daqClockValid = false;
+    QVector<double> daqFrameScratch;       // 追加DAQ帧时的临时缓冲区（一帧全部通道）
+    void appendDAQFrames(const DAQDataBlock &block);
     
     // 新增：控制是否记录数据到文件
     bool enableDataLogging = true;         // 默认启用数据记录
@@ -146,14 +192,35 @@ private:
     QVector<QVector<double>> modbusData;   // Modbus数据缓冲区
 
     // DAQ相关
-    QVector<QVector<double>> daqChannelData; // DAQ通道数据
-    QVector<double> daqTimeData;             // DAQ时间数据
+    std::shared_ptr<DAQHistoryStore> daqHistory;  // DAQ全速率历史（仅本线程写入）
+    std::shared_ptr<DAQHistoryStore> daqPlotHistory;  // DAQ绘图速率历史（仅本线程写入），随抽取器重新分配
+    double daqHistorySeconds = 60.0;              // 历史保存时长（秒）
+    qint64 daqHistoryMaxBytes = 512ll << 20;      // 历史占用内存上限
+    double daqLastWindowTime = -1.0;              // 完整窗口模式下已保存的最后一个样本时间
+    bool ensureDAQHistory(int channels, double sampleRate, int blockSize);
     int daqNumChannels = 16;                 // DAQ通道数量
     bool daqIsAcquiring = false;             // DAQ采集状态
+    quint64 daqNextBlockSequence = 0;        // 期望的下一个DAQ数据块序号
+    quint64 daqLostBlocks = 0;               // 检测到的丢失数据块数量
+
+    // DAQ多级抽取（全速率 -> 绘图速率 -> 快照速率）
+    MultiStageDecimator daqDecimator;
+    double daqPlotRate = 1000.0;             // 绘图数据速率（Hz）
+    double daqSnapshotRate = 10.0;           // 快照数据速率（Hz），随setSnapshotRate更新
+    int daqPlotStage = -1;                   // 绘图速率对应的抽取级，-1表示不可用
+    int daqSnapshotStage = -1;               // 快照速率对应的抽取级，-1表示不可用
+    bool daqDecimatorDirty = true;           // 需要按新参数重新配置抽取器
+    QVector<WindowStats> daqWindowStats;     // 自上次快照以来各通道的全速率统计
+    QVector<double> daqScratch;              // 原始码值数据块换算为电压的临时缓冲区
+    double daqDecimatorInputRate = 0.0;      // 抽取器配置时的输入采样率
+    int daqDecimatorChannels = 0;            // 抽取器配置时的通道数
+    void configureDAQDecimator(const DAQDataBlock &block);
 
     // ECU相关
     QVector<QVector<double>> ecuData;      // ECU数据缓冲区
     QVector<double> customDataBuffer;   // 用于计算customData的临时缓冲区
+    std::shared_ptr<const DerivedChannelProgram> derivedProgram;  // 编译后的派生通道（仅本线程使用）
+    std::vector<double> derivedRegisters;  // 派生通道求值的寄存器
     ECUData latestECUData;                     // ECU最新数据
     bool snapEcuIsConnected = false;           // ECU连接状态
     bool ecuDataValid = false;             // ECU数据有效标志
@@ -169,31 +236,27 @@ private:
     // Add processing enabled flag
     bool processingEnabled = false;
 
-    // +++ 新增: 存储校准参数 +++
-    QMap<QString, QMap<int, CalibrationParams>> allCalibrationParams; // Key1: SourceType ("Modbus", "DAQ", "ECU", "Custom"), Key2: Channel Index
-    // +++ 结束新增 +++
+    // 编译后的校准表，通过std::atomic_load/atomic_store整体替换；快照处理每次取一个引用后使用
+    std::shared_ptr<const CalibrationTable> calibrationTable;
+    QThreadPool calibrationPool;           // 构建校准表的后台线程（单线程，按请求顺序完成）
 
     // +++ 新增: 私有辅助函数声明 +++
     void loadCalibrationSettings(const QString& filePath);
     double applyCalibration(double rawValue, const CalibrationParams& params);
+    void applyCalibrationToDAQStats(DataSnapshot &snapshot, const QVector<double> &rawMean,
+                                    const QVector<double> &rawRms, const CalibrationTable &table);
     // +++ 结束新增 +++
 
     // Logging members
-    QFile *logFile = nullptr;
-    QTextStream *logStream = nullptr;
+    SnapshotLogger *sessionLogger;         // 会话日志（*.slog）写入线程，快照句柄经无锁队列交给它写盘
     QString logFilePath;
-    QStringList csvHeader;
-    int snapshotsSinceLastWrite = 0;
-    const int writeThreshold = 100; // Write to disk every 100 snapshots
     // Store configured channel counts
     int configuredModbusChannels = 0;
     int configuredDaqChannels = 0;
 
     // Private helper methods for logging
     bool initializeLogFile();
-    void generateCsvHeader(); // Helper to create the header string
-    void writeCsvHeader();
-    void writeSnapshotToFile(const DataSnapshot &snapshot);
+    void writeSnapshotToFile(const SnapshotHandle &snapshot);
     void closeLogFile();
 
 };
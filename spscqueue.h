@@ -0,0 +1,115 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+// 单生产者/单消费者（SPSC）无锁有界队列
+//
+// 与DAQBlockRing相同的索引方案：容量为2的幂，读写索引单调递增、位于不同缓存行，
+// 生产者缓存消费者索引以减少跨核读取。元素按值存放（如隐式共享句柄），
+// 出队时移出并把槽位重置为默认值，使元素持有的资源尽早释放。
+// 入队和出队都不分配内存、不加锁；队列满时入队失败，由调用者决定丢弃策略。
+template <typename T>
+class SpscQueue
+{
+public:
+    static constexpr std::size_t CacheLineSize = 64;
+
+    SpscQueue() = default;
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    // 分配槽位（生产者和消费者都未使用队列时调用），capacity向上取整为2的幂
+    bool allocate(std::size_t capacity)
+    {
+        std::size_t count = 2;
+        while (count < capacity) {
+            count <<= 1;
+        }
+        m_slots.reset(new (std::nothrow) T[count]);
+        if (!m_slots) {
+            m_capacity = 0;
+            m_mask = 0;
+            return false;
+        }
+        m_capacity = count;
+        m_mask = count - 1;
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
+        m_cachedTail = 0;
+        m_highWater.store(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool isAllocated() const { return m_slots != nullptr; }
+    std::size_t capacity() const { return m_capacity; }
+
+    // ---- 生产者接口 ----
+
+    // 入队；队列中剩余空位不多于reserve个时失败（为控制类元素保留空位）
+    bool tryPush(T &&item, std::size_t reserve = 0)
+    {
+        const std::uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_cachedTail + reserve >= m_capacity) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head - m_cachedTail + reserve >= m_capacity) {
+                return false;
+            }
+        }
+        m_slots[head & m_mask] = std::move(item);
+        m_head.store(head + 1, std::memory_order_release);
+
+        const std::uint64_t fill = head + 1 - m_cachedTail;
+        if (fill > m_highWater.load(std::memory_order_relaxed)) {
+            m_highWater.store(fill, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    // ---- 消费者接口 ----
+
+    // 出队最早的元素；为空时返回false
+    bool tryPop(T &out)
+    {
+        const std::uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        T &slot = m_slots[tail & m_mask];
+        out = std::move(slot);
+        slot = T();
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // ---- 统计（任意线程） ----
+
+    std::size_t size() const
+    {
+        return std::size_t(m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire));
+    }
+    std::size_t highWater() const { return std::size_t(m_highWater.load(std::memory_order_relaxed)); }
+    void resetHighWater() { m_highWater.store(0, std::memory_order_relaxed); }
+
+private:
+    std::unique_ptr<T[]> m_slots;
+    std::size_t m_capacity = 0;
+    std::size_t m_mask = 0;
+
+    // 生产者独占的缓存行
+    alignas(CacheLineSize) std::atomic<std::uint64_t> m_head{0};
+    std::uint64_t m_cachedTail = 0;
+
+    // 消费者独占的缓存行
+    alignas(CacheLineSize) std::atomic<std::uint64_t> m_tail{0};
+
+    alignas(CacheLineSize) std::atomic<std::uint64_t> m_highWater{0};
+};
+
+#endif // SPSCQUEUE_H
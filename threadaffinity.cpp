@@ -0,0 +1,35 @@
+#include "threadaffinity.h"
+#include <thread>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+int logicalCoreCount()
+{
+    const unsigned int count = std::thread::hardware_concurrency();
+    return count > 0 ? int(count) : 1;
+}
+
+bool pinCurrentThreadToCore(int core)
+{
+    if (core < 0 || core >= logicalCoreCount()) {
+        return false;
+    }
+#if defined(_WIN32)
+    if (core >= int(sizeof(DWORD_PTR) * 8)) {
+        return false;
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << core) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,15 @@
+#ifndef THREADAFFINITY_H
+#define THREADAFFINITY_H
+
+// 线程CPU亲和性
+//
+// 把实时线程（如设备回调线程）固定到指定核心，避免在核心之间迁移造成缓存失效和调度抖动。
+// Windows使用SetThreadAffinityMask，Linux使用pthread_setaffinity_np，其他平台不做处理。
+
+// 逻辑核心数（无法获取时返回1）
+int logicalCoreCount();
+
+// 把调用线程固定到核心core上，成功返回true
+bool pinCurrentThreadToCore(int core);
+
+#endif // THREADAFFINITY_H
@@ -1,10 +1,12 @@
 #include "websocketthread.h"
+#include "pipelinelatency.h"
 #include <QNetworkInterface>
 #include <QDebug>
 #include <QDir>
 #include <QMimeDatabase>
 #include <QDateTime>
 #include <QTimer>
+#include <cmath>
 
 WebSocketThread::WebSocketThread(QObject *parent)
     : QObject(parent)
@@ -378,7 +380,7 @@ bool WebSocketThread::isRunning() const
 }
 
 // 新增：处理数据快照的方法
-void WebSocketThread::handleDataSnapshot(const DataSnapshot &snapshot, int snapshotCount)
+void WebSocketThread::handleDataSnapshot(const SnapshotHandle &snapshot, int snapshotCount)
 {
     // 只有在服务器运行且有客户端连接的情况下才处理数据
     if (!m_running) {
@@ -391,10 +393,12 @@ void WebSocketThread::handleDataSnapshot(const DataSnapshot &snapshot, int snaps
     }
 
     // 转换快照为JSON格式
-    QJsonObject jsonData = convertSnapshotToJson(snapshot, snapshotCount);
+    QJsonObject jsonData = convertSnapshotToJson(*snapshot, snapshotCount);
     
     // 广播消息给所有客户端
     broadcastMessage(jsonData);
+    PipelineLatency::recordSince(PipelineLatency::Publish, snapshot->publishedNs);
+    PipelineLatency::recordSince(PipelineLatency::EndToEndPublish, snapshot->acquiredNs);
     
     qDebug() << "发送快照数据到" << m_clients.size() << "个WebSocket客户端";
 }
@@ -415,6 +419,13 @@ QJsonObject WebSocketThread::convertSnapshotToJson(const DataSnapshot &snapshot,
     jsonData["daqValid"] = snapshot.daqValid;
     jsonData["daqRunning"] = snapshot.daqRunning;
     jsonData["ecuValid"] = snapshot.ecuValid;
+
+    // 各数据源的时效（秒，-1表示无数据）
+    QJsonObject ageObj;
+    ageObj["modbus"] = snapshot.modbusAge;
+    ageObj["daq"] = snapshot.daqAge;
+    ageObj["ecu"] = snapshot.ecuAge;
+    jsonData["age"] = ageObj;
     
     // 添加Modbus数据
     if (snapshot.modbusValid) {
@@ -462,6 +473,20 @@ QJsonObject WebSocketThread::convertSnapshotToJson(const DataSnapshot &snapshot,
         jsonData["ecu"] = ecuArray;
         jsonData["ecuCount"] = snapshot.ecuData.size();
     }
+
+    // 添加派生通道数据
+    if (!snapshot.customData.isEmpty()) {
+        QJsonArray customArray;
+        for (int i = 0; i < snapshot.customData.size(); ++i) {
+            QJsonObject customObj;
+            customObj["index"] = i;
+            customObj["value"] = snapshot.customData[i];
+            customObj["name"] = i < m_customNames.size() ? m_customNames[i] : QString("Custom_%1").arg(i);
+            customArray.append(customObj);
+        }
+        jsonData["custom"] = customArray;
+        jsonData["customCount"] = snapshot.customData.size();
+    }
     
     return jsonData;
 }
@@ -581,10 +606,125 @@ void WebSocketThread::onTextMessageReceived(const QString &message)
     QWebSocket *client = qobject_cast<QWebSocket*>(sender());
     if (client) {
         qDebug() << "收到WebSocket客户端消息:" << message;
-        
-        // 这里可以处理来自客户端的命令
-        // 如果需要的话，可以实现更多的命令处理逻辑
+
+        // 历史数据请求：新连接的客户端补齐图表，只回复给请求者
+        const QJsonObject request = QJsonDocument::fromJson(message.toUtf8()).object();
+        if (request.value("type").toString() == "history") {
+            const QJsonObject reply = buildHistoryReply(request);
+            client->sendTextMessage(QJsonDocument(reply).toJson(QJsonDocument::Compact));
+        } else if (request.value("type").toString() == "latency") {
+            client->sendTextMessage(QJsonDocument(buildLatencyReply()).toJson(QJsonDocument::Compact));
+        }
+    }
+}
+
+// 管线延迟统计
+// 请求：{"type":"latency"}
+// 回复：{"type":"latency", "stages":[{"stage", "count", "meanMs", "p50Ms", "p90Ms", "p99Ms", "p999Ms", "maxMs"}, ...]}
+QJsonObject WebSocketThread::buildLatencyReply() const
+{
+    QJsonArray stages;
+    for (int s = 0; s < PipelineLatency::StageCount; ++s) {
+        const PipelineLatency::Stage stage = PipelineLatency::Stage(s);
+        const LatencyHistogram::Snapshot h = PipelineLatency::histogram(stage).snapshot();
+        QJsonObject stageObj;
+        stageObj["stage"] = PipelineLatency::stageName(stage);
+        stageObj["count"] = double(h.total);
+        stageObj["meanMs"] = h.meanNs() / 1e6;
+        stageObj["p50Ms"] = PipelineClock::toMilliseconds(h.percentile(50.0));
+        stageObj["p90Ms"] = PipelineClock::toMilliseconds(h.percentile(90.0));
+        stageObj["p99Ms"] = PipelineClock::toMilliseconds(h.percentile(99.0));
+        stageObj["p999Ms"] = PipelineClock::toMilliseconds(h.percentile(99.9));
+        stageObj["maxMs"] = PipelineClock::toMilliseconds(h.maxNs);
+        stages.append(stageObj);
+    }
+    QJsonObject reply;
+    reply["type"] = "latency";
+    reply["stages"] = stages;
+    return reply;
+}
+
+// 按请求查询快照历史
+// 请求：{"type":"history", "seconds":60}（最近若干秒）或 {"from":t0, "to":t1}，
+//       可选 "maxPoints"（默认2000，超过时按最小/最大值抽取）、"sources"（["modbus","daq","ecu","custom"]的子集）
+// 回复：{"type":"history", "from", "to", "sourceRows", "decimated", "time":[...],
+//       "modbus":[[通道0...],[通道1...]], "daq":..., "ecu":..., "custom":...}，无效值为null
+QJsonObject WebSocketThread::buildHistoryReply(const QJsonObject &request) const
+{
+    QJsonObject reply;
+    reply["type"] = "history";
+
+    double first = 0.0;
+    double last = 0.0;
+    if (!m_history || !m_history->timeRange(&first, &last)) {
+        reply["error"] = "no history";
+        return reply;
+    }
+
+    double from = first;
+    double to = last;
+    if (request.contains("seconds")) {
+        from = last - request.value("seconds").toDouble();
+    } else {
+        from = request.value("from").toDouble(first);
+        to = request.value("to").toDouble(last);
+    }
+    const int maxPoints = qBound(2, request.value("maxPoints").toInt(2000), 20000);
+
+    struct Source {
+        const char *name;
+        SessionLog::ColumnKind kind;
+    };
+    const Source allSources[] = {
+        {"modbus", SessionLog::ModbusValue},
+        {"daq", SessionLog::DAQValue},
+        {"ecu", SessionLog::ECUValue},
+        {"custom", SessionLog::CustomValue}
+    };
+    QStringList requested;
+    for (const QJsonValue &value : request.value("sources").toArray()) {
+        requested << value.toString();
+    }
+
+    // 一次查询全部请求的通道，各数据源共用同一时间轴
+    QVector<SnapshotHistory::Channel> channels;
+    QVector<QPair<QString, int>> groups;   // 数据源名称、通道数
+    for (const Source &source : allSources) {
+        if (!requested.isEmpty() && !requested.contains(source.name)) {
+            continue;
+        }
+        const int count = m_history->channelCount(source.kind);
+        for (int i = 0; i < count; ++i) {
+            channels.append({source.kind, i});
+        }
+        groups.append(qMakePair(QString(source.name), count));
+    }
+
+    const SnapshotHistory::QueryResult result = m_history->query(from, to, channels, maxPoints);
+    reply["from"] = from;
+    reply["to"] = to;
+    reply["sourceRows"] = double(result.sourceRows);
+    reply["decimated"] = result.decimated;
+
+    QJsonArray timeArray;
+    for (double t : result.time) {
+        timeArray.append(t);
+    }
+    reply["time"] = timeArray;
+
+    int column = 0;
+    for (const auto &group : groups) {
+        QJsonArray sourceArray;
+        for (int i = 0; i < group.second; ++i, ++column) {
+            QJsonArray values;
+            for (double v : result.values[column]) {
+                values.append(std::isnan(v) ? QJsonValue() : QJsonValue(v));
+            }
+            sourceArray.append(values);
+        }
+        reply[group.first] = sourceArray;
     }
+    return reply;
 }
 
 // 添加缺失的onSocketError实现
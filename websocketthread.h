@@ -34,9 +34,15 @@ public:
     // 测试WebSocket连接和数据传输
     Q_INVOKABLE void testConnection();
 
+    // 客户端请求历史数据时查询的快照历史（由MainWindow在连接时设置）
+    void setSnapshotHistory(const std::shared_ptr<const SnapshotHistory> &history) { m_history = history; }
+
 public slots:
+    // 派生通道（customData）的名称，用于快照JSON中的"custom"数组
+    void setCustomChannelNames(const QStringList &names) { m_customNames = names; }
+
     // 新增：处理完整数据快照的槽函数
-    void handleDataSnapshot(const DataSnapshot &snapshot, int snapshotCount);
+    void handleDataSnapshot(const SnapshotHandle &snapshot, int snapshotCount);
     
     // 以下旧方法标记为废弃，将在未来版本移除
     void handleModbusData(const QJsonObject &data, int interval); // 废弃
@@ -74,6 +80,13 @@ private:
     // HTTP服务器相关成员
     QTcpServer *m_httpServer;
     QList<QTcpSocket*> m_httpClients;
+
+    // 快照历史，回复客户端的 {"type":"history"} 请求
+    std::shared_ptr<const SnapshotHistory> m_history;
+    QStringList m_customNames;
+    QJsonObject buildHistoryReply(const QJsonObject &request) const;
+    // 管线延迟统计，回复客户端的 {"type":"latency"} 请求
+    QJsonObject buildLatencyReply() const;
     
     // 发送数据给所有客户端
     void broadcastMessage(const QJsonObject &data);
@@ -0,0 +1,144 @@
+#include "windowstats.h"
+#include "cpufeatures.h"
+
+#include <algorithm>
+
+namespace {
+
+struct Partial {
+    double min;
+    double max;
+    double sum;
+    double sumSquares;
+};
+
+void accumulateScalar(const double *x, int begin, int count, Partial *p)
+{
+    for (int i = begin; i < count; ++i) {
+        const double v = x[i];
+        p->min = std::min(p->min, v);
+        p->max = std::max(p->max, v);
+        p->sum += v;
+        p->sumSquares += v * v;
+    }
+}
+
+#ifdef SIMD_HAVE_SSE2
+// SSE2：每次处理4个样本（两组累加器）
+int accumulateSse2(const double *x, int count, Partial *p)
+{
+    if (count < 4) {
+        return 0;
+    }
+    __m128d mn0 = _mm_loadu_pd(x);
+    __m128d mn1 = _mm_loadu_pd(x + 2);
+    __m128d mx0 = mn0;
+    __m128d mx1 = mn1;
+    __m128d sum0 = _mm_setzero_pd();
+    __m128d sum1 = _mm_setzero_pd();
+    __m128d sq0 = _mm_setzero_pd();
+    __m128d sq1 = _mm_setzero_pd();
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128d a = _mm_loadu_pd(x + i);
+        const __m128d b = _mm_loadu_pd(x + i + 2);
+        mn0 = _mm_min_pd(mn0, a);
+        mn1 = _mm_min_pd(mn1, b);
+        mx0 = _mm_max_pd(mx0, a);
+        mx1 = _mm_max_pd(mx1, b);
+        sum0 = _mm_add_pd(sum0, a);
+        sum1 = _mm_add_pd(sum1, b);
+        sq0 = _mm_add_pd(sq0, _mm_mul_pd(a, a));
+        sq1 = _mm_add_pd(sq1, _mm_mul_pd(b, b));
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_min_pd(mn0, mn1));
+    p->min = std::min(p->min, std::min(lanes[0], lanes[1]));
+    _mm_storeu_pd(lanes, _mm_max_pd(mx0, mx1));
+    p->max = std::max(p->max, std::max(lanes[0], lanes[1]));
+    _mm_storeu_pd(lanes, _mm_add_pd(sum0, sum1));
+    p->sum += lanes[0] + lanes[1];
+    _mm_storeu_pd(lanes, _mm_add_pd(sq0, sq1));
+    p->sumSquares += lanes[0] + lanes[1];
+    return i;
+}
+#endif
+
+#ifdef SIMD_HAVE_X86
+// AVX2/FMA：每次处理8个样本（两组累加器）
+SIMD_TARGET_AVX2 int accumulateAvx2(const double *x, int count, Partial *p)
+{
+    if (count < 8) {
+        return 0;
+    }
+    __m256d mn0 = _mm256_loadu_pd(x);
+    __m256d mn1 = _mm256_loadu_pd(x + 4);
+    __m256d mx0 = mn0;
+    __m256d mx1 = mn1;
+    __m256d sum0 = _mm256_setzero_pd();
+    __m256d sum1 = _mm256_setzero_pd();
+    __m256d sq0 = _mm256_setzero_pd();
+    __m256d sq1 = _mm256_setzero_pd();
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256d a = _mm256_loadu_pd(x + i);
+        const __m256d b = _mm256_loadu_pd(x + i + 4);
+        mn0 = _mm256_min_pd(mn0, a);
+        mn1 = _mm256_min_pd(mn1, b);
+        mx0 = _mm256_max_pd(mx0, a);
+        mx1 = _mm256_max_pd(mx1, b);
+        sum0 = _mm256_add_pd(sum0, a);
+        sum1 = _mm256_add_pd(sum1, b);
+        sq0 = _mm256_fmadd_pd(a, a, sq0);
+        sq1 = _mm256_fmadd_pd(b, b, sq1);
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_min_pd(mn0, mn1));
+    p->min = std::min({p->min, lanes[0], lanes[1], lanes[2], lanes[3]});
+    _mm256_storeu_pd(lanes, _mm256_max_pd(mx0, mx1));
+    p->max = std::max({p->max, lanes[0], lanes[1], lanes[2], lanes[3]});
+    _mm256_storeu_pd(lanes, _mm256_add_pd(sum0, sum1));
+    p->sum += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    _mm256_storeu_pd(lanes, _mm256_add_pd(sq0, sq1));
+    p->sumSquares += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    return i;
+}
+#endif
+
+} // namespace
+
+void accumulateWindowStats(const double *samples, int count, WindowStats *stats)
+{
+    if (!samples || count <= 0 || !stats) {
+        return;
+    }
+
+    Partial p;
+    p.min = stats->count > 0 ? stats->min : samples[0];
+    p.max = stats->count > 0 ? stats->max : samples[0];
+    p.sum = 0.0;
+    p.sumSquares = 0.0;
+
+    int done = 0;
+#ifdef SIMD_HAVE_X86
+    if (cpuHasAvx2Fma()) {
+        done = accumulateAvx2(samples, count, &p);
+    } else
+#endif
+    {
+#ifdef SIMD_HAVE_SSE2
+        done = accumulateSse2(samples, count, &p);
+#endif
+    }
+    accumulateScalar(samples, done, count, &p);
+
+    stats->min = p.min;
+    stats->max = p.max;
+    stats->sum += p.sum;
+    stats->sumSquares += p.sumSquares;
+    stats->count += count;
+}
@@ -0,0 +1,26 @@
+#ifndef WINDOWSTATS_H
+#define WINDOWSTATS_H
+
+#include <cmath>
+#include <cstdint>
+
+// 一个统计窗口（两次快照之间）内单个通道的聚合量
+struct WindowStats {
+    double min = 0.0;
+    double max = 0.0;
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    std::int64_t count = 0;
+
+    void reset() { *this = WindowStats(); }
+    bool isEmpty() const { return count == 0; }
+    double mean() const { return count > 0 ? sum / double(count) : 0.0; }
+    // 均方根（含直流分量）
+    double rms() const { return count > 0 ? std::sqrt(sumSquares / double(count)) : 0.0; }
+};
+
+// 单次遍历累加count个样本的最小值、最大值、和、平方和
+// （运行时选择AVX2/FMA或SSE2内核）
+void accumulateWindowStats(const double *samples, int count, WindowStats *stats);
+
+#endif // WINDOWSTATS_H